@@ -0,0 +1,12 @@
+// Shared declarations of the bindless table, see VulkanBindlessTable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 0, binding = 0) uniform texture2D g_textures[];
+layout(set = 0, binding = 1) uniform sampler g_samplers[];
+
+// Storage buffers are declared per use, e.g. BINDLESS_STORAGE_BUFFER(Vertices, { vec4 data[]; })
+#define BINDLESS_STORAGE_BUFFER(name, body) layout(std430, set = 0, binding = 2) readonly buffer name body g_##name[]
+#define BINDLESS_RW_STORAGE_BUFFER(name, body) layout(std430, set = 0, binding = 2) buffer name body g_##name[]
+
+// Expanded at the use site, implicit LOD sampling only exists in fragment shaders
+#define SAMPLE_BINDLESS(textureIndex, samplerIndex, uv) texture(sampler2D(g_textures[nonuniformEXT(textureIndex)], g_samplers[nonuniformEXT(samplerIndex)]), uv)
@@ -0,0 +1,39 @@
+// Instance and mesh records, see VulkanGpuInstance and VulkanGpuMesh
+struct Instance
+{
+    vec4 positionScale;
+    vec4 color;
+    uint mesh;
+    uint texture;
+};
+
+struct Mesh
+{
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    float radius;
+};
+
+BINDLESS_STORAGE_BUFFER(Instances, { Instance instances[]; });
+BINDLESS_STORAGE_BUFFER(Meshes, { Mesh meshes[]; });
+
+// Frame allocator ring, per frame data is addressed in vec4 units from the push constant offset
+BINDLESS_STORAGE_BUFFER(FrameData, { vec4 frameData[]; });
+
+// FrameConstants in Renderer.cpp
+mat4 LoadViewProjection(uint frameData, uint offset)
+{
+    return mat4(g_FrameData[frameData].frameData[offset], g_FrameData[frameData].frameData[offset + 1],
+        g_FrameData[frameData].frameData[offset + 2], g_FrameData[frameData].frameData[offset + 3]);
+}
+
+// Inverse of VertexQuantization::EncodeOctahedral
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
@@ -0,0 +1,11 @@
+// Streamed textures, see VulkanTextureStreamer. Include after Bindless.glsl.
+// Each entry holds the texture's bindless image index and its finest resident mip, rewritten every frame.
+BINDLESS_STORAGE_BUFFER(TextureTable, { uvec2 textureTable[]; });
+
+uint StreamedImageIndex(uint table, uint texture)
+{
+    return g_TextureTable[table].textureTable[texture].x;
+}
+
+// The image only holds the resident mips, implicit LOD still picks the right one of them
+#define SAMPLE_STREAMED(table, texture, samplerIndex, uv) SAMPLE_BINDLESS(StreamedImageIndex(table, texture), samplerIndex, uv)
@@ -0,0 +1,33 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "Bindless.glsl"
+#include "Textures.glsl"
+
+// Same block as scene.vert
+layout(push_constant) uniform PushConstants
+{
+    uint frameData;
+    uint frameOffset;
+    uint instanceBuffer;
+    uint meshTable;
+    uint instanceOrder;
+    uint textureTable;
+    uint textureSampler;
+} pc;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUv;
+layout(location = 2) flat in uint fragTexture;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    // Instances without a texture, and frames without streaming, keep the plain color
+    vec3 color = fragColor;
+    if (pc.textureTable != 0xffffffffu && fragTexture != 0xffffffffu && StreamedImageIndex(pc.textureTable, fragTexture) != 0xffffffffu)
+        color *= SAMPLE_STREAMED(pc.textureTable, fragTexture, pc.textureSampler, fragUv).rgb;
+
+    outColor = vec4(color, 1.0);
+}
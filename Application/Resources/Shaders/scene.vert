@@ -0,0 +1,46 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "Bindless.glsl"
+#include "Scene.glsl"
+
+// VulkanVertexLayout::Quantized
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inUv;
+
+layout(push_constant) uniform PushConstants
+{
+    uint frameData;
+    uint frameOffset;
+    uint instanceBuffer;
+    uint meshTable;
+    uint instanceOrder;
+    uint textureTable;
+    uint textureSampler;
+} pc;
+
+// Draw list draws cover several instances, their firstInstance points into the instance order
+BINDLESS_STORAGE_BUFFER(InstanceOrder, { uint instanceOrder[]; });
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUv;
+layout(location = 2) flat out uint fragTexture;
+
+void main()
+{
+    uint instanceIndex = pc.instanceOrder != 0xffffffffu ? g_InstanceOrder[pc.instanceOrder].instanceOrder[gl_InstanceIndex] : gl_InstanceIndex;
+    Instance instance = g_Instances[pc.instanceBuffer].instances[instanceIndex];
+    Mesh mesh = g_Meshes[pc.meshTable].meshes[instance.mesh];
+
+    // Positions are stored in units of the mesh radius
+    vec3 position = inPosition.xyz * (mesh.radius * instance.positionScale.w) + instance.positionScale.xyz;
+    gl_Position = LoadViewProjection(pc.frameData, pc.frameOffset) * vec4(position, 1.0);
+
+    // Fixed light from above the camera
+    vec3 normal = DecodeOctahedral(inNormal);
+    float lighting = 0.35 + 0.65 * max(dot(normal, normalize(vec3(0.4, 0.5, 1.0))), 0.0);
+    fragColor = instance.color.rgb * lighting;
+    fragUv = inUv;
+    fragTexture = instance.texture;
+}
@@ -0,0 +1,171 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <fstream>
+#include <numeric>
+#include <print>
+#include <stdexcept>
+
+namespace VEngine
+{
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool AssetArchive::Open(const std::filesystem::path& path)
+	{
+		Close();
+		if (m_file.Open(path) == false)
+			return false;
+
+		const auto data = m_file.GetData();
+		const auto malformed = [&]()
+		{
+			std::println("Asset archive {} is malformed", path.string());
+			Close();
+			return false;
+		};
+
+		if (data.size() < sizeof(AssetArchiveHeader))
+			return malformed();
+
+		// The mapping is page aligned, so the header and entries can be read in place
+		const auto& header = *reinterpret_cast<const AssetArchiveHeader*>(data.data());
+		if (header.Magic != Magic || header.Version != Version || std::has_single_bit(header.Alignment) == false)
+			return malformed();
+
+		const auto entriesEnd = sizeof(AssetArchiveHeader) + (uint64_t)header.EntryCount * sizeof(AssetArchiveEntry);
+		if (entriesEnd > data.size() || header.NamesOffset < entriesEnd || header.NamesSize > data.size() - header.NamesOffset)
+			return malformed();
+
+		const auto entries = std::span(reinterpret_cast<const AssetArchiveEntry*>(data.data() + sizeof(AssetArchiveHeader)), header.EntryCount);
+		for (const auto& entry : entries)
+		{
+			if (entry.Offset > data.size() || entry.Size > data.size() - entry.Offset || (uint64_t)entry.NameOffset + entry.NameLength > header.NamesSize)
+				return malformed();
+		}
+
+		m_entries = entries;
+		m_names = reinterpret_cast<const char*>(data.data() + header.NamesOffset);
+		return true;
+	}
+
+	void AssetArchive::Close()
+	{
+		m_entries = {};
+		m_names = nullptr;
+		m_file.Close();
+	}
+
+	std::span<const std::byte> AssetArchive::Find(std::string_view name) const
+	{
+		const auto hash = HashName(name);
+		auto it = std::ranges::lower_bound(m_entries, hash, {}, &AssetArchiveEntry::NameHash);
+
+		// Equal hashes are adjacent, the names settle collisions
+		for (; it != m_entries.end() && it->NameHash == hash; ++it)
+		{
+			const auto index = (uint32_t)(it - m_entries.begin());
+			if (GetName(index) == name)
+				return GetData(index);
+		}
+
+		return {};
+	}
+
+	std::string_view AssetArchive::GetName(uint32_t entry) const
+	{
+		const auto& archiveEntry = m_entries[entry];
+		return { m_names + archiveEntry.NameOffset, archiveEntry.NameLength };
+	}
+
+	std::span<const std::byte> AssetArchive::GetData(uint32_t entry) const
+	{
+		const auto& archiveEntry = m_entries[entry];
+		return m_file.GetData().subspan(archiveEntry.Offset, archiveEntry.Size);
+	}
+
+	uint64_t AssetArchive::HashName(std::string_view name)
+	{
+		// FNV-1a, the archive format depends on it
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (const auto character : name)
+		{
+			hash ^= (uint8_t)character;
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	AssetArchiveWriter::AssetArchiveWriter(uint32_t alignment)
+		: m_alignment(std::bit_ceil(std::max(alignment, 4u)))
+	{
+	}
+
+	void AssetArchiveWriter::Add(std::string name, std::vector<std::byte> data)
+	{
+		if (std::ranges::any_of(m_blobs, [&](const Blob& blob) { return blob.Name == name; }))
+			throw std::runtime_error(std::format("Asset {} was added twice", name));
+
+		m_blobs.push_back({ std::move(name), std::move(data) });
+	}
+
+	bool AssetArchiveWriter::Write(const std::filesystem::path& path) const
+	{
+		auto header = AssetArchiveHeader();
+		header.Magic = AssetArchive::Magic;
+		header.Version = AssetArchive::Version;
+		header.EntryCount = (uint32_t)m_blobs.size();
+		header.Alignment = m_alignment;
+		header.NamesOffset = sizeof(AssetArchiveHeader) + m_blobs.size() * sizeof(AssetArchiveEntry);
+
+		// Blobs keep the order they were added in, only the table of contents is sorted for lookups
+		auto names = std::string();
+		auto entries = std::vector<AssetArchiveEntry>(m_blobs.size());
+		for (size_t i = 0; i < m_blobs.size(); i++)
+		{
+			entries[i].NameHash = AssetArchive::HashName(m_blobs[i].Name);
+			entries[i].Size = m_blobs[i].Data.size();
+			entries[i].NameOffset = (uint32_t)names.size();
+			entries[i].NameLength = (uint32_t)m_blobs[i].Name.size();
+			names += m_blobs[i].Name;
+		}
+
+		header.NamesSize = names.size();
+
+		auto offset = AlignUp(header.NamesOffset + header.NamesSize, m_alignment);
+		for (auto& entry : entries)
+		{
+			entry.Offset = offset;
+			offset = AlignUp(offset + entry.Size, m_alignment);
+		}
+
+		auto order = std::vector<size_t>(entries.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::ranges::stable_sort(order, {}, [&](size_t index) { return entries[index].NameHash; });
+
+		auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+		if (file.is_open() == false)
+			return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (const auto index : order)
+			file.write(reinterpret_cast<const char*>(&entries[index]), sizeof(AssetArchiveEntry));
+
+		file.write(names.data(), (std::streamsize)names.size());
+
+		const auto padding = std::vector<char>(m_alignment, 0);
+		for (size_t i = 0; i < m_blobs.size(); i++)
+		{
+			const auto position = (uint64_t)file.tellp();
+			file.write(padding.data(), (std::streamsize)(entries[i].Offset - position));
+			file.write(reinterpret_cast<const char*>(m_blobs[i].Data.data()), (std::streamsize)m_blobs[i].Data.size());
+		}
+
+		return file.good();
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace VEngine
+{
+	// On disk layout: header, entries sorted by name hash, name table, then the blobs at Alignment.
+	// The table of contents sits in the first pages, so a lookup never touches blob pages.
+	struct AssetArchiveHeader
+	{
+		uint32_t Magic = 0;
+		uint32_t Version = 0;
+		uint32_t EntryCount = 0;
+		uint32_t Alignment = 0;
+		uint64_t NamesOffset = 0;
+		uint64_t NamesSize = 0;
+	};
+
+	struct AssetArchiveEntry
+	{
+		uint64_t NameHash = 0;
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		uint32_t NameOffset = 0;
+		uint32_t NameLength = 0;
+	};
+
+	// Maps a packed archive once and hands out spans into the mapping, nothing is copied.
+	// Names are relative paths with '/' separators, e.g. "Resources/Shaders/triangle.vert.spv".
+	class AssetArchive
+	{
+	public:
+		static constexpr uint32_t Magic = 0x4b415056; // "VPAK"
+		static constexpr uint32_t Version = 1;
+
+		// Cache line aligned blobs, which also satisfies SPIR-V and staging copies
+		static constexpr uint32_t DefaultAlignment = 64;
+
+		AssetArchive() = default;
+		AssetArchive(const AssetArchive&) = delete;
+		AssetArchive(AssetArchive&&) = delete;
+
+		// Validates the header and table of contents, false if the file is missing or malformed
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		bool IsOpen() const { return m_file.IsOpen(); }
+
+		// Empty span when the archive has no such entry. Spans stay valid until Close.
+		std::span<const std::byte> Find(std::string_view name) const;
+
+		uint32_t GetEntryCount() const { return (uint32_t)m_entries.size(); }
+		std::string_view GetName(uint32_t entry) const;
+		std::span<const std::byte> GetData(uint32_t entry) const;
+
+		static uint64_t HashName(std::string_view name);
+
+	private:
+		MappedFile m_file;
+		std::span<const AssetArchiveEntry> m_entries;
+		const char* m_names = nullptr;
+	};
+
+	// Collects blobs in memory and writes the archive in one go, used by the packer
+	class AssetArchiveWriter
+	{
+	public:
+		explicit AssetArchiveWriter(uint32_t alignment = AssetArchive::DefaultAlignment);
+
+		// Throws when the name is already taken
+		void Add(std::string name, std::vector<std::byte> data);
+
+		bool Write(const std::filesystem::path& path) const;
+
+		uint32_t GetEntryCount() const { return (uint32_t)m_blobs.size(); }
+
+	private:
+		struct Blob
+		{
+			std::string Name;
+			std::vector<std::byte> Data;
+		};
+
+		uint32_t m_alignment = AssetArchive::DefaultAlignment;
+		std::vector<Blob> m_blobs;
+	};
+}
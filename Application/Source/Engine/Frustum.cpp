@@ -0,0 +1,41 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+namespace VEngine
+{
+	Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+	{
+		// Rows of the matrix, glm stores columns
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+		auto frustum = Frustum();
+		frustum.Planes[0] = rows[3] + rows[0];
+		frustum.Planes[1] = rows[3] - rows[0];
+		frustum.Planes[2] = rows[3] + rows[1];
+		frustum.Planes[3] = rows[3] - rows[1];
+		frustum.Planes[4] = rows[2];
+		frustum.Planes[5] = rows[3] - rows[2];
+
+		for (auto& plane : frustum.Planes)
+		{
+			const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			plane = plane / length;
+		}
+
+		return frustum;
+	}
+
+	bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+	{
+		for (const auto& plane : Planes)
+		{
+			if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+				return false;
+		}
+
+		return true;
+	}
+}
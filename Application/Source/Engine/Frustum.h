@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+namespace VEngine 
+{
+	// Planes point inwards, xyz is the normalized normal and w the distance, so dot(plane, point) >= 0 is inside
+	struct Frustum
+	{
+		glm::vec4 Planes[6];
+
+		// Vulkan clip space, depth in [0, 1]
+		static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+		bool IntersectsSphere(const glm::vec3& center, float radius) const;
+	};
+}
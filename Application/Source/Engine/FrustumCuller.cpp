@@ -0,0 +1,323 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define VENGINE_CULLING_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC emits any intrinsic, GCC and Clang need the instruction set enabled per function
+#if defined(VENGINE_CULLING_X64) && !defined(_MSC_VER)
+#define VENGINE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define VENGINE_TARGET_AVX2
+#endif
+
+namespace VEngine
+{
+	// Planes with the absolute normal precomputed, the box's projected radius onto the normal is dot(abs(normal), extent)
+	struct CullingPlane
+	{
+		float X, Y, Z, W;
+		float AbsX, AbsY, AbsZ;
+	};
+
+	static void GetCullingPlanes(const Frustum& frustum, CullingPlane (&planes)[6])
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			const auto& plane = frustum.Planes[i];
+			planes[i] = { plane.x, plane.y, plane.z, plane.w, std::abs(plane.x), std::abs(plane.y), std::abs(plane.z) };
+		}
+	}
+
+	// Every kernel evaluates the same expressions in the same order, so they agree bit for bit
+	static uint32_t CullScalar(const CullingBounds& bounds, const CullingPlane (&planes)[6], uint32_t first, uint32_t count, uint32_t* output)
+	{
+		const auto* centerX = bounds.GetCenterX().data();
+		const auto* centerY = bounds.GetCenterY().data();
+		const auto* centerZ = bounds.GetCenterZ().data();
+		const auto* extentX = bounds.GetExtentX().data();
+		const auto* extentY = bounds.GetExtentY().data();
+		const auto* extentZ = bounds.GetExtentZ().data();
+
+		uint32_t written = 0;
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			bool inside = true;
+			for (const auto& plane : planes)
+			{
+				const float distance = plane.X * centerX[i] + plane.Y * centerY[i] + plane.Z * centerZ[i] + plane.W;
+				const float radius = plane.AbsX * extentX[i] + plane.AbsY * extentY[i] + plane.AbsZ * extentZ[i];
+				inside &= distance + radius >= 0.0f;
+			}
+
+			// Branchless, the index is always stored and only kept when inside
+			output[written] = i;
+			written += inside ? 1 : 0;
+		}
+
+		return written;
+	}
+
+#ifdef VENGINE_CULLING_X64
+	// Branchless like the scalar kernel, visibility is close to random in index order and a bit scan loop mispredicts
+	static uint32_t WriteMask(uint32_t mask, uint32_t base, uint32_t width, uint32_t* output)
+	{
+		uint32_t written = 0;
+		for (uint32_t lane = 0; lane < width; lane++)
+		{
+			output[written] = base + lane;
+			written += (mask >> lane) & 1;
+		}
+
+		return written;
+	}
+
+	// Lane indices of the set bits of every 8 bit mask, packed to the front
+	static constexpr auto CompactTable = []
+	{
+		std::array<std::array<uint32_t, 8>, 256> table = {};
+		for (uint32_t mask = 0; mask < 256; mask++)
+		{
+			uint32_t count = 0;
+			for (uint32_t lane = 0; lane < 8; lane++)
+			{
+				if (mask & (1u << lane))
+					table[mask][count++] = lane;
+			}
+		}
+
+		return table;
+	}();
+
+	static uint32_t CullSse(const CullingBounds& bounds, const CullingPlane (&planes)[6], uint32_t first, uint32_t count, uint32_t* output)
+	{
+		const auto* centerX = bounds.GetCenterX().data();
+		const auto* centerY = bounds.GetCenterY().data();
+		const auto* centerZ = bounds.GetCenterZ().data();
+		const auto* extentX = bounds.GetExtentX().data();
+		const auto* extentY = bounds.GetExtentY().data();
+		const auto* extentZ = bounds.GetExtentZ().data();
+
+		const auto zero = _mm_setzero_ps();
+		const auto simdCount = count & ~3u;
+
+		uint32_t written = 0;
+		for (uint32_t i = first; i < first + simdCount; i += 4)
+		{
+			const auto cx = _mm_loadu_ps(centerX + i);
+			const auto cy = _mm_loadu_ps(centerY + i);
+			const auto cz = _mm_loadu_ps(centerZ + i);
+			const auto ex = _mm_loadu_ps(extentX + i);
+			const auto ey = _mm_loadu_ps(extentY + i);
+			const auto ez = _mm_loadu_ps(extentZ + i);
+
+			auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const auto& plane : planes)
+			{
+				auto distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.X), cx), _mm_mul_ps(_mm_set1_ps(plane.Y), cy)),
+					_mm_mul_ps(_mm_set1_ps(plane.Z), cz)), _mm_set1_ps(plane.W));
+				auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.AbsX), ex), _mm_mul_ps(_mm_set1_ps(plane.AbsY), ey)),
+					_mm_mul_ps(_mm_set1_ps(plane.AbsZ), ez));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			written += WriteMask((uint32_t)_mm_movemask_ps(inside), i, 4, output + written);
+		}
+
+		return written + CullScalar(bounds, planes, first + simdCount, count - simdCount, output + written);
+	}
+
+	VENGINE_TARGET_AVX2 static uint32_t CullAvx2(const CullingBounds& bounds, const CullingPlane (&planes)[6], uint32_t first, uint32_t count, uint32_t* output)
+	{
+		const auto* centerX = bounds.GetCenterX().data();
+		const auto* centerY = bounds.GetCenterY().data();
+		const auto* centerZ = bounds.GetCenterZ().data();
+		const auto* extentX = bounds.GetExtentX().data();
+		const auto* extentY = bounds.GetExtentY().data();
+		const auto* extentZ = bounds.GetExtentZ().data();
+
+		const auto zero = _mm256_setzero_ps();
+		const auto simdCount = count & ~7u;
+
+		uint32_t written = 0;
+		for (uint32_t i = first; i < first + simdCount; i += 8)
+		{
+			const auto cx = _mm256_loadu_ps(centerX + i);
+			const auto cy = _mm256_loadu_ps(centerY + i);
+			const auto cz = _mm256_loadu_ps(centerZ + i);
+			const auto ex = _mm256_loadu_ps(extentX + i);
+			const auto ey = _mm256_loadu_ps(extentY + i);
+			const auto ez = _mm256_loadu_ps(extentZ + i);
+
+			auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (const auto& plane : planes)
+			{
+				auto distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.X), cx), _mm256_mul_ps(_mm256_set1_ps(plane.Y), cy)),
+					_mm256_mul_ps(_mm256_set1_ps(plane.Z), cz)), _mm256_set1_ps(plane.W));
+				auto radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.AbsX), ex), _mm256_mul_ps(_mm256_set1_ps(plane.AbsY), ey)),
+					_mm256_mul_ps(_mm256_set1_ps(plane.AbsZ), ez));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+			}
+
+			// Visible lane indices are shuffled to the front and stored as a whole, the tail is overwritten by the next group.
+			// Stays inside the range since written never passes i - first.
+			const auto mask = (uint32_t)_mm256_movemask_ps(inside);
+			const auto lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(CompactTable[mask].data()));
+			const auto indices = _mm256_add_epi32(_mm256_set1_epi32((int)i), lanes);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + written), indices);
+			written += (uint32_t)std::popcount(mask);
+		}
+
+		return written + CullScalar(bounds, planes, first + simdCount, count - simdCount, output + written);
+	}
+
+	static bool HasAvx2()
+	{
+#ifdef _MSC_VER
+		int registers[4];
+		__cpuid(registers, 1);
+
+		// The OS has to save the ymm registers, OSXSAVE and XCR0 tell whether it does
+		const bool osxsave = (registers[2] & (1 << 27)) != 0;
+		const bool avx = (registers[2] & (1 << 28)) != 0;
+		if (osxsave == false || avx == false || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(registers, 7, 0);
+		return (registers[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	uint32_t CullingBounds::Add(const glm::vec3& center, const glm::vec3& extent)
+	{
+		m_centerX.push_back(center.x);
+		m_centerY.push_back(center.y);
+		m_centerZ.push_back(center.z);
+		m_extentX.push_back(extent.x);
+		m_extentY.push_back(extent.y);
+		m_extentZ.push_back(extent.z);
+		return GetCount() - 1;
+	}
+
+	void CullingBounds::Set(uint32_t index, const glm::vec3& center, const glm::vec3& extent)
+	{
+		m_centerX[index] = center.x;
+		m_centerY[index] = center.y;
+		m_centerZ[index] = center.z;
+		m_extentX[index] = extent.x;
+		m_extentY[index] = extent.y;
+		m_extentZ[index] = extent.z;
+	}
+
+	void CullingBounds::Reserve(uint32_t count)
+	{
+		for (auto* array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+			array->reserve(count);
+	}
+
+	void CullingBounds::Clear()
+	{
+		for (auto* array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+			array->clear();
+	}
+
+	FrustumCuller::FrustumCuller(JobSystem& jobSystem)
+		: m_jobSystem(jobSystem)
+	{
+		m_kernel = GetBestKernel();
+	}
+
+	CullingKernel FrustumCuller::GetBestKernel()
+	{
+#ifdef VENGINE_CULLING_X64
+		static const bool avx2 = HasAvx2();
+		return avx2 ? CullingKernel::Avx2 : CullingKernel::Sse;
+#else
+		return CullingKernel::Scalar;
+#endif
+	}
+
+	bool FrustumCuller::IsSupported(CullingKernel kernel)
+	{
+		return kernel <= GetBestKernel();
+	}
+
+	const char* FrustumCuller::GetKernelName(CullingKernel kernel)
+	{
+		switch (kernel)
+		{
+		case CullingKernel::Sse:
+			return "SSE";
+		case CullingKernel::Avx2:
+			return "AVX2";
+		default:
+			return "Scalar";
+		}
+	}
+
+	void FrustumCuller::SetKernel(CullingKernel kernel)
+	{
+		m_kernel = IsSupported(kernel) ? kernel : GetBestKernel();
+	}
+
+	uint32_t FrustumCuller::CullRange(CullingKernel kernel, const CullingBounds& bounds, const Frustum& frustum, uint32_t first, uint32_t count, uint32_t* output)
+	{
+		CullingPlane planes[6];
+		GetCullingPlanes(frustum, planes);
+
+#ifdef VENGINE_CULLING_X64
+		if (kernel == CullingKernel::Avx2 && IsSupported(kernel))
+			return CullAvx2(bounds, planes, first, count, output);
+
+		if (kernel == CullingKernel::Sse)
+			return CullSse(bounds, planes, first, count, output);
+#endif
+
+		return CullScalar(bounds, planes, first, count, output);
+	}
+
+	void FrustumCuller::Cull(const CullingBounds& bounds, const Frustum& frustum, std::vector<uint32_t>& visible)
+	{
+		const auto count = bounds.GetCount();
+		visible.resize(count);
+
+		const auto chunkCount = (count + ChunkSize - 1) / ChunkSize;
+		if (chunkCount <= 1 || m_jobSystem.GetWorkerCount() == 0)
+		{
+			visible.resize(CullRange(m_kernel, bounds, frustum, 0, count, visible.data()));
+			return;
+		}
+
+		m_chunkVisible.resize(chunkCount);
+
+		auto done = JobCounter();
+		m_jobSystem.ParallelFor(count, ChunkSize, [&, output = visible.data()](uint32_t first, uint32_t rangeCount)
+		{
+			m_chunkVisible[first / ChunkSize] = CullRange(m_kernel, bounds, frustum, first, rangeCount, output + first);
+		}, &done);
+		m_jobSystem.Wait(done);
+
+		// Each chunk wrote its indices at its own start, close the gaps between them
+		uint32_t written = m_chunkVisible[0];
+		for (uint32_t chunk = 1; chunk < chunkCount; chunk++)
+		{
+			std::memmove(visible.data() + written, visible.data() + chunk * ChunkSize, m_chunkVisible[chunk] * sizeof(uint32_t));
+			written += m_chunkVisible[chunk];
+		}
+
+		visible.resize(written);
+	}
+}
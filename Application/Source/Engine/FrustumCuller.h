@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "Frustum.h"
+#include "JobSystem.h"
+
+namespace VEngine
+{
+	// Aligned std::vector storage, so chunk aligned SIMD loads never straddle a cache line
+	template <typename T, size_t Alignment>
+	struct AlignedAllocator
+	{
+		using value_type = T;
+
+		template <typename U>
+		struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+		AlignedAllocator() = default;
+
+		template <typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+		T* allocate(size_t count) { return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment))); }
+		void deallocate(T* pointer, size_t) { ::operator delete(pointer, std::align_val_t(Alignment)); }
+
+		template <typename U>
+		bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+	};
+
+	// Axis aligned boxes as structure of arrays, one component per array so a kernel loads eight boxes' x with one instruction
+	class CullingBounds
+	{
+	public:
+		static constexpr size_t Alignment = 32;
+		using Array = std::vector<float, AlignedAllocator<float, Alignment>>;
+
+		uint32_t Add(const glm::vec3& center, const glm::vec3& extent);
+		void Set(uint32_t index, const glm::vec3& center, const glm::vec3& extent);
+		void Reserve(uint32_t count);
+		void Clear();
+
+		uint32_t GetCount() const { return (uint32_t)m_centerX.size(); }
+
+		const Array& GetCenterX() const { return m_centerX; }
+		const Array& GetCenterY() const { return m_centerY; }
+		const Array& GetCenterZ() const { return m_centerZ; }
+		const Array& GetExtentX() const { return m_extentX; }
+		const Array& GetExtentY() const { return m_extentY; }
+		const Array& GetExtentZ() const { return m_extentZ; }
+
+	private:
+		Array m_centerX;
+		Array m_centerY;
+		Array m_centerZ;
+		Array m_extentX;
+		Array m_extentY;
+		Array m_extentZ;
+	};
+
+	enum class CullingKernel
+	{
+		Scalar,
+		Sse,
+		Avx2
+	};
+
+	// Tests CullingBounds against a frustum in chunks run as jobs, the calling thread works on chunks while it waits.
+	// Every kernel produces the same visible list, so the scalar one doubles as the reference.
+	class FrustumCuller
+	{
+	public:
+		// Bounds per chunk, a multiple of every kernel's width so chunks start aligned
+		static constexpr uint32_t ChunkSize = 16384;
+
+		// Shares the job system's workers, a job system without workers culls on the calling thread only
+		explicit FrustumCuller(JobSystem& jobSystem);
+		FrustumCuller(const FrustumCuller&) = delete;
+		FrustumCuller(FrustumCuller&&) = delete;
+
+		// Widest kernel the CPU runs, SSE is part of x64 and AVX2 is detected at runtime
+		static CullingKernel GetBestKernel();
+		static bool IsSupported(CullingKernel kernel);
+		static const char* GetKernelName(CullingKernel kernel);
+
+		// Unsupported kernels fall back to the best supported one
+		void SetKernel(CullingKernel kernel);
+		CullingKernel GetKernel() const { return m_kernel; }
+		uint32_t GetThreadCount() const { return m_jobSystem.GetWorkerCount() + 1; }
+
+		// Indices of the boxes intersecting the frustum in ascending order, visible is resized to fit
+		void Cull(const CullingBounds& bounds, const Frustum& frustum, std::vector<uint32_t>& visible);
+
+		// Single threaded, writes at most count indices to output and returns how many it wrote
+		static uint32_t CullRange(CullingKernel kernel, const CullingBounds& bounds, const Frustum& frustum, uint32_t first, uint32_t count, uint32_t* output);
+
+	private:
+		JobSystem& m_jobSystem;
+		CullingKernel m_kernel = CullingKernel::Scalar;
+
+		// Indices each chunk of the current Cull call wrote, kept to not reallocate every frame
+		std::vector<uint32_t> m_chunkVisible;
+	};
+}
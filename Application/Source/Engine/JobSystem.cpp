@@ -0,0 +1,225 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace VEngine
+{
+	// Deque of the calling thread, only valid for workers of t_jobSystem
+	thread_local const JobSystem* t_jobSystem = nullptr;
+	thread_local uint32_t t_queueIndex = 0;
+
+	JobSystem::JobSystem(uint32_t workerCount)
+	{
+		m_mainThread = std::this_thread::get_id();
+
+		if (workerCount == 0)
+			workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+		m_queues.reserve(workerCount + 1);
+		for (uint32_t i = 0; i <= workerCount; i++)
+			m_queues.push_back(std::make_unique<WorkerQueue>());
+
+		m_workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard lock(m_sleepMutex);
+			m_stopping = true;
+		}
+
+		m_workAvailable.notify_all();
+		for (auto& worker : m_workers)
+			worker.join();
+	}
+
+	void JobSystem::Schedule(Job job, JobCounter* signal, JobCounter* dependency)
+	{
+		if (signal != nullptr)
+			signal->m_value.fetch_add(1, std::memory_order_relaxed);
+
+		if (dependency != nullptr)
+		{
+			// Checked under the lock the last finishing job takes, so the job is either queued now or by that job
+			std::lock_guard lock(dependency->m_mutex);
+			if (dependency->m_value.load(std::memory_order_acquire) != 0)
+			{
+				dependency->m_continuations.push_back({ std::move(job), signal });
+				return;
+			}
+		}
+
+		Push({ std::move(job), signal });
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t chunkSize, std::function<void(uint32_t first, uint32_t count)> function, JobCounter* signal)
+	{
+		chunkSize = std::max(chunkSize, 1u);
+
+		const auto shared = std::make_shared<std::function<void(uint32_t, uint32_t)>>(std::move(function));
+		for (uint32_t first = 0; first < count; first += chunkSize)
+		{
+			const auto chunk = std::min(chunkSize, count - first);
+			Schedule([shared, first, chunk] { (*shared)(first, chunk); }, signal);
+		}
+	}
+
+	void JobSystem::ScheduleOnMainThread(Job job, JobCounter* signal)
+	{
+		if (signal != nullptr)
+			signal->m_value.fetch_add(1, std::memory_order_relaxed);
+
+		std::lock_guard lock(m_mainThreadMutex);
+		m_mainThreadJobs.push_back({ std::move(job), signal });
+	}
+
+	void JobSystem::PumpMainThread()
+	{
+		if (IsMainThread() == false)
+			return;
+
+		while (true)
+		{
+			auto job = QueuedJob();
+			{
+				std::lock_guard lock(m_mainThreadMutex);
+				if (m_mainThreadJobs.empty())
+					return;
+
+				job = std::move(m_mainThreadJobs.front());
+				m_mainThreadJobs.pop_front();
+			}
+
+			job.Function();
+			Finish(job.Signal);
+		}
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		const auto queueIndex = GetQueueIndex();
+		const bool mainThread = IsMainThread();
+
+		while (counter.IsDone() == false)
+		{
+			if (mainThread)
+				PumpMainThread();
+
+			if (TryRunOne(queueIndex))
+				continue;
+
+			// Nothing to help with, sleep briefly so new jobs and main thread jobs are still picked up
+			std::unique_lock lock(counter.m_mutex);
+			counter.m_done.wait_for(lock, std::chrono::microseconds(200), [&] { return counter.IsDone(); });
+		}
+
+		// The last job may still be inside Finish, the counter must not go away before it leaves
+		std::lock_guard lock(counter.m_mutex);
+	}
+
+	void JobSystem::WorkerLoop(uint32_t queueIndex)
+	{
+		t_jobSystem = this;
+		t_queueIndex = queueIndex;
+
+		while (true)
+		{
+			if (TryRunOne(queueIndex))
+				continue;
+
+			std::unique_lock lock(m_sleepMutex);
+			m_workAvailable.wait(lock, [&] { return m_stopping || m_queuedCount.load(std::memory_order_acquire) > 0; });
+
+			if (m_stopping)
+				return;
+		}
+	}
+
+	void JobSystem::Push(QueuedJob job)
+	{
+		auto& queue = *m_queues[GetQueueIndex()];
+		{
+			// Counted under the queue lock, so a thief can never take the job before it was counted
+			std::lock_guard lock(queue.Mutex);
+			queue.Jobs.push_back(std::move(job));
+			m_queuedCount.fetch_add(1, std::memory_order_release);
+		}
+
+		// Empty critical section orders the push against a worker checking the count before it sleeps
+		{
+			std::lock_guard lock(m_sleepMutex);
+		}
+
+		m_workAvailable.notify_one();
+	}
+
+	bool JobSystem::TryRunOne(uint32_t queueIndex)
+	{
+		auto job = QueuedJob();
+		bool found = false;
+
+		// Own deque from the back, the most recent job is the one most likely still in cache
+		{
+			auto& queue = *m_queues[queueIndex];
+			std::lock_guard lock(queue.Mutex);
+			if (queue.Jobs.empty() == false)
+			{
+				job = std::move(queue.Jobs.back());
+				queue.Jobs.pop_back();
+				found = true;
+			}
+		}
+
+		// Steal the oldest job of another deque, starting next to our own so thieves spread out
+		const auto queueCount = (uint32_t)m_queues.size();
+		for (uint32_t i = 1; i < queueCount && found == false; i++)
+		{
+			auto& queue = *m_queues[(queueIndex + i) % queueCount];
+			std::lock_guard lock(queue.Mutex);
+			if (queue.Jobs.empty() == false)
+			{
+				job = std::move(queue.Jobs.front());
+				queue.Jobs.pop_front();
+				found = true;
+			}
+		}
+
+		if (found == false)
+			return false;
+
+		m_queuedCount.fetch_sub(1, std::memory_order_relaxed);
+		job.Function();
+		Finish(job.Signal);
+		return true;
+	}
+
+	void JobSystem::Finish(JobCounter* signal)
+	{
+		if (signal == nullptr)
+			return;
+
+		auto continuations = std::vector<JobCounter::Continuation>();
+		{
+			// Waiters take the same lock before they return, the counter stays alive until this scope is left
+			std::lock_guard lock(signal->m_mutex);
+			if (signal->m_value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+
+			continuations.swap(signal->m_continuations);
+			signal->m_done.notify_all();
+		}
+
+		for (auto& continuation : continuations)
+			Push({ std::move(continuation.Function), continuation.Signal });
+	}
+
+	uint32_t JobSystem::GetQueueIndex() const
+	{
+		// Threads outside the pool share the main thread's deque, every deque is locked anyway
+		return t_jobSystem == this ? t_queueIndex : (uint32_t)m_queues.size() - 1;
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VEngine
+{
+	using Job = std::function<void()>;
+
+	// Unfinished jobs that signal it, jobs depending on it start once it drops to zero. Reusable once done.
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter(JobCounter&&) = delete;
+
+		bool IsDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		struct Continuation
+		{
+			Job Function;
+			JobCounter* Signal = nullptr;
+		};
+
+		std::atomic<uint32_t> m_value = 0;
+
+		// Guards the continuations and the zero transition, never held while a job runs
+		std::mutex m_mutex;
+		std::condition_variable m_done;
+		std::vector<Continuation> m_continuations;
+	};
+
+	// Work stealing scheduler: every worker pops its own deque from the back and steals from the front of the others.
+	// The thread that creates it is the main thread, it owns a deque too and works on jobs while it waits.
+	class JobSystem
+	{
+	public:
+		// Zero picks one worker per hardware thread besides the main thread
+		explicit JobSystem(uint32_t workerCount = 0);
+		JobSystem(const JobSystem&) = delete;
+		JobSystem(JobSystem&&) = delete;
+
+		// Jobs still queued are dropped, wait on their counters first
+		~JobSystem();
+
+		uint32_t GetWorkerCount() const { return (uint32_t)m_workers.size(); }
+		bool IsMainThread() const { return std::this_thread::get_id() == m_mainThread; }
+
+		// Any thread. Signal counts the job until it finished, the job only starts once dependency is done.
+		void Schedule(Job job, JobCounter* signal = nullptr, JobCounter* dependency = nullptr);
+
+		// Runs function(first, count) over [0, count) in chunks of at most chunkSize
+		void ParallelFor(uint32_t count, uint32_t chunkSize, std::function<void(uint32_t first, uint32_t count)> function, JobCounter* signal);
+
+		// For APIs bound to the main thread like GLFW, run from Wait and PumpMainThread on the main thread
+		void ScheduleOnMainThread(Job job, JobCounter* signal = nullptr);
+		void PumpMainThread();
+
+		// Works on other jobs until the counter is done instead of blocking, the main thread also runs its own jobs
+		void Wait(JobCounter& counter);
+
+	private:
+		struct QueuedJob
+		{
+			Job Function;
+			JobCounter* Signal = nullptr;
+		};
+
+		// Padded so workers pushing to their own deque never share a cache line
+		struct alignas(64) WorkerQueue
+		{
+			std::mutex Mutex;
+			std::deque<QueuedJob> Jobs;
+		};
+
+		void WorkerLoop(uint32_t queueIndex);
+		void Push(QueuedJob job);
+		bool TryRunOne(uint32_t queueIndex);
+		void Finish(JobCounter* signal);
+		uint32_t GetQueueIndex() const;
+
+		// One deque per worker, the last one belongs to the main thread and takes jobs from outside the pool
+		std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+		std::vector<std::thread> m_workers;
+		std::thread::id m_mainThread;
+
+		std::mutex m_mainThreadMutex;
+		std::deque<QueuedJob> m_mainThreadJobs;
+
+		// Workers sleep while nothing is queued anywhere
+		std::mutex m_sleepMutex;
+		std::condition_variable m_workAvailable;
+		std::atomic<uint32_t> m_queuedCount = 0;
+		bool m_stopping = false;
+	};
+}
@@ -0,0 +1,128 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VEngine
+{
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		Close();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_open = std::exchange(other.m_open, false);
+#ifdef _WIN32
+		m_file = std::exchange(other.m_file, nullptr);
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+
+		return *this;
+	}
+
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+#ifdef _WIN32
+		const auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		auto size = LARGE_INTEGER();
+		if (GetFileSizeEx(file, &size) == FALSE)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_file = file;
+		m_size = (size_t)size.QuadPart;
+		m_open = true;
+
+		// Zero sized files can't be mapped
+		if (m_size == 0)
+			return true;
+
+		m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping != nullptr)
+			m_data = static_cast<const std::byte*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+		const auto file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat status = {};
+		if (fstat(file, &status) != 0)
+		{
+			close(file);
+			return false;
+		}
+
+		m_size = (size_t)status.st_size;
+		m_open = true;
+
+		// The mapping keeps its own reference to the file
+		if (m_size != 0)
+		{
+			const auto data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data != MAP_FAILED)
+				m_data = static_cast<const std::byte*>(data);
+		}
+
+		close(file);
+#endif
+
+		if (m_size != 0 && m_data == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		if (m_file != nullptr)
+			CloseHandle(m_file);
+
+		m_mapping = nullptr;
+		m_file = nullptr;
+#else
+		if (m_data != nullptr)
+			munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+
+		m_data = nullptr;
+		m_size = 0;
+		m_open = false;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace VEngine
+{
+	// Read-only mapping of a whole file, pages are faulted in on first access
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile();
+
+		// False when the file doesn't exist or can't be mapped, empty files map to an empty span
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		bool IsOpen() const { return m_open; }
+		std::span<const std::byte> GetData() const { return { m_data, m_size }; }
+
+	private:
+		const std::byte* m_data = nullptr;
+		size_t m_size = 0;
+		bool m_open = false;
+
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,104 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include <glm/geometric.hpp>
+
+namespace VEngine
+{
+	float MeshData::GetRadius() const
+	{
+		float radius = 0.0f;
+		for (const auto& vertex : Vertices)
+			radius = std::max(radius, glm::length(vertex.Position));
+
+		return radius;
+	}
+
+	MeshData MeshData::CreateCube(float halfExtent)
+	{
+		// Normal and two tangents with u x v = normal, so the corners below run counter-clockwise seen from outside
+		struct Face
+		{
+			glm::vec3 Normal;
+			glm::vec3 U;
+			glm::vec3 V;
+		};
+
+		const Face faces[] =
+		{
+			{ {  1.0f,  0.0f,  0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+			{ { -1.0f,  0.0f,  0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f } },
+			{ {  0.0f,  1.0f,  0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f } },
+			{ {  0.0f, -1.0f,  0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+			{ {  0.0f,  0.0f,  1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+			{ {  0.0f,  0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } },
+		};
+
+		const glm::vec2 corners[] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+
+		auto mesh = MeshData();
+		for (const auto& face : faces)
+		{
+			const auto base = (uint32_t)mesh.Vertices.size();
+			for (const auto& corner : corners)
+			{
+				auto vertex = MeshVertex();
+				vertex.Position = (face.Normal + face.U * corner.x + face.V * corner.y) * halfExtent;
+				vertex.Normal = face.Normal;
+				vertex.Uv = glm::vec2(corner.x * 0.5f + 0.5f, corner.y * 0.5f + 0.5f);
+				mesh.Vertices.push_back(vertex);
+			}
+
+			mesh.Indices.insert(mesh.Indices.end(), { base, base + 3, base + 2, base, base + 2, base + 1 });
+		}
+
+		return mesh;
+	}
+
+	MeshData MeshData::CreateSphere(float radius, uint32_t rings, uint32_t segments)
+	{
+		rings = std::max(rings, 2u);
+		segments = std::max(segments, 3u);
+
+		// The seam column is duplicated so uvs don't wrap
+		auto mesh = MeshData();
+		for (uint32_t ring = 0; ring <= rings; ring++)
+		{
+			const float theta = std::numbers::pi_v<float> * (float)ring / (float)rings;
+			for (uint32_t segment = 0; segment <= segments; segment++)
+			{
+				const float phi = 2.0f * std::numbers::pi_v<float> * (float)segment / (float)segments;
+				const auto normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+				auto vertex = MeshVertex();
+				vertex.Position = normal * radius;
+				vertex.Normal = normal;
+				vertex.Uv = glm::vec2((float)segment / (float)segments, (float)ring / (float)rings);
+				mesh.Vertices.push_back(vertex);
+			}
+		}
+
+		// Poles collapse one triangle of each quad, those are left out
+		const auto columns = segments + 1;
+		for (uint32_t ring = 0; ring < rings; ring++)
+		{
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				const auto a = ring * columns + segment;
+				const auto b = a + 1;
+				const auto c = a + columns + 1;
+				const auto d = a + columns;
+
+				if (ring != 0)
+					mesh.Indices.insert(mesh.Indices.end(), { a, c, b });
+				if (ring != rings - 1)
+					mesh.Indices.insert(mesh.Indices.end(), { a, d, c });
+			}
+		}
+
+		return mesh;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+namespace VEngine
+{
+	// Full precision vertex as produced by loaders and generators, 32 bytes
+	struct MeshVertex
+	{
+		glm::vec3 Position;
+		glm::vec3 Normal;
+		glm::vec2 Uv;
+	};
+
+	// Triangles are wound clockwise seen from outside, the pipelines use VK_FRONT_FACE_CLOCKWISE
+	struct MeshData
+	{
+		std::vector<MeshVertex> Vertices;
+		std::vector<uint32_t> Indices;
+
+		// Bounding sphere radius around the mesh origin
+		float GetRadius() const;
+
+		static MeshData CreateCube(float halfExtent);
+		static MeshData CreateSphere(float radius, uint32_t rings, uint32_t segments);
+	};
+}
@@ -0,0 +1,291 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/geometric.hpp>
+
+namespace VEngine
+{
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	// Tuning from Forsyth's "Linear-Speed Vertex Cache Optimisation", the cache size is an LRU model, not the hardware's
+	static constexpr uint32_t ForsythCacheSize = 32;
+	static constexpr float ForsythCacheDecayPower = 1.5f;
+	static constexpr float ForsythLastTriangleScore = 0.75f;
+	static constexpr float ForsythValenceBoostScale = 2.0f;
+	static constexpr float ForsythValenceBoostPower = 0.5f;
+
+	static float ForsythVertexScore(int32_t cachePosition, uint32_t remainingValence)
+	{
+		if (remainingValence == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The last triangle's vertices get a fixed score so the next one doesn't just reuse the same edge
+			if (cachePosition < 3)
+				score = ForsythLastTriangleScore;
+			else
+				score = std::pow(1.0f - (float)(cachePosition - 3) / (float)(ForsythCacheSize - 3), ForsythCacheDecayPower);
+		}
+
+		// Vertices with few triangles left are finished first, so they don't linger as isolated triangles
+		return score + ForsythValenceBoostScale * std::pow((float)remainingValence, -ForsythValenceBoostPower);
+	}
+
+	void MeshOptimizer::Optimize(MeshData& mesh)
+	{
+		OptimizeVertexCache(mesh.Indices, (uint32_t)mesh.Vertices.size());
+		OptimizeOverdraw(mesh.Indices, mesh.Vertices);
+		OptimizeVertexFetch(mesh.Vertices, mesh.Indices);
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount)
+	{
+		const auto triangleCount = (uint32_t)(indices.size() / 3);
+		if (triangleCount == 0)
+			return;
+
+		// Triangles adjacent to each vertex, the first remainingValence entries are the ones not emitted yet
+		auto remainingValence = std::vector<uint32_t>(vertexCount, 0);
+		for (const auto index : indices)
+			remainingValence[index]++;
+
+		auto adjacencyOffsets = std::vector<uint32_t>(vertexCount + 1, 0);
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingValence[vertex];
+
+		auto adjacency = std::vector<uint32_t>(indices.size());
+		auto adjacencyCursor = std::vector<uint32_t>(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+				adjacency[adjacencyCursor[indices[triangle * 3 + corner]]++] = triangle;
+		}
+
+		auto cachePositions = std::vector<int32_t>(vertexCount, -1);
+		auto vertexScores = std::vector<float>(vertexCount);
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			vertexScores[vertex] = ForsythVertexScore(-1, remainingValence[vertex]);
+
+		const auto scoreTriangle = [&](uint32_t triangle)
+		{
+			return vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+		};
+
+		auto triangleScores = std::vector<float>(triangleCount);
+		auto emitted = std::vector<bool>(triangleCount, false);
+		auto bestTriangle = 0u;
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			triangleScores[triangle] = scoreTriangle(triangle);
+			if (triangleScores[triangle] > triangleScores[bestTriangle])
+				bestTriangle = triangle;
+		}
+
+		auto output = std::vector<uint32_t>();
+		output.reserve(indices.size());
+
+		uint32_t cache[ForsythCacheSize + 3];
+		uint32_t cacheCount = 0;
+		uint32_t nextUnemitted = 0;
+
+		while (output.size() < indices.size())
+		{
+			// Nothing in the cache has triangles left, continue with whatever comes next in the original order
+			if (bestTriangle == InvalidIndex)
+			{
+				while (emitted[nextUnemitted])
+					nextUnemitted++;
+
+				bestTriangle = nextUnemitted;
+			}
+
+			const uint32_t triangleVertices[3] = { indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+			emitted[bestTriangle] = true;
+			output.insert(output.end(), std::begin(triangleVertices), std::end(triangleVertices));
+
+			for (const auto vertex : triangleVertices)
+			{
+				const auto begin = adjacency.begin() + adjacencyOffsets[vertex];
+				const auto end = begin + remainingValence[vertex];
+				const auto it = std::find(begin, end, bestTriangle);
+				if (it != end)
+				{
+					*it = *(end - 1);
+					remainingValence[vertex]--;
+				}
+			}
+
+			// Emitted vertices move to the front, everything past the cache size falls out
+			uint32_t newCache[ForsythCacheSize + 3];
+			uint32_t newCacheCount = 0;
+			for (const auto vertex : triangleVertices)
+				newCache[newCacheCount++] = vertex;
+
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				const auto vertex = cache[i];
+				if (vertex != triangleVertices[0] && vertex != triangleVertices[1] && vertex != triangleVertices[2])
+					newCache[newCacheCount++] = vertex;
+			}
+
+			for (uint32_t i = 0; i < newCacheCount; i++)
+			{
+				const auto vertex = newCache[i];
+				cachePositions[vertex] = i < ForsythCacheSize ? (int32_t)i : -1;
+				vertexScores[vertex] = ForsythVertexScore(cachePositions[vertex], remainingValence[vertex]);
+			}
+
+			cacheCount = std::min(newCacheCount, ForsythCacheSize);
+			std::copy(newCache, newCache + cacheCount, cache);
+
+			// Only triangles touching changed vertices changed score, the best of them is emitted next
+			bestTriangle = InvalidIndex;
+			auto bestScore = -1.0f;
+			for (uint32_t i = 0; i < newCacheCount; i++)
+			{
+				const auto vertex = newCache[i];
+				const auto begin = adjacencyOffsets[vertex];
+				for (uint32_t j = begin; j < begin + remainingValence[vertex]; j++)
+				{
+					const auto triangle = adjacency[j];
+					triangleScores[triangle] = scoreTriangle(triangle);
+					if (triangleScores[triangle] > bestScore)
+					{
+						bestScore = triangleScores[triangle];
+						bestTriangle = triangle;
+					}
+				}
+			}
+		}
+
+		std::ranges::copy(output, indices.begin());
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(std::span<uint32_t> indices, std::span<const MeshVertex> vertices)
+	{
+		const auto triangleCount = (uint32_t)(indices.size() / 3);
+		if (triangleCount == 0 || vertices.empty())
+			return;
+
+		struct Cluster
+		{
+			uint32_t FirstTriangle = 0;
+			uint32_t TriangleCount = 0;
+			float SortKey = 0.0f;
+		};
+
+		auto meshCentroid = glm::vec3(0.0f);
+		for (const auto& vertex : vertices)
+			meshCentroid = meshCentroid + vertex.Position;
+
+		meshCentroid = meshCentroid / (float)vertices.size();
+
+		const auto restarts = FindCacheRestarts(indices, (uint32_t)vertices.size(), AnalyzeCacheSize);
+		auto clusters = std::vector<Cluster>(restarts.size());
+		for (size_t i = 0; i < restarts.size(); i++)
+		{
+			auto& cluster = clusters[i];
+			cluster.FirstTriangle = restarts[i];
+			cluster.TriangleCount = (i + 1 < restarts.size() ? restarts[i + 1] : triangleCount) - restarts[i];
+
+			// Vertex normals instead of face normals, so the key doesn't depend on the winding convention
+			auto centroid = glm::vec3(0.0f);
+			auto normal = glm::vec3(0.0f);
+			for (uint32_t index = cluster.FirstTriangle * 3; index < (cluster.FirstTriangle + cluster.TriangleCount) * 3; index++)
+			{
+				centroid = centroid + vertices[indices[index]].Position;
+				normal = normal + vertices[indices[index]].Normal;
+			}
+
+			centroid = centroid / (float)(cluster.TriangleCount * 3);
+
+			// Clusters facing away from the center occlude the rest of the mesh more often than they are occluded
+			const auto normalLength = glm::length(normal);
+			if (normalLength > 0.0f)
+				cluster.SortKey = glm::dot(centroid - meshCentroid, normal / normalLength);
+		}
+
+		std::ranges::stable_sort(clusters, [](const Cluster& a, const Cluster& b) { return a.SortKey > b.SortKey; });
+
+		auto output = std::vector<uint32_t>();
+		output.reserve(indices.size());
+		for (const auto& cluster : clusters)
+			output.insert(output.end(), indices.begin() + cluster.FirstTriangle * 3, indices.begin() + (cluster.FirstTriangle + cluster.TriangleCount) * 3);
+
+		std::ranges::copy(output, indices.begin());
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(std::vector<MeshVertex>& vertices, std::span<uint32_t> indices)
+	{
+		auto remap = std::vector<uint32_t>(vertices.size(), InvalidIndex);
+		auto reordered = std::vector<MeshVertex>();
+		reordered.reserve(vertices.size());
+
+		for (auto& index : indices)
+		{
+			if (remap[index] == InvalidIndex)
+			{
+				remap[index] = (uint32_t)reordered.size();
+				reordered.push_back(vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		vertices = std::move(reordered);
+	}
+
+	float MeshOptimizer::AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		const auto triangleCount = (uint32_t)(indices.size() / 3);
+		if (triangleCount == 0)
+			return 0.0f;
+
+		// A vertex is cached while fewer than cacheSize misses happened since it was inserted
+		auto timestamps = std::vector<uint32_t>(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+		uint32_t misses = 0;
+
+		for (const auto index : indices)
+		{
+			if (time - timestamps[index] > cacheSize)
+			{
+				timestamps[index] = time++;
+				misses++;
+			}
+		}
+
+		return (float)misses / (float)triangleCount;
+	}
+
+	std::vector<uint32_t> MeshOptimizer::FindCacheRestarts(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		auto timestamps = std::vector<uint32_t>(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+
+		auto restarts = std::vector<uint32_t>();
+		for (uint32_t triangle = 0; triangle < indices.size() / 3; triangle++)
+		{
+			uint32_t misses = 0;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const auto index = indices[triangle * 3 + corner];
+				if (time - timestamps[index] > cacheSize)
+				{
+					timestamps[index] = time++;
+					misses++;
+				}
+			}
+
+			// The first triangle opens a cluster even when it is degenerate, so every triangle belongs to one
+			if (misses == 3 || triangle == 0)
+				restarts.push_back(triangle);
+		}
+
+		return restarts;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.h"
+
+namespace VEngine
+{
+	// Offline style index and vertex reordering, run once per mesh before it is uploaded
+	class MeshOptimizer
+	{
+	public:
+		// Size of the simulated FIFO post-transform cache used for statistics
+		static constexpr uint32_t AnalyzeCacheSize = 16;
+
+		// Vertex cache, overdraw and vertex fetch optimization in that order
+		static void Optimize(MeshData& mesh);
+
+		// Forsyth's linear speed reordering, triangles that share recently used vertices are emitted together
+		static void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount);
+
+		// Splits the cache optimized list into clusters at cache restarts and draws outward facing clusters first.
+		// Keeps the cache efficiency of OptimizeVertexCache within each cluster.
+		static void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const MeshVertex> vertices);
+
+		// Orders vertices by first use and drops unreferenced ones, so the fetch walks memory linearly
+		static void OptimizeVertexFetch(std::vector<MeshVertex>& vertices, std::span<uint32_t> indices);
+
+		// Average cache misses per triangle, 0.5 is the practical optimum for regular grids and 3 the worst case
+		static float AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = AnalyzeCacheSize);
+
+	private:
+		// Triangle indices where the simulated cache missed all three vertices
+		static std::vector<uint32_t> FindCacheRestarts(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize);
+	};
+}
@@ -0,0 +1,138 @@
+#include "Profiler.h"
+
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <print>
+
+namespace VEngine
+{
+	struct ProfilerThreadBuffer
+	{
+		std::mutex Mutex;
+		std::vector<ProfilerZone> Zones;
+		uint32_t ThreadId = 0;
+	};
+
+	static std::mutex s_threadBuffersMutex;
+	static std::vector<std::shared_ptr<ProfilerThreadBuffer>> s_threadBuffers;
+	static std::atomic<uint32_t> s_nextThreadId = 0;
+
+	static ProfilerThreadBuffer& GetThreadBuffer()
+	{
+		// Each thread appends to its own buffer, the lock is only contended while a frame is collected
+		thread_local std::shared_ptr<ProfilerThreadBuffer> buffer = []
+		{
+			auto threadBuffer = std::make_shared<ProfilerThreadBuffer>();
+			threadBuffer->ThreadId = s_nextThreadId++;
+
+			std::lock_guard lock(s_threadBuffersMutex);
+			s_threadBuffers.push_back(threadBuffer);
+			return threadBuffer;
+		}();
+
+		return *buffer;
+	}
+
+	uint64_t Profiler::Now()
+	{
+		static const auto epoch = std::chrono::steady_clock::now();
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	void Profiler::BeginFrame()
+	{
+		s_frameNumber++;
+
+		if (IsEnabled() == false)
+			return;
+
+		s_currentFrame = ProfilerFrame();
+		s_currentFrame.FrameNumber = s_frameNumber;
+		s_currentFrame.StartNs = Now();
+	}
+
+	void Profiler::EndFrame()
+	{
+		if (IsEnabled() == false || s_currentFrame.FrameNumber != s_frameNumber)
+			return;
+
+		s_currentFrame.EndNs = Now();
+
+		{
+			std::lock_guard lock(s_threadBuffersMutex);
+			for (const auto& threadBuffer : s_threadBuffers)
+			{
+				std::lock_guard bufferLock(threadBuffer->Mutex);
+				s_currentFrame.CpuZones.insert(s_currentFrame.CpuZones.end(), threadBuffer->Zones.begin(), threadBuffer->Zones.end());
+				threadBuffer->Zones.clear();
+			}
+		}
+
+		s_history.push_back(std::move(s_currentFrame));
+		while (s_history.size() > HistorySize)
+			s_history.pop_front();
+	}
+
+	void Profiler::RecordCpuZone(const char* name, uint64_t startNs, uint64_t endNs)
+	{
+		auto& threadBuffer = GetThreadBuffer();
+
+		std::lock_guard lock(threadBuffer.Mutex);
+		threadBuffer.Zones.push_back({ name, startNs, endNs, threadBuffer.ThreadId });
+	}
+
+	void Profiler::SubmitGpuZones(uint64_t frameNumber, std::span<const ProfilerZone> zones)
+	{
+		for (auto& frame : s_history)
+		{
+			if (frame.FrameNumber != frameNumber)
+				continue;
+
+			frame.GpuZones.insert(frame.GpuZones.end(), zones.begin(), zones.end());
+			return;
+		}
+	}
+
+	bool Profiler::ExportChromeTrace(const std::filesystem::path& path)
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::println("Failed to open {} for the profiler trace", path.string());
+			return false;
+		}
+
+		// Chrome trace / Perfetto JSON, timestamps in microseconds, fixed so large ones keep their nanosecond digits
+		const auto writeZone = [&](const ProfilerZone& zone, uint32_t processId, bool& first)
+		{
+			file << (first ? "\n" : ",\n");
+			file << "{\"name\":\"" << zone.Name << "\",\"ph\":\"X\",\"pid\":" << processId << ",\"tid\":" << zone.ThreadId
+				<< std::format(",\"ts\":{:.3f},\"dur\":{:.3f}}}", (double)zone.StartNs / 1000.0, (double)(zone.EndNs - zone.StartNs) / 1000.0);
+			first = false;
+		};
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		file << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},";
+		file << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+		bool first = false;
+		for (const auto& frame : s_history)
+		{
+			writeZone({ "Frame", frame.StartNs, frame.EndNs, UINT32_MAX }, 0, first);
+
+			for (const auto& zone : frame.CpuZones)
+				writeZone(zone, 0, first);
+
+			for (const auto& zone : frame.GpuZones)
+				writeZone(zone, 1, first);
+		}
+
+		file << "\n]}\n";
+
+		std::println("Profiler trace with {} frames written to {}", s_history.size(), path.string());
+		return file.good();
+	}
+}
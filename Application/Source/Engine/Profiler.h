@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace VEngine 
+{
+	struct ProfilerZone
+	{
+		// Names must outlive the profiler, string literals in practice
+		const char* Name = nullptr;
+		uint64_t StartNs = 0;
+		uint64_t EndNs = 0;
+		uint32_t ThreadId = 0;
+	};
+
+	struct ProfilerFrame
+	{
+		uint64_t FrameNumber = 0;
+		uint64_t StartNs = 0;
+		uint64_t EndNs = 0;
+
+		std::vector<ProfilerZone> CpuZones;
+		std::vector<ProfilerZone> GpuZones;
+	};
+
+	class Profiler
+	{
+	public:
+		static constexpr size_t HistorySize = 240;
+
+		// Disabled zones cost one relaxed atomic load, so the profiler stays compiled into release builds
+		static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+		static void SetEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+
+		static uint64_t Now();
+		static uint64_t GetFrameNumber() { return s_frameNumber; }
+
+		static void BeginFrame();
+		static void EndFrame();
+
+		static void RecordCpuZone(const char* name, uint64_t startNs, uint64_t endNs);
+
+		// GPU results arrive a few frames late, they are attached to the frame that recorded them
+		static void SubmitGpuZones(uint64_t frameNumber, std::span<const ProfilerZone> zones);
+
+		static const std::deque<ProfilerFrame>& GetHistory() { return s_history; }
+		static bool ExportChromeTrace(const std::filesystem::path& path);
+
+	private:
+		inline static std::atomic<bool> s_enabled = false;
+
+		inline static uint64_t s_frameNumber = 0;
+		inline static ProfilerFrame s_currentFrame;
+		inline static std::deque<ProfilerFrame> s_history;
+	};
+
+	class ProfilerScope
+	{
+	public:
+		explicit ProfilerScope(const char* name)
+		{
+			if (Profiler::IsEnabled() == false)
+				return;
+
+			m_name = name;
+			m_startNs = Profiler::Now();
+		}
+
+		ProfilerScope(const ProfilerScope&) = delete;
+		ProfilerScope(ProfilerScope&&) = delete;
+
+		~ProfilerScope()
+		{
+			if (m_name != nullptr)
+				Profiler::RecordCpuZone(m_name, m_startNs, Profiler::Now());
+		}
+
+	private:
+		const char* m_name = nullptr;
+		uint64_t m_startNs = 0;
+	};
+}
+
+#define VENGINE_PROFILE_CONCAT_INNER(a, b) a##b
+#define VENGINE_PROFILE_CONCAT(a, b) VENGINE_PROFILE_CONCAT_INNER(a, b)
+#define VENGINE_PROFILE_SCOPE(name) ::VEngine::ProfilerScope VENGINE_PROFILE_CONCAT(profilerScope, __LINE__)(name)
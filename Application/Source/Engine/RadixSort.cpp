@@ -0,0 +1,56 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace VEngine
+{
+	void RadixSort::SortPairs(std::span<uint64_t> keys, std::span<uint32_t> values, std::span<uint64_t> keyScratch, std::span<uint32_t> valueScratch)
+	{
+		const auto count = keys.size();
+		if (count < 2)
+			return;
+
+		// All eight histograms in a single read of the keys
+		uint32_t histograms[8][256] = {};
+		for (const auto key : keys)
+		{
+			for (uint32_t pass = 0; pass < 8; pass++)
+				histograms[pass][(key >> (pass * 8)) & 0xff]++;
+		}
+
+		auto* sourceKeys = keys.data();
+		auto* sourceValues = values.data();
+		auto* targetKeys = keyScratch.data();
+		auto* targetValues = valueScratch.data();
+
+		for (uint32_t pass = 0; pass < 8; pass++)
+		{
+			auto& histogram = histograms[pass];
+			const auto shift = pass * 8;
+			if (std::ranges::any_of(histogram, [&](uint32_t bucket) { return bucket == count; }))
+				continue;
+
+			uint32_t offset = 0;
+			for (auto& bucket : histogram)
+				offset += std::exchange(bucket, offset);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto target = histogram[(sourceKeys[i] >> shift) & 0xff]++;
+				targetKeys[target] = sourceKeys[i];
+				targetValues[target] = sourceValues[i];
+			}
+
+			std::swap(sourceKeys, targetKeys);
+			std::swap(sourceValues, targetValues);
+		}
+
+		// An odd number of passes leaves the result in the scratch spans
+		if (sourceKeys != keys.data())
+		{
+			std::copy_n(sourceKeys, count, keys.data());
+			std::copy_n(sourceValues, count, values.data());
+		}
+	}
+}
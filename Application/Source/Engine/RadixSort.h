@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace VEngine
+{
+	// Stable LSD radix sort of 64 bit keys carrying a 32 bit value each, one byte per pass.
+	// Passes where every key has the same byte are skipped, so keys that only use a few bits sort in a few passes.
+	class RadixSort
+	{
+	public:
+		// Scratch spans need at least as many elements as keys, the result ends up in keys and values
+		static void SortPairs(std::span<uint64_t> keys, std::span<uint32_t> values, std::span<uint64_t> keyScratch, std::span<uint32_t> valueScratch);
+	};
+}
@@ -1,21 +1,143 @@
 #include "Renderer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <print>
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Frustum.h"
+#include "FrustumCuller.h"
+#include "MeshOptimizer.h"
+#include "VulkanAllocator.h"
+#include "VulkanOffscreenTarget.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanSwapChain.h"
+#include "Profiler.h"
 
 namespace VEngine 
 {
-	void Renderer::Initialize()
+	// Matches FrameConstants in Scene.glsl, written to the frame allocator once per frame
+	struct FrameConstants
+	{
+		glm::mat4 ViewProjection;
+	};
+
+	// Per frame regions of the frame allocator, sized for a frame's transient constants with plenty of headroom
+	static constexpr VkDeviceSize FrameAllocatorSize = 1024 * 1024;
+
+	// Uploads that don't fit in what the transfer queue hasn't finished yet are retried by their callers
+	static constexpr VkDeviceSize UploadStagingSize = 32 * 1024 * 1024;
+
+	// Spreads defragmentation over frames, moving a whole block at once would stall the frame it lands in
+	static constexpr VkDeviceSize DefragmentationBytesPerFrame = 8 * 1024 * 1024;
+
+	// Matches the push constant block in scene.vert and scene.frag
+	struct ScenePushConstants
 	{
-		glfwInit();
-		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+		// Bindless buffer index of the frame allocator and the frame's constants in it, in vec4 units
+		uint32_t FrameData = 0;
+		uint32_t FrameOffset = 0;
+		uint32_t InstanceBuffer = 0;
+		uint32_t MeshTable = 0;
+
+		// Maps gl_InstanceIndex to the instance for draw list draws, InvalidIndex when firstInstance is the instance itself
+		uint32_t InstanceOrder = VulkanBindlessTable::InvalidIndex;
+
+		// The frame slot's streamed texture table and its sampler, InvalidIndex without streaming
+		uint32_t TextureTable = VulkanBindlessTable::InvalidIndex;
+		uint32_t TextureSampler = VulkanBindlessTable::InvalidIndex;
+	};
+
+	static_assert(sizeof(ScenePushConstants) <= VulkanBindlessTable::PushConstantSize);
+
+	static uint64_t Fnv1a(std::span<const std::byte> data)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (const auto byte : data)
+		{
+			hash ^= (uint64_t)byte;
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	void Renderer::Initialize(const RendererSettings& settings)
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		m_settings = settings;
+		m_settings.FramesInFlight = std::clamp(m_settings.FramesInFlight, 1u, VulkanRenderTarget::MaxFramesInFlight);
+
+#if defined(VENGINE_SHADER_SOURCE_DIR) && defined(VENGINE_GLSL_VALIDATOR)
+		// Recompiled modules land next to the loose files, the archive would shadow them
+		if (m_settings.HotReload)
+		{
+			m_settings.AssetArchivePath.clear();
+			m_shaderWatcher = std::make_unique<ShaderWatcher>(VENGINE_SHADER_SOURCE_DIR, "Resources/Shaders", VENGINE_GLSL_VALIDATOR);
+		}
+#else
+		if (m_settings.HotReload)
+			std::println("Shader hot reload needs the source directory and glslangValidator from the build");
+#endif
 
-		m_scope.Initialize();
-		m_window = glfwCreateWindow(800, 600, "Vulkan Window", nullptr, nullptr);
-		m_swapChain = std::make_shared<VulkanSwapChain>(m_scope.GetVulkanDevice(), m_window);
+		// Mapped before anything loads shaders, spans into it stay valid until shutdown
+		if (m_settings.AssetArchivePath.empty() == false && m_assets.Open(m_settings.AssetArchivePath))
+			std::println("Asset archive: {} entries from {}", m_assets.GetEntryCount(), m_settings.AssetArchivePath);
+
+		if (m_settings.Headless)
+		{
+			m_scope.Initialize(true);
+
+			auto offscreenTarget = std::make_shared<VulkanOffscreenTarget>(m_scope.GetVulkanDevice(), VkExtent2D{ m_settings.Width, m_settings.Height }, m_settings.FramesInFlight);
+			offscreenTarget->SetReadbackCallback([this](uint64_t frameNumber, VkExtent2D extent, std::span<const std::byte> pixels)
+			{
+				m_lastChecksum = Fnv1a(pixels);
+
+				if (m_settings.ReadbackDumpPath.empty() || frameNumber + 1 != m_settings.FrameLimit)
+					return;
+
+				// Binary PPM, alpha is dropped
+				std::ofstream file(m_settings.ReadbackDumpPath, std::ios::binary);
+				file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+				for (size_t i = 0; i < pixels.size(); i += 4)
+					file.write(reinterpret_cast<const char*>(&pixels[i]), 3);
+			});
+
+			m_renderTarget = offscreenTarget;
+		}
+		else
+		{
+			glfwInit();
+			glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+			glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+			m_scope.Initialize();
+			m_window = glfwCreateWindow((int)m_settings.Width, (int)m_settings.Height, "Vulkan Window", nullptr, nullptr);
+			m_renderTarget = std::make_shared<VulkanSwapChain>(m_scope.GetVulkanDevice(), m_window, m_settings.FramesInFlight);
+
+			glfwSetWindowUserPointer(m_window, this);
+			glfwSetFramebufferSizeCallback(m_window, OnFramebufferResize);
+		}
+
+		m_bindlessTable = std::make_unique<VulkanBindlessTable>(m_scope.GetVulkanDevice());
+		m_uploader = std::make_unique<VulkanUploader>(m_scope.GetVulkanDevice(), UploadStagingSize);
+
+		auto streamerSettings = VulkanTextureStreamerSettings();
+		streamerSettings.MaxResidentBytes = (VkDeviceSize)m_settings.TextureBudgetMiB * 1024 * 1024;
+		m_textureStreamer = std::make_unique<VulkanTextureStreamer>(m_scope.GetVulkanDevice(), *m_bindlessTable, *m_uploader, m_renderTarget->GetFramesInFlight(), streamerSettings);
+
+		// One registration covers the whole ring, allocations are addressed by their offset
+		m_frameAllocator = m_scope.GetVulkanDevice()->GetAllocator().CreateLinearPool(FrameAllocatorSize, m_renderTarget->GetFramesInFlight(),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		if (m_bindlessTable->IsSupported())
+			m_frameAllocatorIndex = m_bindlessTable->RegisterStorageBuffer(m_frameAllocator->GetBuffer());
 
 		auto vertShader = std::make_shared<VulkanShader>("Resources/Shaders/triangle.vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
 		auto fragShader = std::make_shared<VulkanShader>("Resources/Shaders/triangle.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
@@ -24,35 +146,512 @@ namespace VEngine
 		{
 			fragShader,
 			vertShader,
-			m_swapChain->GetRenderPass(),
-			m_swapChain->GetExtent()
+			m_renderTarget->GetRenderPass(),
+			m_renderTarget->GetExtent(),
+			m_bindlessTable->GetPipelineLayout()
 		};
+		layout.ColorFormat = m_renderTarget->GetFormat();
+
+		Profiler::SetEnabled(m_settings.ProfilerTracePath.empty() == false);
+		m_gpuProfiler = std::make_unique<VulkanGpuProfiler>(m_scope.GetVulkanDevice(), m_renderTarget->GetFramesInFlight());
+		m_renderGraph = std::make_unique<VulkanRenderGraph>(m_scope.GetVulkanDevice());
+
+		m_pipelineCompiler = std::make_unique<VulkanPipelineCompiler>();
+		m_jobSystem = std::make_unique<JobSystem>();
+		std::println("Job system: {} workers", m_jobSystem->GetWorkerCount());
+
+		// One recording per worker and one for the main thread, which works on them while it waits
+		if (m_settings.ParallelRecording)
+			m_parallelRecorder = std::make_unique<VulkanParallelRecorder>(m_scope.GetVulkanDevice(), m_jobSystem->GetWorkerCount() + 1, m_renderTarget->GetFramesInFlight());
 
-		m_testPipeline = std::make_shared<VulkanPipeline>(layout);
+		m_testPipeline = m_pipelineCompiler->Compile(layout);
 
-		glm::mat4 matrix;
-		glm::vec4 vec;
-		auto test = matrix * vec;
+		CreateScene();
+
+		m_frameTimes.reserve(m_settings.FrameLimit > 0 ? m_settings.FrameLimit : 4096);
+		m_lastFrameTime = std::chrono::steady_clock::now();
+
+		std::println("Startup took {:.2f} ms", std::chrono::duration<double, std::milli>(m_lastFrameTime - startTime).count());
 	}
 
 	void Renderer::Update()
 	{
-		m_swapChain->Begin();
+		Profiler::BeginFrame();
+
+		// Pipelines are only swapped while no preparation reads them
+		{
+			VENGINE_PROFILE_SCOPE("WaitPrepare");
+			m_jobSystem->Wait(m_prepareCounter);
+		}
 
-		m_swapChain->Apply(m_testPipeline);
+		ApplyShaderChanges();
 
-		m_swapChain->End();
+		bool began;
+		{
+			VENGINE_PROFILE_SCOPE("Begin");
+			began = m_renderTarget->BeginFrame();
+		}
+
+		if (began == false)
+		{
+			// Swapchain is being rebuilt or the window is minimized, headless targets have no window to poll
+			if (m_window != nullptr)
+			{
+				glfwPollEvents();
+				m_isRunning = glfwWindowShouldClose(m_window) == false;
+			}
+
+			Profiler::EndFrame();
+			return;
+		}
+
+		m_gpuProfiler->BeginFrame(m_renderTarget->GetFrameIndex());
+		m_frameAllocator->Reset(m_renderTarget->GetFrameIndex());
+		m_scope.GetVulkanDevice()->GetDeletionQueue().Collect();
+		m_bindlessTable->BeginFrame();
+		m_indirectCuller->BeginFrame(m_renderTarget->GetFrameIndex());
+		if (m_parallelRecorder != nullptr)
+			m_parallelRecorder->BeginFrame(m_renderTarget->GetFrameIndex());
+
+		{
+			VENGINE_PROFILE_SCOPE("Upload");
+			m_textureStreamer->Update(m_renderTarget->GetFrameIndex());
+			m_uploader->Flush(m_renderTarget->GetCommandBuffer());
+
+			// After the flush, nothing queued still targets a buffer that moves now
+			const auto& device = m_scope.GetVulkanDevice();
+			device->GetAllocator().Defragment(m_renderTarget->GetCommandBuffer(), device->GetDeletionQueue(), DefragmentationBytesPerFrame);
+		}
+
+		{
+			VENGINE_PROFILE_SCOPE("Record");
+			m_renderGraph->Reset();
+
+			const auto backBuffer = m_renderGraph->ImportTarget(*m_renderTarget);
+			constexpr VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
+
+			if (m_scenePipeline != nullptr)
+			{
+				// Prepared during the previous frame, unless that was before a resize, a pipeline swap or the first frame
+				auto& frame = m_preparedFrames[m_preparedSlot];
+				const auto extent = m_renderTarget->GetExtent();
+				const auto pipeline = m_scenePipeline->IsReady() ? m_scenePipeline->GetPipeline() : nullptr;
+				if (m_prepared == false || frame.Extent.width != extent.width || frame.Extent.height != extent.height || frame.Pipeline != pipeline)
+					PrepareFrame(frame, extent);
+
+				// The next frame is prepared on a worker while this one records and submits
+				m_preparedSlot = (m_preparedSlot + 1) % (uint32_t)m_preparedFrames.size();
+				m_prepared = true;
+				m_jobSystem->Schedule([this, &next = m_preparedFrames[m_preparedSlot], extent] { PrepareFrame(next, extent); }, &m_prepareCounter);
+
+				AddScenePasses(backBuffer, clearColor, frame);
+			}
+			else
+			{
+				m_renderGraph->AddPass("Triangle", [this](VkCommandBuffer commandBuffer)
+				{
+					VulkanGpuProfilerScope gpuScope(m_gpuProfiler.get(), commandBuffer, "Triangle");
+					m_renderTarget->Apply(*m_testPipeline);
+				}).Clear(backBuffer, VulkanRenderGraphAccess::ColorAttachment, clearColor);
+			}
+
+			m_renderGraph->Execute(m_renderTarget->GetCommandBuffer());
+		}
+
+		{
+			VENGINE_PROFILE_SCOPE("Submit");
+			m_gpuProfiler->EndFrame();
+			m_renderTarget->End();
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		m_frameTimes.push_back(std::chrono::duration<double, std::milli>(now - m_lastFrameTime).count());
+		m_lastFrameTime = now;
+		m_frameCount++;
+
+		// GLFW stays on the main thread, jobs needing it are run here
+		m_jobSystem->PumpMainThread();
+		if (m_window != nullptr)
+		{
+			glfwPollEvents();
+			m_isRunning = glfwWindowShouldClose(m_window) == false;
+		}
+
+		if (m_settings.FrameLimit > 0 && m_frameCount >= m_settings.FrameLimit)
+			m_isRunning = false;
 
-		glfwPollEvents();
-		m_isRunning = glfwWindowShouldClose(m_window) == false;
+		Profiler::EndFrame();
 	}
 
 	void Renderer::Shutdown()
 	{
-		m_swapChain = nullptr;
+		m_jobSystem->Wait(m_prepareCounter);
+
+		if (const auto offscreenTarget = std::dynamic_pointer_cast<VulkanOffscreenTarget>(m_renderTarget))
+			offscreenTarget->FlushReadbacks();
+
+		m_shaderWatcher = nullptr;
+		m_pipelineCompiler = nullptr;
+
+		PrintFrameStatistics();
+		m_scope.GetVulkanDevice()->GetPipelineCache().PrintStatistics();
+		m_scope.GetVulkanDevice()->GetAllocator().PrintStatistics();
+		m_bindlessTable->PrintStatistics();
+		m_uploader->PrintStatistics();
+		m_textureStreamer->PrintStatistics();
+		m_scope.GetVulkanDevice()->GetDeletionQueue().PrintStatistics();
+		std::println("Frame allocator: peak {} of {} bytes per frame", m_frameAllocator->GetPeakSize(), m_frameAllocator->GetFrameSize());
+		if (m_meshBuffer != nullptr)
+			m_meshBuffer->PrintStatistics();
+
+		if (m_settings.ProfilerTracePath.empty() == false)
+			Profiler::ExportChromeTrace(m_settings.ProfilerTracePath);
+
+		// The only place that drains the GPU, the objects below are destroyed right away rather than deferred
+		vkDeviceWaitIdle(m_scope.GetVulkanDevice()->GetDevice());
+		m_renderTarget = nullptr;
+		m_gpuProfiler = nullptr;
+		m_renderGraph = nullptr;
+		m_parallelRecorder = nullptr;
+		m_indirectCuller = nullptr;
+		m_textureStreamer = nullptr;
+
+		m_bindlessTable->Release(VulkanBindlessType::StorageBuffer, m_instanceBufferIndex);
+		m_bindlessTable->Release(VulkanBindlessType::StorageBuffer, m_meshTableIndex);
+		for (const auto index : m_instanceOrderIndices)
+			m_bindlessTable->Release(VulkanBindlessType::StorageBuffer, index);
+
+		m_bindlessTable->Release(VulkanBindlessType::StorageBuffer, m_frameAllocatorIndex);
+		m_instanceOrderBuffers.clear();
+		m_frameAllocator = nullptr;
+		m_instanceBuffer = nullptr;
+		m_meshBuffer = nullptr;
+		m_uploader = nullptr;
+		m_bindlessTable = nullptr;
+		m_assets.Close();
+
+		if (m_window != nullptr)
+		{
+			glfwDestroyWindow(m_window);
+			glfwTerminate();
+		}
+	}
+
+	void Renderer::ApplyShaderChanges()
+	{
+		if (m_shaderWatcher == nullptr)
+			return;
+
+		VENGINE_PROFILE_SCOPE("Shader Reload");
+
+		// Graphics pipelines recompile in the background and are swapped in on a later frame
+		const auto changes = m_shaderWatcher->TakeChanges();
+		if (changes.empty() == false)
+		{
+			m_pipelineCompiler->Reload(changes);
+			m_indirectCuller->ReloadShaders(changes);
+		}
+
+		m_pipelineCompiler->ApplyReloads();
+	}
+
+	void Renderer::CreateScene()
+	{
+		m_indirectCuller = std::make_unique<VulkanIndirectCuller>(m_scope.GetVulkanDevice(), *m_bindlessTable, m_renderTarget->GetFramesInFlight(), m_settings.InstanceCount);
+
+		// Scene shaders fetch everything through the bindless table, without it only the test triangle is drawn
+		if (m_bindlessTable->IsSupported() == false)
+			return;
+
+		m_gpuCulling = m_indirectCuller->IsSupported() && m_settings.CpuCulling == false;
+
+		m_meshBuffer = std::make_unique<VulkanMeshBuffer>(*m_uploader, 16, 64 * 1024, 256 * 1024);
+		for (auto mesh : { MeshData::CreateCube(0.5f), MeshData::CreateSphere(0.5f, 24, 48) })
+		{
+			const auto acmr = MeshOptimizer::AnalyzeVertexCache(mesh.Indices, (uint32_t)mesh.Vertices.size());
+			MeshOptimizer::Optimize(mesh);
+
+			std::println("Mesh {}: {} vertices, {} triangles, ACMR {:.3f} -> {:.3f}", m_meshes.size(), mesh.Vertices.size(), mesh.Indices.size() / 3,
+				acmr, MeshOptimizer::AnalyzeVertexCache(mesh.Indices, (uint32_t)mesh.Vertices.size()));
+			m_meshes.push_back(m_meshBuffer->Upload(mesh));
+
+			// Coarse mips are resident right away, finer ones stream in as instances of the mesh cover more of the screen
+			const auto hash = (uint32_t)m_meshes.size() * 2654435761u;
+			auto texture = std::make_shared<TextureData>(TextureData::CreateCheckerboard(1024, 16, 0xffffffffu, 0xff000000u | (hash >> 8)));
+			m_meshTextures.push_back(m_textureStreamer->Register(std::move(texture)));
+		}
+
+		// Square grid in the xy plane, only its middle is in view. Instances are small enough that their
+		// projections never overlap, so the image doesn't depend on the order the GPU emits draws in.
+		constexpr float spacing = 1.5f;
+		constexpr float scale = 0.6f;
+		const auto side = (uint32_t)std::ceil(std::sqrt((double)m_settings.InstanceCount));
+		m_instances.resize(m_settings.InstanceCount);
+		for (uint32_t i = 0; i < m_settings.InstanceCount; i++)
+		{
+			const auto x = ((float)(i % side) - (float)side * 0.5f) * spacing;
+			const auto y = ((float)(i / side) - (float)side * 0.5f) * spacing;
+			const auto hash = i * 2654435761u;
+
+			auto& instance = m_instances[i];
+			instance.PositionScale = glm::vec4(x, y, 0.0f, scale);
+			instance.Color = glm::vec4((float)(hash >> 24) / 255.0f, (float)((hash >> 16) & 0xff) / 255.0f, (float)((hash >> 8) & 0xff) / 255.0f, 1.0f);
+			instance.Mesh = m_meshes[i % m_meshes.size()];
+			instance.Texture = m_meshTextures[i % m_meshTextures.size()];
+		}
+
+		// Boxes around the bounding spheres, cull.comp tests the same ones. The instances never move so the bounds are built once,
+		// with GPU culling they only check its draw count at shutdown.
+		m_frustumCuller = std::make_unique<FrustumCuller>(*m_jobSystem);
+		m_cullingBounds.Reserve((uint32_t)m_instances.size());
+		for (const auto& instance : m_instances)
+		{
+			const auto& positionScale = instance.PositionScale;
+			const auto radius = m_meshBuffer->GetMesh(instance.Mesh).Radius * positionScale.w;
+			m_cullingBounds.Add(glm::vec3(positionScale.x, positionScale.y, positionScale.z), glm::vec3(radius));
+		}
+
+		if (m_gpuCulling == false)
+		{
+			std::println("CPU culling: {} kernel on {} threads", FrustumCuller::GetKernelName(m_frustumCuller->GetKernel()), m_frustumCuller->GetThreadCount());
+
+			// The draw list's instance order, rewritten every frame so each slot gets its own buffer
+			for (uint32_t i = 0; i < m_renderTarget->GetFramesInFlight(); i++)
+			{
+				auto buffer = std::make_unique<VulkanBuffer>(m_instances.size() * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VulkanMemoryUsage::CpuToGpu);
+				m_instanceOrderIndices.push_back(m_bindlessTable->RegisterStorageBuffer(buffer->GetBuffer()));
+				m_instanceOrderBuffers.push_back(std::move(buffer));
+			}
+		}
+
+		// Written once from the host, host visible memory saves the staging copy
+		const auto instanceBytes = m_instances.size() * sizeof(VulkanGpuInstance);
+		m_instanceBuffer = std::make_unique<VulkanBuffer>(instanceBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VulkanMemoryUsage::CpuToGpu);
+		std::memcpy(m_instanceBuffer->GetMappedData(), m_instances.data(), instanceBytes);
+
+		m_instanceBufferIndex = m_bindlessTable->RegisterStorageBuffer(m_instanceBuffer->GetBuffer());
+		m_meshTableIndex = m_bindlessTable->RegisterStorageBuffer(m_meshBuffer->GetMeshTable());
+
+		VulkanPipelineLayout layout =
+		{
+			std::make_shared<VulkanShader>("Resources/Shaders/scene.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT),
+			std::make_shared<VulkanShader>("Resources/Shaders/scene.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
+			m_renderTarget->GetRenderPass(),
+			m_renderTarget->GetExtent(),
+			m_bindlessTable->GetPipelineLayout(),
+			m_meshBuffer->GetVertexLayout()
+		};
+		layout.ColorFormat = m_renderTarget->GetFormat();
+
+		m_scenePipeline = m_pipelineCompiler->Compile(layout);
+	}
+
+	void Renderer::PrepareFrame(PreparedFrame& frame, VkExtent2D extent)
+	{
+		VENGINE_PROFILE_SCOPE("Prepare");
+
+		// Looks down at the grid from far enough to see about half of it
+		const auto side = std::ceil(std::sqrt((float)m_instances.size()));
+		auto projection = glm::perspective(glm::radians(60.0f), (float)extent.width / (float)std::max(extent.height, 1u), 0.1f, 1000.0f);
+		projection[1][1] *= -1.0f;
+
+		const auto view = glm::lookAt(glm::vec3(0.0f, 0.0f, side * 0.75f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		frame.Extent = extent;
+		frame.ViewProjection = projection * view;
+		frame.ViewFrustum = Frustum::FromMatrix(frame.ViewProjection);
+		frame.Pipeline = m_scenePipeline->IsReady() ? m_scenePipeline->GetPipeline() : nullptr;
+		frame.DrawList.Clear();
+
+		// Every instance sits at the camera's distance from the grid, so the one straight ahead sets each mesh texture's detail
+		const auto pixelsPerUnit = (float)extent.height / (2.0f * side * 0.75f * std::tan(glm::radians(60.0f) * 0.5f));
+		for (size_t i = 0; i < m_meshTextures.size() && m_instances.empty() == false; i++)
+			m_textureStreamer->RequestSize(m_meshTextures[i], 2.0f * m_meshBuffer->GetMesh(m_meshes[i]).Radius * m_instances[0].PositionScale.w * pixelsPerUnit);
+
+		// GPU culling only needs the camera
+		if (m_gpuCulling)
+			return;
+
+		{
+			VENGINE_PROFILE_SCOPE("CpuCulling");
+			m_frustumCuller->Cull(m_cullingBounds, frame.ViewFrustum, frame.VisibleInstances);
+		}
+
+		// Nothing to sort while the pipeline compiles, the pass only clears then
+		if (frame.Pipeline == nullptr)
+			return;
+
+		VENGINE_PROFILE_SCOPE("DrawList");
+		for (const auto index : frame.VisibleInstances)
+		{
+			const auto& instance = m_instances[index];
+			const auto& mesh = m_meshBuffer->GetMesh(instance.Mesh);
+			const auto& position = instance.PositionScale;
+
+			auto item = VulkanDrawItem();
+			item.Pipeline = frame.Pipeline.get();
+			item.Mesh = instance.Mesh;
+			item.IndexCount = mesh.IndexCount;
+			item.FirstIndex = mesh.FirstIndex;
+			item.VertexOffset = mesh.VertexOffset;
+			item.Depth = -(view[0][2] * position.x + view[1][2] * position.y + view[2][2] * position.z + view[3][2]);
+			item.Instance = index;
+			frame.DrawList.Add(item);
+		}
+
+		frame.DrawList.Sort();
+	}
+
+	void Renderer::AddScenePasses(VulkanRenderGraphResource backBuffer, VkClearValue clearColor, PreparedFrame& frame)
+	{
+		auto cullOutput = VulkanIndirectCullOutput();
+		if (m_gpuCulling)
+			cullOutput = m_indirectCuller->AddPasses(*m_renderGraph, { m_instanceBufferIndex, m_meshTableIndex, (uint32_t)m_instances.size(), frame.ViewFrustum });
+
+		const auto frameIndex = m_renderTarget->GetFrameIndex();
+		if (m_gpuCulling == false)
+		{
+			const auto& instanceOrder = frame.DrawList.GetInstanceOrder();
+			std::memcpy(m_instanceOrderBuffers[frameIndex]->GetMappedData(), instanceOrder.data(), instanceOrder.size() * sizeof(uint32_t));
+		}
+
+		// Written now, the GPU reads it once the frame is submitted
+		const auto frameConstants = m_frameAllocator->Allocate(sizeof(FrameConstants), sizeof(glm::vec4));
+		if (frameConstants.IsValid())
+			*static_cast<FrameConstants*>(frameConstants.MappedData) = { frame.ViewProjection };
+
+		const auto frameOffset = (uint32_t)(frameConstants.Offset / sizeof(glm::vec4));
+		const bool parallel = m_gpuCulling == false && m_parallelRecorder != nullptr;
+		auto& scenePass = m_renderGraph->AddPass("Scene", [this, &frame, frameOffset, frameIndex, parallel](VkCommandBuffer commandBuffer)
+		{
+			// Inside the pass the primary may only execute secondaries, those carry the zone then
+			VulkanGpuProfilerScope gpuScope(parallel ? nullptr : m_gpuProfiler.get(), commandBuffer, "Scene");
+			if (m_scenePipeline->IsReady() == false)
+				return;
+
+			auto pushConstants = ScenePushConstants{ m_frameAllocatorIndex, frameOffset, m_instanceBufferIndex, m_meshTableIndex };
+			if (m_textureStreamer->IsSupported())
+			{
+				pushConstants.TextureTable = m_textureStreamer->GetTableIndex(frameIndex);
+				pushConstants.TextureSampler = m_textureStreamer->GetSamplerIndex();
+			}
+
+			if (m_gpuCulling)
+			{
+				const auto& pipeline = *m_scenePipeline->GetPipeline();
+				m_renderTarget->Bind(commandBuffer, pipeline);
+				m_bindlessTable->Bind(commandBuffer);
+				m_meshBuffer->Bind(commandBuffer);
+
+				vkCmdPushConstants(commandBuffer, pipeline.GetLayout(), VK_SHADER_STAGE_ALL, 0, sizeof(pushConstants), &pushConstants);
+				m_indirectCuller->Draw(commandBuffer);
+				return;
+			}
+
+			// Every scene draw shares the bindless layout, so the table and the constants survive pipeline changes.
+			// Scene materials only differ in their bindless texture, which the instance carries.
+			pushConstants.InstanceOrder = m_instanceOrderIndices[frameIndex];
+			auto bindMaterial = [&, boundLayout = VkPipelineLayout()](VkCommandBuffer commandBuffer, const VulkanPipeline& pipeline, [[maybe_unused]] uint32_t material) mutable
+			{
+				if (pipeline.GetLayout() == boundLayout)
+					return;
+
+				boundLayout = pipeline.GetLayout();
+				m_bindlessTable->Bind(commandBuffer);
+				vkCmdPushConstants(commandBuffer, boundLayout, VK_SHADER_STAGE_ALL, 0, sizeof(pushConstants), &pushConstants);
+			};
+
+			if (parallel)
+			{
+				RecordDrawListParallel(commandBuffer, frame, bindMaterial);
+				return;
+			}
+
+			m_meshBuffer->Bind(commandBuffer);
+			frame.DrawList.Record(commandBuffer, m_renderTarget->GetExtent(), bindMaterial);
+		}).Clear(backBuffer, VulkanRenderGraphAccess::ColorAttachment, clearColor);
+
+		if (parallel)
+			scenePass.SetSecondaryContents();
+
+		if (m_gpuCulling)
+		{
+			scenePass.Read(cullOutput.DrawCommands, VulkanRenderGraphAccess::IndirectBuffer);
+			scenePass.Read(cullOutput.DrawCount, VulkanRenderGraphAccess::IndirectBuffer);
+		}
+	}
+
+	void Renderer::RecordDrawListParallel(VkCommandBuffer commandBuffer, PreparedFrame& frame, const VulkanDrawList::BindMaterialCallback& bindMaterial)
+	{
+		VENGINE_PROFILE_SCOPE("ParallelRecord");
+		m_parallelRecorder->BeginPass(m_renderGraph->GetInheritance());
+
+		// The GPU zone opens and closes in secondaries of their own, sorted around the draws
+		const auto zoneBegin = m_parallelRecorder->BeginRecording(0, 0);
+		const auto zone = m_gpuProfiler->BeginZone(zoneBegin, "Scene");
+		m_parallelRecorder->EndRecording(zoneBegin);
+
+		const auto bindBuffers = [this](VkCommandBuffer commandBuffer) { m_meshBuffer->Bind(commandBuffer); };
+		const auto statistics = m_parallelRecorder->RecordDrawList(*m_jobSystem, frame.DrawList, m_renderTarget->GetExtent(), 1, bindBuffers, bindMaterial);
+		frame.DrawList.SetStatistics(statistics);
+
+		const auto zoneEnd = m_parallelRecorder->BeginRecording(0, 2);
+		m_gpuProfiler->EndZone(zoneEnd, zone);
+		m_parallelRecorder->EndRecording(zoneEnd);
+
+		m_parallelRecorder->Execute(commandBuffer);
+	}
+
+	void Renderer::OnFramebufferResize(GLFWwindow* window, int width, int height)
+	{
+		const auto renderer = static_cast<Renderer*>(glfwGetWindowUserPointer(window));
+
+		if (const auto swapChain = std::dynamic_pointer_cast<VulkanSwapChain>(renderer->m_renderTarget))
+			swapChain->Invalidate();
+	}
+
+	void Renderer::PrintFrameStatistics() const
+	{
+		if (m_frameTimes.empty())
+			return;
+
+		auto sorted = m_frameTimes;
+		std::ranges::sort(sorted);
+
+		double total = 0.0;
+		for (const double frameTime : sorted)
+			total += frameTime;
+
+		const auto percentile = [&](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * (double)sorted.size()))]; };
+		const double average = total / (double)sorted.size();
+
+		std::println("Frames: {}, frames in flight: {}", m_frameCount, m_renderTarget->GetFramesInFlight());
+		std::println("Frame time avg: {:.3f} ms, p50: {:.3f} ms, p99: {:.3f} ms, max: {:.3f} ms ({:.1f} fps)", 
+			average, percentile(0.5), percentile(0.99), sorted.back(), 1000.0 / average);
+
+		if (m_scenePipeline != nullptr)
+		{
+			// The slot before the one being prepared is the last one recorded
+			const auto& frame = m_preparedFrames[(m_preparedSlot + m_preparedFrames.size() - 1) % m_preparedFrames.size()];
+			const auto drawCount = m_gpuCulling ? m_indirectCuller->GetLastDrawCount() : (uint32_t)frame.VisibleInstances.size();
+			std::println("Draws: {} of {} instances ({} culling)", drawCount, m_instances.size(), m_gpuCulling ? "GPU" : "CPU");
+
+			// Both paths cull the same boxes, the camera never moves so the count read back matches the last frustum
+			if (m_gpuCulling && m_frameCount > m_renderTarget->GetFramesInFlight())
+			{
+				auto visible = std::vector<uint32_t>();
+				m_frustumCuller->Cull(m_cullingBounds, frame.ViewFrustum, visible);
+				if (visible.size() != drawCount)
+					std::println("GPU culling draws {} instances, CPU culling {}", drawCount, visible.size());
+			}
 
-		glfwDestroyWindow(m_window);
+			if (m_gpuCulling == false)
+			{
+				const auto& statistics = frame.DrawList.GetStatistics();
+				std::println("Draw list: {} items in {} draws, {} pipeline binds, {} material binds", statistics.Items, statistics.Draws, statistics.PipelineBinds, statistics.MaterialBinds);
+			}
+		}
 
-		glfwTerminate();
+		if (m_settings.Headless)
+			std::println("Last frame checksum: {:016x}", m_lastChecksum);
 	}
-}
\ No newline at end of file
+}
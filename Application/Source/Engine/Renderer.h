@@ -1,13 +1,63 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
 #include <GLFW/glfw3.h>
 
+#include "AssetArchive.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "ShaderWatcher.h"
+#include "VulkanBindlessTable.h"
+#include "VulkanDrawList.h"
+#include "VulkanGpuProfiler.h"
+#include "VulkanIndirectCuller.h"
+#include "VulkanParallelRecorder.h"
 #include "VulkanPipeline.h"
+#include "VulkanPipelineCompiler.h"
+#include "VulkanRenderGraph.h"
+#include "VulkanRenderTarget.h"
 #include "VulkanScope.h"
-#include "VulkanSwapChain.h"
+#include "VulkanTextureStreamer.h"
+#include "VulkanUploader.h"
 
 namespace VEngine 
 {
+	struct RendererSettings
+	{
+		bool Headless = false;
+		uint32_t Width = 800;
+		uint32_t Height = 600;
+		uint32_t FramesInFlight = 2;
+
+		// Zero keeps running until the window is closed
+		uint64_t FrameLimit = 0;
+		std::string ReadbackDumpPath;
+
+		// Enables the profiler, the recorded history is written as a Chrome trace on shutdown
+		std::string ProfilerTracePath;
+
+		uint32_t InstanceCount = 16384;
+
+		// Culls and draws instances one by one on the CPU, the reference for the GPU driven path
+		bool CpuCulling = false;
+
+		// Records the CPU culled draw list on the job system's workers into secondary command buffers
+		bool ParallelRecording = true;
+
+		// Assets are read from the archive when it exists and from loose files otherwise
+		std::string AssetArchivePath = "Resources/Assets.vpak";
+
+		// Recompiles edited shader sources and swaps the affected pipelines in while running, loose files only
+		bool HotReload = false;
+
+		// Caps resident streamed texture memory, zero leaves it to the device local heap budget
+		uint32_t TextureBudgetMiB = 0;
+	};
+
 	class Renderer 
 	{
 	public:
@@ -16,21 +66,85 @@ namespace VEngine
 		Renderer(Renderer&&) = delete;
 		~Renderer() = default;
 
-		void Initialize();
+		void Initialize(const RendererSettings& settings = {});
 		void Update();
 		void Shutdown();
 
 		bool IsRunning() const { return m_isRunning; }
 
 		static VulkanScope& GetScope() { return m_scope; }
+		static const AssetArchive& GetAssets() { return m_assets; }
 
 	private:
+		// CPU half of a frame: camera, culling and the sorted draw list. Built on a worker while the previous frame records.
+		struct PreparedFrame
+		{
+			VkExtent2D Extent = {};
+			glm::mat4 ViewProjection = glm::mat4(1.0f);
+			Frustum ViewFrustum = {};
+
+			// Pipeline the draw list was built for, null while it compiles
+			std::shared_ptr<VulkanPipeline> Pipeline = nullptr;
+			std::vector<uint32_t> VisibleInstances;
+			VulkanDrawList DrawList;
+		};
+
+		static void OnFramebufferResize(GLFWwindow* window, int width, int height);
+		void CreateScene();
+		void PrepareFrame(PreparedFrame& frame, VkExtent2D extent);
+		void AddScenePasses(VulkanRenderGraphResource backBuffer, VkClearValue clearColor, PreparedFrame& frame);
+		void RecordDrawListParallel(VkCommandBuffer commandBuffer, PreparedFrame& frame, const VulkanDrawList::BindMaterialCallback& bindMaterial);
+		void PrintFrameStatistics() const;
+		void ApplyShaderChanges();
+
 		bool m_isRunning = true;
+		RendererSettings m_settings;
 
 		inline static VulkanScope m_scope;
+		inline static AssetArchive m_assets;
 
-		std::shared_ptr<VulkanSwapChain> m_swapChain = nullptr;
-		std::shared_ptr<VulkanPipeline> m_testPipeline = nullptr;
+		std::shared_ptr<VulkanRenderTarget> m_renderTarget = nullptr;
+		std::unique_ptr<VulkanPipelineCompiler> m_pipelineCompiler = nullptr;
+		std::unique_ptr<VulkanGpuProfiler> m_gpuProfiler = nullptr;
+		std::unique_ptr<VulkanRenderGraph> m_renderGraph = nullptr;
+		std::unique_ptr<VulkanBindlessTable> m_bindlessTable = nullptr;
+		std::unique_ptr<VulkanUploader> m_uploader = nullptr;
+		std::unique_ptr<VulkanTextureStreamer> m_textureStreamer = nullptr;
+		std::unique_ptr<VulkanIndirectCuller> m_indirectCuller = nullptr;
+		std::unique_ptr<ShaderWatcher> m_shaderWatcher = nullptr;
+		std::shared_ptr<VulkanPipelineHandle> m_testPipeline = nullptr;
+		std::shared_ptr<VulkanPipelineHandle> m_scenePipeline = nullptr;
 		GLFWwindow* m_window = nullptr;
+
+		std::vector<VulkanGpuInstance> m_instances;
+		std::vector<uint32_t> m_meshes;
+		std::vector<uint32_t> m_meshTextures;
+		std::unique_ptr<VulkanMeshBuffer> m_meshBuffer = nullptr;
+		std::unique_ptr<VulkanBuffer> m_instanceBuffer = nullptr;
+		uint32_t m_instanceBufferIndex = VulkanBindlessTable::InvalidIndex;
+		uint32_t m_meshTableIndex = VulkanBindlessTable::InvalidIndex;
+
+		bool m_gpuCulling = false;
+		std::unique_ptr<FrustumCuller> m_frustumCuller = nullptr;
+		CullingBounds m_cullingBounds;
+		std::vector<std::unique_ptr<VulkanBuffer>> m_instanceOrderBuffers;
+		std::vector<uint32_t> m_instanceOrderIndices;
+
+		// Transient per-frame GPU data, reset when the frame slot comes around again
+		std::unique_ptr<VulkanLinearPool> m_frameAllocator = nullptr;
+		uint32_t m_frameAllocatorIndex = VulkanBindlessTable::InvalidIndex;
+
+		// Frame N records from one slot while frame N + 1 is prepared into the other
+		std::unique_ptr<JobSystem> m_jobSystem = nullptr;
+		std::unique_ptr<VulkanParallelRecorder> m_parallelRecorder = nullptr;
+		std::array<PreparedFrame, 2> m_preparedFrames;
+		uint32_t m_preparedSlot = 0;
+		bool m_prepared = false;
+		JobCounter m_prepareCounter;
+
+		uint64_t m_frameCount = 0;
+		uint64_t m_lastChecksum = 0;
+		std::chrono::steady_clock::time_point m_lastFrameTime;
+		std::vector<double> m_frameTimes;
 	};
 }
@@ -0,0 +1,163 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <print>
+#include <set>
+#include <utility>
+
+namespace VEngine
+{
+	static constexpr auto PollInterval = std::chrono::milliseconds(250);
+
+	ShaderWatcher::ShaderWatcher(std::filesystem::path sourceDirectory, std::filesystem::path outputDirectory, std::string compiler)
+		: m_sourceDirectory(std::move(sourceDirectory)), m_outputDirectory(std::move(outputDirectory)), m_compiler(std::move(compiler))
+	{
+		// The build compiled everything already, the first poll only records the timestamps
+		Poll();
+
+		m_thread = std::thread(&ShaderWatcher::WatchLoop, this);
+		std::println("Watching {} for shader changes", m_sourceDirectory.string());
+	}
+
+	ShaderWatcher::~ShaderWatcher()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_stopping = true;
+		}
+
+		m_wake.notify_all();
+		m_thread.join();
+	}
+
+	std::vector<std::string> ShaderWatcher::TakeChanges()
+	{
+		std::lock_guard lock(m_mutex);
+		return std::exchange(m_changes, {});
+	}
+
+	void ShaderWatcher::WatchLoop()
+	{
+		auto lock = std::unique_lock(m_mutex);
+		while (m_wake.wait_for(lock, PollInterval, [this] { return m_stopping; }) == false)
+		{
+			lock.unlock();
+			Poll();
+			lock.lock();
+		}
+	}
+
+	void ShaderWatcher::Poll()
+	{
+		const auto seeding = m_timestamps.empty();
+		auto sources = std::vector<std::filesystem::path>();
+		auto changed = std::set<std::filesystem::path>();
+
+		auto error = std::error_code();
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(m_sourceDirectory, error))
+		{
+			const auto& path = entry.path();
+			if (entry.is_regular_file(error) == false || (IsStage(path) == false && path.extension() != ".glsl"))
+				continue;
+
+			// Editors replace files while saving, a file that vanished for a moment is picked up on the next poll
+			const auto timestamp = std::filesystem::last_write_time(path, error);
+			if (error)
+				continue;
+
+			sources.push_back(path);
+			auto [it, inserted] = m_timestamps.try_emplace(path.string(), timestamp);
+			if (inserted == false && it->second == timestamp)
+				continue;
+
+			it->second = timestamp;
+			if (seeding == false)
+				changed.insert(path);
+		}
+
+		// Includes can be nested, spread changed headers until no more files pick one up
+		auto dirtyHeaders = std::vector<std::string>();
+		for (bool spreading = true; spreading;)
+		{
+			spreading = false;
+			for (const auto& path : changed)
+			{
+				const auto name = path.filename().string();
+				if (path.extension() == ".glsl" && std::ranges::find(dirtyHeaders, name) == dirtyHeaders.end())
+					dirtyHeaders.push_back(name);
+			}
+
+			for (const auto& source : sources)
+			{
+				if (changed.contains(source) == false && std::ranges::any_of(dirtyHeaders, [&](const std::string& header) { return Includes(source, header); }))
+				{
+					changed.insert(source);
+					spreading = true;
+				}
+			}
+		}
+
+		for (const auto& path : changed)
+		{
+			if (IsStage(path) == false || Compile(path) == false)
+				continue;
+
+			std::lock_guard lock(m_mutex);
+			m_changes.push_back((m_outputDirectory / (path.filename().string() + ".spv")).generic_string());
+		}
+	}
+
+	bool ShaderWatcher::Compile(const std::filesystem::path& source)
+	{
+		const auto output = m_outputDirectory / (source.filename().string() + ".spv");
+		const auto temporary = std::filesystem::path(output.string() + ".tmp");
+
+		auto command = std::format("\"{}\" -V \"{}\" -o \"{}\"", m_compiler, source.string(), temporary.string());
+#ifdef _WIN32
+		// cmd strips the outer quotes, the quoted paths inside survive
+		command = std::format("\"{}\"", command);
+#endif
+
+		std::println("Compiling {}", source.filename().string());
+		if (std::system(command.c_str()) != 0)
+		{
+			std::println("Failed to compile {}, keeping the previous module", source.filename().string());
+			auto error = std::error_code();
+			std::filesystem::remove(temporary, error);
+			return false;
+		}
+
+		auto error = std::error_code();
+		std::filesystem::rename(temporary, output, error);
+		if (error)
+		{
+			std::println("Failed to replace {}: {}", output.string(), error.message());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool ShaderWatcher::IsStage(const std::filesystem::path& path)
+	{
+		const auto extension = path.extension();
+		return extension == ".vert" || extension == ".frag" || extension == ".comp";
+	}
+
+	bool ShaderWatcher::Includes(const std::filesystem::path& source, const std::string& header)
+	{
+		auto file = std::ifstream(source);
+		const auto directive = std::format("#include \"{}\"", header);
+		for (auto line = std::string(); std::getline(file, line);)
+		{
+			if (line.find(directive) != std::string::npos)
+				return true;
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace VEngine
+{
+	// Polls a GLSL source directory on a background thread and recompiles stages whose source or includes changed.
+	// Modules are written to <outputDirectory>/<file>.spv through a temporary file, so a failed compile leaves the old module in place.
+	class ShaderWatcher
+	{
+	public:
+		ShaderWatcher(std::filesystem::path sourceDirectory, std::filesystem::path outputDirectory, std::string compiler);
+		ShaderWatcher(const ShaderWatcher&) = delete;
+		ShaderWatcher(ShaderWatcher&&) = delete;
+		~ShaderWatcher();
+
+		// Modules recompiled since the last call, named the way VulkanShader loads them
+		std::vector<std::string> TakeChanges();
+
+	private:
+		void WatchLoop();
+		void Poll();
+		bool Compile(const std::filesystem::path& source);
+
+		static bool IsStage(const std::filesystem::path& path);
+		static bool Includes(const std::filesystem::path& source, const std::string& header);
+
+		std::filesystem::path m_sourceDirectory;
+		std::filesystem::path m_outputDirectory;
+		std::string m_compiler;
+
+		// Only touched by the watch thread
+		std::unordered_map<std::string, std::filesystem::file_time_type> m_timestamps;
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::vector<std::string> m_changes;
+		bool m_stopping = false;
+	};
+}
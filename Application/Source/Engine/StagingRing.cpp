@@ -0,0 +1,21 @@
+#include "StagingRing.h"
+
+namespace VEngine
+{
+	StagingRingReservation ReserveStagingRange(uint64_t head, uint64_t tail, uint64_t ringSize, uint64_t size, uint64_t alignment)
+	{
+		auto begin = (head + alignment - 1) & ~(alignment - 1);
+		if (begin % ringSize + size > ringSize)
+			begin = (begin / ringSize + 1) * ringSize;
+
+		const auto end = begin + size;
+		if (end - tail <= ringSize)
+			return { end, true };
+
+		// The skipped bytes are taken on their own, otherwise a ring drained to an unaligned head never fits a large range
+		if (begin != head && begin - tail <= ringSize)
+			return { begin, false };
+
+		return { head, false };
+	}
+}
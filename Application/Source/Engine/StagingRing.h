@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+namespace VEngine
+{
+	// Space in a ring addressed by monotonic offsets, the ring offset is the monotonic one modulo the ring size.
+	// Ranges never wrap, a range that doesn't fit before the end of the ring starts at the next lap instead.
+	struct StagingRingReservation
+	{
+		// Head after the reservation, the old head when nothing was taken
+		uint64_t Head = 0;
+
+		// The data goes to [Head - size, Head). False when only the bytes skipped up to the range's start were taken.
+		bool Reserved = false;
+	};
+
+	// Alignment has to be a power of two, size at most the ring size. The caller publishes Head with a compare exchange.
+	StagingRingReservation ReserveStagingRange(uint64_t head, uint64_t tail, uint64_t ringSize, uint64_t size, uint64_t alignment);
+}
@@ -0,0 +1,152 @@
+#include "Texture.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace VEngine
+{
+	bool TextureData::Load(std::span<const std::byte> data)
+	{
+		m_mips.clear();
+		m_data = {};
+		m_storage.clear();
+
+		if (data.size() < sizeof(TextureHeader))
+			return false;
+
+		auto header = TextureHeader();
+		std::memcpy(&header, data.data(), sizeof(header));
+		if (header.Magic != Magic || header.Version != Version || header.MipCount == 0 || header.MipCount > 32)
+			return false;
+
+		if (header.Format != TextureFormat::Rgba8Unorm && header.Format != TextureFormat::Rgba8Srgb)
+			return false;
+
+		const auto dataOffset = sizeof(TextureHeader) + (uint64_t)header.MipCount * sizeof(TextureMip);
+		if (dataOffset > data.size())
+			return false;
+
+		auto mips = std::vector<TextureMip>(header.MipCount);
+		std::memcpy(mips.data(), data.data() + sizeof(TextureHeader), mips.size() * sizeof(TextureMip));
+
+		// Chains are uploaded as one range, so the mips have to be back to back in order
+		const auto pixelData = data.subspan(dataOffset);
+		uint64_t expectedOffset = 0;
+		for (const auto& mip : mips)
+		{
+			const auto size = (uint64_t)mip.Width * mip.Height * GetBytesPerPixel(header.Format);
+			if (mip.Width == 0 || mip.Height == 0 || mip.Offset != expectedOffset || mip.Size != size || size > pixelData.size() - mip.Offset)
+				return false;
+
+			expectedOffset += size;
+		}
+
+		m_format = header.Format;
+		m_mips = std::move(mips);
+		m_data = pixelData.first(expectedOffset);
+		return true;
+	}
+
+	std::vector<std::byte> TextureData::Serialize() const
+	{
+		auto header = TextureHeader();
+		header.Magic = Magic;
+		header.Version = Version;
+		header.Format = m_format;
+		header.MipCount = (uint32_t)m_mips.size();
+
+		const auto mipTableSize = m_mips.size() * sizeof(TextureMip);
+		auto data = std::vector<std::byte>(sizeof(header) + mipTableSize + m_data.size());
+		std::memcpy(data.data(), &header, sizeof(header));
+		std::memcpy(data.data() + sizeof(header), m_mips.data(), mipTableSize);
+		std::memcpy(data.data() + sizeof(header) + mipTableSize, m_data.data(), m_data.size());
+		return data;
+	}
+
+	std::span<const std::byte> TextureData::GetChainData(uint32_t firstMip) const
+	{
+		return m_data.subspan(m_mips[firstMip].Offset);
+	}
+
+	uint32_t TextureData::FindMip(uint32_t size) const
+	{
+		for (uint32_t mip = 0; mip < m_mips.size(); mip++)
+		{
+			if (std::max(m_mips[mip].Width, m_mips[mip].Height) <= size)
+				return mip;
+		}
+
+		return m_mips.empty() ? 0 : (uint32_t)m_mips.size() - 1;
+	}
+
+	uint32_t TextureData::GetBytesPerPixel(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::Rgba8Unorm:
+		case TextureFormat::Rgba8Srgb:
+			return 4;
+		}
+
+		return 4;
+	}
+
+	TextureData TextureData::CreateCheckerboard(uint32_t size, uint32_t cells, uint32_t colorA, uint32_t colorB)
+	{
+		size = std::bit_ceil(std::max(size, 1u));
+		cells = std::clamp(cells, 1u, size);
+
+		auto texture = TextureData();
+		texture.m_format = TextureFormat::Rgba8Unorm;
+
+		uint64_t totalSize = 0;
+		for (uint32_t mipSize = size; ; mipSize /= 2)
+		{
+			const auto mipBytes = (uint64_t)mipSize * mipSize * 4;
+			texture.m_mips.push_back({ mipSize, mipSize, totalSize, mipBytes });
+			totalSize += mipBytes;
+
+			if (mipSize == 1)
+				break;
+		}
+
+		texture.m_storage.resize(totalSize);
+		auto* pixels = reinterpret_cast<uint8_t*>(texture.m_storage.data());
+
+		const auto cellSize = size / cells;
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const auto color = ((x / cellSize + y / cellSize) % 2) == 0 ? colorA : colorB;
+				std::memcpy(pixels + ((uint64_t)y * size + x) * 4, &color, 4);
+			}
+		}
+
+		// Every mip averages 2x2 texels of the previous one, sides are powers of two so none is left over
+		for (size_t mip = 1; mip < texture.m_mips.size(); mip++)
+		{
+			const auto& source = texture.m_mips[mip - 1];
+			const auto& target = texture.m_mips[mip];
+			const auto* sourcePixels = pixels + source.Offset;
+			auto* targetPixels = pixels + target.Offset;
+
+			for (uint32_t y = 0; y < target.Height; y++)
+			{
+				for (uint32_t x = 0; x < target.Width; x++)
+				{
+					for (uint32_t channel = 0; channel < 4; channel++)
+					{
+						const auto sample = [&](uint32_t sx, uint32_t sy) { return (uint32_t)sourcePixels[((uint64_t)sy * source.Width + sx) * 4 + channel]; };
+						const auto sum = sample(x * 2, y * 2) + sample(x * 2 + 1, y * 2) + sample(x * 2, y * 2 + 1) + sample(x * 2 + 1, y * 2 + 1);
+						targetPixels[((uint64_t)y * target.Width + x) * 4 + channel] = (uint8_t)((sum + 2) / 4);
+					}
+				}
+			}
+		}
+
+		texture.m_data = texture.m_storage;
+		return texture;
+	}
+}
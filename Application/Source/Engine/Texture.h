@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace VEngine
+{
+	enum class TextureFormat : uint32_t
+	{
+		Rgba8Unorm,
+		Rgba8Srgb
+	};
+
+	// Offsets are relative to the start of the pixel data
+	struct TextureMip
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+	};
+
+	// On disk layout: header, mip table, then the pixel data
+	struct TextureHeader
+	{
+		uint32_t Magic = 0;
+		uint32_t Version = 0;
+		TextureFormat Format = TextureFormat::Rgba8Unorm;
+		uint32_t MipCount = 0;
+	};
+
+	// Mips are stored finest first and back to back, so every chain from a mip down to 1x1 is one contiguous range.
+	// Loaded textures view their source without copying, generated ones own their pixels.
+	class TextureData
+	{
+	public:
+		static constexpr uint32_t Magic = 0x58455456; // "VTEX"
+		static constexpr uint32_t Version = 1;
+
+		TextureData() = default;
+		TextureData(const TextureData&) = delete;
+		TextureData(TextureData&&) = default;
+		TextureData& operator=(TextureData&&) = default;
+
+		// Data has to outlive the texture, e.g. an archive entry. False if it is malformed.
+		bool Load(std::span<const std::byte> data);
+		std::vector<std::byte> Serialize() const;
+
+		TextureFormat GetFormat() const { return m_format; }
+		uint32_t GetWidth() const { return m_mips.empty() ? 0 : m_mips[0].Width; }
+		uint32_t GetHeight() const { return m_mips.empty() ? 0 : m_mips[0].Height; }
+		uint32_t GetMipCount() const { return (uint32_t)m_mips.size(); }
+		const TextureMip& GetMip(uint32_t mip) const { return m_mips[mip]; }
+
+		// Mips firstMip to the last, offsets inside the span are the mip offsets minus the one of firstMip
+		std::span<const std::byte> GetChainData(uint32_t firstMip) const;
+
+		// Finest mip whose larger side is at most size, the last mip if none is that small
+		uint32_t FindMip(uint32_t size) const;
+
+		static uint32_t GetBytesPerPixel(TextureFormat format);
+
+		// Two colour checkerboard with a box filtered chain down to 1x1, size is rounded up to a power of two
+		static TextureData CreateCheckerboard(uint32_t size, uint32_t cells, uint32_t colorA, uint32_t colorB);
+
+	private:
+		TextureFormat m_format = TextureFormat::Rgba8Unorm;
+		std::vector<TextureMip> m_mips;
+		std::span<const std::byte> m_data;
+		std::vector<std::byte> m_storage;
+	};
+}
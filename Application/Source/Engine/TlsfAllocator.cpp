@@ -0,0 +1,240 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace VEngine
+{
+	TlsfAllocator::TlsfAllocator(uint64_t size)
+	{
+		m_size = size;
+
+		for (auto& heads : m_freeHeads)
+			heads.fill(InvalidNode);
+
+		if (size > 0)
+			InsertFree(CreateNode(0, size));
+	}
+
+	void TlsfAllocator::MapSize(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+	{
+		// Sizes below the second level count get a linear class each
+		if (size < SecondLevelCount)
+		{
+			firstLevel = 0;
+			secondLevel = (uint32_t)size;
+			return;
+		}
+
+		const uint32_t msb = 63 - (uint32_t)std::countl_zero(size);
+		firstLevel = msb - SecondLevelBits + 1;
+		secondLevel = (uint32_t)(size >> (msb - SecondLevelBits)) & (SecondLevelCount - 1);
+	}
+
+	TlsfAllocator::Allocation TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		size = size == 0 ? 1 : size;
+		alignment = alignment == 0 ? 1 : alignment;
+
+		// Worst case padding is reserved up front, the unused part goes back to the free lists
+		const uint64_t searchSize = size + alignment - 1;
+		if (searchSize < size || searchSize > GetFreeSize())
+			return {};
+
+		const uint32_t node = FindFree(searchSize);
+		if (node == InvalidNode)
+			return {};
+
+		RemoveFree(node);
+
+		const uint64_t alignedOffset = (m_nodes[node].Offset + alignment - 1) & ~(alignment - 1);
+		const uint64_t padding = alignedOffset - m_nodes[node].Offset;
+
+		if (padding > 0)
+		{
+			// Previous physical node is always in use, free neighbours are merged eagerly
+			const uint32_t front = CreateNode(m_nodes[node].Offset, padding);
+			m_nodes[front].PrevPhysical = m_nodes[node].PrevPhysical;
+			m_nodes[front].NextPhysical = node;
+			if (m_nodes[front].PrevPhysical != InvalidNode)
+				m_nodes[m_nodes[front].PrevPhysical].NextPhysical = front;
+
+			m_nodes[node].PrevPhysical = front;
+			m_nodes[node].Offset = alignedOffset;
+			m_nodes[node].Size -= padding;
+
+			InsertFree(front);
+		}
+
+		if (m_nodes[node].Size > size)
+		{
+			const uint32_t back = CreateNode(m_nodes[node].Offset + size, m_nodes[node].Size - size);
+			m_nodes[back].PrevPhysical = node;
+			m_nodes[back].NextPhysical = m_nodes[node].NextPhysical;
+			if (m_nodes[back].NextPhysical != InvalidNode)
+				m_nodes[m_nodes[back].NextPhysical].PrevPhysical = back;
+
+			m_nodes[node].NextPhysical = back;
+			m_nodes[node].Size = size;
+
+			InsertFree(back);
+		}
+
+		m_usedSize += size;
+		m_allocationCount++;
+
+		return { m_nodes[node].Offset, node };
+	}
+
+	void TlsfAllocator::Free(const Allocation& allocation)
+	{
+		if (allocation.IsValid() == false)
+			return;
+
+		uint32_t node = allocation.Node;
+		m_usedSize -= m_nodes[node].Size;
+		m_allocationCount--;
+
+		const uint32_t prev = m_nodes[node].PrevPhysical;
+		if (prev != InvalidNode && m_nodes[prev].Free)
+		{
+			RemoveFree(prev);
+
+			m_nodes[prev].Size += m_nodes[node].Size;
+			m_nodes[prev].NextPhysical = m_nodes[node].NextPhysical;
+			if (m_nodes[prev].NextPhysical != InvalidNode)
+				m_nodes[m_nodes[prev].NextPhysical].PrevPhysical = prev;
+
+			ReleaseNode(node);
+			node = prev;
+		}
+
+		const uint32_t next = m_nodes[node].NextPhysical;
+		if (next != InvalidNode && m_nodes[next].Free)
+		{
+			RemoveFree(next);
+
+			m_nodes[node].Size += m_nodes[next].Size;
+			m_nodes[node].NextPhysical = m_nodes[next].NextPhysical;
+			if (m_nodes[node].NextPhysical != InvalidNode)
+				m_nodes[m_nodes[node].NextPhysical].PrevPhysical = node;
+
+			ReleaseNode(next);
+		}
+
+		InsertFree(node);
+	}
+
+	uint64_t TlsfAllocator::GetLargestFreeRegion() const
+	{
+		if (m_firstLevelBitmap == 0)
+			return 0;
+
+		const uint32_t firstLevel = 63 - (uint32_t)std::countl_zero(m_firstLevelBitmap);
+		const uint32_t secondLevel = 31 - (uint32_t)std::countl_zero(m_secondLevelBitmaps[firstLevel]);
+
+		uint64_t largest = 0;
+		for (uint32_t node = m_freeHeads[firstLevel][secondLevel]; node != InvalidNode; node = m_nodes[node].NextFree)
+			largest = std::max(largest, m_nodes[node].Size);
+
+		return largest;
+	}
+
+	uint32_t TlsfAllocator::CreateNode(uint64_t offset, uint64_t size)
+	{
+		uint32_t node;
+		if (m_unusedNodes.empty() == false)
+		{
+			node = m_unusedNodes.back();
+			m_unusedNodes.pop_back();
+			m_nodes[node] = Node();
+		}
+		else
+		{
+			node = (uint32_t)m_nodes.size();
+			m_nodes.emplace_back();
+		}
+
+		m_nodes[node].Offset = offset;
+		m_nodes[node].Size = size;
+		return node;
+	}
+
+	void TlsfAllocator::ReleaseNode(uint32_t node)
+	{
+		m_unusedNodes.push_back(node);
+	}
+
+	void TlsfAllocator::InsertFree(uint32_t node)
+	{
+		uint32_t firstLevel, secondLevel;
+		MapSize(m_nodes[node].Size, firstLevel, secondLevel);
+
+		const uint32_t head = m_freeHeads[firstLevel][secondLevel];
+		m_nodes[node].Free = true;
+		m_nodes[node].PrevFree = InvalidNode;
+		m_nodes[node].NextFree = head;
+		if (head != InvalidNode)
+			m_nodes[head].PrevFree = node;
+
+		m_freeHeads[firstLevel][secondLevel] = node;
+		m_firstLevelBitmap |= 1ull << firstLevel;
+		m_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	}
+
+	void TlsfAllocator::RemoveFree(uint32_t node)
+	{
+		uint32_t firstLevel, secondLevel;
+		MapSize(m_nodes[node].Size, firstLevel, secondLevel);
+
+		const uint32_t prev = m_nodes[node].PrevFree;
+		const uint32_t next = m_nodes[node].NextFree;
+		if (prev != InvalidNode)
+			m_nodes[prev].NextFree = next;
+		if (next != InvalidNode)
+			m_nodes[next].PrevFree = prev;
+
+		if (m_freeHeads[firstLevel][secondLevel] == node)
+		{
+			m_freeHeads[firstLevel][secondLevel] = next;
+			if (next == InvalidNode)
+			{
+				m_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+				if (m_secondLevelBitmaps[firstLevel] == 0)
+					m_firstLevelBitmap &= ~(1ull << firstLevel);
+			}
+		}
+
+		m_nodes[node].Free = false;
+		m_nodes[node].PrevFree = InvalidNode;
+		m_nodes[node].NextFree = InvalidNode;
+	}
+
+	uint32_t TlsfAllocator::FindFree(uint64_t size) const
+	{
+		uint32_t firstLevel, secondLevel;
+		MapSize(size, firstLevel, secondLevel);
+
+		// Blocks in the exact class may still be big enough, check them before rounding up
+		for (uint32_t node = m_freeHeads[firstLevel][secondLevel]; node != InvalidNode; node = m_nodes[node].NextFree)
+		{
+			if (m_nodes[node].Size >= size)
+				return node;
+		}
+
+		// Every block in any higher class is guaranteed to fit
+		uint32_t secondLevelMap = secondLevel + 1 < SecondLevelCount ? m_secondLevelBitmaps[firstLevel] & (~0u << (secondLevel + 1)) : 0;
+		if (secondLevelMap == 0)
+		{
+			const uint64_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? m_firstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+			if (firstLevelMap == 0)
+				return InvalidNode;
+
+			firstLevel = (uint32_t)std::countr_zero(firstLevelMap);
+			secondLevelMap = m_secondLevelBitmaps[firstLevel];
+		}
+
+		secondLevel = (uint32_t)std::countr_zero(secondLevelMap);
+		return m_freeHeads[firstLevel][secondLevel];
+	}
+}
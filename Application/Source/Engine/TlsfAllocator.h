@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace VEngine 
+{
+	// Two-level segregated fit allocator over an abstract [0, size) range, O(1) allocate and free.
+	// It only hands out offsets, the memory itself lives elsewhere (device memory, mega buffers).
+	class TlsfAllocator
+	{
+	public:
+		static constexpr uint64_t InvalidOffset = UINT64_MAX;
+		static constexpr uint32_t InvalidNode = UINT32_MAX;
+
+		struct Allocation
+		{
+			uint64_t Offset = InvalidOffset;
+			uint32_t Node = InvalidNode;
+
+			bool IsValid() const { return Offset != InvalidOffset; }
+		};
+
+		explicit TlsfAllocator(uint64_t size);
+
+		// Alignment has to be a power of two
+		Allocation Allocate(uint64_t size, uint64_t alignment = 1);
+		void Free(const Allocation& allocation);
+
+		uint64_t GetAllocationSize(const Allocation& allocation) const { return m_nodes[allocation.Node].Size; }
+
+		uint64_t GetSize() const { return m_size; }
+		uint64_t GetUsedSize() const { return m_usedSize; }
+		uint64_t GetFreeSize() const { return m_size - m_usedSize; }
+		uint64_t GetLargestFreeRegion() const;
+		uint32_t GetAllocationCount() const { return m_allocationCount; }
+		bool IsEmpty() const { return m_allocationCount == 0; }
+
+	private:
+		static constexpr uint32_t SecondLevelBits = 4;
+		static constexpr uint32_t SecondLevelCount = 1u << SecondLevelBits;
+		static constexpr uint32_t FirstLevelCount = 64 - SecondLevelBits + 1;
+
+		struct Node
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+
+			uint32_t PrevPhysical = InvalidNode;
+			uint32_t NextPhysical = InvalidNode;
+			uint32_t PrevFree = InvalidNode;
+			uint32_t NextFree = InvalidNode;
+
+			bool Free = false;
+		};
+
+		static void MapSize(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+		uint32_t CreateNode(uint64_t offset, uint64_t size);
+		void ReleaseNode(uint32_t node);
+
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+		uint32_t FindFree(uint64_t size) const;
+
+		uint64_t m_size = 0;
+		uint64_t m_usedSize = 0;
+		uint32_t m_allocationCount = 0;
+
+		uint64_t m_firstLevelBitmap = 0;
+		std::array<uint32_t, FirstLevelCount> m_secondLevelBitmaps = {};
+		std::array<std::array<uint32_t, SecondLevelCount>, FirstLevelCount> m_freeHeads;
+
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_unusedNodes;
+	};
+}
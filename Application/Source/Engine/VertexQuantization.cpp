@@ -0,0 +1,88 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace VEngine
+{
+	int16_t VertexQuantization::ToSnorm16(float value)
+	{
+		return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	uint16_t VertexQuantization::ToHalf(float value)
+	{
+		const auto bits = std::bit_cast<uint32_t>(value);
+		const auto sign = (bits >> 16) & 0x8000u;
+		const auto biasedExponent = (int32_t)((bits >> 23) & 0xff);
+		auto mantissa = bits & 0x7fffffu;
+
+		// Infinity stays infinity, NaN stays a quiet NaN
+		if (biasedExponent == 0xff)
+			return (uint16_t)(sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u));
+
+		const auto exponent = biasedExponent - 127 + 15;
+		if (exponent >= 31)
+			return (uint16_t)(sign | 0x7c00u);
+
+		if (exponent <= 0)
+		{
+			// Too small even for a half denormal
+			if (exponent < -10)
+				return (uint16_t)sign;
+
+			mantissa |= 0x800000u;
+			const auto shift = (uint32_t)(14 - exponent);
+			auto half = mantissa >> shift;
+			if ((mantissa >> (shift - 1)) & 1u)
+				half++;
+
+			return (uint16_t)(sign | half);
+		}
+
+		// Rounding may carry into the exponent, which is still the correctly rounded result
+		auto half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+		if (mantissa & 0x1000u)
+			half++;
+
+		return (uint16_t)half;
+	}
+
+	glm::vec2 VertexQuantization::EncodeOctahedral(const glm::vec3& normal)
+	{
+		const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (length == 0.0f)
+			return glm::vec2(0.0f, 0.0f);
+
+		auto x = normal.x / length;
+		auto y = normal.y / length;
+
+		// The lower hemisphere folds over the diagonals
+		if (normal.z < 0.0f)
+		{
+			const auto foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			const auto foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		return glm::vec2(x, y);
+	}
+
+	QuantizedVertex VertexQuantization::Quantize(const MeshVertex& vertex, float positionScale)
+	{
+		const auto normal = EncodeOctahedral(vertex.Normal);
+
+		auto quantized = QuantizedVertex();
+		quantized.Position[0] = ToSnorm16(vertex.Position.x * positionScale);
+		quantized.Position[1] = ToSnorm16(vertex.Position.y * positionScale);
+		quantized.Position[2] = ToSnorm16(vertex.Position.z * positionScale);
+		quantized.Normal[0] = ToSnorm16(normal.x);
+		quantized.Normal[1] = ToSnorm16(normal.y);
+		quantized.Uv[0] = ToHalf(vertex.Uv.x);
+		quantized.Uv[1] = ToHalf(vertex.Uv.y);
+
+		return quantized;
+	}
+}
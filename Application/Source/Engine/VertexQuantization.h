@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "Mesh.h"
+
+namespace VEngine
+{
+	// 16 bytes instead of MeshVertex's 32, see VulkanVertexLayout::Quantized for the attribute formats
+	struct QuantizedVertex
+	{
+		// Snorm of the position divided by the mesh radius, w is padding
+		int16_t Position[4] = {};
+
+		// Snorm octahedral encoding of the unit normal
+		int16_t Normal[2] = {};
+
+		// Half floats, wrapping uvs keep their precision
+		uint16_t Uv[2] = {};
+	};
+
+	static_assert(sizeof(QuantizedVertex) == 16);
+
+	class VertexQuantization
+	{
+	public:
+		static int16_t ToSnorm16(float value);
+		static uint16_t ToHalf(float value);
+
+		// Maps the unit sphere onto the [-1, 1] square, decoded in Scene.glsl
+		static glm::vec2 EncodeOctahedral(const glm::vec3& normal);
+
+		// positionScale is 1 / radius, so positions land in [-1, 1]
+		static QuantizedVertex Quantize(const MeshVertex& vertex, float positionScale);
+	};
+}
@@ -1,9 +1,59 @@
-﻿#include "Engine/Renderer.h"
+﻿#include <charconv>
+#include <string_view>
 
-int main()
+#include "Engine/Renderer.h"
+
+static uint32_t ParseNumber(std::string_view value)
 {
+	uint32_t result = 0;
+	std::from_chars(value.data(), value.data() + value.size(), result);
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	VEngine::RendererSettings settings;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (arg == "--headless")
+			settings.Headless = true;
+		else if (arg == "--frames" && hasValue)
+			settings.FrameLimit = ParseNumber(argv[++i]);
+		else if (arg == "--frames-in-flight" && hasValue)
+			settings.FramesInFlight = ParseNumber(argv[++i]);
+		else if (arg == "--width" && hasValue)
+			settings.Width = ParseNumber(argv[++i]);
+		else if (arg == "--height" && hasValue)
+			settings.Height = ParseNumber(argv[++i]);
+		else if (arg == "--dump" && hasValue)
+			settings.ReadbackDumpPath = argv[++i];
+		else if (arg == "--profile" && hasValue)
+			settings.ProfilerTracePath = argv[++i];
+		else if (arg == "--instances" && hasValue)
+			settings.InstanceCount = ParseNumber(argv[++i]);
+		else if (arg == "--cpu-culling")
+			settings.CpuCulling = true;
+		else if (arg == "--inline-recording")
+			settings.ParallelRecording = false;
+		else if (arg == "--assets" && hasValue)
+			settings.AssetArchivePath = argv[++i];
+		else if (arg == "--loose-assets")
+			settings.AssetArchivePath.clear();
+		else if (arg == "--hot-reload")
+			settings.HotReload = true;
+		else if (arg == "--texture-budget" && hasValue)
+			settings.TextureBudgetMiB = ParseNumber(argv[++i]);
+	}
+
+	// Headless runs need an end, otherwise they would render forever
+	if (settings.Headless && settings.FrameLimit == 0)
+		settings.FrameLimit = 1000;
+
 	VEngine::Renderer renderer;
-	renderer.Initialize();
+	renderer.Initialize(settings);
 
 	while (renderer.IsRunning())
 	{
@@ -0,0 +1,533 @@
+#include "VulkanAllocator.h"
+
+#include <algorithm>
+#include <print>
+#include <stdexcept>
+
+#include "VulkanDebugger.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanDevice.h"
+
+namespace VEngine
+{
+	static constexpr VkDeviceSize DefaultBlockSize = 64ull * 1024 * 1024;
+
+	VulkanLinearPool::VulkanLinearPool(VulkanAllocator& allocator, VulkanAllocation* allocation, VkDeviceSize frameSize, uint32_t frameCount, VkDeviceAddress deviceAddress)
+		: m_allocator(allocator)
+	{
+		m_allocation = allocation;
+		m_frameSize = frameSize;
+		m_frameCount = frameCount;
+		m_deviceAddress = deviceAddress;
+	}
+
+	VulkanLinearPool::~VulkanLinearPool()
+	{
+		if (m_allocation == nullptr)
+			return;
+
+		m_allocator.DestroyBuffer(m_allocation);
+		m_allocation = nullptr;
+	}
+
+	VulkanLinearAllocation VulkanLinearPool::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		// Aligning needs the current head, so this is a compare exchange loop rather than a single fetch_add
+		auto head = m_head.load(std::memory_order_relaxed);
+		VkDeviceSize offset;
+		do
+		{
+			offset = (head + alignment - 1) & ~(alignment - 1);
+			if (offset + size > m_frameSize)
+				return {};
+		}
+		while (m_head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed) == false);
+
+		auto allocation = VulkanLinearAllocation();
+		allocation.Buffer = m_allocation->Buffer;
+		allocation.Offset = m_frameOffset + offset;
+		allocation.Size = size;
+		allocation.MappedData = static_cast<std::byte*>(m_allocation->MappedData) + allocation.Offset;
+		allocation.DeviceAddress = m_deviceAddress != 0 ? m_deviceAddress + allocation.Offset : 0;
+		return allocation;
+	}
+
+	void VulkanLinearPool::Reset(uint32_t frameIndex)
+	{
+		m_peak = std::max(m_peak, m_head.load(std::memory_order_relaxed));
+		m_frameOffset = (VkDeviceSize)(frameIndex % m_frameCount) * m_frameSize;
+		m_head.store(0, std::memory_order_relaxed);
+	}
+
+	VulkanAllocator::VulkanAllocator(VkDevice device, const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, bool bufferDeviceAddress)
+	{
+		m_device = device;
+		m_physicalDevice = physicalDevice;
+		m_bufferDeviceAddress = bufferDeviceAddress;
+
+		const auto& memoryProperties = physicalDevice->GetMemoryProperties();
+		m_separateImagePools = physicalDevice->GetProperties().limits.bufferImageGranularity > 1;
+
+		const uint32_t poolsPerType = m_separateImagePools ? 2 : 1;
+		m_pools.resize(memoryProperties.memoryTypeCount * poolsPerType);
+		for (uint32_t i = 0; i < (uint32_t)m_pools.size(); i++)
+			m_pools[i].MemoryTypeIndex = i / poolsPerType;
+
+		for (const auto& queueInfo : physicalDevice->GetQueueFamilyInfos())
+			m_queueFamilies.push_back(queueInfo.queueFamilyIndex);
+	}
+
+	void VulkanAllocator::ShareAcrossQueues(VkBufferCreateInfo& bufferInfo) const
+	{
+		// Uploads and async compute can then use buffers without ownership transfers, buffers lose nothing by it
+		if (m_queueFamilies.size() < 2)
+			return;
+
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = (uint32_t)m_queueFamilies.size();
+		bufferInfo.pQueueFamilyIndices = m_queueFamilies.data();
+	}
+
+	uint32_t VulkanAllocator::FindMemoryType(uint32_t typeBits, VulkanMemoryUsage usage) const
+	{
+		switch (usage)
+		{
+		case VulkanMemoryUsage::CpuToGpu:
+			return m_physicalDevice->FindMemoryType(typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		case VulkanMemoryUsage::GpuToCpu:
+			return m_physicalDevice->FindMemoryType(typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+		case VulkanMemoryUsage::GpuOnly:
+		default:
+			return m_physicalDevice->FindMemoryType(typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+	}
+
+	uint32_t VulkanAllocator::GetPoolIndex(uint32_t memoryTypeIndex, bool linear) const
+	{
+		if (m_separateImagePools == false)
+			return memoryTypeIndex;
+
+		return memoryTypeIndex * 2 + (linear ? 0 : 1);
+	}
+
+	VkDeviceSize VulkanAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+	{
+		const auto& memoryProperties = m_physicalDevice->GetMemoryProperties();
+		const auto heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+
+		// Small heaps (BAR windows, integrated carve-outs) get smaller blocks so one block can't eat the heap
+		if (heapSize <= 1024ull * 1024 * 1024)
+			return std::min(DefaultBlockSize, heapSize / 8);
+
+		return DefaultBlockSize;
+	}
+
+	VkDeviceMemory VulkanAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mappedData) const
+	{
+		auto allocInfo = VkMemoryAllocateInfo();
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		// Every block gets the flag, so any buffer can ask for its address without a dedicated allocation
+		auto flagsInfo = VkMemoryAllocateFlagsInfo();
+		flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+		flagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+		if (m_bufferDeviceAddress)
+			allocInfo.pNext = &flagsInfo;
+
+		VkDeviceMemory memory = nullptr;
+		if (vkAllocateMemory(m_device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+			return nullptr;
+
+		// Host visible memory stays mapped for its whole lifetime
+		*mappedData = nullptr;
+		const auto flags = m_physicalDevice->GetMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags;
+		if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			VULKAN_CHECK(vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, mappedData));
+
+		return memory;
+	}
+
+	bool VulkanAllocator::AllocateFromBlock(VulkanMemoryBlock& block, VulkanAllocation& allocation) const
+	{
+		const auto range = block.Ranges.Allocate(allocation.Size, allocation.Alignment);
+		if (range.IsValid() == false)
+			return false;
+
+		allocation.Memory = block.Memory;
+		allocation.Offset = range.Offset;
+		allocation.MappedData = block.MappedData != nullptr ? block.MappedData + range.Offset : nullptr;
+		allocation.Block = &block;
+		allocation.Range = range;
+
+		block.Allocations.insert(&allocation);
+		return true;
+	}
+
+	VulkanAllocation* VulkanAllocator::Allocate(const VkMemoryRequirements& requirements, VulkanMemoryUsage usage, bool linear)
+	{
+		const uint32_t memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, usage);
+		const VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+
+		auto allocation = std::make_unique<VulkanAllocation>();
+		allocation->Size = requirements.size;
+		allocation->Alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+		allocation->MemoryTypeIndex = memoryTypeIndex;
+		allocation->PoolIndex = GetPoolIndex(memoryTypeIndex, linear);
+
+		std::lock_guard lock(m_mutex);
+
+		// Large resources get their own allocation instead of wasting most of a block
+		if (requirements.size > blockSize / 2)
+		{
+			void* mappedData;
+			allocation->Memory = AllocateDeviceMemory(requirements.size, memoryTypeIndex, &mappedData);
+			if (allocation->Memory == nullptr)
+				throw std::runtime_error("Failed to allocate dedicated device memory!");
+
+			allocation->MappedData = mappedData;
+			m_dedicatedAllocations.insert(allocation.get());
+			return allocation.release();
+		}
+
+		auto& pool = m_pools[allocation->PoolIndex];
+		for (const auto& block : pool.Blocks)
+		{
+			if (AllocateFromBlock(*block, *allocation))
+				return allocation.release();
+		}
+
+		void* mappedData;
+		const auto memory = AllocateDeviceMemory(blockSize, memoryTypeIndex, &mappedData);
+		if (memory == nullptr)
+			throw std::runtime_error("Failed to allocate device memory block!");
+
+		auto block = std::make_unique<VulkanMemoryBlock>(blockSize);
+		block->Memory = memory;
+		block->MappedData = static_cast<std::byte*>(mappedData);
+
+		AllocateFromBlock(*block, *allocation);
+		pool.Blocks.push_back(std::move(block));
+
+		return allocation.release();
+	}
+
+	void VulkanAllocator::Free(VulkanAllocation* allocation)
+	{
+		if (allocation == nullptr)
+			return;
+
+		std::lock_guard lock(m_mutex);
+
+		if (allocation->Block == nullptr)
+		{
+			m_dedicatedAllocations.erase(allocation);
+			vkFreeMemory(m_device, allocation->Memory, nullptr);
+		}
+		else
+		{
+			allocation->Block->Ranges.Free(allocation->Range);
+			allocation->Block->Allocations.erase(allocation);
+			m_movingAllocations.erase(allocation);
+
+			FreeBlocks(m_pools[allocation->PoolIndex], true);
+		}
+
+		delete allocation;
+	}
+
+	void VulkanAllocator::FreeBlocks(MemoryPool& pool, bool keepOne)
+	{
+		// One empty block is kept around so alloc/free patterns don't ping-pong vkAllocateMemory
+		bool keptEmptyBlock = keepOne == false;
+		std::erase_if(pool.Blocks, [&](const std::unique_ptr<VulkanMemoryBlock>& block)
+		{
+			if (block->Ranges.IsEmpty() == false)
+				return false;
+
+			if (keptEmptyBlock == false)
+			{
+				keptEmptyBlock = true;
+				return false;
+			}
+
+			vkFreeMemory(m_device, block->Memory, nullptr);
+			return true;
+		});
+	}
+
+	VulkanAllocation* VulkanAllocator::CreateBuffer(const VkBufferCreateInfo& createInfo, VulkanMemoryUsage usage)
+	{
+		// Transfer usage on every buffer, the uploader copies into them and readbacks copy out of them
+		auto bufferInfo = createInfo;
+		bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		ShareAcrossQueues(bufferInfo);
+
+		VkBuffer buffer;
+		VULKAN_CHECK(vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer));
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(m_device, buffer, &requirements);
+
+		const auto allocation = Allocate(requirements, usage, true);
+		allocation->Buffer = buffer;
+		allocation->BufferUsage = bufferInfo.usage;
+		allocation->BufferSize = bufferInfo.size;
+
+		VULKAN_CHECK(vkBindBufferMemory(m_device, buffer, allocation->Memory, allocation->Offset));
+		return allocation;
+	}
+
+	void VulkanAllocator::DestroyBuffer(VulkanAllocation* allocation)
+	{
+		if (allocation == nullptr)
+			return;
+
+		vkDestroyBuffer(m_device, allocation->Buffer, nullptr);
+		Free(allocation);
+	}
+
+	VulkanAllocation* VulkanAllocator::CreateImage(const VkImageCreateInfo& createInfo, VulkanMemoryUsage usage)
+	{
+		VkImage image;
+		VULKAN_CHECK(vkCreateImage(m_device, &createInfo, nullptr, &image));
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(m_device, image, &requirements);
+
+		const auto allocation = Allocate(requirements, usage, createInfo.tiling == VK_IMAGE_TILING_LINEAR);
+		allocation->Image = image;
+
+		VULKAN_CHECK(vkBindImageMemory(m_device, image, allocation->Memory, allocation->Offset));
+		return allocation;
+	}
+
+	void VulkanAllocator::DestroyImage(VulkanAllocation* allocation)
+	{
+		if (allocation == nullptr)
+			return;
+
+		vkDestroyImage(m_device, allocation->Image, nullptr);
+		Free(allocation);
+	}
+
+	std::unique_ptr<VulkanLinearPool> VulkanAllocator::CreateLinearPool(VkDeviceSize frameSize, uint32_t frameCount, VkBufferUsageFlags usage)
+	{
+		// Frame regions start on an alignment every descriptor type accepts
+		const auto& limits = m_physicalDevice->GetProperties().limits;
+		const VkDeviceSize alignment = std::max({ limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, (VkDeviceSize)256 });
+		frameSize = (frameSize + alignment - 1) & ~(alignment - 1);
+
+		auto bufferInfo = VkBufferCreateInfo();
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = frameSize * frameCount;
+		bufferInfo.usage = usage | (m_bufferDeviceAddress ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0);
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		const auto allocation = CreateBuffer(bufferInfo, VulkanMemoryUsage::CpuToGpu);
+
+		VkDeviceAddress deviceAddress = 0;
+		if (m_bufferDeviceAddress)
+		{
+			auto addressInfo = VkBufferDeviceAddressInfo();
+			addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+			addressInfo.buffer = allocation->Buffer;
+			deviceAddress = vkGetBufferDeviceAddress(m_device, &addressInfo);
+		}
+
+		return std::make_unique<VulkanLinearPool>(*this, allocation, frameSize, frameCount, deviceAddress);
+	}
+
+	VkDeviceSize VulkanAllocator::Defragment(VkCommandBuffer commandBuffer, VulkanDeletionQueue& deletionQueue, VkDeviceSize maxBytesToMove)
+	{
+		auto oldAllocations = std::vector<VulkanAllocation*>();
+		auto movedAllocations = std::unordered_set<VulkanAllocation*>();
+		VkDeviceSize bytesMoved = 0;
+
+		{
+			std::lock_guard lock(m_mutex);
+
+			for (auto& pool : m_pools)
+			{
+				if (pool.Blocks.size() < 2)
+					continue;
+
+				// Evacuate the emptiest blocks into the fullest ones
+				auto blocks = std::vector<VulkanMemoryBlock*>();
+				for (const auto& block : pool.Blocks)
+					blocks.push_back(block.get());
+
+				std::ranges::sort(blocks, [](const VulkanMemoryBlock* a, const VulkanMemoryBlock* b) { return a->Ranges.GetUsedSize() < b->Ranges.GetUsedSize(); });
+
+				for (size_t source = 0; source + 1 < blocks.size(); source++)
+				{
+					auto allocations = std::vector(blocks[source]->Allocations.begin(), blocks[source]->Allocations.end());
+					for (const auto allocation : allocations)
+					{
+						// Host visible buffers are written through their mapping, device addresses are baked into shader data.
+						// Moving an allocation twice would chain copies inside one command buffer.
+						if (allocation->Movable == false || allocation->Buffer == nullptr || allocation->MappedData != nullptr ||
+							(allocation->BufferUsage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) || movedAllocations.contains(allocation) ||
+							bytesMoved + allocation->Size > maxBytesToMove)
+							continue;
+
+						// The old range and buffer stay alive as their own allocation until the copy has executed
+						auto oldAllocation = std::make_unique<VulkanAllocation>(*allocation);
+						oldAllocation->Movable = false;
+
+						bool moved = false;
+						for (size_t destination = blocks.size() - 1; destination > source && moved == false; destination--)
+							moved = AllocateFromBlock(*blocks[destination], *allocation);
+
+						if (moved == false)
+							continue;
+
+						blocks[source]->Allocations.erase(allocation);
+						blocks[source]->Allocations.insert(oldAllocation.get());
+
+						auto bufferInfo = VkBufferCreateInfo();
+						bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+						bufferInfo.size = allocation->BufferSize;
+						bufferInfo.usage = allocation->BufferUsage;
+						bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+						ShareAcrossQueues(bufferInfo);
+
+						VULKAN_CHECK(vkCreateBuffer(m_device, &bufferInfo, nullptr, &allocation->Buffer));
+						VULKAN_CHECK(vkBindBufferMemory(m_device, allocation->Buffer, allocation->Memory, allocation->Offset));
+
+						if (oldAllocations.empty())
+						{
+							auto barrier = VkMemoryBarrier();
+							barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+							barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+							barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+							vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+						}
+
+						auto region = VkBufferCopy();
+						region.size = allocation->BufferSize;
+						vkCmdCopyBuffer(commandBuffer, oldAllocation->Buffer, allocation->Buffer, 1, &region);
+
+						m_movingAllocations.insert(oldAllocation.get());
+						oldAllocations.push_back(oldAllocation.release());
+						movedAllocations.insert(allocation);
+						bytesMoved += allocation->Size;
+					}
+				}
+			}
+
+			m_movedCount += oldAllocations.size();
+			m_movedBytes += bytesMoved;
+		}
+
+		if (oldAllocations.empty())
+			return 0;
+
+		auto barrier = VkMemoryBarrier();
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		// Emptied blocks go back to the driver along with the last old range in them
+		for (const auto oldAllocation : oldAllocations)
+			deletionQueue.DestroyBuffer(oldAllocation);
+
+		return bytesMoved;
+	}
+
+	std::vector<VulkanHeapStatistics> VulkanAllocator::GetStatistics() const
+	{
+		const auto& memoryProperties = m_physicalDevice->GetMemoryProperties();
+
+		auto statistics = std::vector<VulkanHeapStatistics>(memoryProperties.memoryHeapCount);
+		auto freeBytes = std::vector<VkDeviceSize>(memoryProperties.memoryHeapCount);
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+		{
+			statistics[i].HeapIndex = i;
+			statistics[i].HeapSize = memoryProperties.memoryHeaps[i].size;
+			statistics[i].Flags = memoryProperties.memoryHeaps[i].flags;
+		}
+
+		std::lock_guard lock(m_mutex);
+
+		for (const auto& pool : m_pools)
+		{
+			auto& heap = statistics[memoryProperties.memoryTypes[pool.MemoryTypeIndex].heapIndex];
+			auto& heapFreeBytes = freeBytes[heap.HeapIndex];
+
+			for (const auto& block : pool.Blocks)
+			{
+				heap.BlockCount++;
+				heap.AllocationCount += block->Ranges.GetAllocationCount();
+				heap.BlockBytes += block->Size;
+				heap.UsedBytes += block->Ranges.GetUsedSize();
+				heap.LargestFreeRange = std::max(heap.LargestFreeRange, block->Ranges.GetLargestFreeRegion());
+				heapFreeBytes += block->Ranges.GetFreeSize();
+			}
+		}
+
+		for (const auto allocation : m_dedicatedAllocations)
+		{
+			auto& heap = statistics[memoryProperties.memoryTypes[allocation->MemoryTypeIndex].heapIndex];
+			heap.DedicatedAllocationCount++;
+			heap.DedicatedBytes += allocation->Size;
+		}
+
+		for (const auto allocation : m_movingAllocations)
+		{
+			auto& heap = statistics[memoryProperties.memoryTypes[allocation->MemoryTypeIndex].heapIndex];
+			heap.AllocationCount--;
+			heap.MovingBytes += allocation->Size;
+		}
+
+		for (auto& heap : statistics)
+		{
+			const auto heapFreeBytes = freeBytes[heap.HeapIndex];
+			heap.Fragmentation = heapFreeBytes > 0 ? 1.0f - (float)heap.LargestFreeRange / (float)heapFreeBytes : 0.0f;
+		}
+
+		return statistics;
+	}
+
+	void VulkanAllocator::PrintStatistics() const
+	{
+		constexpr double MiB = 1024.0 * 1024.0;
+
+		for (const auto& heap : GetStatistics())
+		{
+			std::println("Heap {} ({:.0f} MiB{}): {} blocks, {} allocations, {:.2f}/{:.2f} MiB used, {} dedicated ({:.2f} MiB), fragmentation {:.1f}%",
+				heap.HeapIndex, (double)heap.HeapSize / MiB, heap.Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? ", device local" : "",
+				heap.BlockCount, heap.AllocationCount, (double)heap.UsedBytes / MiB, (double)heap.BlockBytes / MiB,
+				heap.DedicatedAllocationCount, (double)heap.DedicatedBytes / MiB, heap.Fragmentation * 100.0f);
+		}
+
+		std::lock_guard lock(m_mutex);
+		if (m_movedCount > 0)
+			std::println("Defragmentation: {} buffers moved, {:.2f} MiB", m_movedCount, (double)m_movedBytes / MiB);
+	}
+
+	VulkanAllocator::~VulkanAllocator()
+	{
+		if (m_dedicatedAllocations.empty() == false)
+			std::println("Allocator destroyed with {} dedicated allocations alive", m_dedicatedAllocations.size());
+
+		for (const auto allocation : m_dedicatedAllocations)
+		{
+			vkFreeMemory(m_device, allocation->Memory, nullptr);
+			delete allocation;
+		}
+
+		for (auto& pool : m_pools)
+		{
+			for (const auto& block : pool.Blocks)
+			{
+				for (const auto allocation : block->Allocations)
+					delete allocation;
+
+				vkFreeMemory(m_device, block->Memory, nullptr);
+			}
+		}
+	}
+}
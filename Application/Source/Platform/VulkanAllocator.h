@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "TlsfAllocator.h"
+
+namespace VEngine 
+{
+	class VulkanAllocator;
+	class VulkanDeletionQueue;
+	class VulkanPhysicalDevice;
+	struct VulkanAllocation;
+
+	enum class VulkanMemoryUsage
+	{
+		GpuOnly,
+		CpuToGpu,
+		GpuToCpu
+	};
+
+	struct VulkanMemoryBlock
+	{
+		VkDeviceMemory Memory = nullptr;
+		VkDeviceSize Size = 0;
+		std::byte* MappedData = nullptr;
+
+		TlsfAllocator Ranges;
+		std::unordered_set<VulkanAllocation*> Allocations;
+
+		VulkanMemoryBlock(VkDeviceSize size) : Size(size), Ranges(size) {}
+	};
+
+	struct VulkanAllocation
+	{
+		VkDeviceMemory Memory = nullptr;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		VkDeviceSize Alignment = 1;
+		void* MappedData = nullptr;
+		uint32_t MemoryTypeIndex = 0;
+
+		// Resources created through the allocator
+		VkBuffer Buffer = nullptr;
+		VkImage Image = nullptr;
+
+		// Defragmentation recreates the buffer from these. It only moves buffers their owner marked movable: device local,
+		// never registered anywhere and looked up through Buffer every time, so the new handle is picked up on its own.
+		VkBufferUsageFlags BufferUsage = 0;
+		VkDeviceSize BufferSize = 0;
+		bool Movable = false;
+
+		VulkanMemoryBlock* Block = nullptr;
+		TlsfAllocator::Allocation Range;
+		uint32_t PoolIndex = 0;
+	};
+
+	struct VulkanHeapStatistics
+	{
+		uint32_t HeapIndex = 0;
+		VkDeviceSize HeapSize = 0;
+		VkMemoryHeapFlags Flags = 0;
+
+		uint32_t BlockCount = 0;
+		uint32_t AllocationCount = 0;
+		uint32_t DedicatedAllocationCount = 0;
+
+		VkDeviceSize BlockBytes = 0;
+		VkDeviceSize UsedBytes = 0;
+		VkDeviceSize DedicatedBytes = 0;
+		VkDeviceSize LargestFreeRange = 0;
+
+		// Old ranges of buffers defragmentation moved, still in use until the copies out of them completed
+		VkDeviceSize MovingBytes = 0;
+
+		// 0 when all free space is one range, approaches 1 as it gets scattered
+		float Fragmentation = 0.0f;
+	};
+
+	struct VulkanLinearAllocation
+	{
+		VkBuffer Buffer = nullptr;
+
+		// From the start of the buffer, usable as a dynamic offset or added to a bindless buffer index
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		void* MappedData = nullptr;
+
+		// Zero unless the device enabled bufferDeviceAddress
+		VkDeviceAddress DeviceAddress = 0;
+
+		bool IsValid() const { return MappedData != nullptr; }
+	};
+
+	// Persistently mapped ring of per-frame regions for transient uniform and storage data.
+	// Allocate is a lock-free bump of the current region and safe from any thread. Reset switches to the next
+	// frame's region and must only be called from the frame thread once that slot's fence signaled.
+	class VulkanLinearPool
+	{
+	public:
+		VulkanLinearPool(VulkanAllocator& allocator, VulkanAllocation* allocation, VkDeviceSize frameSize, uint32_t frameCount, VkDeviceAddress deviceAddress);
+		VulkanLinearPool(const VulkanLinearPool&) = delete;
+		VulkanLinearPool(VulkanLinearPool&&) = delete;
+		~VulkanLinearPool();
+
+		// Memory is only valid until the same frame slot is reset again, an invalid allocation means the region is full
+		VulkanLinearAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment);
+		void Reset(uint32_t frameIndex);
+
+		VkBuffer GetBuffer() const { return m_allocation->Buffer; }
+		VkDeviceSize GetFrameSize() const { return m_frameSize; }
+		VkDeviceSize GetUsedSize() const { return m_head.load(std::memory_order_relaxed); }
+		VkDeviceSize GetPeakSize() const { return m_peak; }
+
+	private:
+		VulkanAllocator& m_allocator;
+		VulkanAllocation* m_allocation = nullptr;
+		VkDeviceSize m_frameSize = 0;
+		uint32_t m_frameCount = 0;
+		VkDeviceAddress m_deviceAddress = 0;
+
+		VkDeviceSize m_frameOffset = 0;
+		std::atomic<VkDeviceSize> m_head = 0;
+		VkDeviceSize m_peak = 0;
+	};
+
+	class VulkanAllocator
+	{
+	public:
+		// Memory is allocated with the device address flag when bufferDeviceAddress is enabled on the device
+		VulkanAllocator(VkDevice device, const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, bool bufferDeviceAddress = false);
+		VulkanAllocator(const VulkanAllocator&) = delete;
+		VulkanAllocator(VulkanAllocator&&) = delete;
+		~VulkanAllocator();
+
+		VulkanAllocation* Allocate(const VkMemoryRequirements& requirements, VulkanMemoryUsage usage, bool linear);
+		void Free(VulkanAllocation* allocation);
+
+		VulkanAllocation* CreateBuffer(const VkBufferCreateInfo& createInfo, VulkanMemoryUsage usage);
+		void DestroyBuffer(VulkanAllocation* allocation);
+
+		VulkanAllocation* CreateImage(const VkImageCreateInfo& createInfo, VulkanMemoryUsage usage);
+		void DestroyImage(VulkanAllocation* allocation);
+
+		// Device addresses are added to the usage when supported
+		std::unique_ptr<VulkanLinearPool> CreateLinearPool(VkDeviceSize frameSize, uint32_t frameCount, VkBufferUsageFlags usage);
+		bool HasBufferDeviceAddress() const { return m_bufferDeviceAddress; }
+
+		// Render thread, right after the uploader flushed, so no queued upload still targets an old buffer. Records copies
+		// moving movable buffers out of the emptiest blocks into fuller ones. The old buffers and ranges go through the
+		// deletion queue once the next graphics submission completed. Returns the bytes moved.
+		VkDeviceSize Defragment(VkCommandBuffer commandBuffer, VulkanDeletionQueue& deletionQueue, VkDeviceSize maxBytesToMove = UINT64_MAX);
+
+		std::vector<VulkanHeapStatistics> GetStatistics() const;
+		void PrintStatistics() const;
+
+	private:
+		struct MemoryPool
+		{
+			uint32_t MemoryTypeIndex = 0;
+			std::vector<std::unique_ptr<VulkanMemoryBlock>> Blocks;
+		};
+
+		uint32_t FindMemoryType(uint32_t typeBits, VulkanMemoryUsage usage) const;
+		uint32_t GetPoolIndex(uint32_t memoryTypeIndex, bool linear) const;
+		VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+
+		void ShareAcrossQueues(VkBufferCreateInfo& bufferInfo) const;
+
+		VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mappedData) const;
+		bool AllocateFromBlock(VulkanMemoryBlock& block, VulkanAllocation& allocation) const;
+		void FreeBlocks(MemoryPool& pool, bool keepOne);
+
+		VkDevice m_device;
+		std::shared_ptr<VulkanPhysicalDevice> m_physicalDevice;
+
+		// Buffers and optimal images live in separate pools when bufferImageGranularity could make them alias a page
+		bool m_separateImagePools = false;
+		bool m_bufferDeviceAddress = false;
+
+		// Every queue family the device created a queue from, buffers are concurrent across them when there are several
+		std::vector<uint32_t> m_queueFamilies;
+		std::vector<MemoryPool> m_pools;
+		std::unordered_set<VulkanAllocation*> m_dedicatedAllocations;
+
+		// Old ranges of moved buffers, waiting in the deletion queue
+		std::unordered_set<VulkanAllocation*> m_movingAllocations;
+		uint64_t m_movedCount = 0;
+		VkDeviceSize m_movedBytes = 0;
+
+		mutable std::mutex m_mutex;
+	};
+}
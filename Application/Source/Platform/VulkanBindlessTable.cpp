@@ -0,0 +1,256 @@
+#include "VulkanBindlessTable.h"
+
+#include <algorithm>
+#include <print>
+#include <stdexcept>
+
+#include "VulkanDebugger.h"
+
+namespace VEngine
+{
+	uint32_t VulkanBindlessIndexAllocator::Allocate()
+	{
+		if (m_free.empty() == false)
+		{
+			const auto index = m_free.back();
+			m_free.pop_back();
+			return index;
+		}
+
+		if (m_next == m_capacity)
+			return VulkanBindlessTable::InvalidIndex;
+
+		return m_next++;
+	}
+
+	void VulkanBindlessIndexAllocator::Free(uint32_t index, uint64_t timelineValue)
+	{
+		m_retired.push_back({ index, timelineValue });
+	}
+
+	void VulkanBindlessIndexAllocator::Recycle(uint64_t completedValue)
+	{
+		std::erase_if(m_retired, [&](const RetiredIndex& retired)
+		{
+			if (retired.TimelineValue > completedValue)
+				return false;
+
+			m_free.push_back(retired.Index);
+			return true;
+		});
+	}
+
+	VulkanBindlessTable::VulkanBindlessTable(const std::shared_ptr<VulkanLogicalDevice>& device)
+	{
+		m_device = device->GetDevice();
+		m_timeline = &device->GetGraphicsTimeline();
+
+		const auto& enabled12 = device->GetEnabledVulkan12Features();
+		m_supported = enabled12.descriptorIndexing && enabled12.runtimeDescriptorArray && enabled12.descriptorBindingPartiallyBound;
+		if (m_supported == false)
+		{
+			std::println("Bindless descriptors are not supported on this device");
+			return;
+		}
+
+		// Arrays are sized to the update-after-bind limits, the driver only pays for the slots that get written
+		const auto& limits12 = device->GetPhysicalDevice()->GetVulkan12Properties();
+		const auto imageCount = std::min({ 16384u, limits12.maxPerStageDescriptorUpdateAfterBindSampledImages, limits12.maxDescriptorSetUpdateAfterBindSampledImages });
+		const auto samplerCount = std::min({ 1024u, limits12.maxPerStageDescriptorUpdateAfterBindSamplers, limits12.maxDescriptorSetUpdateAfterBindSamplers });
+		const auto bufferCount = std::min({ 16384u, limits12.maxPerStageDescriptorUpdateAfterBindStorageBuffers, limits12.maxDescriptorSetUpdateAfterBindStorageBuffers });
+
+		m_indices[(size_t)VulkanBindlessType::SampledImage] = VulkanBindlessIndexAllocator(imageCount);
+		m_indices[(size_t)VulkanBindlessType::Sampler] = VulkanBindlessIndexAllocator(samplerCount);
+		m_indices[(size_t)VulkanBindlessType::StorageBuffer] = VulkanBindlessIndexAllocator(bufferCount);
+
+		const VkDescriptorSetLayoutBinding bindings[] =
+		{
+			{ 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, imageCount, VK_SHADER_STAGE_ALL, nullptr },
+			{ 1, VK_DESCRIPTOR_TYPE_SAMPLER, samplerCount, VK_SHADER_STAGE_ALL, nullptr },
+			{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, bufferCount, VK_SHADER_STAGE_ALL, nullptr }
+		};
+
+		constexpr VkDescriptorBindingFlags bindingFlag = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		const VkDescriptorBindingFlags bindingFlags[] = { bindingFlag, bindingFlag, bindingFlag };
+
+		auto bindingFlagsInfo = VkDescriptorSetLayoutBindingFlagsCreateInfo();
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = (uint32_t)std::size(bindingFlags);
+		bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+		auto setLayoutInfo = VkDescriptorSetLayoutCreateInfo();
+		setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		setLayoutInfo.pNext = &bindingFlagsInfo;
+		setLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		setLayoutInfo.bindingCount = (uint32_t)std::size(bindings);
+		setLayoutInfo.pBindings = bindings;
+
+		VULKAN_CHECK(vkCreateDescriptorSetLayout(m_device, &setLayoutInfo, nullptr, &m_setLayout));
+
+		const VkDescriptorPoolSize poolSizes[] =
+		{
+			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, imageCount },
+			{ VK_DESCRIPTOR_TYPE_SAMPLER, samplerCount },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, bufferCount }
+		};
+
+		auto poolInfo = VkDescriptorPoolCreateInfo();
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = (uint32_t)std::size(poolSizes);
+		poolInfo.pPoolSizes = poolSizes;
+
+		VULKAN_CHECK(vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool));
+
+		auto allocateInfo = VkDescriptorSetAllocateInfo();
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = m_descriptorPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &m_setLayout;
+
+		VULKAN_CHECK(vkAllocateDescriptorSets(m_device, &allocateInfo, &m_descriptorSet));
+
+		// Every bindless pipeline shares this layout, so switching pipelines never disturbs the bound set
+		auto pushConstantRange = VkPushConstantRange();
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_ALL;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = PushConstantSize;
+
+		auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo();
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &m_setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		VULKAN_CHECK(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout));
+	}
+
+	void VulkanBindlessTable::BeginFrame()
+	{
+		const auto completedValue = m_timeline->GetCompletedValue();
+
+		std::lock_guard lock(m_mutex);
+		for (auto& indices : m_indices)
+			indices.Recycle(completedValue);
+	}
+
+	uint32_t VulkanBindlessTable::Allocate(VulkanBindlessType type)
+	{
+		if (m_supported == false)
+			return InvalidIndex;
+
+		const auto index = m_indices[(size_t)type].Allocate();
+		if (index == InvalidIndex)
+			throw std::runtime_error("Bindless table is full!");
+
+		return index;
+	}
+
+	void VulkanBindlessTable::WriteImage(uint32_t binding, VkDescriptorType descriptorType, uint32_t index, const VkDescriptorImageInfo& imageInfo)
+	{
+		auto write = VkWriteDescriptorSet();
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_descriptorSet;
+		write.dstBinding = binding;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = descriptorType;
+		write.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+	}
+
+	uint32_t VulkanBindlessTable::RegisterSampledImage(VkImageView view, VkImageLayout layout)
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto index = Allocate(VulkanBindlessType::SampledImage);
+		if (index != InvalidIndex)
+			WriteImage(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, index, { nullptr, view, layout });
+
+		return index;
+	}
+
+	void VulkanBindlessTable::UpdateSampledImage(uint32_t index, VkImageView view, VkImageLayout layout)
+	{
+		std::lock_guard lock(m_mutex);
+
+		if (m_supported && index != InvalidIndex)
+			WriteImage(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, index, { nullptr, view, layout });
+	}
+
+	uint32_t VulkanBindlessTable::RegisterSampler(VkSampler sampler)
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto index = Allocate(VulkanBindlessType::Sampler);
+		if (index != InvalidIndex)
+			WriteImage(1, VK_DESCRIPTOR_TYPE_SAMPLER, index, { sampler, nullptr, VK_IMAGE_LAYOUT_UNDEFINED });
+
+		return index;
+	}
+
+	uint32_t VulkanBindlessTable::RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto index = Allocate(VulkanBindlessType::StorageBuffer);
+		if (index == InvalidIndex)
+			return index;
+
+		const auto bufferInfo = VkDescriptorBufferInfo{ buffer, offset, range };
+
+		auto write = VkWriteDescriptorSet();
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_descriptorSet;
+		write.dstBinding = 2;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+		return index;
+	}
+
+	void VulkanBindlessTable::Release(VulkanBindlessType type, uint32_t index)
+	{
+		if (index == InvalidIndex)
+			return;
+
+		// Submissions up to the pending one may have recorded the slot, later ones can no longer see it
+		std::lock_guard lock(m_mutex);
+		m_indices[(size_t)type].Free(index, m_timeline->GetPendingValue());
+	}
+
+	void VulkanBindlessTable::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint) const
+	{
+		if (m_supported)
+			vkCmdBindDescriptorSets(commandBuffer, bindPoint, m_pipelineLayout, 0, 1, &m_descriptorSet, 0, nullptr);
+	}
+
+	void VulkanBindlessTable::PrintStatistics() const
+	{
+		if (m_supported == false)
+			return;
+
+		std::lock_guard lock(m_mutex);
+		const auto& images = m_indices[(size_t)VulkanBindlessType::SampledImage];
+		const auto& samplers = m_indices[(size_t)VulkanBindlessType::Sampler];
+		const auto& buffers = m_indices[(size_t)VulkanBindlessType::StorageBuffer];
+
+		std::println("Bindless table: {}/{} images, {}/{} samplers, {}/{} storage buffers",
+			images.GetUsedCount(), images.GetCapacity(), samplers.GetUsedCount(), samplers.GetCapacity(), buffers.GetUsedCount(), buffers.GetCapacity());
+	}
+
+	VulkanBindlessTable::~VulkanBindlessTable()
+	{
+		// The set is freed with its pool
+		vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+	}
+}
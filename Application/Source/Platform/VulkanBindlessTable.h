@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "VulkanDevice.h"
+#include "VulkanTimeline.h"
+
+namespace VEngine
+{
+	enum class VulkanBindlessType
+	{
+		SampledImage,
+		Sampler,
+		StorageBuffer,
+		Count
+	};
+
+	// Hands out array slots, freed slots are only reused once the submissions that could still read them have completed
+	class VulkanBindlessIndexAllocator
+	{
+	public:
+		VulkanBindlessIndexAllocator() = default;
+		VulkanBindlessIndexAllocator(uint32_t capacity) : m_capacity(capacity) { }
+
+		uint32_t Allocate();
+		void Free(uint32_t index, uint64_t timelineValue);
+		void Recycle(uint64_t completedValue);
+
+		uint32_t GetCapacity() const { return m_capacity; }
+		uint32_t GetUsedCount() const { return m_next - (uint32_t)m_free.size() - (uint32_t)m_retired.size(); }
+
+	private:
+		struct RetiredIndex
+		{
+			uint32_t Index = 0;
+			uint64_t TimelineValue = 0;
+		};
+
+		uint32_t m_capacity = 0;
+		uint32_t m_next = 0;
+		std::vector<uint32_t> m_free;
+		std::vector<RetiredIndex> m_retired;
+	};
+
+	// One global descriptor set with large partially bound arrays, shaders index resources by integer handle.
+	// Binding layout: 0 = sampled images, 1 = samplers, 2 = storage buffers.
+	class VulkanBindlessTable
+	{
+	public:
+		static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+		// Guaranteed minimum of maxPushConstantsSize, shared by every bindless pipeline
+		static constexpr uint32_t PushConstantSize = 128;
+
+		explicit VulkanBindlessTable(const std::shared_ptr<VulkanLogicalDevice>& device);
+		VulkanBindlessTable(const VulkanBindlessTable&) = delete;
+		VulkanBindlessTable(VulkanBindlessTable&&) = delete;
+		~VulkanBindlessTable();
+
+		// Needs the descriptor indexing features, pipelines fall back to an empty layout otherwise
+		bool IsSupported() const { return m_supported; }
+
+		// Call once per frame, recycles the slots whose last reader passed on the graphics timeline
+		void BeginFrame();
+
+		uint32_t RegisterSampledImage(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		uint32_t RegisterSampler(VkSampler sampler);
+		uint32_t RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+		// Rewrites a live slot, e.g. when a streamed texture gets more mips
+		void UpdateSampledImage(uint32_t index, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// The slot keeps its old descriptor until the next graphics submission has completed
+		void Release(VulkanBindlessType type, uint32_t index);
+
+		// Binds set 0, it stays bound across every pipeline that uses GetPipelineLayout
+		void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+
+		VkDescriptorSetLayout GetSetLayout() const { return m_setLayout; }
+		VkPipelineLayout GetPipelineLayout() const { return m_pipelineLayout; }
+
+		uint32_t GetCapacity(VulkanBindlessType type) const { return m_indices[(size_t)type].GetCapacity(); }
+		void PrintStatistics() const;
+
+	private:
+		uint32_t Allocate(VulkanBindlessType type);
+		void WriteImage(uint32_t binding, VkDescriptorType descriptorType, uint32_t index, const VkDescriptorImageInfo& imageInfo);
+
+		VkDevice m_device;
+		VulkanTimeline* m_timeline;
+		bool m_supported = false;
+
+		VkDescriptorSetLayout m_setLayout = nullptr;
+		VkDescriptorPool m_descriptorPool = nullptr;
+		VkDescriptorSet m_descriptorSet = nullptr;
+		VkPipelineLayout m_pipelineLayout = nullptr;
+
+		mutable std::mutex m_mutex;
+		VulkanBindlessIndexAllocator m_indices[(size_t)VulkanBindlessType::Count];
+	};
+}
@@ -0,0 +1,30 @@
+#include "VulkanBuffer.h"
+
+#include "Renderer.h"
+
+namespace VEngine
+{
+	VulkanBuffer::VulkanBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VulkanMemoryUsage memoryUsage)
+	{
+		auto& allocator = Renderer::GetScope().GetVulkanDevice()->GetAllocator();
+
+		auto bufferInfo = VkBufferCreateInfo();
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		m_size = size;
+		m_allocation = allocator.CreateBuffer(bufferInfo, memoryUsage);
+	}
+
+	VulkanBuffer::~VulkanBuffer()
+	{
+		if (m_allocation == nullptr)
+			return;
+
+		auto& allocator = Renderer::GetScope().GetVulkanDevice()->GetAllocator();
+		allocator.DestroyBuffer(m_allocation);
+		m_allocation = nullptr;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "VulkanAllocator.h"
+
+namespace VEngine 
+{
+	class VulkanBuffer
+	{
+	public:
+		VulkanBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VulkanMemoryUsage memoryUsage = VulkanMemoryUsage::GpuOnly);
+		VulkanBuffer(const VulkanBuffer&) = delete;
+		VulkanBuffer(VulkanBuffer&&) = delete;
+		~VulkanBuffer();
+
+		VkBuffer GetBuffer() const { return m_allocation->Buffer; }
+		VkDeviceSize GetSize() const { return m_size; }
+
+		// Null unless the buffer lives in host visible memory
+		void* GetMappedData() const { return m_allocation->MappedData; }
+
+		const VulkanAllocation& GetAllocation() const { return *m_allocation; }
+
+		// Lets defragmentation move a device local buffer, only for owners that never keep or register the VkBuffer
+		void SetMovable(bool movable) { m_allocation->Movable = movable; }
+
+	private:
+		VkDeviceSize m_size = 0;
+		VulkanAllocation* m_allocation = nullptr;
+	};
+}
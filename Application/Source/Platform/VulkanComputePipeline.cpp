@@ -0,0 +1,39 @@
+#include "VulkanComputePipeline.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanScope.h"
+#include "Renderer.h"
+
+#include <chrono>
+
+namespace VEngine
+{
+	VulkanComputePipeline::VulkanComputePipeline(const std::shared_ptr<VulkanShader>& shader, VkPipelineLayout sharedLayout)
+	{
+		const auto device = Renderer::GetScope().GetVulkanDevice()->GetDevice();
+		auto& pipelineCache = Renderer::GetScope().GetVulkanDevice()->GetPipelineCache();
+
+		m_layout = sharedLayout;
+		if (m_layout == nullptr)
+		{
+			const VulkanShaderReflection* reflections[] = { &shader->GetReflection() };
+			m_reflectedLayout = std::make_unique<VulkanReflectedLayout>(reflections);
+			m_layout = m_reflectedLayout->GetLayout();
+		}
+
+		auto pipelineInfo = VkComputePipelineCreateInfo();
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = shader->GetCreateInfo();
+		pipelineInfo.layout = m_layout;
+
+		const auto startTime = std::chrono::steady_clock::now();
+		VULKAN_CHECK(vkCreateComputePipelines(device, pipelineCache.GetCache(), 1, &pipelineInfo, nullptr, &m_pipeline));
+
+		pipelineCache.RecordPipeline(nullptr, std::chrono::steady_clock::now() - startTime);
+	}
+
+	VulkanComputePipeline::~VulkanComputePipeline()
+	{
+		// Frames in flight may still dispatch with it, e.g. after a reload swapped it out
+		Renderer::GetScope().GetVulkanDevice()->GetDeletionQueue().Destroy(m_pipeline);
+	}
+}
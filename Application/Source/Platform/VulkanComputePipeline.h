@@ -0,0 +1,26 @@
+#pragma once
+
+#include "VulkanShader.h"
+
+#include <memory>
+
+namespace VEngine 
+{
+	class VulkanComputePipeline
+	{
+	public:
+		// A null layout is reflected from the shader and owned, shared layouts such as the bindless table's are borrowed
+		VulkanComputePipeline(const std::shared_ptr<VulkanShader>& shader, VkPipelineLayout sharedLayout = nullptr);
+		VulkanComputePipeline(const VulkanComputePipeline&) = delete;
+		VulkanComputePipeline(VulkanComputePipeline&&) = delete;
+		~VulkanComputePipeline();
+
+		VkPipeline GetPipeline() const { return m_pipeline; }
+		VkPipelineLayout GetLayout() const { return m_layout; }
+
+	private:
+		std::unique_ptr<VulkanReflectedLayout> m_reflectedLayout = nullptr;
+		VkPipelineLayout m_layout = nullptr;
+		VkPipeline m_pipeline = nullptr;
+	};
+}
@@ -0,0 +1,123 @@
+#include "VulkanDeletionQueue.h"
+#include "VulkanAllocator.h"
+
+#include <algorithm>
+#include <print>
+
+namespace VEngine
+{
+	VulkanDeletionQueue::VulkanDeletionQueue(VkDevice device, VulkanAllocator& allocator, VulkanTimeline& timeline)
+		: m_device(device), m_allocator(allocator), m_timeline(timeline)
+	{
+	}
+
+	VulkanDeletionQueue::~VulkanDeletionQueue()
+	{
+		Flush();
+	}
+
+	void VulkanDeletionQueue::Push(Type type, uint64_t object, uint64_t timelineValue)
+	{
+		if (object == 0)
+			return;
+
+		if (timelineValue == 0)
+			timelineValue = m_timeline.GetPendingValue();
+
+		std::lock_guard lock(m_mutex);
+		m_entries.push_back({ timelineValue, type, object });
+		m_peakPendingCount = std::max(m_peakPendingCount, m_entries.size());
+	}
+
+	void VulkanDeletionQueue::Collect()
+	{
+		auto ready = std::vector<Entry>();
+		{
+			std::lock_guard lock(m_mutex);
+			if (m_entries.empty())
+				return;
+
+			// Most entries wait for one of the last few frames, a single completed value read covers all of them
+			const auto completedValue = m_timeline.GetCompletedValue();
+			const auto pending = std::ranges::stable_partition(m_entries, [&](const Entry& entry) { return entry.TimelineValue <= completedValue; });
+			ready.assign(m_entries.begin(), pending.begin());
+			m_entries.erase(m_entries.begin(), pending.begin());
+			m_destroyedCount += ready.size();
+		}
+
+		// Outside the lock, workers keep queueing while the objects go
+		for (const auto& entry : ready)
+			DestroyEntry(entry);
+	}
+
+	void VulkanDeletionQueue::Flush()
+	{
+		auto entries = std::vector<Entry>();
+		{
+			std::lock_guard lock(m_mutex);
+			entries.swap(m_entries);
+			m_destroyedCount += entries.size();
+		}
+
+		for (const auto& entry : entries)
+			DestroyEntry(entry);
+	}
+
+	void VulkanDeletionQueue::DestroyEntry(const Entry& entry) const
+	{
+		switch (entry.ObjectType)
+		{
+		case Type::Pipeline:
+			vkDestroyPipeline(m_device, (VkPipeline)entry.Object, nullptr);
+			break;
+		case Type::PipelineLayout:
+			vkDestroyPipelineLayout(m_device, (VkPipelineLayout)entry.Object, nullptr);
+			break;
+		case Type::DescriptorSetLayout:
+			vkDestroyDescriptorSetLayout(m_device, (VkDescriptorSetLayout)entry.Object, nullptr);
+			break;
+		case Type::RenderPass:
+			vkDestroyRenderPass(m_device, (VkRenderPass)entry.Object, nullptr);
+			break;
+		case Type::Framebuffer:
+			vkDestroyFramebuffer(m_device, (VkFramebuffer)entry.Object, nullptr);
+			break;
+		case Type::ImageView:
+			vkDestroyImageView(m_device, (VkImageView)entry.Object, nullptr);
+			break;
+		case Type::Image:
+			vkDestroyImage(m_device, (VkImage)entry.Object, nullptr);
+			break;
+		case Type::Sampler:
+			vkDestroySampler(m_device, (VkSampler)entry.Object, nullptr);
+			break;
+		case Type::CommandPool:
+			vkDestroyCommandPool(m_device, (VkCommandPool)entry.Object, nullptr);
+			break;
+		case Type::Semaphore:
+			vkDestroySemaphore(m_device, (VkSemaphore)entry.Object, nullptr);
+			break;
+		case Type::AllocatedBuffer:
+			m_allocator.DestroyBuffer(ToAllocation(entry.Object));
+			break;
+		case Type::AllocatedImage:
+			m_allocator.DestroyImage(ToAllocation(entry.Object));
+			break;
+		case Type::Allocation:
+			m_allocator.Free(ToAllocation(entry.Object));
+			break;
+		}
+	}
+
+	size_t VulkanDeletionQueue::GetPendingCount() const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_entries.size();
+	}
+
+	void VulkanDeletionQueue::PrintStatistics() const
+	{
+		std::lock_guard lock(m_mutex);
+		std::println("Deletion queue: {} objects destroyed, {} pending, peak {} pending", m_destroyedCount, m_entries.size(), m_peakPendingCount);
+	}
+}
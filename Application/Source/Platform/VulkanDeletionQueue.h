@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "VulkanTimeline.h"
+
+namespace VEngine
+{
+	class VulkanAllocator;
+	struct VulkanAllocation;
+
+	// Vulkan objects released while submitted work may still use them. Each one waits for a value on the graphics
+	// timeline, the submission that last used it, and is destroyed by the first Collect after the GPU passed it.
+	// Releasing something therefore never waits for the GPU, not even when a pipeline or a whole level goes away.
+	class VulkanDeletionQueue
+	{
+	public:
+		VulkanDeletionQueue(VkDevice device, VulkanAllocator& allocator, VulkanTimeline& timeline);
+		VulkanDeletionQueue(const VulkanDeletionQueue&) = delete;
+		VulkanDeletionQueue(VulkanDeletionQueue&&) = delete;
+
+		// Destroys everything still queued, the device must be idle
+		~VulkanDeletionQueue();
+
+		// Any thread. Zero waits for the next graphics submission, so anything recorded so far may still use the object.
+		void Destroy(VkPipeline pipeline, uint64_t timelineValue = 0) { Push(Type::Pipeline, ToHandle(pipeline), timelineValue); }
+		void Destroy(VkPipelineLayout layout, uint64_t timelineValue = 0) { Push(Type::PipelineLayout, ToHandle(layout), timelineValue); }
+		void Destroy(VkDescriptorSetLayout layout, uint64_t timelineValue = 0) { Push(Type::DescriptorSetLayout, ToHandle(layout), timelineValue); }
+		void Destroy(VkRenderPass renderPass, uint64_t timelineValue = 0) { Push(Type::RenderPass, ToHandle(renderPass), timelineValue); }
+		void Destroy(VkFramebuffer framebuffer, uint64_t timelineValue = 0) { Push(Type::Framebuffer, ToHandle(framebuffer), timelineValue); }
+		void Destroy(VkImageView imageView, uint64_t timelineValue = 0) { Push(Type::ImageView, ToHandle(imageView), timelineValue); }
+		void Destroy(VkImage image, uint64_t timelineValue = 0) { Push(Type::Image, ToHandle(image), timelineValue); }
+		void Destroy(VkSampler sampler, uint64_t timelineValue = 0) { Push(Type::Sampler, ToHandle(sampler), timelineValue); }
+		void Destroy(VkCommandPool commandPool, uint64_t timelineValue = 0) { Push(Type::CommandPool, ToHandle(commandPool), timelineValue); }
+		void Destroy(VkSemaphore semaphore, uint64_t timelineValue = 0) { Push(Type::Semaphore, ToHandle(semaphore), timelineValue); }
+
+		// Allocator resources, through DestroyBuffer, DestroyImage and Free
+		void DestroyBuffer(VulkanAllocation* allocation, uint64_t timelineValue = 0) { Push(Type::AllocatedBuffer, ToHandle(allocation), timelineValue); }
+		void DestroyImage(VulkanAllocation* allocation, uint64_t timelineValue = 0) { Push(Type::AllocatedImage, ToHandle(allocation), timelineValue); }
+		void Free(VulkanAllocation* allocation, uint64_t timelineValue = 0) { Push(Type::Allocation, ToHandle(allocation), timelineValue); }
+
+		// Render thread once per frame. Objects waiting for the same value go in the order they were queued.
+		void Collect();
+
+		// Destroys everything regardless of the timeline, the device must be idle
+		void Flush();
+
+		size_t GetPendingCount() const;
+		void PrintStatistics() const;
+
+	private:
+		enum class Type : uint32_t
+		{
+			Pipeline,
+			PipelineLayout,
+			DescriptorSetLayout,
+			RenderPass,
+			Framebuffer,
+			ImageView,
+			Image,
+			Sampler,
+			CommandPool,
+			Semaphore,
+			AllocatedBuffer,
+			AllocatedImage,
+			Allocation
+		};
+
+		// Non-dispatchable handles are 64 bit integers on 32 bit targets, every handle and pointer fits 64 bits
+		struct Entry
+		{
+			uint64_t TimelineValue = 0;
+			Type ObjectType = Type::Pipeline;
+			uint64_t Object = 0;
+		};
+
+		template <typename T>
+		static uint64_t ToHandle(T object) { return (uint64_t)object; }
+
+		static uint64_t ToHandle(VulkanAllocation* allocation) { return (uint64_t)reinterpret_cast<uintptr_t>(allocation); }
+		static VulkanAllocation* ToAllocation(uint64_t object) { return reinterpret_cast<VulkanAllocation*>((uintptr_t)object); }
+
+		void Push(Type type, uint64_t object, uint64_t timelineValue);
+		void DestroyEntry(const Entry& entry) const;
+
+		VkDevice m_device;
+		VulkanAllocator& m_allocator;
+		VulkanTimeline& m_timeline;
+
+		mutable std::mutex m_mutex;
+		std::vector<Entry> m_entries;
+
+		uint64_t m_destroyedCount = 0;
+		size_t m_peakPendingCount = 0;
+	};
+}
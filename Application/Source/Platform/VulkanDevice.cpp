@@ -1,4 +1,6 @@
 #include "VulkanDevice.h"
+#include "VulkanAllocator.h"
+#include "VulkanPipelineCache.h"
 #include "VulkanScope.h"
 
 #include <print>
@@ -37,6 +39,26 @@ namespace VEngine
 		vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_deviceFeatures);
 		vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_deviceMemoryProperties);
 
+		// Vulkan 1.2 features and limits are only reachable through the features2 and properties2 chains
+		m_vulkan12Features = VkPhysicalDeviceVulkan12Features();
+		m_vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		m_vulkan12Properties = VkPhysicalDeviceVulkan12Properties();
+		m_vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+		if (m_deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+		{
+			auto features2 = VkPhysicalDeviceFeatures2();
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &m_vulkan12Features;
+			vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+			m_vulkan12Features.pNext = nullptr;
+
+			auto properties2 = VkPhysicalDeviceProperties2();
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties2.pNext = &m_vulkan12Properties;
+			vkGetPhysicalDeviceProperties2(m_physicalDevice, &properties2);
+			m_vulkan12Properties.pNext = nullptr;
+		}
+
 		uint32_t extCount = 0;
 		VULKAN_CHECK(vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extCount, nullptr));
 		auto extensions = std::vector<VkExtensionProperties>(extCount);
@@ -53,6 +75,23 @@ namespace VEngine
 			std::println();
 		}
 
+		// Dynamic rendering is still an extension on 1.2, its feature bit says whether the driver really implements it
+		if (IsExtensionSupported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) && m_deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+		{
+			auto dynamicRenderingFeatures = VkPhysicalDeviceDynamicRenderingFeaturesKHR();
+			dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+			auto features2 = VkPhysicalDeviceFeatures2();
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &dynamicRenderingFeatures;
+			vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+
+			m_dynamicRendering = dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+		}
+
+		// The budget struct is only filled through the 1.1 properties2 entry point
+		m_memoryBudget = IsExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) && m_deviceProperties.apiVersion >= VK_API_VERSION_1_1;
+
 		// Setup Queue Families
 		uint32_t queueFamilyCount;
 		vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
@@ -63,31 +102,98 @@ namespace VEngine
 		static constexpr float defaultQueuePriority = 1.0f;
 		m_queueFamilyIndices = FindQueueFamilyIndices();
 
-		// Graphics Family
-		auto queueInfo = VkDeviceQueueCreateInfo();
-		queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		queueInfo.queueFamilyIndex = m_queueFamilyIndices.GraphicsFamily.value();
-		queueInfo.queueCount = 1;
-		queueInfo.pQueuePriorities = &defaultQueuePriority;
-		m_queueCreateInfos.push_back(queueInfo);
+		if (m_queueFamilyIndices.GraphicsFamily.has_value() == false)
+			throw std::runtime_error("There's no available graphics family queue on GPU!");
+
+		// One queue per distinct family
+		for (const auto& family : { m_queueFamilyIndices.GraphicsFamily, m_queueFamilyIndices.ComputeFamily, m_queueFamilyIndices.TransferFamily })
+		{
+			if (family.has_value() == false)
+				continue;
+
+			auto queueInfo = VkDeviceQueueCreateInfo();
+			queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueInfo.queueFamilyIndex = family.value();
+			queueInfo.queueCount = 1;
+			queueInfo.pQueuePriorities = &defaultQueuePriority;
+			m_queueCreateInfos.push_back(queueInfo);
+		}
+
+		std::println("Queue families: graphics {}, compute {}, transfer {}", m_queueFamilyIndices.GraphicsFamily.value(),
+			m_queueFamilyIndices.ComputeFamily.has_value() ? std::to_string(m_queueFamilyIndices.ComputeFamily.value()) : "shared",
+			m_queueFamilyIndices.TransferFamily.has_value() ? std::to_string(m_queueFamilyIndices.TransferFamily.value()) : "shared");
 	}
 
 	QueueFamilyIndices VulkanPhysicalDevice::FindQueueFamilyIndices() const
 	{
 		QueueFamilyIndices indices;
 
+		// Async compute wants a family without graphics, transfer one without graphics and compute (usually a DMA engine)
 		for (size_t i = 0; i < m_queueFamilyProperties.size(); i++)
 		{
-			if (m_queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
-			{
-				indices.GraphicsFamily = (int32_t)i;
-				break;
-			}
+			const auto flags = m_queueFamilyProperties[i].queueFlags;
+			if (m_queueFamilyProperties[i].queueCount == 0)
+				continue;
+
+			if ((flags & VK_QUEUE_GRAPHICS_BIT) && indices.GraphicsFamily.has_value() == false)
+				indices.GraphicsFamily = (uint32_t)i;
+			else if ((flags & VK_QUEUE_COMPUTE_BIT) && (flags & VK_QUEUE_GRAPHICS_BIT) == 0 && indices.ComputeFamily.has_value() == false)
+				indices.ComputeFamily = (uint32_t)i;
+			else if ((flags & VK_QUEUE_TRANSFER_BIT) && (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0 && indices.TransferFamily.has_value() == false)
+				indices.TransferFamily = (uint32_t)i;
 		}
 
 		return indices;
 	}
 
+	uint32_t VulkanPhysicalDevice::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+	{
+		auto selectedType = UINT32_MAX;
+		for (uint32_t i = 0; i < m_deviceMemoryProperties.memoryTypeCount; i++)
+		{
+			const auto flags = m_deviceMemoryProperties.memoryTypes[i].propertyFlags;
+			if ((typeBits & (1u << i)) == 0 || (flags & required) != required)
+				continue;
+
+			if ((flags & preferred) == preferred)
+				return i;
+
+			if (selectedType == UINT32_MAX)
+				selectedType = i;
+		}
+
+		if (selectedType == UINT32_MAX)
+			throw std::runtime_error("Failed to find suitable memory type!");
+
+		return selectedType;
+	}
+
+	VulkanHeapBudget VulkanPhysicalDevice::GetHeapBudget(uint32_t heapIndex) const
+	{
+		auto heapBudget = VulkanHeapBudget();
+		if (heapIndex >= m_deviceMemoryProperties.memoryHeapCount)
+			return heapBudget;
+
+		if (m_memoryBudget == false)
+		{
+			// Roughly what drivers report for an otherwise idle system
+			heapBudget.Budget = m_deviceMemoryProperties.memoryHeaps[heapIndex].size / 10 * 8;
+			return heapBudget;
+		}
+
+		auto budgetProperties = VkPhysicalDeviceMemoryBudgetPropertiesEXT();
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		auto memoryProperties2 = VkPhysicalDeviceMemoryProperties2();
+		memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		memoryProperties2.pNext = &budgetProperties;
+		vkGetPhysicalDeviceMemoryProperties2(m_physicalDevice, &memoryProperties2);
+
+		heapBudget.Budget = budgetProperties.heapBudget[heapIndex];
+		heapBudget.Usage = budgetProperties.heapUsage[heapIndex];
+		return heapBudget;
+	}
+
 	VulkanPhysicalDevice::~VulkanPhysicalDevice()
 	{
 		
@@ -98,30 +204,129 @@ namespace VEngine
 		m_physicalDevice = physicalDevice;
 		const auto qInfos = m_physicalDevice->GetQueueFamilyInfos();
 
-		std::vector deviceExtensions =
+		// Swapchain is optional so headless hosts without presentation support still get a device
+		std::vector<const char*> deviceExtensions;
+		const auto enableIfSupported = [&](const char* extensionName)
 		{
-			VK_KHR_SWAPCHAIN_EXTENSION_NAME
+			if (physicalDevice->IsExtensionSupported(extensionName) == false)
+				return;
+
+			deviceExtensions.push_back(extensionName);
+			m_enabledExtensions.emplace(extensionName);
 		};
 
+		enableIfSupported(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		enableIfSupported(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+		if (physicalDevice->SupportsMemoryBudget())
+			enableIfSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		// Only the 1.2 features the engine actually uses are turned on
+		const auto& supported12 = physicalDevice->GetVulkan12Features();
+		m_enabledVulkan12Features = VkPhysicalDeviceVulkan12Features();
+		m_enabledVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		m_enabledVulkan12Features.hostQueryReset = supported12.hostQueryReset;
+		m_enabledVulkan12Features.drawIndirectCount = supported12.drawIndirectCount;
+		m_enabledVulkan12Features.bufferDeviceAddress = supported12.bufferDeviceAddress;
+
+		// Frame pacing and resource recycling track the GPU through timeline values, core and mandatory in 1.2
+		if (supported12.timelineSemaphore == VK_FALSE)
+			throw std::runtime_error("Selected GPU has no timeline semaphore support, Vulkan 1.2 is required!");
+
+		m_enabledVulkan12Features.timelineSemaphore = VK_TRUE;
+
+		// Descriptor indexing backs the bindless table, it is all or nothing
+		const bool bindless = supported12.descriptorIndexing && supported12.runtimeDescriptorArray && supported12.descriptorBindingPartiallyBound &&
+			supported12.descriptorBindingUpdateUnusedWhilePending && supported12.descriptorBindingSampledImageUpdateAfterBind &&
+			supported12.descriptorBindingStorageBufferUpdateAfterBind && supported12.shaderSampledImageArrayNonUniformIndexing &&
+			supported12.shaderStorageBufferArrayNonUniformIndexing;
+
+		if (bindless)
+		{
+			m_enabledVulkan12Features.descriptorIndexing = VK_TRUE;
+			m_enabledVulkan12Features.runtimeDescriptorArray = VK_TRUE;
+			m_enabledVulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+			m_enabledVulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			m_enabledVulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			m_enabledVulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+			m_enabledVulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			m_enabledVulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+		}
+
+		// Render targets and the render graph skip render pass and framebuffer objects when this is on
+		auto dynamicRenderingFeatures = VkPhysicalDeviceDynamicRenderingFeaturesKHR();
+		dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+		dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+
+		if (physicalDevice->SupportsDynamicRendering())
+		{
+			enableIfSupported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+			m_enabledVulkan12Features.pNext = &dynamicRenderingFeatures;
+		}
+
+		auto features2 = VkPhysicalDeviceFeatures2();
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.features = physicalDevice->GetFeatures();
+		if (physicalDevice->GetProperties().apiVersion >= VK_API_VERSION_1_2)
+			features2.pNext = &m_enabledVulkan12Features;
+
 		auto createInfo = VkDeviceCreateInfo();
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		createInfo.pQueueCreateInfos = qInfos.data();
 		createInfo.queueCreateInfoCount = (uint32_t)qInfos.size();
-		createInfo.pEnabledFeatures = &physicalDevice->GetFeatures();
+		createInfo.pNext = &features2;
 		createInfo.enabledExtensionCount = (uint32_t)deviceExtensions.size();
 		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
 		VULKAN_CHECK(vkCreateDevice(physicalDevice->GetDevice(), &createInfo, nullptr, &m_logicalDevice));
+		m_enabledVulkan12Features.pNext = nullptr;
 
-		const auto graphicsFamilyIndex = physicalDevice->GetQueueFamilyIndices().GraphicsFamily;
-		if (graphicsFamilyIndex.has_value() == false)
-			throw std::runtime_error("There's available graphics family queue on GPU!");
+		if (IsExtensionEnabled(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+		{
+			m_cmdBeginRendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(m_logicalDevice, "vkCmdBeginRenderingKHR");
+			m_cmdEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(m_logicalDevice, "vkCmdEndRenderingKHR");
+		}
+
+		const auto& familyIndices = physicalDevice->GetQueueFamilyIndices();
+		const auto createQueue = [&](const std::optional<uint32_t>& family)
+		{
+			if (family.has_value() == false)
+				return m_queues[(size_t)VulkanQueueType::Graphics];
+
+			return m_ownedQueues.emplace_back(std::make_unique<VulkanQueue>(m_logicalDevice, family.value())).get();
+		};
+
+		m_queues[(size_t)VulkanQueueType::Graphics] = createQueue(familyIndices.GraphicsFamily);
+		m_queues[(size_t)VulkanQueueType::Compute] = createQueue(familyIndices.ComputeFamily);
+		m_queues[(size_t)VulkanQueueType::Transfer] = createQueue(familyIndices.TransferFamily);
+
+		m_allocator = std::make_unique<VulkanAllocator>(m_logicalDevice, m_physicalDevice, m_enabledVulkan12Features.bufferDeviceAddress);
+		m_deletionQueue = std::make_unique<VulkanDeletionQueue>(m_logicalDevice, *m_allocator, GetGraphicsTimeline());
 
-		vkGetDeviceQueue(m_logicalDevice, graphicsFamilyIndex.value(), 0, &m_graphicsQueue);
+		const bool creationFeedback = IsExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+		m_pipelineCache = std::make_unique<VulkanPipelineCache>(m_logicalDevice, m_physicalDevice, "PipelineCache.bin", creationFeedback);
+	}
+
+	void VulkanLogicalDevice::BeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR& renderingInfo) const
+	{
+		m_cmdBeginRendering(commandBuffer, &renderingInfo);
+	}
+
+	void VulkanLogicalDevice::EndRendering(VkCommandBuffer commandBuffer) const
+	{
+		m_cmdEndRendering(commandBuffer);
 	}
 
 	VulkanLogicalDevice::~VulkanLogicalDevice()
 	{
+		// Whatever is still queued may belong to the last submissions, and it has to go before the allocator
+		vkDeviceWaitIdle(m_logicalDevice);
+		m_deletionQueue = nullptr;
+
+		m_pipelineCache = nullptr;
+		m_allocator = nullptr;
+		m_queues = {};
+		m_ownedQueues.clear();
+
 		vkDestroyDevice(m_logicalDevice, nullptr);
 		m_logicalDevice = nullptr;
 	}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vulkan/vulkan_core.h>
 #include <optional>
@@ -7,11 +8,27 @@
 #include <unordered_set>
 #include <vector>
 
+#include "VulkanDeletionQueue.h"
+#include "VulkanQueue.h"
+
 namespace VEngine 
 {
+	class VulkanAllocator;
+	class VulkanPipelineCache;
+
+	// Compute and transfer are only set for families without graphics, their work falls back to the graphics queue otherwise
 	struct QueueFamilyIndices
 	{
 		std::optional<uint32_t> GraphicsFamily;
+		std::optional<uint32_t> ComputeFamily;
+		std::optional<uint32_t> TransferFamily;
+	};
+
+	// Budget is what the process can use in the heap before the OS starts paging, usage covers every allocation of the process
+	struct VulkanHeapBudget
+	{
+		VkDeviceSize Budget = 0;
+		VkDeviceSize Usage = 0;
 	};
 
 	class VulkanPhysicalDevice
@@ -22,10 +39,23 @@ namespace VEngine
 
 		const VkPhysicalDevice& GetDevice() const { return m_physicalDevice; }
 		const VkPhysicalDeviceFeatures& GetFeatures() const { return m_deviceFeatures; }
+		const VkPhysicalDeviceVulkan12Features& GetVulkan12Features() const { return m_vulkan12Features; }
+		const VkPhysicalDeviceProperties& GetProperties() const { return m_deviceProperties; }
+		const VkPhysicalDeviceVulkan12Properties& GetVulkan12Properties() const { return m_vulkan12Properties; }
+		const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_deviceMemoryProperties; }
+
+		bool IsExtensionSupported(const std::string& extensionName) const { return m_supportedExtensions.contains(extensionName); }
+		bool SupportsDynamicRendering() const { return m_dynamicRendering; }
+		uint32_t FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0) const;
+
+		// Queried live through VK_EXT_memory_budget, without it the budget is a fixed share of the heap and usage is unknown (zero)
+		bool SupportsMemoryBudget() const { return m_memoryBudget; }
+		VulkanHeapBudget GetHeapBudget(uint32_t heapIndex) const;
 
 		QueueFamilyIndices& GetQueueFamilyIndices() { return m_queueFamilyIndices; }
 
 		const std::vector<VkDeviceQueueCreateInfo>& GetQueueFamilyInfos() const { return m_queueCreateInfos; }
+		const std::vector<VkQueueFamilyProperties>& GetQueueFamilyProperties() const { return m_queueFamilyProperties; }
 
 	private:
 		QueueFamilyIndices FindQueueFamilyIndices() const;
@@ -33,10 +63,14 @@ namespace VEngine
 
 		VkPhysicalDevice m_physicalDevice = nullptr;
 		VkPhysicalDeviceProperties m_deviceProperties;
+		VkPhysicalDeviceVulkan12Properties m_vulkan12Properties;
 		VkPhysicalDeviceFeatures m_deviceFeatures;
+		VkPhysicalDeviceVulkan12Features m_vulkan12Features;
 		VkPhysicalDeviceMemoryProperties m_deviceMemoryProperties;
 
 		std::unordered_set<std::string> m_supportedExtensions;
+		bool m_dynamicRendering = false;
+		bool m_memoryBudget = false;
 		std::vector<VkDeviceQueueCreateInfo> m_queueCreateInfos;
 		std::vector<VkQueueFamilyProperties> m_queueFamilyProperties;
 	};
@@ -50,12 +84,42 @@ namespace VEngine
 		const std::shared_ptr<VulkanPhysicalDevice>& GetPhysicalDevice() const { return m_physicalDevice; }
 
 		const VkDevice& GetDevice() const { return m_logicalDevice; }
-		const VkQueue& GetGraphicsQueue() const { return m_graphicsQueue; }
+
+		// Types without a dedicated family share the graphics queue, and with it its timeline
+		VulkanQueue& GetQueue(VulkanQueueType type) const { return *m_queues[(size_t)type]; }
+		bool HasDedicatedQueue(VulkanQueueType type) const { return m_queues[(size_t)type] != m_queues[(size_t)VulkanQueueType::Graphics]; }
+
+		// Every submission to the graphics queue signals the next value
+		VulkanTimeline& GetGraphicsTimeline() const { return GetQueue(VulkanQueueType::Graphics).GetTimeline(); }
+
+		VulkanAllocator& GetAllocator() const { return *m_allocator; }
+		VulkanPipelineCache& GetPipelineCache() const { return *m_pipelineCache; }
+
+		// Releases objects against the graphics timeline, the renderer collects it once per frame
+		VulkanDeletionQueue& GetDeletionQueue() const { return *m_deletionQueue; }
+
+		bool IsExtensionEnabled(const std::string& extensionName) const { return m_enabledExtensions.contains(extensionName); }
+		const VkPhysicalDeviceVulkan12Features& GetEnabledVulkan12Features() const { return m_enabledVulkan12Features; }
+
+		// Render passes and framebuffers are only created when this is off
+		bool HasDynamicRendering() const { return m_cmdBeginRendering != nullptr; }
+		void BeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR& renderingInfo) const;
+		void EndRendering(VkCommandBuffer commandBuffer) const;
 
 	private:
 		VkDevice m_logicalDevice = nullptr;
+		std::unique_ptr<VulkanAllocator> m_allocator;
+		std::unique_ptr<VulkanPipelineCache> m_pipelineCache;
+		std::unique_ptr<VulkanDeletionQueue> m_deletionQueue;
+
+		std::unordered_set<std::string> m_enabledExtensions;
+		VkPhysicalDeviceVulkan12Features m_enabledVulkan12Features;
+
+		PFN_vkCmdBeginRenderingKHR m_cmdBeginRendering = nullptr;
+		PFN_vkCmdEndRenderingKHR m_cmdEndRendering = nullptr;
 
-		VkQueue m_graphicsQueue = nullptr;
+		std::vector<std::unique_ptr<VulkanQueue>> m_ownedQueues;
+		std::array<VulkanQueue*, (size_t)VulkanQueueType::Count> m_queues = {};
 
 		std::shared_ptr<VulkanPhysicalDevice> m_physicalDevice = nullptr;
 	};
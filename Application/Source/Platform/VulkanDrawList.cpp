@@ -0,0 +1,144 @@
+#include "VulkanDrawList.h"
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <numeric>
+#include <stdexcept>
+
+#include "RadixSort.h"
+
+namespace VEngine
+{
+	static constexpr uint32_t DepthBits = 24;
+	static constexpr uint32_t MeshShift = DepthBits;
+	static constexpr uint32_t MaterialShift = MeshShift + 14;
+	static constexpr uint32_t PipelineShift = MaterialShift + 12;
+	static constexpr uint32_t LayerShift = PipelineShift + 10;
+
+	// Non-negative floats order like their bit patterns, the top 24 of the 31 bits keep about 16 bits of mantissa
+	static uint64_t QuantizeDepth(float depth)
+	{
+		return std::bit_cast<uint32_t>(std::max(depth, 0.0f)) >> (31 - DepthBits);
+	}
+
+	void VulkanDrawList::Clear()
+	{
+		m_items.clear();
+		m_pipelines.clear();
+		m_keys.clear();
+		m_instanceOrder.clear();
+		m_batchStarts.clear();
+	}
+
+	void VulkanDrawList::Add(const VulkanDrawItem& item)
+	{
+		if (item.Layer >= MaxLayers || item.Material >= MaxMaterials || item.Mesh >= MaxMeshes)
+			throw std::runtime_error(std::format("Draw item out of key range: layer {}, material {}, mesh {}", item.Layer, item.Material, item.Mesh));
+
+		const uint64_t key = (uint64_t)item.Layer << LayerShift | (uint64_t)GetPipelineId(item.Pipeline) << PipelineShift |
+			(uint64_t)item.Material << MaterialShift | (uint64_t)item.Mesh << MeshShift | QuantizeDepth(item.Depth);
+
+		m_items.push_back(item);
+		m_keys.push_back(key);
+	}
+
+	uint32_t VulkanDrawList::GetPipelineId(const VulkanPipeline* pipeline)
+	{
+		// Ids are handed out in submission order, a pass only uses a handful of pipelines
+		const auto it = std::ranges::find(m_pipelines, pipeline);
+		if (it != m_pipelines.end())
+			return (uint32_t)(it - m_pipelines.begin());
+
+		if (m_pipelines.size() == MaxPipelines)
+			throw std::runtime_error("Too many pipelines in one draw list");
+
+		m_pipelines.push_back(pipeline);
+		return (uint32_t)m_pipelines.size() - 1;
+	}
+
+	void VulkanDrawList::Sort()
+	{
+		const auto count = m_items.size();
+		m_order.resize(count);
+		std::iota(m_order.begin(), m_order.end(), 0);
+
+		m_keyScratch.resize(count);
+		m_orderScratch.resize(count);
+		RadixSort::SortPairs(m_keys, m_order, m_keyScratch, m_orderScratch);
+
+		m_instanceOrder.resize(count);
+		for (size_t i = 0; i < count; i++)
+			m_instanceOrder[i] = m_items[m_order[i]].Instance;
+
+		// Consecutive items only differing in depth and instance share one draw, the last start closes the last batch
+		m_batchStarts.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (i == 0 || (m_keys[i] >> MeshShift) != (m_keys[i - 1] >> MeshShift))
+				m_batchStarts.push_back((uint32_t)i);
+		}
+
+		m_batchStarts.push_back((uint32_t)count);
+	}
+
+	void VulkanDrawList::Record(VkCommandBuffer commandBuffer, VkExtent2D extent, const BindMaterialCallback& bindMaterial)
+	{
+		Record(commandBuffer, extent, bindMaterial, 0, GetBatchCount(), m_statistics);
+	}
+
+	void VulkanDrawList::Record(VkCommandBuffer commandBuffer, VkExtent2D extent, const BindMaterialCallback& bindMaterial,
+		uint32_t firstBatch, uint32_t batchCount, VulkanDrawListStatistics& statistics) const
+	{
+		statistics = VulkanDrawListStatistics();
+		if (batchCount == 0)
+			return;
+
+		statistics.Items = m_batchStarts[firstBatch + batchCount] - m_batchStarts[firstBatch];
+
+		const VulkanPipeline* boundPipeline = nullptr;
+		uint32_t boundMaterial = 0;
+		bool dynamicStateSet = false;
+
+		for (uint32_t batch = firstBatch; batch < firstBatch + batchCount; batch++)
+		{
+			const auto first = m_batchStarts[batch];
+			const auto last = m_batchStarts[batch + 1];
+			const auto& item = m_items[m_order[first]];
+
+			if (item.Pipeline != boundPipeline)
+			{
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, item.Pipeline->GetPipeline());
+				statistics.PipelineBinds++;
+
+				if (dynamicStateSet == false)
+				{
+					auto viewport = VkViewport();
+					viewport.width = (float)extent.width;
+					viewport.height = (float)extent.height;
+					viewport.maxDepth = 1.0f;
+					vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+					auto scissor = VkRect2D();
+					scissor.extent = extent;
+					vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+					dynamicStateSet = true;
+				}
+			}
+
+			if (item.Pipeline != boundPipeline || item.Material != boundMaterial)
+			{
+				if (bindMaterial)
+					bindMaterial(commandBuffer, *item.Pipeline, item.Material);
+
+				statistics.MaterialBinds++;
+				boundPipeline = item.Pipeline;
+				boundMaterial = item.Material;
+			}
+
+			// firstInstance indexes the instance order, the shader maps it back to the instance
+			vkCmdDrawIndexed(commandBuffer, item.IndexCount, last - first, item.FirstIndex, item.VertexOffset, first);
+			statistics.Draws++;
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "VulkanPipeline.h"
+
+namespace VEngine
+{
+	struct VulkanDrawItem
+	{
+		// Drawn in ascending order, up to MaxLayers
+		uint32_t Layer = 0;
+		const VulkanPipeline* Pipeline = nullptr;
+
+		// Opaque ids below MaxMaterials and MaxMeshes. Items with the same mesh id must have the same ranges.
+		uint32_t Material = 0;
+		uint32_t Mesh = 0;
+
+		uint32_t IndexCount = 0;
+		uint32_t FirstIndex = 0;
+		int32_t VertexOffset = 0;
+
+		// View space distance, non-negative. Sorts front to back within a mesh.
+		float Depth = 0.0f;
+
+		// Written to the instance order, shaders read it through gl_InstanceIndex
+		uint32_t Instance = 0;
+	};
+
+	struct VulkanDrawListStatistics
+	{
+		uint32_t Items = 0;
+		uint32_t Draws = 0;
+		uint32_t PipelineBinds = 0;
+		uint32_t MaterialBinds = 0;
+	};
+
+	// Collects draws for one pass, sorts them by a 64 bit key and records them with redundant binds removed.
+	// Runs of items with the same pipeline, material and mesh become one instanced draw. Their instances are
+	// adjacent in GetInstanceOrder, which the caller uploads for the shaders before Record.
+	//
+	// Key, from the most significant bit: layer (4), pipeline (10), material (12), mesh (14), depth (24)
+	class VulkanDrawList
+	{
+	public:
+		static constexpr uint32_t MaxLayers = 1u << 4;
+		static constexpr uint32_t MaxPipelines = 1u << 10;
+		static constexpr uint32_t MaxMaterials = 1u << 12;
+		static constexpr uint32_t MaxMeshes = 1u << 14;
+
+		// Called whenever the pipeline or material changes, after the pipeline is bound. Parallel recording copies it for
+		// every command buffer, so whatever it remembers having bound starts out empty in each.
+		using BindMaterialCallback = std::function<void(VkCommandBuffer commandBuffer, const VulkanPipeline& pipeline, uint32_t material)>;
+
+		void Clear();
+
+		// Throws when an id is out of its key range
+		void Add(const VulkanDrawItem& item);
+		void Sort();
+
+		// Instance of every item in recording order, valid after Sort
+		const std::vector<uint32_t>& GetInstanceOrder() const { return m_instanceOrder; }
+
+		// Runs of items that become one instanced draw, valid after Sort
+		uint32_t GetBatchCount() const { return m_batchStarts.empty() ? 0 : (uint32_t)m_batchStarts.size() - 1; }
+
+		// Viewport and scissor are set once, every pipeline keeps them as dynamic state
+		void Record(VkCommandBuffer commandBuffer, VkExtent2D extent, const BindMaterialCallback& bindMaterial);
+
+		// Any thread, records a range of batches into a command buffer of its own, so every state is set again.
+		// The statistics of the range are written to statistics, SetStatistics takes the totals afterwards.
+		void Record(VkCommandBuffer commandBuffer, VkExtent2D extent, const BindMaterialCallback& bindMaterial,
+			uint32_t firstBatch, uint32_t batchCount, VulkanDrawListStatistics& statistics) const;
+		void SetStatistics(const VulkanDrawListStatistics& statistics) { m_statistics = statistics; }
+
+		uint32_t GetItemCount() const { return (uint32_t)m_items.size(); }
+		const VulkanDrawListStatistics& GetStatistics() const { return m_statistics; }
+
+	private:
+		uint32_t GetPipelineId(const VulkanPipeline* pipeline);
+
+		std::vector<VulkanDrawItem> m_items;
+		std::vector<const VulkanPipeline*> m_pipelines;
+
+		std::vector<uint64_t> m_keys;
+		std::vector<uint32_t> m_order;
+		std::vector<uint64_t> m_keyScratch;
+		std::vector<uint32_t> m_orderScratch;
+		std::vector<uint32_t> m_instanceOrder;
+		std::vector<uint32_t> m_batchStarts;
+
+		VulkanDrawListStatistics m_statistics;
+	};
+}
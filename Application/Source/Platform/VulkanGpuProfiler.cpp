@@ -0,0 +1,141 @@
+#include "VulkanGpuProfiler.h"
+
+#include <algorithm>
+#include <print>
+
+#include "VulkanDebugger.h"
+
+namespace VEngine
+{
+	VulkanGpuProfiler::VulkanGpuProfiler(const std::shared_ptr<VulkanLogicalDevice>& device, uint32_t framesInFlight, uint32_t maxZonesPerFrame)
+	{
+		m_device = device->GetDevice();
+		m_maxQueries = std::max(maxZonesPerFrame, 1u) * 2;
+
+		const auto& physicalDevice = device->GetPhysicalDevice();
+		const auto graphicsFamily = physicalDevice->GetQueueFamilyIndices().GraphicsFamily.value();
+		const auto validBits = physicalDevice->GetQueueFamilyProperties()[graphicsFamily].timestampValidBits;
+
+		m_supported = validBits > 0 && device->GetEnabledVulkan12Features().hostQueryReset;
+		if (m_supported == false)
+		{
+			std::println("GPU profiling is not supported on this device");
+			return;
+		}
+
+		m_timestampPeriod = (double)physicalDevice->GetProperties().limits.timestampPeriod;
+		m_timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+		auto queryPoolInfo = VkQueryPoolCreateInfo();
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = m_maxQueries;
+
+		// One pool per frame slot, a slot is only read back once its fence has signaled so reads never stall
+		m_slots = std::vector<FrameSlot>(std::max(framesInFlight, 1u));
+		for (auto& slot : m_slots)
+		{
+			VULKAN_CHECK(vkCreateQueryPool(m_device, &queryPoolInfo, nullptr, &slot.QueryPool));
+			vkResetQueryPool(m_device, slot.QueryPool, 0, m_maxQueries);
+		}
+
+		m_timestamps.resize(m_maxQueries);
+	}
+
+	void VulkanGpuProfiler::BeginFrame(uint32_t frameIndex)
+	{
+		if (m_supported == false)
+			return;
+
+		m_frameIndex = frameIndex % (uint32_t)m_slots.size();
+
+		auto& slot = m_slots[m_frameIndex];
+		if (slot.Recorded)
+			ReadBack(slot);
+
+		if (slot.QueryCount > 0)
+			vkResetQueryPool(m_device, slot.QueryPool, 0, slot.QueryCount);
+
+		slot.Zones.clear();
+		slot.QueryCount = 0;
+		slot.FrameNumber = Profiler::GetFrameNumber();
+		slot.Recorded = false;
+	}
+
+	void VulkanGpuProfiler::EndFrame()
+	{
+		if (m_supported == false)
+			return;
+
+		auto& slot = m_slots[m_frameIndex];
+		slot.SubmitNs = Profiler::Now();
+		slot.Recorded = slot.QueryCount > 0;
+	}
+
+	uint32_t VulkanGpuProfiler::BeginZone(VkCommandBuffer commandBuffer, const char* name)
+	{
+		if (m_supported == false || Profiler::IsEnabled() == false)
+			return UINT32_MAX;
+
+		auto& slot = m_slots[m_frameIndex];
+		if (slot.QueryCount + 2 > m_maxQueries)
+			return UINT32_MAX;
+
+		auto zone = GpuZone();
+		zone.Name = name;
+		zone.BeginQuery = slot.QueryCount++;
+		zone.EndQuery = slot.QueryCount++;
+		slot.Zones.push_back(zone);
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.QueryPool, zone.BeginQuery);
+		return (uint32_t)slot.Zones.size() - 1;
+	}
+
+	void VulkanGpuProfiler::EndZone(VkCommandBuffer commandBuffer, uint32_t zone)
+	{
+		if (zone == UINT32_MAX)
+			return;
+
+		const auto& slot = m_slots[m_frameIndex];
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.QueryPool, slot.Zones[zone].EndQuery);
+	}
+
+	void VulkanGpuProfiler::ReadBack(FrameSlot& slot)
+	{
+		// No WAIT flag, the fence already signaled and a missing result just drops the frame's GPU zones
+		const auto result = vkGetQueryPoolResults(m_device, slot.QueryPool, 0, slot.QueryCount, slot.QueryCount * sizeof(uint64_t),
+			m_timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+		if (result != VK_SUCCESS)
+			return;
+
+		// Device ticks have no common epoch with the CPU clock, so the first zone is anchored at submission time
+		auto firstTick = m_timestamps[slot.Zones.front().BeginQuery] & m_timestampMask;
+		for (const auto& zone : slot.Zones)
+			firstTick = std::min(firstTick, m_timestamps[zone.BeginQuery] & m_timestampMask);
+
+		const auto toNs = [&](uint64_t tick)
+		{
+			const auto ticks = ((tick & m_timestampMask) - firstTick) & m_timestampMask;
+			return slot.SubmitNs + (uint64_t)((double)ticks * m_timestampPeriod);
+		};
+
+		m_resolvedZones.clear();
+		for (const auto& zone : slot.Zones)
+		{
+			auto resolved = ProfilerZone();
+			resolved.Name = zone.Name;
+			resolved.StartNs = toNs(m_timestamps[zone.BeginQuery]);
+			resolved.EndNs = std::max(resolved.StartNs, toNs(m_timestamps[zone.EndQuery]));
+			m_resolvedZones.push_back(resolved);
+		}
+
+		Profiler::SubmitGpuZones(slot.FrameNumber, m_resolvedZones);
+	}
+
+	VulkanGpuProfiler::~VulkanGpuProfiler()
+	{
+		for (const auto& slot : m_slots)
+			vkDestroyQueryPool(m_device, slot.QueryPool, nullptr);
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Profiler.h"
+#include "VulkanDevice.h"
+
+namespace VEngine 
+{
+	class VulkanGpuProfiler
+	{
+	public:
+		VulkanGpuProfiler(const std::shared_ptr<VulkanLogicalDevice>& device, uint32_t framesInFlight, uint32_t maxZonesPerFrame = 256);
+		VulkanGpuProfiler(const VulkanGpuProfiler&) = delete;
+		VulkanGpuProfiler(VulkanGpuProfiler&&) = delete;
+		~VulkanGpuProfiler();
+
+		// Needs timestamp support on the graphics queue and hostQueryReset, queries are reset inside render passes otherwise
+		bool IsSupported() const { return m_supported; }
+
+		// Call after the target waited for the slot's fence, results of the slot's previous frame are read back here
+		void BeginFrame(uint32_t frameIndex);
+		// Call right before the frame is submitted, GPU zones are placed on the CPU timeline relative to this point
+		void EndFrame();
+
+		uint32_t BeginZone(VkCommandBuffer commandBuffer, const char* name);
+		void EndZone(VkCommandBuffer commandBuffer, uint32_t zone);
+
+	private:
+		struct GpuZone
+		{
+			const char* Name = nullptr;
+			uint32_t BeginQuery = 0;
+			uint32_t EndQuery = 0;
+		};
+
+		struct FrameSlot
+		{
+			VkQueryPool QueryPool = nullptr;
+			std::vector<GpuZone> Zones;
+			uint32_t QueryCount = 0;
+
+			uint64_t FrameNumber = 0;
+			uint64_t SubmitNs = 0;
+			bool Recorded = false;
+		};
+
+		void ReadBack(FrameSlot& slot);
+
+		VkDevice m_device;
+		bool m_supported = false;
+
+		double m_timestampPeriod = 1.0;
+		uint64_t m_timestampMask = UINT64_MAX;
+		uint32_t m_maxQueries = 0;
+
+		uint32_t m_frameIndex = 0;
+		std::vector<FrameSlot> m_slots;
+
+		std::vector<uint64_t> m_timestamps;
+		std::vector<ProfilerZone> m_resolvedZones;
+	};
+
+	class VulkanGpuProfilerScope
+	{
+	public:
+		VulkanGpuProfilerScope(VulkanGpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name)
+		{
+			if (profiler == nullptr)
+				return;
+
+			m_profiler = profiler;
+			m_commandBuffer = commandBuffer;
+			m_zone = profiler->BeginZone(commandBuffer, name);
+		}
+
+		VulkanGpuProfilerScope(const VulkanGpuProfilerScope&) = delete;
+		VulkanGpuProfilerScope(VulkanGpuProfilerScope&&) = delete;
+
+		~VulkanGpuProfilerScope()
+		{
+			if (m_profiler != nullptr)
+				m_profiler->EndZone(m_commandBuffer, m_zone);
+		}
+
+	private:
+		VulkanGpuProfiler* m_profiler = nullptr;
+		VkCommandBuffer m_commandBuffer = nullptr;
+		uint32_t m_zone = UINT32_MAX;
+	};
+}
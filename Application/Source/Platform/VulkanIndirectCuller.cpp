@@ -0,0 +1,246 @@
+#include "VulkanIndirectCuller.h"
+
+#include <algorithm>
+#include <print>
+#include <stdexcept>
+
+#include "VulkanDebugger.h"
+
+namespace VEngine
+{
+	// Matches the push constant block in cull.comp
+	struct CullPushConstants
+	{
+		glm::vec4 Planes[6];
+		uint32_t InstanceBuffer = 0;
+		uint32_t MeshBuffer = 0;
+		uint32_t DrawBuffer = 0;
+		uint32_t CountBuffer = 0;
+		uint32_t InstanceCount = 0;
+	};
+
+	static_assert(sizeof(CullPushConstants) <= VulkanBindlessTable::PushConstantSize);
+
+	static constexpr uint32_t CullGroupSize = 64;
+	static constexpr auto CullShaderPath = "Resources/Shaders/cull.comp.spv";
+
+	VulkanIndirectCuller::VulkanIndirectCuller(const std::shared_ptr<VulkanLogicalDevice>& device, VulkanBindlessTable& bindlessTable, uint32_t framesInFlight, uint32_t maxDraws)
+		: m_bindlessTable(bindlessTable)
+	{
+		m_device = device->GetDevice();
+		m_graphicsQueue = &device->GetQueue(VulkanQueueType::Graphics);
+		m_computeQueue = &device->GetQueue(VulkanQueueType::Compute);
+		m_maxDraws = std::max(maxDraws, 1u);
+
+		// Instance indices travel in firstInstance, which indirect draws only honor with drawIndirectFirstInstance
+		m_supported = bindlessTable.IsSupported() && device->GetEnabledVulkan12Features().drawIndirectCount &&
+			device->GetPhysicalDevice()->GetFeatures().drawIndirectFirstInstance;
+		if (m_supported == false)
+		{
+			std::println("GPU driven culling is not supported on this device");
+			return;
+		}
+
+		auto shader = std::make_shared<VulkanShader>(CullShaderPath, VK_SHADER_STAGE_COMPUTE_BIT);
+		m_pipeline = std::make_unique<VulkanComputePipeline>(shader, bindlessTable.GetPipelineLayout());
+
+		// Commands and counts are rewritten every frame, one set per slot so a frame never overwrites what the previous one still draws
+		m_slots = std::vector<FrameSlot>(std::max(framesInFlight, 1u));
+		for (auto& slot : m_slots)
+		{
+			slot.DrawCommands = std::make_unique<VulkanBuffer>(m_maxDraws * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+			slot.DrawCount = std::make_unique<VulkanBuffer>(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+			slot.Readback = std::make_unique<VulkanBuffer>(sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VulkanMemoryUsage::GpuToCpu);
+
+			slot.DrawCommandsIndex = bindlessTable.RegisterStorageBuffer(slot.DrawCommands->GetBuffer());
+			slot.DrawCountIndex = bindlessTable.RegisterStorageBuffer(slot.DrawCount->GetBuffer());
+
+			if (UsesComputeQueue() == false)
+				continue;
+
+			auto poolInfo = VkCommandPoolCreateInfo();
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			poolInfo.queueFamilyIndex = m_computeQueue->GetFamilyIndex();
+			VULKAN_CHECK(vkCreateCommandPool(m_device, &poolInfo, nullptr, &slot.CommandPool));
+
+			auto allocInfo = VkCommandBufferAllocateInfo();
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = slot.CommandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			VULKAN_CHECK(vkAllocateCommandBuffers(m_device, &allocInfo, &slot.CommandBuffer));
+		}
+
+		std::println("GPU driven culling on the {} queue", UsesComputeQueue() ? "compute" : "graphics");
+	}
+
+	void VulkanIndirectCuller::ReloadShaders(std::span<const std::string> changedFiles)
+	{
+		if (m_supported == false || std::ranges::find(changedFiles, CullShaderPath) == changedFiles.end())
+			return;
+
+		try
+		{
+			auto shader = std::make_shared<VulkanShader>(CullShaderPath, VK_SHADER_STAGE_COMPUTE_BIT);
+			auto pipeline = std::make_unique<VulkanComputePipeline>(shader, m_bindlessTable.GetPipelineLayout());
+			if (pipeline->GetPipeline() == nullptr)
+				throw std::runtime_error("vkCreateComputePipelines failed");
+
+			// The old pipeline goes through the deletion queue, frames in flight keep dispatching with it
+			m_pipeline = std::move(pipeline);
+			std::println("Reloaded {}", CullShaderPath);
+		}
+		catch (const std::exception& exception)
+		{
+			std::println("Keeping previous {}: {}", CullShaderPath, exception.what());
+		}
+	}
+
+	void VulkanIndirectCuller::BeginFrame(uint32_t frameIndex)
+	{
+		if (m_supported == false)
+			return;
+
+		m_frameIndex = frameIndex % (uint32_t)m_slots.size();
+
+		// The frame that drew the slot's commands waited for their cull, so this never blocks once the slot's fence signaled
+		auto& slot = m_slots[m_frameIndex];
+		if (slot.ComputeValue != 0)
+		{
+			m_computeQueue->GetTimeline().Wait(slot.ComputeValue);
+			VULKAN_CHECK(vkResetCommandPool(m_device, slot.CommandPool, 0));
+			slot.ComputeValue = 0;
+		}
+
+		if (slot.Recorded)
+			m_lastDrawCount = *static_cast<const uint32_t*>(slot.Readback->GetMappedData());
+
+		slot.Recorded = false;
+	}
+
+	VulkanIndirectCullOutput VulkanIndirectCuller::AddPasses(VulkanRenderGraph& graph, const VulkanIndirectCullInput& input)
+	{
+		if (m_supported == false)
+			return {};
+
+		auto& slot = m_slots[m_frameIndex];
+		slot.Recorded = true;
+
+		auto output = VulkanIndirectCullOutput();
+		output.DrawCommands = graph.ImportBuffer("DrawCommands", slot.DrawCommands->GetBuffer(), slot.DrawCommands->GetSize());
+		output.DrawCount = graph.ImportBuffer("DrawCount", slot.DrawCount->GetBuffer(), slot.DrawCount->GetSize());
+
+		if (UsesComputeQueue())
+		{
+			// Buffers from the allocator are shared by all queue families, the timeline wait alone hands them over
+			auto beginInfo = VkCommandBufferBeginInfo();
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VULKAN_CHECK(vkBeginCommandBuffer(slot.CommandBuffer, &beginInfo));
+
+			auto barrier = VkMemoryBarrier();
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+			RecordResetDrawCount(slot.CommandBuffer, slot);
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(slot.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+			RecordCull(slot.CommandBuffer, input, slot);
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(slot.CommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+			RecordReadback(slot.CommandBuffer, slot);
+			VULKAN_CHECK(vkEndCommandBuffer(slot.CommandBuffer));
+
+			auto submit = VulkanQueueSubmit();
+			submit.CommandBuffers = { &slot.CommandBuffer, 1 };
+			slot.ComputeValue = m_computeQueue->Submit(submit);
+
+			// The graph sees the outputs as imported buffers nothing wrote yet, the frame's submission waits instead
+			m_graphicsQueue->AddWait({ m_computeQueue, slot.ComputeValue, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT });
+			return output;
+		}
+
+		const auto readback = graph.ImportBuffer("DrawCountReadback", slot.Readback->GetBuffer(), slot.Readback->GetSize());
+
+		graph.AddPass("ResetDrawCount", [this, &slot](VkCommandBuffer commandBuffer)
+		{
+			RecordResetDrawCount(commandBuffer, slot);
+		}).Write(output.DrawCount, VulkanRenderGraphAccess::TransferDst);
+
+		graph.AddPass("Cull", [this, input, &slot](VkCommandBuffer commandBuffer)
+		{
+			RecordCull(commandBuffer, input, slot);
+		})
+		.Write(output.DrawCommands, VulkanRenderGraphAccess::StorageWrite)
+		.Write(output.DrawCount, VulkanRenderGraphAccess::StorageWrite);
+
+		graph.AddPass("ReadbackDrawCount", [this, &slot](VkCommandBuffer commandBuffer)
+		{
+			RecordReadback(commandBuffer, slot);
+		})
+		.Read(output.DrawCount, VulkanRenderGraphAccess::TransferSrc)
+		.Write(readback, VulkanRenderGraphAccess::TransferDst);
+
+		return output;
+	}
+
+	void VulkanIndirectCuller::RecordResetDrawCount(VkCommandBuffer commandBuffer, const FrameSlot& slot) const
+	{
+		vkCmdFillBuffer(commandBuffer, slot.DrawCount->GetBuffer(), 0, sizeof(uint32_t), 0);
+	}
+
+	void VulkanIndirectCuller::RecordCull(VkCommandBuffer commandBuffer, const VulkanIndirectCullInput& input, const FrameSlot& slot) const
+	{
+		auto pushConstants = CullPushConstants();
+		std::ranges::copy(input.CullFrustum.Planes, pushConstants.Planes);
+		pushConstants.InstanceBuffer = input.InstanceBuffer;
+		pushConstants.MeshBuffer = input.MeshBuffer;
+		pushConstants.DrawBuffer = slot.DrawCommandsIndex;
+		pushConstants.CountBuffer = slot.DrawCountIndex;
+		pushConstants.InstanceCount = std::min(input.InstanceCount, m_maxDraws);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline->GetPipeline());
+		m_bindlessTable.Bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+		vkCmdPushConstants(commandBuffer, m_pipeline->GetLayout(), VK_SHADER_STAGE_ALL, 0, sizeof(pushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, (pushConstants.InstanceCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+	}
+
+	// The count is copied out for statistics, the frame never waits for it
+	void VulkanIndirectCuller::RecordReadback(VkCommandBuffer commandBuffer, const FrameSlot& slot) const
+	{
+		const auto region = VkBufferCopy{ 0, 0, sizeof(uint32_t) };
+		vkCmdCopyBuffer(commandBuffer, slot.DrawCount->GetBuffer(), slot.Readback->GetBuffer(), 1, &region);
+
+		auto hostBarrier = VkMemoryBarrier();
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	void VulkanIndirectCuller::Draw(VkCommandBuffer commandBuffer) const
+	{
+		if (m_supported == false)
+			return;
+
+		const auto& slot = m_slots[m_frameIndex];
+		vkCmdDrawIndexedIndirectCount(commandBuffer, slot.DrawCommands->GetBuffer(), 0, slot.DrawCount->GetBuffer(), 0, m_maxDraws, sizeof(VkDrawIndexedIndirectCommand));
+	}
+
+	VulkanIndirectCuller::~VulkanIndirectCuller()
+	{
+		for (const auto& slot : m_slots)
+		{
+			m_bindlessTable.Release(VulkanBindlessType::StorageBuffer, slot.DrawCommandsIndex);
+			m_bindlessTable.Release(VulkanBindlessType::StorageBuffer, slot.DrawCountIndex);
+
+			if (slot.CommandPool != nullptr)
+				vkDestroyCommandPool(m_device, slot.CommandPool, nullptr);
+		}
+	}
+}
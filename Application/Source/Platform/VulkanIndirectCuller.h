@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "Frustum.h"
+#include "VulkanBindlessTable.h"
+#include "VulkanBuffer.h"
+#include "VulkanComputePipeline.h"
+#include "VulkanMeshBuffer.h"
+#include "VulkanRenderGraph.h"
+
+namespace VEngine
+{
+	// std430 layout shared with cull.comp and the scene shaders
+	struct VulkanGpuInstance
+	{
+		// xyz position, w uniform scale
+		glm::vec4 PositionScale;
+		glm::vec4 Color;
+		uint32_t Mesh = 0;
+
+		// Streamed texture handle, see Textures.glsl. UINT32_MAX draws the plain color.
+		uint32_t Texture = UINT32_MAX;
+		uint32_t Padding[2] = {};
+	};
+
+	struct VulkanIndirectCullInput
+	{
+		uint32_t InstanceBuffer = VulkanBindlessTable::InvalidIndex;
+		uint32_t MeshBuffer = VulkanBindlessTable::InvalidIndex;
+		uint32_t InstanceCount = 0;
+		Frustum CullFrustum;
+	};
+
+	// Output of AddPasses, draw passes read both buffers as VulkanRenderGraphAccess::IndirectBuffer
+	struct VulkanIndirectCullOutput
+	{
+		VulkanRenderGraphResource DrawCommands;
+		VulkanRenderGraphResource DrawCount;
+	};
+
+	// Frustum culls instances in a compute pass and writes one compacted VkDrawIndexedIndirectCommand per visible instance.
+	// firstInstance carries the instance index, so vertex shaders fetch their instance through gl_InstanceIndex.
+	// With a dedicated compute queue the cull is submitted there ahead of the frame, whose graphics submission waits for it.
+	// Otherwise it runs as render graph passes in the frame's command buffer.
+	class VulkanIndirectCuller
+	{
+	public:
+		VulkanIndirectCuller(const std::shared_ptr<VulkanLogicalDevice>& device, VulkanBindlessTable& bindlessTable, uint32_t framesInFlight, uint32_t maxDraws);
+		VulkanIndirectCuller(const VulkanIndirectCuller&) = delete;
+		VulkanIndirectCuller(VulkanIndirectCuller&&) = delete;
+		~VulkanIndirectCuller();
+
+		// Needs drawIndirectCount, drawIndirectFirstInstance and the bindless table
+		bool IsSupported() const { return m_supported; }
+
+		// Call after the target waited for the slot's fence, picks up the draw count the slot's previous frame produced
+		void BeginFrame(uint32_t frameIndex);
+
+		// Submits the compute queue's cull right away, the outputs are imported into the graph either way
+		VulkanIndirectCullOutput AddPasses(VulkanRenderGraph& graph, const VulkanIndirectCullInput& input);
+
+		// Records the indirect draw inside a pass that read the output, pipeline and index buffer have to be bound
+		void Draw(VkCommandBuffer commandBuffer) const;
+
+		// Recreates the cull pipeline when cull.comp changed, without waiting for the GPU. A failed reload keeps the old pipeline.
+		void ReloadShaders(std::span<const std::string> changedFiles);
+
+		// Draws the GPU produced a few frames ago, the latest result that doesn't stall
+		uint32_t GetLastDrawCount() const { return m_lastDrawCount; }
+		uint32_t GetMaxDraws() const { return m_maxDraws; }
+		bool UsesComputeQueue() const { return m_computeQueue != m_graphicsQueue; }
+
+	private:
+		struct FrameSlot
+		{
+			std::unique_ptr<VulkanBuffer> DrawCommands;
+			std::unique_ptr<VulkanBuffer> DrawCount;
+			std::unique_ptr<VulkanBuffer> Readback;
+
+			uint32_t DrawCommandsIndex = VulkanBindlessTable::InvalidIndex;
+			uint32_t DrawCountIndex = VulkanBindlessTable::InvalidIndex;
+			bool Recorded = false;
+
+			// Only with the compute queue, the value its last cull signaled
+			VkCommandPool CommandPool = nullptr;
+			VkCommandBuffer CommandBuffer = nullptr;
+			uint64_t ComputeValue = 0;
+		};
+
+		void RecordResetDrawCount(VkCommandBuffer commandBuffer, const FrameSlot& slot) const;
+		void RecordCull(VkCommandBuffer commandBuffer, const VulkanIndirectCullInput& input, const FrameSlot& slot) const;
+		void RecordReadback(VkCommandBuffer commandBuffer, const FrameSlot& slot) const;
+
+		VkDevice m_device;
+		VulkanBindlessTable& m_bindlessTable;
+		VulkanQueue* m_graphicsQueue;
+		VulkanQueue* m_computeQueue;
+		bool m_supported = false;
+		uint32_t m_maxDraws = 0;
+
+		std::unique_ptr<VulkanComputePipeline> m_pipeline = nullptr;
+		std::vector<FrameSlot> m_slots;
+		uint32_t m_frameIndex = 0;
+		uint32_t m_lastDrawCount = 0;
+	};
+}
@@ -0,0 +1,155 @@
+#include "VulkanMeshBuffer.h"
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <print>
+#include <span>
+
+namespace VEngine
+{
+	VulkanMeshBuffer::VulkanMeshBuffer(VulkanUploader& uploader, uint32_t maxMeshes, uint32_t maxVertices, uint32_t maxIndices)
+		: m_uploader(uploader), m_vertexRanges(maxVertices), m_indexRanges(maxIndices)
+	{
+		m_vertexLayout = std::make_shared<const VulkanVertexLayout>(VulkanVertexLayout::Quantized());
+		m_maxMeshes = std::max(maxMeshes, 1u);
+
+		// Geometry is read every frame and goes to device local memory, the small mesh table is rewritten in place
+		m_vertexBuffer = std::make_unique<VulkanBuffer>((VkDeviceSize)maxVertices * sizeof(QuantizedVertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VulkanMemoryUsage::GpuOnly);
+		m_indexBuffer = std::make_unique<VulkanBuffer>((VkDeviceSize)maxIndices * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VulkanMemoryUsage::GpuOnly);
+		m_meshTable = std::make_unique<VulkanBuffer>((VkDeviceSize)m_maxMeshes * sizeof(VulkanGpuMesh), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VulkanMemoryUsage::CpuToGpu);
+
+		// Uploads and binds look the buffers up every time, so defragmentation may move them
+		m_vertexBuffer->SetMovable(true);
+		m_indexBuffer->SetMovable(true);
+	}
+
+	uint32_t VulkanMeshBuffer::Upload(const MeshData& mesh)
+	{
+		if (mesh.Vertices.empty() || mesh.Indices.empty())
+			return InvalidMesh;
+
+		RetireAbandonedUploads();
+
+		if (m_freeMeshes.empty() && m_meshes.size() == m_maxMeshes)
+		{
+			std::println("Mesh buffer is out of mesh slots");
+			return InvalidMesh;
+		}
+
+		auto ranges = MeshRanges();
+		ranges.Vertices = m_vertexRanges.Allocate(mesh.Vertices.size());
+		ranges.Indices = m_indexRanges.Allocate(mesh.Indices.size());
+
+		const auto freeRanges = [&]
+		{
+			if (ranges.Vertices.IsValid())
+				m_vertexRanges.Free(ranges.Vertices);
+			if (ranges.Indices.IsValid())
+				m_indexRanges.Free(ranges.Indices);
+		};
+
+		if (ranges.Vertices.IsValid() == false || ranges.Indices.IsValid() == false)
+		{
+			freeRanges();
+			std::println("Mesh buffer is out of space for {} vertices and {} indices", mesh.Vertices.size(), mesh.Indices.size());
+			return InvalidMesh;
+		}
+
+		auto gpuMesh = VulkanGpuMesh();
+		gpuMesh.IndexCount = (uint32_t)mesh.Indices.size();
+		gpuMesh.FirstIndex = (uint32_t)ranges.Indices.Offset;
+		gpuMesh.VertexOffset = (int32_t)ranges.Vertices.Offset;
+		gpuMesh.Radius = mesh.GetRadius();
+
+		// Positions are stored relative to the bounding sphere, which uses the full snorm range
+		const auto positionScale = gpuMesh.Radius > 0.0f ? 1.0f / gpuMesh.Radius : 1.0f;
+		auto vertices = std::vector<QuantizedVertex>();
+		vertices.reserve(mesh.Vertices.size());
+		for (const auto& vertex : mesh.Vertices)
+			vertices.push_back(VertexQuantization::Quantize(vertex, positionScale));
+
+		const auto vertexUpload = m_uploader.UploadBuffer(m_vertexBuffer->GetBuffer(), ranges.Vertices.Offset * sizeof(QuantizedVertex), std::as_bytes(std::span(vertices)));
+		const auto indexUpload = vertexUpload.IsValid() ? m_uploader.UploadBuffer(m_indexBuffer->GetBuffer(), ranges.Indices.Offset * sizeof(uint32_t), std::as_bytes(std::span(mesh.Indices))) : VulkanUploadTicket();
+		if (indexUpload.IsValid() == false)
+		{
+			// A queued vertex upload can't be taken back. Reusing its range before the copy landed would put two
+			// overlapping regions into one merged copy command, in no defined order.
+			if (vertexUpload.IsValid())
+			{
+				m_abandonedUploads.push_back({ ranges.Vertices, vertexUpload });
+				ranges.Vertices = {};
+			}
+
+			freeRanges();
+			std::println("Upload staging is full, mesh with {} vertices has to be retried", mesh.Vertices.size());
+			return InvalidMesh;
+		}
+
+		auto handle = InvalidMesh;
+		if (m_freeMeshes.empty() == false)
+		{
+			handle = m_freeMeshes.back();
+			m_freeMeshes.pop_back();
+			m_meshes[handle] = gpuMesh;
+			m_meshRanges[handle] = ranges;
+		}
+		else
+		{
+			handle = (uint32_t)m_meshes.size();
+			m_meshes.push_back(gpuMesh);
+			m_meshRanges.push_back(ranges);
+		}
+
+		static_cast<VulkanGpuMesh*>(m_meshTable->GetMappedData())[handle] = gpuMesh;
+		m_meshCount++;
+
+		return handle;
+	}
+
+	void VulkanMeshBuffer::RetireAbandonedUploads()
+	{
+		std::erase_if(m_abandonedUploads, [&](const AbandonedUpload& upload)
+		{
+			if (upload.Ticket.IsComplete() == false)
+				return false;
+
+			m_vertexRanges.Free(upload.Vertices);
+			return true;
+		});
+	}
+
+	void VulkanMeshBuffer::Free(uint32_t mesh)
+	{
+		if (mesh == InvalidMesh)
+			return;
+
+		auto& ranges = m_meshRanges[mesh];
+		m_vertexRanges.Free(ranges.Vertices);
+		m_indexRanges.Free(ranges.Indices);
+		ranges = MeshRanges();
+
+		m_meshes[mesh] = VulkanGpuMesh();
+		static_cast<VulkanGpuMesh*>(m_meshTable->GetMappedData())[mesh] = VulkanGpuMesh();
+		m_freeMeshes.push_back(mesh);
+		m_meshCount--;
+	}
+
+	void VulkanMeshBuffer::Bind(VkCommandBuffer commandBuffer) const
+	{
+		const auto vertexBuffer = m_vertexBuffer->GetBuffer();
+		const VkDeviceSize offset = 0;
+
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+		vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	void VulkanMeshBuffer::PrintStatistics() const
+	{
+		constexpr double MiB = 1024.0 * 1024.0;
+		const auto usedVertices = m_vertexRanges.GetUsedSize();
+
+		std::println("Mesh buffer: {} meshes, {}/{} vertices ({:.2f} MiB, {:.2f} MiB unquantized), {}/{} indices",
+			m_meshCount, usedVertices, m_vertexRanges.GetSize(), (double)(usedVertices * sizeof(QuantizedVertex)) / MiB,
+			(double)(usedVertices * sizeof(MeshVertex)) / MiB, m_indexRanges.GetUsedSize(), m_indexRanges.GetSize());
+	}
+}
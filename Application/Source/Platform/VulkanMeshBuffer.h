@@ -0,0 +1,89 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Mesh.h"
+#include "TlsfAllocator.h"
+#include "VulkanBuffer.h"
+#include "VulkanUploader.h"
+#include "VulkanVertexLayout.h"
+
+namespace VEngine
+{
+	// std430 layout shared with cull.comp and the scene shaders, one entry per mesh in the mesh table
+	struct VulkanGpuMesh
+	{
+		uint32_t IndexCount = 0;
+		uint32_t FirstIndex = 0;
+		int32_t VertexOffset = 0;
+
+		// Bounding sphere radius around the mesh origin at scale 1, also the scale of the quantized positions
+		float Radius = 0.0f;
+	};
+
+	// Every mesh lives in one vertex and one index buffer, so a single bind covers all draws.
+	// Ranges are sub-allocated with TLSF in units of vertices and indices, which makes the offsets usable as
+	// vertexOffset and firstIndex directly. Vertices are stored as QuantizedVertex in device local memory,
+	// written through the uploader.
+	class VulkanMeshBuffer
+	{
+	public:
+		static constexpr uint32_t InvalidMesh = UINT32_MAX;
+
+		VulkanMeshBuffer(VulkanUploader& uploader, uint32_t maxMeshes, uint32_t maxVertices, uint32_t maxIndices);
+		VulkanMeshBuffer(const VulkanMeshBuffer&) = delete;
+		VulkanMeshBuffer(VulkanMeshBuffer&&) = delete;
+
+		// Quantizes the mesh and queues its upload, returns InvalidMesh when it doesn't fit. Run MeshOptimizer first.
+		// Drawable from the frame that flushes the uploader next.
+		uint32_t Upload(const MeshData& mesh);
+
+		// Only once no frame in flight draws the mesh anymore, its ranges are reused right away
+		void Free(uint32_t mesh);
+
+		// Binds both buffers to vertex binding 0 and the index binding
+		void Bind(VkCommandBuffer commandBuffer) const;
+
+		const VulkanGpuMesh& GetMesh(uint32_t mesh) const { return m_meshes[mesh]; }
+		const std::shared_ptr<const VulkanVertexLayout>& GetVertexLayout() const { return m_vertexLayout; }
+
+		// VulkanGpuMesh per mesh handle, for shaders that look meshes up by index
+		VkBuffer GetMeshTable() const { return m_meshTable->GetBuffer(); }
+
+		void PrintStatistics() const;
+
+	private:
+		struct MeshRanges
+		{
+			TlsfAllocator::Allocation Vertices;
+			TlsfAllocator::Allocation Indices;
+		};
+
+		// Vertex upload of a mesh whose index upload didn't fit, its range stays taken until the copy landed
+		struct AbandonedUpload
+		{
+			TlsfAllocator::Allocation Vertices;
+			VulkanUploadTicket Ticket;
+		};
+
+		void RetireAbandonedUploads();
+
+		VulkanUploader& m_uploader;
+		std::shared_ptr<const VulkanVertexLayout> m_vertexLayout = nullptr;
+
+		std::unique_ptr<VulkanBuffer> m_vertexBuffer = nullptr;
+		std::unique_ptr<VulkanBuffer> m_indexBuffer = nullptr;
+		std::unique_ptr<VulkanBuffer> m_meshTable = nullptr;
+
+		TlsfAllocator m_vertexRanges;
+		TlsfAllocator m_indexRanges;
+
+		std::vector<VulkanGpuMesh> m_meshes;
+		std::vector<MeshRanges> m_meshRanges;
+		std::vector<uint32_t> m_freeMeshes;
+		std::vector<AbandonedUpload> m_abandonedUploads;
+		uint32_t m_maxMeshes = 0;
+		uint32_t m_meshCount = 0;
+	};
+}
@@ -0,0 +1,268 @@
+#include "VulkanOffscreenTarget.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VulkanScope.h"
+
+namespace VEngine
+{
+	VulkanOffscreenTarget::VulkanOffscreenTarget(const std::shared_ptr<VulkanLogicalDevice>& device, VkExtent2D extent, uint32_t framesInFlight, VkFormat format)
+	{
+		const auto& physicalDevice = device->GetPhysicalDevice();
+		m_device = device->GetDevice();
+		m_queue = &device->GetQueue(VulkanQueueType::Graphics);
+		m_timeline = &m_queue->GetTimeline();
+		m_deletionQueue = &device->GetDeletionQueue();
+		m_allocator = &device->GetAllocator();
+		m_format = format;
+		m_extent = extent;
+
+		// Readback is tightly packed, only 8-bit RGBA layouts are supported
+		if (format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB && format != VK_FORMAT_B8G8R8A8_UNORM && format != VK_FORMAT_B8G8R8A8_SRGB)
+			throw std::runtime_error("Offscreen target supports only 8-bit RGBA formats!");
+
+		m_readbackSize = (VkDeviceSize)extent.width * extent.height * 4;
+
+		// Create Render Pass, dynamic rendering goes without one and its framebuffers
+		const bool dynamicRendering = device->HasDynamicRendering();
+		auto colorAttachmentRef = VkAttachmentReference();
+		colorAttachmentRef.attachment = 0;
+		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		auto subPass = VkSubpassDescription();
+		subPass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subPass.colorAttachmentCount = 1;
+		subPass.pColorAttachments = &colorAttachmentRef;
+
+		VkSubpassDependency dependencies[2] = {};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		auto colorAttachment = VkAttachmentDescription();
+		colorAttachment.format = m_format;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		auto renderPassInfo = VkRenderPassCreateInfo();
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = 1;
+		renderPassInfo.pAttachments = &colorAttachment;
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subPass;
+		renderPassInfo.dependencyCount = 2;
+		renderPassInfo.pDependencies = dependencies;
+
+		if (dynamicRendering == false)
+			VULKAN_CHECK(vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass));
+
+		// Create Command Pool
+		auto poolInfo = VkCommandPoolCreateInfo();
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = physicalDevice->GetQueueFamilyIndices().GraphicsFamily.value();
+
+		VULKAN_CHECK(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool));
+
+		m_frames.resize(std::clamp(framesInFlight, 1u, MaxFramesInFlight));
+
+		auto commandBuffers = std::vector<VkCommandBuffer>(m_frames.size());
+		auto allocInfo = VkCommandBufferAllocateInfo();
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+
+		VULKAN_CHECK(vkAllocateCommandBuffers(m_device, &allocInfo, commandBuffers.data()));
+
+		// Create Frame Ring
+		for (size_t i = 0; i < m_frames.size(); i++)
+		{
+			auto& frame = m_frames[i];
+			frame.CommandBuffer = commandBuffers[i];
+
+			auto imageInfo = VkImageCreateInfo();
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = m_format;
+			imageInfo.extent = { m_extent.width, m_extent.height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			frame.Image = m_allocator->CreateImage(imageInfo, VulkanMemoryUsage::GpuOnly);
+
+			auto viewCreateInfo = VkImageViewCreateInfo();
+			viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewCreateInfo.image = frame.Image->Image;
+			viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewCreateInfo.format = m_format;
+			viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			viewCreateInfo.subresourceRange.baseMipLevel = 0;
+			viewCreateInfo.subresourceRange.levelCount = 1;
+			viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+			viewCreateInfo.subresourceRange.layerCount = 1;
+
+			VULKAN_CHECK(vkCreateImageView(m_device, &viewCreateInfo, nullptr, &frame.ImageView));
+
+			if (dynamicRendering == false)
+			{
+				auto framebufferInfo = VkFramebufferCreateInfo();
+				framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				framebufferInfo.renderPass = m_renderPass;
+				framebufferInfo.attachmentCount = 1;
+				framebufferInfo.pAttachments = &frame.ImageView;
+				framebufferInfo.width = m_extent.width;
+				framebufferInfo.height = m_extent.height;
+				framebufferInfo.layers = 1;
+
+				VULKAN_CHECK(vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &frame.Framebuffer));
+			}
+
+			// Readback buffer is persistently mapped by the allocator
+			auto bufferInfo = VkBufferCreateInfo();
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = m_readbackSize;
+			bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			frame.ReadbackBuffer = m_allocator->CreateBuffer(bufferInfo, VulkanMemoryUsage::GpuToCpu);
+		}
+	}
+
+	bool VulkanOffscreenTarget::BeginFrame()
+	{
+		auto& frame = m_frames[m_currentFrame];
+
+		m_timeline->Wait(frame.SubmittedValue);
+		DeliverReadback(frame);
+
+		vkResetCommandBuffer(frame.CommandBuffer, 0);
+
+		auto beginInfo = VkCommandBufferBeginInfo();
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VULKAN_CHECK(vkBeginCommandBuffer(frame.CommandBuffer, &beginInfo))
+
+		return true;
+	}
+
+	void VulkanOffscreenTarget::End()
+	{
+		auto& frame = m_frames[m_currentFrame];
+
+		EndRenderPass();
+
+		// Copy the image into this slot's readback buffer, the host picks it up once the timeline passes the slot's value
+		auto region = VkBufferImageCopy();
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { m_extent.width, m_extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(frame.CommandBuffer, frame.Image->Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, frame.ReadbackBuffer->Buffer, 1, &region);
+
+		auto readbackBarrier = VkBufferMemoryBarrier();
+		readbackBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		readbackBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		readbackBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		readbackBarrier.buffer = frame.ReadbackBuffer->Buffer;
+		readbackBarrier.offset = 0;
+		readbackBarrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(frame.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &readbackBarrier, 0, nullptr);
+
+		VULKAN_CHECK(vkEndCommandBuffer(frame.CommandBuffer))
+
+		auto submit = VulkanQueueSubmit();
+		submit.CommandBuffers = { &frame.CommandBuffer, 1 };
+		frame.SubmittedValue = m_queue->Submit(submit);
+
+		frame.FrameNumber = m_frameNumber++;
+		frame.ReadbackPending = true;
+
+		m_currentFrame = (m_currentFrame + 1) % (uint32_t)m_frames.size();
+
+		// Hand out older frames that already finished without waiting on anything
+		for (size_t i = 0; i < m_frames.size(); i++)
+		{
+			auto& pendingFrame = m_frames[(m_currentFrame + i) % m_frames.size()];
+			if (pendingFrame.ReadbackPending == false)
+				continue;
+
+			if (m_timeline->IsComplete(pendingFrame.SubmittedValue) == false)
+				break;
+
+			DeliverReadback(pendingFrame);
+		}
+	}
+
+	void VulkanOffscreenTarget::FlushReadbacks()
+	{
+		// Deliver in submission order starting from the oldest slot
+		for (size_t i = 0; i < m_frames.size(); i++)
+		{
+			auto& frame = m_frames[(m_currentFrame + i) % m_frames.size()];
+			if (frame.ReadbackPending == false)
+				continue;
+
+			m_timeline->Wait(frame.SubmittedValue);
+			DeliverReadback(frame);
+		}
+	}
+
+	void VulkanOffscreenTarget::DeliverReadback(VulkanOffscreenFrame& frame) const
+	{
+		if (frame.ReadbackPending == false)
+			return;
+
+		frame.ReadbackPending = false;
+
+		if (m_readbackCallback)
+			m_readbackCallback(frame.FrameNumber, m_extent, std::span(static_cast<const std::byte*>(frame.ReadbackBuffer->MappedData), (size_t)m_readbackSize));
+	}
+
+	VulkanOffscreenTarget::~VulkanOffscreenTarget()
+	{
+		// Everything goes once the last frame rendered into it finished, other work on the GPU isn't waited for
+		const auto lastValue = m_timeline->GetSubmittedValue();
+		for (const auto& frame : m_frames)
+		{
+			m_deletionQueue->Destroy(frame.Framebuffer, lastValue);
+			m_deletionQueue->Destroy(frame.ImageView, lastValue);
+			m_deletionQueue->DestroyImage(frame.Image, lastValue);
+			m_deletionQueue->DestroyBuffer(frame.ReadbackBuffer, lastValue);
+		}
+
+		m_deletionQueue->Destroy(m_commandPool, lastValue);
+		m_deletionQueue->Destroy(m_renderPass, lastValue);
+	}
+}
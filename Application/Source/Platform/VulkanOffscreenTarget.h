@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "VulkanAllocator.h"
+#include "VulkanDevice.h"
+#include "VulkanRenderTarget.h"
+#include "VulkanQueue.h"
+#include "VulkanTimeline.h"
+
+namespace VEngine 
+{
+	using VulkanReadbackCallback = std::function<void(uint64_t frameNumber, VkExtent2D extent, std::span<const std::byte> pixels)>;
+
+	struct VulkanOffscreenFrame
+	{
+		VulkanAllocation* Image = nullptr;
+		VkImageView ImageView = nullptr;
+		VkFramebuffer Framebuffer = nullptr;
+
+		VulkanAllocation* ReadbackBuffer = nullptr;
+
+		VkCommandBuffer CommandBuffer = nullptr;
+
+		// Graphics timeline value of the slot's last submission
+		uint64_t SubmittedValue = 0;
+
+		uint64_t FrameNumber = 0;
+		bool ReadbackPending = false;
+	};
+
+	class VulkanOffscreenTarget : public VulkanRenderTarget
+	{
+	public:
+		VulkanOffscreenTarget(const std::shared_ptr<VulkanLogicalDevice>& device, VkExtent2D extent, uint32_t framesInFlight = 2, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+		~VulkanOffscreenTarget() override;
+
+		VkRenderPass GetRenderPass() const override { return m_renderPass; }
+		VkExtent2D GetExtent() const override { return m_extent; }
+		VkFormat GetFormat() const override { return m_format; }
+
+		uint32_t GetFramesInFlight() const override { return (uint32_t)m_frames.size(); }
+		uint32_t GetFrameIndex() const override { return m_currentFrame; }
+		VkCommandBuffer GetCommandBuffer() const override { return m_frames[m_currentFrame].CommandBuffer; }
+		VkFramebuffer GetFramebuffer() const override { return m_frames[m_currentFrame].Framebuffer; }
+
+		VkImage GetImage() const override { return m_frames[m_currentFrame].Image->Image; }
+		VkImageView GetImageView() const override { return m_frames[m_currentFrame].ImageView; }
+
+		// Slot's timeline value was waited on, the previous copy out of the image is complete
+		VulkanRenderTargetImageState GetInitialState() const override { return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0 }; }
+		VulkanRenderTargetImageState GetFinalState() const override { return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT }; }
+
+		// Called from Begin/End once the copy of a frame lands in host memory, never blocks the frame being recorded
+		void SetReadbackCallback(VulkanReadbackCallback callback) { m_readbackCallback = std::move(callback); }
+		void FlushReadbacks();
+
+		bool BeginFrame() override;
+		void End() override;
+
+	private:
+		void DeliverReadback(VulkanOffscreenFrame& frame) const;
+
+		VkFormat m_format;
+		VkExtent2D m_extent;
+		VkDeviceSize m_readbackSize = 0;
+
+		VkDevice m_device;
+		VulkanQueue* m_queue;
+		VulkanTimeline* m_timeline;
+		VulkanDeletionQueue* m_deletionQueue;
+		VulkanAllocator* m_allocator;
+
+		VkCommandPool m_commandPool;
+		VkRenderPass m_renderPass = nullptr;
+
+		uint64_t m_frameNumber = 0;
+		uint32_t m_currentFrame = 0;
+		std::vector<VulkanOffscreenFrame> m_frames;
+
+		VulkanReadbackCallback m_readbackCallback;
+	};
+}
@@ -0,0 +1,182 @@
+#include "VulkanParallelRecorder.h"
+
+#include <algorithm>
+
+#include "VulkanDebugger.h"
+
+namespace VEngine
+{
+	VulkanParallelRecorder::VulkanParallelRecorder(const std::shared_ptr<VulkanLogicalDevice>& device, uint32_t threadCount, uint32_t framesInFlight)
+	{
+		m_device = device->GetDevice();
+		m_threadCount = std::max(threadCount, 1u);
+		m_framesInFlight = std::max(framesInFlight, 1u);
+
+		m_inheritance = VkCommandBufferInheritanceInfo();
+		m_inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+		// One transient pool per thread and frame slot, so pools are reset wholesale and never locked
+		auto poolInfo = VkCommandPoolCreateInfo();
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = device->GetPhysicalDevice()->GetQueueFamilyIndices().GraphicsFamily.value();
+
+		m_threadData = std::vector<ThreadFrameData>(m_threadCount * m_framesInFlight);
+		for (auto& threadData : m_threadData)
+			VULKAN_CHECK(vkCreateCommandPool(m_device, &poolInfo, nullptr, &threadData.CommandPool));
+	}
+
+	void VulkanParallelRecorder::BeginFrame(uint32_t frameIndex)
+	{
+		// Target already waited for this slot's fence, so its pools are no longer in use
+		m_frameIndex = frameIndex % m_framesInFlight;
+
+		for (uint32_t threadIndex = 0; threadIndex < m_threadCount; threadIndex++)
+		{
+			auto& threadData = GetThreadData(m_frameIndex, threadIndex);
+			VULKAN_CHECK(vkResetCommandPool(m_device, threadData.CommandPool, 0));
+
+			threadData.UsedCount = 0;
+			threadData.Recorded.clear();
+		}
+	}
+
+	void VulkanParallelRecorder::BeginPass(const VulkanRenderGraphInheritance& inheritance)
+	{
+		m_inheritance.renderPass = inheritance.RenderPass;
+		m_inheritance.subpass = 0;
+		m_inheritance.framebuffer = inheritance.Framebuffer;
+
+		// Without a render pass the secondaries inherit the attachment formats of the dynamic rendering instead
+		m_colorFormats = inheritance.ColorFormats;
+		m_renderingInheritance = VkCommandBufferInheritanceRenderingInfoKHR();
+		m_renderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+		m_renderingInheritance.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+		m_renderingInheritance.colorAttachmentCount = (uint32_t)m_colorFormats.size();
+		m_renderingInheritance.pColorAttachmentFormats = m_colorFormats.data();
+		m_renderingInheritance.depthAttachmentFormat = inheritance.DepthFormat;
+		m_renderingInheritance.stencilAttachmentFormat = inheritance.StencilFormat;
+		m_renderingInheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		m_inheritance.pNext = m_inheritance.renderPass == nullptr ? &m_renderingInheritance : nullptr;
+	}
+
+	VkCommandBuffer VulkanParallelRecorder::BeginRecording(uint32_t threadIndex, uint64_t sortKey)
+	{
+		auto& threadData = GetThreadData(m_frameIndex, threadIndex);
+
+		// Buffers are reused across frames, the pool only grows when a thread records more than before
+		if (threadData.UsedCount == threadData.CommandBuffers.size())
+		{
+			auto allocInfo = VkCommandBufferAllocateInfo();
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = threadData.CommandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			VULKAN_CHECK(vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer));
+			threadData.CommandBuffers.push_back(commandBuffer);
+		}
+
+		const auto commandBuffer = threadData.CommandBuffers[threadData.UsedCount];
+
+		auto recorded = RecordedBuffer();
+		recorded.SortKey = sortKey;
+		recorded.ThreadIndex = threadIndex;
+		recorded.Order = threadData.UsedCount++;
+		recorded.CommandBuffer = commandBuffer;
+		threadData.Recorded.push_back(recorded);
+
+		auto beginInfo = VkCommandBufferBeginInfo();
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &m_inheritance;
+
+		VULKAN_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+		return commandBuffer;
+	}
+
+	void VulkanParallelRecorder::EndRecording(VkCommandBuffer commandBuffer) const
+	{
+		VULKAN_CHECK(vkEndCommandBuffer(commandBuffer));
+	}
+
+	VulkanDrawListStatistics VulkanParallelRecorder::RecordDrawList(JobSystem& jobSystem, const VulkanDrawList& drawList, VkExtent2D extent, uint64_t sortKey,
+		const std::function<void(VkCommandBuffer commandBuffer)>& bindBuffers, const VulkanDrawList::BindMaterialCallback& bindMaterial)
+	{
+		const auto batchCount = drawList.GetBatchCount();
+		if (batchCount == 0)
+			return VulkanDrawListStatistics();
+
+		// Chunk index doubles as thread index, no two jobs ever record with the same one
+		const auto chunkSize = std::max((batchCount + m_threadCount - 1) / m_threadCount, MinBatchesPerRecording);
+		m_drawListStatistics.assign((batchCount + chunkSize - 1) / chunkSize, VulkanDrawListStatistics());
+
+		auto counter = JobCounter();
+		jobSystem.ParallelFor(batchCount, chunkSize, [&](uint32_t first, uint32_t count)
+		{
+			const auto threadIndex = first / chunkSize;
+			const auto commandBuffer = BeginRecording(threadIndex, sortKey);
+
+			if (bindBuffers)
+				bindBuffers(commandBuffer);
+
+			// A copy per command buffer, callbacks may track what they bound in it
+			const auto bindChunkMaterial = bindMaterial;
+			drawList.Record(commandBuffer, extent, bindChunkMaterial, first, count, m_drawListStatistics[threadIndex]);
+			EndRecording(commandBuffer);
+		}, &counter);
+
+		jobSystem.Wait(counter);
+
+		auto statistics = VulkanDrawListStatistics();
+		for (const auto& chunkStatistics : m_drawListStatistics)
+		{
+			statistics.Items += chunkStatistics.Items;
+			statistics.Draws += chunkStatistics.Draws;
+			statistics.PipelineBinds += chunkStatistics.PipelineBinds;
+			statistics.MaterialBinds += chunkStatistics.MaterialBinds;
+		}
+
+		return statistics;
+	}
+
+	void VulkanParallelRecorder::Execute(VkCommandBuffer primaryCommandBuffer)
+	{
+		m_executionOrder.clear();
+		for (uint32_t threadIndex = 0; threadIndex < m_threadCount; threadIndex++)
+		{
+			const auto& recorded = GetThreadData(m_frameIndex, threadIndex).Recorded;
+			m_executionOrder.insert(m_executionOrder.end(), recorded.begin(), recorded.end());
+		}
+
+		if (m_executionOrder.empty())
+			return;
+
+		// Same result no matter which worker finished first
+		std::ranges::sort(m_executionOrder, [](const RecordedBuffer& a, const RecordedBuffer& b)
+		{
+			if (a.SortKey != b.SortKey)
+				return a.SortKey < b.SortKey;
+			if (a.ThreadIndex != b.ThreadIndex)
+				return a.ThreadIndex < b.ThreadIndex;
+			return a.Order < b.Order;
+		});
+
+		m_executionBuffers.clear();
+		for (const auto& recorded : m_executionOrder)
+			m_executionBuffers.push_back(recorded.CommandBuffer);
+
+		vkCmdExecuteCommands(primaryCommandBuffer, (uint32_t)m_executionBuffers.size(), m_executionBuffers.data());
+
+		// Buffers stay allocated until the next frame, the following pass only executes its own
+		for (uint32_t threadIndex = 0; threadIndex < m_threadCount; threadIndex++)
+			GetThreadData(m_frameIndex, threadIndex).Recorded.clear();
+	}
+
+	VulkanParallelRecorder::~VulkanParallelRecorder()
+	{
+		for (const auto& threadData : m_threadData)
+			vkDestroyCommandPool(m_device, threadData.CommandPool, nullptr);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "VulkanDevice.h"
+#include "VulkanDrawList.h"
+#include "VulkanRenderGraph.h"
+
+namespace VEngine 
+{
+	class VulkanParallelRecorder
+	{
+	public:
+		// Fewer batches aren't worth a secondary command buffer of their own
+		static constexpr uint32_t MinBatchesPerRecording = 32;
+
+		VulkanParallelRecorder(const std::shared_ptr<VulkanLogicalDevice>& device, uint32_t threadCount, uint32_t framesInFlight);
+		VulkanParallelRecorder(const VulkanParallelRecorder&) = delete;
+		VulkanParallelRecorder(VulkanParallelRecorder&&) = delete;
+		~VulkanParallelRecorder();
+
+		uint32_t GetThreadCount() const { return m_threadCount; }
+
+		// Main thread, after the target waited for the frame slot's fence
+		void BeginFrame(uint32_t frameIndex);
+
+		// Main thread, from the callback of a render graph pass with secondary contents, before its buffers are recorded
+		void BeginPass(const VulkanRenderGraphInheritance& inheritance);
+
+		// Any thread, but a thread index must not be shared by two threads at the same time.
+		// Returned buffer inherits the pass's render pass and framebuffer, or its dynamic rendering, and is already begun.
+		VkCommandBuffer BeginRecording(uint32_t threadIndex, uint64_t sortKey);
+		void EndRecording(VkCommandBuffer commandBuffer) const;
+
+		// Main thread, splits the draw list's batches into one secondary per thread, recorded with ParallelFor and waited for.
+		// The secondaries share the sort key and keep the list's order, bindBuffers runs first in each of them.
+		VulkanDrawListStatistics RecordDrawList(JobSystem& jobSystem, const VulkanDrawList& drawList, VkExtent2D extent, uint64_t sortKey,
+			const std::function<void(VkCommandBuffer commandBuffer)>& bindBuffers, const VulkanDrawList::BindMaterialCallback& bindMaterial);
+
+		// Main thread, executes everything recorded for the pass ordered by sort key, then thread and recording order
+		void Execute(VkCommandBuffer primaryCommandBuffer);
+
+	private:
+		struct RecordedBuffer
+		{
+			uint64_t SortKey = 0;
+			uint32_t ThreadIndex = 0;
+			uint32_t Order = 0;
+			VkCommandBuffer CommandBuffer = nullptr;
+		};
+
+		// Padded so workers never write into each other's cache lines
+		struct alignas(64) ThreadFrameData
+		{
+			VkCommandPool CommandPool = nullptr;
+			std::vector<VkCommandBuffer> CommandBuffers;
+			uint32_t UsedCount = 0;
+
+			std::vector<RecordedBuffer> Recorded;
+		};
+
+		ThreadFrameData& GetThreadData(uint32_t frameIndex, uint32_t threadIndex) { return m_threadData[frameIndex * m_threadCount + threadIndex]; }
+
+		VkDevice m_device;
+		uint32_t m_threadCount = 0;
+		uint32_t m_framesInFlight = 0;
+
+		uint32_t m_frameIndex = 0;
+		VkCommandBufferInheritanceInfo m_inheritance;
+		VkCommandBufferInheritanceRenderingInfoKHR m_renderingInheritance;
+		std::vector<VkFormat> m_colorFormats;
+
+		std::vector<ThreadFrameData> m_threadData;
+		std::vector<RecordedBuffer> m_executionOrder;
+		std::vector<VkCommandBuffer> m_executionBuffers;
+		std::vector<VulkanDrawListStatistics> m_drawListStatistics;
+	};
+}
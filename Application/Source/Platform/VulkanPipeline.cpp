@@ -1,7 +1,10 @@
 #include "VulkanPipeline.h"
+#include "VulkanPipelineCache.h"
 #include "VulkanScope.h"
 #include "Renderer.h"
 
+#include <chrono>
+#include <stdexcept>
 #include <vector>
 
 namespace VEngine
@@ -9,11 +12,22 @@ namespace VEngine
 	VulkanPipeline::VulkanPipeline(const VulkanPipelineLayout& layout)
 	{
 		const auto device = Renderer::GetScope().GetVulkanDevice()->GetDevice();
+		auto& pipelineCache = Renderer::GetScope().GetVulkanDevice()->GetPipelineCache();
+
+		auto vertexBinding = VkVertexInputBindingDescription();
+		auto vertexAttributes = std::vector<VkVertexInputAttributeDescription>();
+		if (layout.VertexLayout != nullptr)
+		{
+			vertexBinding = layout.VertexLayout->GetBindingDescription();
+			vertexAttributes = layout.VertexLayout->GetAttributeDescriptions();
+		}
 
 		auto vertexInputInfo = VkPipelineVertexInputStateCreateInfo();
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = 0;
-		vertexInputInfo.vertexAttributeDescriptionCount = 0;
+		vertexInputInfo.vertexBindingDescriptionCount = layout.VertexLayout != nullptr ? 1 : 0;
+		vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
+		vertexInputInfo.vertexAttributeDescriptionCount = (uint32_t)vertexAttributes.size();
+		vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
 
 		auto inputAssembly = VkPipelineInputAssemblyStateCreateInfo();
 		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -80,14 +94,13 @@ namespace VEngine
 		colorBlending.attachmentCount = 1;
 		colorBlending.pAttachments = &colorBlendAttachment;
 
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 0; // Optional
-		pipelineLayoutInfo.pSetLayouts = nullptr; // Optional
-		pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-		pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-
-		VULKAN_CHECK(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_layout));
+		m_layout = layout.SharedLayout;
+		if (m_layout == nullptr)
+		{
+			const VulkanShaderReflection* reflections[] = { &layout.Vertex->GetReflection(), &layout.Fragment->GetReflection() };
+			m_reflectedLayout = std::make_unique<VulkanReflectedLayout>(reflections);
+			m_layout = m_reflectedLayout->GetLayout();
+		}
 
 		std::vector stages = 
 		{
@@ -111,15 +124,43 @@ namespace VEngine
 		pipelineInfo.renderPass = layout.RenderPass;
 		pipelineInfo.subpass = 0;
 
-		VULKAN_CHECK(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline));
+		// Creation feedback tells whether the driver served the pipeline from the cache
+		auto pipelineFeedback = VkPipelineCreationFeedbackEXT();
+		auto stageFeedbacks = std::vector<VkPipelineCreationFeedbackEXT>(stages.size());
+
+		auto feedbackInfo = VkPipelineCreationFeedbackCreateInfoEXT();
+		feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+		feedbackInfo.pPipelineCreationFeedback = &pipelineFeedback;
+		feedbackInfo.pipelineStageCreationFeedbackCount = (uint32_t)stageFeedbacks.size();
+		feedbackInfo.pPipelineStageCreationFeedbacks = stageFeedbacks.data();
+
+		if (pipelineCache.HasCreationFeedback())
+			pipelineInfo.pNext = &feedbackInfo;
+
+		auto renderingInfo = VkPipelineRenderingCreateInfoKHR();
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachmentFormats = &layout.ColorFormat;
+
+		if (layout.RenderPass == nullptr)
+		{
+			if (layout.ColorFormat == VK_FORMAT_UNDEFINED || Renderer::GetScope().GetVulkanDevice()->HasDynamicRendering() == false)
+				throw std::runtime_error("Pipeline needs a render pass or a color format with dynamic rendering!");
+
+			renderingInfo.pNext = pipelineInfo.pNext;
+			pipelineInfo.pNext = &renderingInfo;
+		}
+
+		const auto startTime = std::chrono::steady_clock::now();
+		VULKAN_CHECK(vkCreateGraphicsPipelines(device, pipelineCache.GetCache(), 1, &pipelineInfo, nullptr, &m_pipeline));
+
+		pipelineCache.RecordPipeline(pipelineCache.HasCreationFeedback() ? &pipelineFeedback : nullptr, std::chrono::steady_clock::now() - startTime);
 	}
 
 	VulkanPipeline::~VulkanPipeline()
 	{
-		const auto device = Renderer::GetScope().GetVulkanDevice()->GetDevice();
-
-		vkDestroyPipeline(device, m_pipeline, nullptr);
-		vkDestroyPipelineLayout(device, m_layout, nullptr);
+		// Frames in flight may still draw with it, e.g. after a reload swapped it out
+		Renderer::GetScope().GetVulkanDevice()->GetDeletionQueue().Destroy(m_pipeline);
 	}
 
 }
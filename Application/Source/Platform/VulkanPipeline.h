@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VulkanShader.h"
+#include "VulkanVertexLayout.h"
 
 #include <memory>
 
@@ -12,6 +13,16 @@ namespace VEngine
 		std::shared_ptr<VulkanShader> Vertex = nullptr;
 		VkRenderPass RenderPass = nullptr;
 		VkExtent2D Extent = { 0, 0 };
+
+		// Shared layout such as the bindless table's, when unset the pipeline owns one reflected from its shaders
+		VkPipelineLayout SharedLayout = nullptr;
+
+		// Vertex binding 0, unset for shaders that generate their vertices like triangle.vert
+		std::shared_ptr<const VulkanVertexLayout> VertexLayout = nullptr;
+
+		// Attachment format for dynamic rendering, used instead of RenderPass when that is unset.
+		// Such a pipeline works with any target of the same format and survives target resizes.
+		VkFormat ColorFormat = VK_FORMAT_UNDEFINED;
 	};
 
 	class VulkanPipeline
@@ -21,9 +32,11 @@ namespace VEngine
 		~VulkanPipeline();
 
 		VkPipeline GetPipeline() const { return m_pipeline; }
+		VkPipelineLayout GetLayout() const { return m_layout; }
 
 	private:
-		VkPipelineLayout m_layout;
-		VkPipeline m_pipeline;
+		std::unique_ptr<VulkanReflectedLayout> m_reflectedLayout = nullptr;
+		VkPipelineLayout m_layout = nullptr;
+		VkPipeline m_pipeline = nullptr;
 	};
 }
@@ -0,0 +1,218 @@
+#include "VulkanPipelineCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <print>
+#include <span>
+#include <vector>
+
+#include "VulkanDebugger.h"
+#include "VulkanDevice.h"
+
+namespace VEngine
+{
+	static constexpr uint32_t PipelineCacheMagic = 0x43504556; // "VEPC"
+	static constexpr uint32_t PipelineCacheVersion = 1;
+
+	struct PipelineCacheFileHeader
+	{
+		uint32_t Magic = PipelineCacheMagic;
+		uint32_t Version = PipelineCacheVersion;
+		uint32_t VendorID = 0;
+		uint32_t DeviceID = 0;
+		uint32_t DriverVersion = 0;
+		uint8_t CacheUUID[VK_UUID_SIZE] = {};
+		uint64_t DataSize = 0;
+		uint64_t DataHash = 0;
+	};
+
+	static uint64_t HashData(std::span<const std::byte> data)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (const auto byte : data)
+		{
+			hash ^= (uint64_t)byte;
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	VulkanPipelineCache::VulkanPipelineCache(VkDevice device, const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, std::filesystem::path path, bool creationFeedback)
+	{
+		m_device = device;
+		m_physicalDevice = physicalDevice;
+		m_path = std::move(path);
+		m_creationFeedback = creationFeedback;
+
+		const auto data = Load();
+		m_loadedFromDisk = data.empty() == false;
+
+		auto createInfo = VkPipelineCacheCreateInfo();
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.data();
+
+		if (vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache) != VK_SUCCESS)
+		{
+			// Driver rejected the blob after all, start from an empty cache
+			createInfo.initialDataSize = 0;
+			createInfo.pInitialData = nullptr;
+			m_loadedFromDisk = false;
+
+			VULKAN_CHECK(vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache));
+		}
+
+		std::println("Pipeline cache: {} ({} bytes)", m_loadedFromDisk ? "loaded" : "empty", data.size());
+	}
+
+	std::vector<std::byte> VulkanPipelineCache::Load() const
+	{
+		std::ifstream file(m_path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+			return {};
+
+		const auto fileSize = (size_t)file.tellg();
+		if (fileSize < sizeof(PipelineCacheFileHeader))
+			return {};
+
+		file.seekg(0);
+
+		auto header = PipelineCacheFileHeader();
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		const auto& properties = m_physicalDevice->GetProperties();
+		if (header.Magic != PipelineCacheMagic || header.Version != PipelineCacheVersion ||
+			header.VendorID != properties.vendorID || header.DeviceID != properties.deviceID ||
+			header.DriverVersion != properties.driverVersion ||
+			std::memcmp(header.CacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+			header.DataSize != fileSize - sizeof(header))
+		{
+			std::println("Pipeline cache at {} is stale or from another device, ignoring it", m_path.string());
+			return {};
+		}
+
+		auto data = std::vector<std::byte>(header.DataSize);
+		file.read(reinterpret_cast<char*>(data.data()), (std::streamsize)data.size());
+
+		if (file.gcount() != (std::streamsize)data.size() || HashData(data) != header.DataHash || IsCompatible(data) == false)
+		{
+			std::println("Pipeline cache at {} is corrupted, ignoring it", m_path.string());
+			return {};
+		}
+
+		return data;
+	}
+
+	bool VulkanPipelineCache::IsCompatible(std::span<const std::byte> data) const
+	{
+		// Drivers validate this as well, but not all of them gracefully
+		if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+			return false;
+
+		auto header = VkPipelineCacheHeaderVersionOne();
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		const auto& properties = m_physicalDevice->GetProperties();
+		return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+			header.vendorID == properties.vendorID &&
+			header.deviceID == properties.deviceID &&
+			std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	void VulkanPipelineCache::Save() const
+	{
+		size_t dataSize = 0;
+		VULKAN_CHECK(vkGetPipelineCacheData(m_device, m_cache, &dataSize, nullptr));
+
+		auto data = std::vector<std::byte>(dataSize);
+		VULKAN_CHECK(vkGetPipelineCacheData(m_device, m_cache, &dataSize, data.data()));
+		data.resize(dataSize);
+
+		if (data.empty() || IsCompatible(data) == false)
+			return;
+
+		const auto& properties = m_physicalDevice->GetProperties();
+
+		auto header = PipelineCacheFileHeader();
+		header.VendorID = properties.vendorID;
+		header.DeviceID = properties.deviceID;
+		header.DriverVersion = properties.driverVersion;
+		std::memcpy(header.CacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.DataSize = data.size();
+		header.DataHash = HashData(data);
+
+		auto temporaryPath = m_path;
+		temporaryPath += ".tmp";
+
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				std::println("Failed to write pipeline cache to {}", temporaryPath.string());
+				return;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+			file.flush();
+
+			if (!file.good())
+			{
+				std::println("Failed to write pipeline cache to {}", temporaryPath.string());
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, m_path, error);
+		if (error)
+		{
+			std::println("Failed to replace pipeline cache {}: {}", m_path.string(), error.message());
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+
+		std::println("Pipeline cache saved ({} bytes)", data.size());
+	}
+
+	void VulkanPipelineCache::Clear()
+	{
+		vkDestroyPipelineCache(m_device, m_cache, nullptr);
+
+		auto createInfo = VkPipelineCacheCreateInfo();
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		VULKAN_CHECK(vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache));
+		m_loadedFromDisk = false;
+	}
+
+	void VulkanPipelineCache::RecordPipeline(const VkPipelineCreationFeedbackEXT* feedback, std::chrono::nanoseconds duration)
+	{
+		m_statistics.CreationTimeNs += (uint64_t)duration.count();
+
+		if (feedback == nullptr || (feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) == 0)
+		{
+			m_statistics.Untracked++;
+			return;
+		}
+
+		if (feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)
+			m_statistics.Hits++;
+		else
+			m_statistics.Misses++;
+	}
+
+	void VulkanPipelineCache::PrintStatistics() const
+	{
+		std::println("Pipeline cache: {} hits, {} misses, {} untracked, {:.2f} ms spent creating pipelines",
+			m_statistics.Hits.load(), m_statistics.Misses.load(), m_statistics.Untracked.load(),
+			(double)m_statistics.CreationTimeNs.load() / 1e6);
+	}
+
+	VulkanPipelineCache::~VulkanPipelineCache()
+	{
+		Save();
+		vkDestroyPipelineCache(m_device, m_cache, nullptr);
+	}
+}
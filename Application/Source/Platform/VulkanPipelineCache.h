@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace VEngine 
+{
+	class VulkanPhysicalDevice;
+
+	struct VulkanPipelineCacheStatistics
+	{
+		std::atomic<uint32_t> Hits = 0;
+		std::atomic<uint32_t> Misses = 0;
+
+		// Pipelines created without creation feedback support, hit or miss is unknown
+		std::atomic<uint32_t> Untracked = 0;
+		std::atomic<uint64_t> CreationTimeNs = 0;
+	};
+
+	class VulkanPipelineCache
+	{
+	public:
+		VulkanPipelineCache(VkDevice device, const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, std::filesystem::path path, bool creationFeedback);
+		VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+		VulkanPipelineCache(VulkanPipelineCache&&) = delete;
+		~VulkanPipelineCache();
+
+		VkPipelineCache GetCache() const { return m_cache; }
+		bool HasCreationFeedback() const { return m_creationFeedback; }
+		bool WasLoadedFromDisk() const { return m_loadedFromDisk; }
+
+		void RecordPipeline(const VkPipelineCreationFeedbackEXT* feedback, std::chrono::nanoseconds duration);
+		const VulkanPipelineCacheStatistics& GetStatistics() const { return m_statistics; }
+		void PrintStatistics() const;
+
+		// Replaces the cache with an empty one, the next pipelines compile cold. No pipeline may be created meanwhile.
+		void Clear();
+
+		// Writes to a temporary file first and renames it over the old cache, a crash mid-write leaves the old file intact
+		void Save() const;
+
+	private:
+		std::vector<std::byte> Load() const;
+		bool IsCompatible(std::span<const std::byte> data) const;
+
+		VkDevice m_device;
+		std::shared_ptr<VulkanPhysicalDevice> m_physicalDevice;
+		std::filesystem::path m_path;
+
+		VkPipelineCache m_cache = nullptr;
+		bool m_creationFeedback = false;
+		bool m_loadedFromDisk = false;
+
+		VulkanPipelineCacheStatistics m_statistics;
+	};
+}
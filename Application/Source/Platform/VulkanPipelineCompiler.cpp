@@ -0,0 +1,194 @@
+#include "VulkanPipelineCompiler.h"
+
+#include <algorithm>
+#include <print>
+#include <stdexcept>
+
+namespace VEngine
+{
+	VulkanPipelineCompiler::VulkanPipelineCompiler(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+		m_workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_workers.emplace_back(&VulkanPipelineCompiler::WorkerLoop, this);
+	}
+
+	std::shared_ptr<VulkanPipelineHandle> VulkanPipelineCompiler::Compile(const VulkanPipelineLayout& layout)
+	{
+		auto handle = std::make_shared<VulkanPipelineHandle>();
+		handle->m_layout = layout;
+		handle->m_vertexPath = layout.Vertex->GetFilename();
+		handle->m_fragmentPath = layout.Fragment->GetFilename();
+
+		{
+			std::lock_guard lock(m_mutex);
+			std::erase_if(m_handles, [](const auto& weakHandle) { return weakHandle.expired(); });
+			m_handles.push_back(handle);
+		}
+
+		Enqueue(handle);
+		return handle;
+	}
+
+	void VulkanPipelineCompiler::Reload(std::span<const std::string> changedFiles)
+	{
+		auto reloads = std::vector<std::shared_ptr<VulkanPipelineHandle>>();
+		{
+			std::lock_guard lock(m_mutex);
+			for (const auto& weakHandle : m_handles)
+			{
+				auto handle = weakHandle.lock();
+				if (handle == nullptr || handle->m_reloading || handle->GetState() == VulkanPipelineState::Pending)
+					continue;
+
+				const auto uses = [&](const std::string& file) { return file == handle->m_vertexPath || file == handle->m_fragmentPath; };
+				if (std::ranges::any_of(changedFiles, uses))
+				{
+					handle->m_reloading = true;
+					reloads.push_back(std::move(handle));
+				}
+			}
+		}
+
+		for (auto& handle : reloads)
+			Enqueue(std::move(handle));
+	}
+
+	void VulkanPipelineCompiler::ApplyReloads()
+	{
+		auto finished = std::vector<std::shared_ptr<VulkanPipelineHandle>>();
+		{
+			std::lock_guard lock(m_mutex);
+			finished.swap(m_finishedReloads);
+		}
+
+		if (finished.empty())
+			return;
+
+		// Frames in flight may still draw with the previous pipelines, their destruction waits in the deletion queue
+		for (const auto& handle : finished)
+		{
+			if (handle->m_reloadedPipeline != nullptr)
+			{
+				handle->m_pipeline = std::move(handle->m_reloadedPipeline);
+				handle->m_state.store(VulkanPipelineState::Ready, std::memory_order_release);
+				std::println("Reloaded pipeline {} / {}", handle->m_vertexPath, handle->m_fragmentPath);
+			}
+			else
+			{
+				std::println("Keeping previous pipeline {} / {}", handle->m_vertexPath, handle->m_fragmentPath);
+			}
+
+			std::lock_guard lock(m_mutex);
+			handle->m_reloading = false;
+		}
+	}
+
+	void VulkanPipelineCompiler::Enqueue(std::shared_ptr<VulkanPipelineHandle> handle)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_queue.push_back(std::move(handle));
+			m_pendingCount++;
+		}
+
+		m_workAvailable.notify_one();
+	}
+
+	void VulkanPipelineCompiler::WaitIdle()
+	{
+		std::unique_lock lock(m_mutex);
+		m_idle.wait(lock, [this] { return m_pendingCount.load() == 0; });
+	}
+
+	void VulkanPipelineCompiler::WorkerLoop()
+	{
+		while (true)
+		{
+			std::shared_ptr<VulkanPipelineHandle> handle;
+			{
+				std::unique_lock lock(m_mutex);
+				m_workAvailable.wait(lock, [this] { return m_stopping || m_queue.empty() == false; });
+
+				if (m_stopping)
+					return;
+
+				handle = std::move(m_queue.front());
+				m_queue.pop_front();
+			}
+
+			// Set before the handle was queued, the queue's mutex orders it
+			const auto reloading = handle->m_reloading;
+
+			// Pipeline cache is internally synchronized, workers share it
+			try
+			{
+				auto layout = handle->m_layout;
+				if (reloading)
+				{
+					layout.Vertex = std::make_shared<VulkanShader>(handle->m_vertexPath, VK_SHADER_STAGE_VERTEX_BIT);
+					layout.Fragment = std::make_shared<VulkanShader>(handle->m_fragmentPath, VK_SHADER_STAGE_FRAGMENT_BIT);
+				}
+
+				auto pipeline = std::make_shared<VulkanPipeline>(layout);
+				if (pipeline->GetPipeline() == nullptr)
+					throw std::runtime_error("vkCreateGraphicsPipelines failed");
+
+				if (reloading)
+				{
+					handle->m_reloadedPipeline = std::move(pipeline);
+				}
+				else
+				{
+					handle->m_pipeline = std::move(pipeline);
+					handle->m_state.store(VulkanPipelineState::Ready, std::memory_order_release);
+				}
+			}
+			catch (const std::exception& exception)
+			{
+				std::println("Pipeline compilation failed: {}", exception.what());
+				if (reloading == false)
+					handle->m_state.store(VulkanPipelineState::Failed, std::memory_order_release);
+			}
+
+			// Shaders are only needed while compiling, the rest of the layout is kept for reloads
+			handle->m_layout.Vertex = nullptr;
+			handle->m_layout.Fragment = nullptr;
+
+			{
+				std::lock_guard lock(m_mutex);
+				if (reloading)
+					m_finishedReloads.push_back(handle);
+
+				m_pendingCount--;
+			}
+
+			m_idle.notify_all();
+		}
+	}
+
+	VulkanPipelineCompiler::~VulkanPipelineCompiler()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_stopping = true;
+
+			// Requests that never started are reported as failed, queued reloads keep their pipeline
+			for (const auto& handle : m_queue)
+			{
+				if (handle->m_reloading == false)
+					handle->m_state.store(VulkanPipelineState::Failed, std::memory_order_release);
+			}
+
+			m_pendingCount -= (uint32_t)m_queue.size();
+			m_queue.clear();
+		}
+
+		m_workAvailable.notify_all();
+		for (auto& worker : m_workers)
+			worker.join();
+	}
+}
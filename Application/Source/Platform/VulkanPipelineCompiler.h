@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VulkanPipeline.h"
+
+namespace VEngine 
+{
+	enum class VulkanPipelineState
+	{
+		Pending,
+		Ready,
+		Failed
+	};
+
+	class VulkanPipelineHandle
+	{
+	public:
+		VulkanPipelineState GetState() const { return m_state.load(std::memory_order_acquire); }
+		bool IsReady() const { return GetState() == VulkanPipelineState::Ready; }
+
+		// Only valid once the handle is ready
+		const std::shared_ptr<VulkanPipeline>& GetPipeline() const { return m_pipeline; }
+
+	private:
+		friend class VulkanPipelineCompiler;
+
+		std::atomic<VulkanPipelineState> m_state = VulkanPipelineState::Pending;
+		std::shared_ptr<VulkanPipeline> m_pipeline = nullptr;
+		VulkanPipelineLayout m_layout;
+
+		// Reloads recreate the shaders from these, the result is swapped in by ApplyReloads
+		std::string m_vertexPath;
+		std::string m_fragmentPath;
+		std::shared_ptr<VulkanPipeline> m_reloadedPipeline = nullptr;
+		bool m_reloading = false;
+	};
+
+	class VulkanPipelineCompiler
+	{
+	public:
+		// Zero picks half of the hardware threads
+		explicit VulkanPipelineCompiler(uint32_t threadCount = 0);
+		VulkanPipelineCompiler(const VulkanPipelineCompiler&) = delete;
+		VulkanPipelineCompiler(VulkanPipelineCompiler&&) = delete;
+		~VulkanPipelineCompiler();
+
+		std::shared_ptr<VulkanPipelineHandle> Compile(const VulkanPipelineLayout& layout);
+
+		// Recompiles every finished pipeline using one of the changed shader files in the background,
+		// so a pipeline that failed to compile can be fixed without a restart
+		void Reload(std::span<const std::string> changedFiles);
+
+		// Swaps finished reloads in, call between frames. The previous pipelines are released through the
+		// deletion queue, a failed reload keeps them.
+		void ApplyReloads();
+
+		void WaitIdle();
+		uint32_t GetPendingCount() const { return m_pendingCount.load(std::memory_order_relaxed); }
+
+	private:
+		void WorkerLoop();
+		void Enqueue(std::shared_ptr<VulkanPipelineHandle> handle);
+
+		std::vector<std::thread> m_workers;
+		std::vector<std::weak_ptr<VulkanPipelineHandle>> m_handles;
+		std::vector<std::shared_ptr<VulkanPipelineHandle>> m_finishedReloads;
+
+		std::mutex m_mutex;
+		std::condition_variable m_workAvailable;
+		std::condition_variable m_idle;
+		std::deque<std::shared_ptr<VulkanPipelineHandle>> m_queue;
+		bool m_stopping = false;
+
+		std::atomic<uint32_t> m_pendingCount = 0;
+	};
+}
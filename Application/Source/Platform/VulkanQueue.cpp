@@ -0,0 +1,170 @@
+#include "VulkanQueue.h"
+
+#include <vector>
+
+#include "VulkanDebugger.h"
+
+namespace VEngine
+{
+	VulkanQueue::VulkanQueue(VkDevice device, uint32_t familyIndex)
+		: m_familyIndex(familyIndex), m_timeline(device)
+	{
+		vkGetDeviceQueue(device, familyIndex, 0, &m_queue);
+	}
+
+	uint64_t VulkanQueue::Submit(const VulkanQueueSubmit& submit)
+	{
+		auto waitSemaphores = std::vector<VkSemaphore>();
+		auto waitValues = std::vector<uint64_t>();
+		auto waitStages = std::vector<VkPipelineStageFlags>();
+
+		const auto addWait = [&](const VulkanQueueWait& wait)
+		{
+			if (wait.Queue == nullptr || wait.Queue == this || wait.Value == 0)
+				return;
+
+			waitSemaphores.push_back(wait.Queue->GetTimeline().GetSemaphore());
+			waitValues.push_back(wait.Value);
+			waitStages.push_back(wait.StageMask);
+		};
+
+		for (const auto& wait : submit.Waits)
+			addWait(wait);
+
+		// Binary semaphores ignore their value, only the timeline ones read it
+		if (submit.WaitSemaphore != nullptr)
+		{
+			waitSemaphores.push_back(submit.WaitSemaphore);
+			waitValues.push_back(0);
+			waitStages.push_back(submit.WaitStageMask);
+		}
+
+		VkSemaphore signalSemaphores[] = { m_timeline.GetSemaphore(), submit.SignalSemaphore };
+		uint64_t signalValues[] = { 0, 0 };
+		const uint32_t signalCount = submit.SignalSemaphore != nullptr ? 2 : 1;
+
+		// Claimed under the lock so values reach the queue in the order they were handed out
+		std::lock_guard lock(m_submitMutex);
+		signalValues[0] = m_timeline.Submit();
+
+		for (const auto& wait : m_pendingWaits)
+			addWait(wait);
+		m_pendingWaits.clear();
+
+		auto timelineInfo = VkTimelineSemaphoreSubmitInfo();
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = (uint32_t)waitValues.size();
+		timelineInfo.pWaitSemaphoreValues = waitValues.data();
+		timelineInfo.signalSemaphoreValueCount = signalCount;
+		timelineInfo.pSignalSemaphoreValues = signalValues;
+
+		auto submitInfo = VkSubmitInfo();
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = (uint32_t)waitSemaphores.size();
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		submitInfo.commandBufferCount = (uint32_t)submit.CommandBuffers.size();
+		submitInfo.pCommandBuffers = submit.CommandBuffers.data();
+		submitInfo.signalSemaphoreCount = signalCount;
+		submitInfo.pSignalSemaphores = signalSemaphores;
+
+		VULKAN_CHECK(vkQueueSubmit(m_queue, 1, &submitInfo, VK_NULL_HANDLE))
+		return signalValues[0];
+	}
+
+	void VulkanQueue::AddWait(const VulkanQueueWait& wait)
+	{
+		std::lock_guard lock(m_submitMutex);
+		m_pendingWaits.push_back(wait);
+	}
+
+	VkResult VulkanQueue::Present(const VkPresentInfoKHR& presentInfo)
+	{
+		std::lock_guard lock(m_submitMutex);
+		return vkQueuePresentKHR(m_queue, &presentInfo);
+	}
+
+	void VulkanQueue::WaitIdle()
+	{
+		std::lock_guard lock(m_submitMutex);
+		VULKAN_CHECK(vkQueueWaitIdle(m_queue))
+	}
+
+	void VulkanQueue::ReleaseBuffer(VkCommandBuffer commandBuffer, const VulkanQueue& destination, VkBuffer buffer, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask) const
+	{
+		if (destination.m_familyIndex == m_familyIndex)
+			return;
+
+		// Destination access is ignored on release, the acquire half makes the writes visible
+		auto barrier = VkBufferMemoryBarrier();
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = m_familyIndex;
+		barrier.dstQueueFamilyIndex = destination.m_familyIndex;
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void VulkanQueue::AcquireBuffer(VkCommandBuffer commandBuffer, const VulkanQueue& source, VkBuffer buffer, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask) const
+	{
+		const bool transfer = source.m_familyIndex != m_familyIndex;
+
+		auto barrier = VkBufferMemoryBarrier();
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = transfer ? 0 : VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.srcQueueFamilyIndex = transfer ? source.m_familyIndex : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = transfer ? m_familyIndex : VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		const auto srcStageMask = transfer ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void VulkanQueue::ReleaseImage(VkCommandBuffer commandBuffer, const VulkanQueue& destination, VkImage image, const VkImageSubresourceRange& range,
+		VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask) const
+	{
+		if (destination.m_familyIndex == m_familyIndex)
+			return;
+
+		auto barrier = VkImageMemoryBarrier();
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = 0;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = m_familyIndex;
+		barrier.dstQueueFamilyIndex = destination.m_familyIndex;
+		barrier.image = image;
+		barrier.subresourceRange = range;
+
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	void VulkanQueue::AcquireImage(VkCommandBuffer commandBuffer, const VulkanQueue& source, VkImage image, const VkImageSubresourceRange& range,
+		VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask) const
+	{
+		const bool transfer = source.m_familyIndex != m_familyIndex;
+
+		auto barrier = VkImageMemoryBarrier();
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = transfer ? 0 : VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = transfer ? source.m_familyIndex : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = transfer ? m_familyIndex : VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = range;
+
+		const auto srcStageMask = transfer ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "VulkanTimeline.h"
+
+namespace VEngine
+{
+	enum class VulkanQueueType
+	{
+		Graphics,
+		Compute,
+		Transfer,
+		Count
+	};
+
+	class VulkanQueue;
+
+	// GPU side wait for another queue's timeline to reach a value
+	struct VulkanQueueWait
+	{
+		const VulkanQueue* Queue = nullptr;
+		uint64_t Value = 0;
+		VkPipelineStageFlags StageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	};
+
+	struct VulkanQueueSubmit
+	{
+		std::span<const VkCommandBuffer> CommandBuffers;
+		std::span<const VulkanQueueWait> Waits;
+
+		// Binary semaphores, only the swap chain's acquire and present handshake needs them
+		VkSemaphore WaitSemaphore = nullptr;
+		VkPipelineStageFlags WaitStageMask = 0;
+		VkSemaphore SignalSemaphore = nullptr;
+	};
+
+	// One VkQueue and its timeline. Submissions are serialized internally, so any thread may submit and
+	// timeline values always reach the queue in increasing order.
+	class VulkanQueue
+	{
+	public:
+		VulkanQueue(VkDevice device, uint32_t familyIndex);
+		VulkanQueue(const VulkanQueue&) = delete;
+		VulkanQueue(VulkanQueue&&) = delete;
+
+		VkQueue GetQueue() const { return m_queue; }
+		uint32_t GetFamilyIndex() const { return m_familyIndex; }
+		VulkanTimeline& GetTimeline() const { return m_timeline; }
+
+		// Signals the queue's next timeline value and returns it, waits on this queue itself are implied by submission order
+		uint64_t Submit(const VulkanQueueSubmit& submit);
+
+		// Added to the next submission, for work another queue produced for whatever is submitted next here
+		void AddWait(const VulkanQueueWait& wait);
+
+		VkResult Present(const VkPresentInfoKHR& presentInfo);
+		void WaitIdle();
+
+		// Exclusive resources change families in two halves, released on the source queue and acquired on the destination
+		// after a timeline wait. Within one family the release is skipped and the acquire is a full barrier.
+		void ReleaseBuffer(VkCommandBuffer commandBuffer, const VulkanQueue& destination, VkBuffer buffer, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask) const;
+		void AcquireBuffer(VkCommandBuffer commandBuffer, const VulkanQueue& source, VkBuffer buffer, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask) const;
+
+		// Both halves must use the same layouts
+		void ReleaseImage(VkCommandBuffer commandBuffer, const VulkanQueue& destination, VkImage image, const VkImageSubresourceRange& range,
+			VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask) const;
+		void AcquireImage(VkCommandBuffer commandBuffer, const VulkanQueue& source, VkImage image, const VkImageSubresourceRange& range,
+			VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask) const;
+
+	private:
+		VkQueue m_queue = nullptr;
+		uint32_t m_familyIndex = 0;
+		mutable VulkanTimeline m_timeline;
+
+		std::mutex m_submitMutex;
+		std::vector<VulkanQueueWait> m_pendingWaits;
+	};
+}
@@ -0,0 +1,1007 @@
+#include "VulkanRenderGraph.h"
+
+#include <algorithm>
+#include <format>
+#include <print>
+#include <stdexcept>
+
+#include "VulkanDebugger.h"
+
+namespace VEngine
+{
+	struct VulkanRenderGraphAccessInfo
+	{
+		VkPipelineStageFlags Stage = 0;
+		VkAccessFlags Access = 0;
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkImageUsageFlags ImageUsage = 0;
+		VkBufferUsageFlags BufferUsage = 0;
+		bool Write = false;
+	};
+
+	static constexpr VkAccessFlags WriteAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+	static VulkanRenderGraphAccessInfo GetAccessInfo(VulkanRenderGraphAccess access)
+	{
+		constexpr VkPipelineStageFlags fragmentTests = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		constexpr VkPipelineStageFlags allShaders = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		switch (access)
+		{
+		case VulkanRenderGraphAccess::ColorAttachment:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0, true };
+		case VulkanRenderGraphAccess::DepthAttachment:
+			return { fragmentTests, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, true };
+		case VulkanRenderGraphAccess::DepthAttachmentRead:
+			return { fragmentTests, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, false };
+		case VulkanRenderGraphAccess::SampledFragment:
+			return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0, false };
+		case VulkanRenderGraphAccess::SampledCompute:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0, false };
+		case VulkanRenderGraphAccess::StorageRead:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false };
+		case VulkanRenderGraphAccess::StorageWrite:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL,
+				VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true };
+		case VulkanRenderGraphAccess::TransferSrc:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false };
+		case VulkanRenderGraphAccess::TransferDst:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true };
+		case VulkanRenderGraphAccess::VertexBuffer:
+			return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, false };
+		case VulkanRenderGraphAccess::IndexBuffer:
+			return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false };
+		case VulkanRenderGraphAccess::IndirectBuffer:
+			return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false };
+		case VulkanRenderGraphAccess::UniformBuffer:
+			return { allShaders, VK_ACCESS_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false };
+		}
+
+		return {};
+	}
+
+	static VkImageAspectFlags GetAspectMask(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		case VK_FORMAT_S8_UINT:
+			return VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+
+	VulkanRenderGraphPass& VulkanRenderGraphPass::Read(VulkanRenderGraphResource resource, VulkanRenderGraphAccess access)
+	{
+		if (GetAccessInfo(access).Write)
+			throw std::runtime_error(std::format("Render graph pass {} reads with a write access!", m_name));
+
+		m_accesses.push_back({ resource.Index, access, false, false, {} });
+		return *this;
+	}
+
+	VulkanRenderGraphPass& VulkanRenderGraphPass::Write(VulkanRenderGraphResource resource, VulkanRenderGraphAccess access)
+	{
+		if (GetAccessInfo(access).Write == false)
+			throw std::runtime_error(std::format("Render graph pass {} writes with a read access!", m_name));
+
+		m_accesses.push_back({ resource.Index, access, true, false, {} });
+		return *this;
+	}
+
+	VulkanRenderGraphPass& VulkanRenderGraphPass::Clear(VulkanRenderGraphResource resource, VulkanRenderGraphAccess access, VkClearValue clearValue)
+	{
+		if (access != VulkanRenderGraphAccess::ColorAttachment && access != VulkanRenderGraphAccess::DepthAttachment)
+			throw std::runtime_error(std::format("Render graph pass {} clears a resource that isn't an attachment!", m_name));
+
+		m_accesses.push_back({ resource.Index, access, true, true, clearValue });
+		return *this;
+	}
+
+	VulkanRenderGraph::VulkanRenderGraph(const std::shared_ptr<VulkanLogicalDevice>& device)
+	{
+		m_logicalDevice = device;
+		m_device = device->GetDevice();
+		m_allocator = &device->GetAllocator();
+		m_timeline = &device->GetGraphicsTimeline();
+		m_deletionQueue = &device->GetDeletionQueue();
+		m_dynamicRendering = device->HasDynamicRendering();
+	}
+
+	void VulkanRenderGraph::Reset()
+	{
+		m_resources.clear();
+		m_passes.clear();
+	}
+
+	VulkanRenderGraphResource VulkanRenderGraph::CreateImage(const std::string& name, const VulkanRenderGraphImageDesc& desc)
+	{
+		auto node = ResourceNode();
+		node.Name = name;
+		node.ImageDesc = desc;
+
+		m_resources.push_back(std::move(node));
+		return { (uint32_t)m_resources.size() - 1 };
+	}
+
+	VulkanRenderGraphResource VulkanRenderGraph::CreateBuffer(const std::string& name, VkDeviceSize size, VkBufferUsageFlags usage)
+	{
+		auto node = ResourceNode();
+		node.Name = name;
+		node.IsImage = false;
+		node.BufferSize = size;
+		node.BufferUsage = usage;
+
+		m_resources.push_back(std::move(node));
+		return { (uint32_t)m_resources.size() - 1 };
+	}
+
+	VulkanRenderGraphResource VulkanRenderGraph::ImportImage(const std::string& name, const VulkanRenderGraphImport& import)
+	{
+		auto node = ResourceNode();
+		node.Name = name;
+		node.Imported = true;
+		node.Import = import;
+		node.ImageDesc.Format = import.Format;
+		node.ImageDesc.Extent = import.Extent;
+
+		m_resources.push_back(std::move(node));
+		return { (uint32_t)m_resources.size() - 1 };
+	}
+
+	VulkanRenderGraphResource VulkanRenderGraph::ImportBuffer(const std::string& name, VkBuffer buffer, VkDeviceSize size)
+	{
+		auto node = ResourceNode();
+		node.Name = name;
+		node.IsImage = false;
+		node.Imported = true;
+		node.ImportedBuffer = buffer;
+		node.BufferSize = size;
+
+		m_resources.push_back(std::move(node));
+		return { (uint32_t)m_resources.size() - 1 };
+	}
+
+	VulkanRenderGraphResource VulkanRenderGraph::ImportTarget(const VulkanRenderTarget& target)
+	{
+		auto import = VulkanRenderGraphImport();
+		import.Image = target.GetImage();
+		import.View = target.GetImageView();
+		import.Format = target.GetFormat();
+		import.Extent = target.GetExtent();
+		import.InitialState = target.GetInitialState();
+		import.FinalState = target.GetFinalState();
+
+		return ImportImage("BackBuffer", import);
+	}
+
+	VulkanRenderGraphPass& VulkanRenderGraph::AddPass(const std::string& name, VulkanRenderGraphExecute execute)
+	{
+		auto pass = std::make_unique<VulkanRenderGraphPass>();
+		pass->m_name = name;
+		pass->m_execute = std::move(execute);
+
+		m_passes.push_back(std::move(pass));
+		return *m_passes.back();
+	}
+
+	std::vector<uint64_t> VulkanRenderGraph::BuildSignature() const
+	{
+		// Everything that changes the compiled result, handles of imported resources are resolved per frame
+		auto signature = std::vector<uint64_t>();
+		signature.push_back(m_resources.size());
+
+		for (const auto& node : m_resources)
+		{
+			signature.push_back((uint64_t)node.IsImage | (uint64_t)node.Imported << 1);
+
+			if (node.IsImage)
+			{
+				const auto& desc = node.ImageDesc;
+				signature.push_back((uint64_t)desc.Format << 32 | desc.Usage);
+				signature.push_back((uint64_t)desc.Extent.width << 32 | desc.Extent.height);
+
+				if (node.Imported)
+				{
+					const auto& initialState = node.Import.InitialState;
+					const auto& finalState = node.Import.FinalState;
+					signature.push_back((uint64_t)initialState.Layout << 32 | initialState.Stage);
+					signature.push_back((uint64_t)finalState.Layout << 32 | finalState.Stage);
+					signature.push_back((uint64_t)initialState.Access << 32 | finalState.Access);
+				}
+			}
+			else
+			{
+				signature.push_back(node.BufferSize);
+				signature.push_back(node.BufferUsage);
+			}
+		}
+
+		for (const auto& pass : m_passes)
+		{
+			signature.push_back(std::hash<std::string>()(pass->m_name));
+			signature.push_back((uint64_t)pass->m_sideEffects << 32 | pass->m_accesses.size());
+
+			for (const auto& access : pass->m_accesses)
+				signature.push_back((uint64_t)access.Resource | (uint64_t)access.Type << 32 | (uint64_t)access.Write << 48 | (uint64_t)access.Clear << 49);
+		}
+
+		return signature;
+	}
+
+	std::vector<VulkanRenderGraph::PassAccess> VulkanRenderGraph::MergeAccesses(const VulkanRenderGraphPass& pass) const
+	{
+		// A pass touches every resource in exactly one layout, repeated accesses are folded together
+		auto accesses = std::vector<PassAccess>();
+		for (uint32_t i = 0; i < pass.m_accesses.size(); i++)
+		{
+			const auto& access = pass.m_accesses[i];
+			if (access.Resource >= m_resources.size())
+				throw std::runtime_error(std::format("Render graph pass {} uses an invalid resource!", pass.m_name));
+
+			const auto& node = m_resources[access.Resource];
+			const auto info = GetAccessInfo(access.Type);
+			const auto layout = node.IsImage ? info.Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+			const auto isColor = access.Type == VulkanRenderGraphAccess::ColorAttachment;
+			const auto isDepth = access.Type == VulkanRenderGraphAccess::DepthAttachment || access.Type == VulkanRenderGraphAccess::DepthAttachmentRead;
+			if ((isColor || isDepth) && node.IsImage == false)
+				throw std::runtime_error(std::format("Render graph pass {} uses buffer {} as an attachment!", pass.m_name, node.Name));
+
+			auto existing = std::ranges::find_if(accesses, [&](const PassAccess& merged) { return merged.Resource == access.Resource; });
+			if (existing == accesses.end())
+			{
+				auto merged = PassAccess();
+				merged.Resource = access.Resource;
+				merged.AccessIndex = i;
+				merged.Layout = layout;
+				accesses.push_back(merged);
+				existing = accesses.end() - 1;
+			}
+			else if (existing->Layout != layout)
+			{
+				throw std::runtime_error(std::format("Render graph pass {} uses {} in two layouts!", pass.m_name, node.Name));
+			}
+
+			existing->Stage |= info.Stage;
+			existing->Access |= info.Access;
+			existing->Write |= access.Write;
+			existing->ColorAttachment |= isColor;
+			existing->DepthAttachment |= isDepth;
+
+			if (access.Clear)
+			{
+				existing->Clear = true;
+				existing->AccessIndex = i;
+			}
+		}
+
+		return accesses;
+	}
+
+	void VulkanRenderGraph::Compile(CompiledGraph& graph)
+	{
+		const auto resourceCount = (uint32_t)m_resources.size();
+		const auto passCount = (uint32_t)m_passes.size();
+
+		auto passAccesses = std::vector<std::vector<PassAccess>>(passCount);
+		for (uint32_t i = 0; i < passCount; i++)
+			passAccesses[i] = MergeAccesses(*m_passes[i]);
+
+		// Cull passes, walking backwards from the imported resources and passes with side effects
+		auto needed = std::vector<bool>(resourceCount);
+		for (uint32_t i = 0; i < resourceCount; i++)
+			needed[i] = m_resources[i].Imported;
+
+		auto live = std::vector<bool>(passCount);
+		for (uint32_t i = passCount; i-- > 0;)
+		{
+			bool isLive = m_passes[i]->m_sideEffects;
+			for (const auto& access : passAccesses[i])
+				isLive |= access.Write && needed[access.Resource];
+
+			if (isLive == false)
+				continue;
+
+			live[i] = true;
+
+			// Cleared contents don't depend on earlier writers, everything else keeps them alive
+			for (const auto& access : passAccesses[i])
+				needed[access.Resource] = access.Clear == false;
+		}
+
+		auto& statistics = graph.Statistics;
+		statistics.PassCount = passCount;
+
+		auto liveAccesses = std::vector<std::vector<PassAccess>>();
+		for (uint32_t i = 0; i < passCount; i++)
+		{
+			if (live[i] == false)
+			{
+				statistics.CulledPassCount++;
+				continue;
+			}
+
+			auto compiledPass = CompiledPass();
+			compiledPass.Pass = i;
+			graph.Passes.push_back(compiledPass);
+			liveAccesses.push_back(std::move(passAccesses[i]));
+		}
+
+		// Lifetimes in compiled pass indices and the usage every resource needs
+		auto firstUse = std::vector<uint32_t>(resourceCount, UINT32_MAX);
+		auto lastUse = std::vector<uint32_t>(resourceCount, 0);
+		auto imageUsage = std::vector<VkImageUsageFlags>(resourceCount);
+		auto bufferUsage = std::vector<VkBufferUsageFlags>(resourceCount);
+
+		for (uint32_t i = 0; i < graph.Passes.size(); i++)
+		{
+			const auto& pass = *m_passes[graph.Passes[i].Pass];
+			for (const auto& access : pass.m_accesses)
+			{
+				const auto info = GetAccessInfo(access.Type);
+				firstUse[access.Resource] = std::min(firstUse[access.Resource], i);
+				lastUse[access.Resource] = std::max(lastUse[access.Resource], i);
+				imageUsage[access.Resource] |= info.ImageUsage;
+				bufferUsage[access.Resource] |= info.BufferUsage;
+			}
+		}
+
+		// Create transient images, memory is bound after aliasing decided where they go
+		graph.Images.resize(resourceCount);
+		graph.Buffers.resize(resourceCount, nullptr);
+
+		auto requirements = std::vector<VkMemoryRequirements>(resourceCount);
+		auto transientImages = std::vector<uint32_t>();
+		for (uint32_t i = 0; i < resourceCount; i++)
+		{
+			const auto& node = m_resources[i];
+			if (node.Imported || firstUse[i] == UINT32_MAX)
+				continue;
+
+			if (node.IsImage == false)
+			{
+				auto bufferInfo = VkBufferCreateInfo();
+				bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+				bufferInfo.size = node.BufferSize;
+				bufferInfo.usage = bufferUsage[i] | node.BufferUsage;
+				bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+				graph.Buffers[i] = m_allocator->CreateBuffer(bufferInfo, VulkanMemoryUsage::GpuOnly);
+				continue;
+			}
+
+			auto imageInfo = VkImageCreateInfo();
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = node.ImageDesc.Format;
+			imageInfo.extent = { node.ImageDesc.Extent.width, node.ImageDesc.Extent.height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = imageUsage[i] | node.ImageDesc.Usage;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VULKAN_CHECK(vkCreateImage(m_device, &imageInfo, nullptr, &graph.Images[i].Image));
+			vkGetImageMemoryRequirements(m_device, graph.Images[i].Image, &requirements[i]);
+
+			transientImages.push_back(i);
+			statistics.TransientImageCount++;
+			statistics.UnaliasedBytes += requirements[i].size;
+		}
+
+		// Alias memory between images whose lifetimes don't overlap, largest images pick their slot first
+		struct MemorySlot
+		{
+			VkMemoryRequirements Requirements;
+			std::vector<uint32_t> Resources;
+		};
+
+		std::ranges::sort(transientImages, [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+		auto slots = std::vector<MemorySlot>();
+		auto imageSlot = std::vector<uint32_t>(resourceCount, UINT32_MAX);
+		for (const auto image : transientImages)
+		{
+			const auto& imageRequirements = requirements[image];
+			auto slot = std::ranges::find_if(slots, [&](const MemorySlot& candidate)
+			{
+				if ((candidate.Requirements.memoryTypeBits & imageRequirements.memoryTypeBits) == 0)
+					return false;
+
+				return std::ranges::all_of(candidate.Resources, [&](uint32_t other)
+				{
+					return lastUse[other] < firstUse[image] || firstUse[other] > lastUse[image];
+				});
+			});
+
+			if (slot == slots.end())
+			{
+				slots.push_back({ imageRequirements, {} });
+				slot = slots.end() - 1;
+			}
+
+			slot->Requirements.size = std::max(slot->Requirements.size, imageRequirements.size);
+			slot->Requirements.alignment = std::max(slot->Requirements.alignment, imageRequirements.alignment);
+			slot->Requirements.memoryTypeBits &= imageRequirements.memoryTypeBits;
+			slot->Resources.push_back(image);
+			imageSlot[image] = (uint32_t)(slot - slots.begin());
+		}
+
+		for (const auto& slot : slots)
+		{
+			const auto allocation = m_allocator->Allocate(slot.Requirements, VulkanMemoryUsage::GpuOnly, false);
+			graph.MemorySlots.push_back(allocation);
+			statistics.TransientBytes += slot.Requirements.size;
+
+			for (const auto image : slot.Resources)
+			{
+				auto& transientImage = graph.Images[image];
+				VULKAN_CHECK(vkBindImageMemory(m_device, transientImage.Image, allocation->Memory, allocation->Offset));
+
+				const auto format = m_resources[image].ImageDesc.Format;
+				auto viewCreateInfo = VkImageViewCreateInfo();
+				viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewCreateInfo.image = transientImage.Image;
+				viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewCreateInfo.format = format;
+				viewCreateInfo.subresourceRange.aspectMask = GetAspectMask(format);
+				viewCreateInfo.subresourceRange.baseMipLevel = 0;
+				viewCreateInfo.subresourceRange.levelCount = 1;
+				viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+				viewCreateInfo.subresourceRange.layerCount = 1;
+
+				VULKAN_CHECK(vkCreateImageView(m_device, &viewCreateInfo, nullptr, &transientImage.View));
+			}
+		}
+
+		// Simulate the frame to find the hazards, only the ones that exist get a barrier
+		struct ResourceState
+		{
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags WriteStages = 0;
+			VkAccessFlags WriteAccess = 0;
+			VkPipelineStageFlags ReadStages = 0;
+			VkPipelineStageFlags VisibleStages = 0;
+		};
+
+		auto states = std::vector<ResourceState>(resourceCount);
+		for (uint32_t i = 0; i < resourceCount; i++)
+		{
+			const auto& node = m_resources[i];
+			if (node.Imported && node.IsImage)
+				states[i] = { node.Import.InitialState.Layout, node.Import.InitialState.Stage, node.Import.InitialState.Access, 0, 0 };
+		}
+
+		// Every frame in flight reuses the transients, so the first use in a frame has to wait for the previous
+		// frame's last accesses to the same memory. Those are the end of graph accesses of the slot's last occupant.
+		auto endStates = std::vector<ResourceState>(resourceCount);
+		for (const auto& accesses : liveAccesses)
+		{
+			for (const auto& access : accesses)
+			{
+				auto& endState = endStates[access.Resource];
+				if (access.Write)
+				{
+					endState.WriteStages = access.Stage;
+					endState.WriteAccess = access.Access & WriteAccessMask;
+					endState.ReadStages = 0;
+				}
+				else
+					endState.ReadStages |= access.Stage;
+			}
+		}
+
+		auto slotFirst = std::vector<uint32_t>(slots.size(), UINT32_MAX);
+		auto slotLast = std::vector<uint32_t>(slots.size(), UINT32_MAX);
+		for (uint32_t i = 0; i < resourceCount; i++)
+		{
+			const auto slot = imageSlot[i];
+			if (slot == UINT32_MAX)
+				continue;
+
+			if (slotFirst[slot] == UINT32_MAX || firstUse[i] < firstUse[slotFirst[slot]])
+				slotFirst[slot] = i;
+			if (slotLast[slot] == UINT32_MAX || lastUse[i] > lastUse[slotLast[slot]])
+				slotLast[slot] = i;
+		}
+
+		const auto seedState = [&](uint32_t resource, uint32_t previous)
+		{
+			states[resource].WriteStages = endStates[previous].WriteStages | endStates[previous].ReadStages;
+			states[resource].WriteAccess = endStates[previous].WriteAccess;
+		};
+
+		for (uint32_t i = 0; i < resourceCount; i++)
+		{
+			if (graph.Buffers[i] != nullptr)
+				seedState(i, i);
+		}
+
+		for (size_t slot = 0; slot < slots.size(); slot++)
+			seedState(slotFirst[slot], slotLast[slot]);
+
+		const auto applyAccess = [&](CompiledPass& compiledPass, uint32_t resource, VkPipelineStageFlags stage, VkAccessFlags access, VkImageLayout layout, bool write)
+		{
+			auto& state = states[resource];
+			const bool isImage = m_resources[resource].IsImage;
+			const bool transition = isImage && state.Layout != layout;
+
+			// Write after write, write after read and layout transitions
+			if (transition || write)
+			{
+				const auto srcStages = state.WriteStages | state.ReadStages;
+				if (transition || srcStages != 0)
+				{
+					compiledPass.SrcStages |= srcStages != 0 ? srcStages : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+					compiledPass.DstStages |= stage;
+
+					if (isImage && (transition || state.WriteAccess != 0))
+						compiledPass.ImageBarriers.push_back({ resource, state.Layout, layout, state.WriteAccess, access });
+					else if (isImage == false && state.WriteAccess != 0)
+					{
+						compiledPass.MemorySrcAccess |= state.WriteAccess;
+						compiledPass.MemoryDstAccess |= access;
+					}
+				}
+
+				state.Layout = layout;
+				state.WriteStages = stage;
+				state.WriteAccess = write ? access & WriteAccessMask : 0;
+				state.ReadStages = write ? 0 : stage;
+				state.VisibleStages = stage;
+				return;
+			}
+
+			// Read after write, every stage only has to be made visible once
+			if ((stage & ~state.VisibleStages) != 0 && state.WriteStages != 0)
+			{
+				compiledPass.SrcStages |= state.WriteStages;
+				compiledPass.DstStages |= stage;
+
+				if (isImage && state.WriteAccess != 0)
+					compiledPass.ImageBarriers.push_back({ resource, layout, layout, state.WriteAccess, access });
+				else if (state.WriteAccess != 0)
+				{
+					compiledPass.MemorySrcAccess |= state.WriteAccess;
+					compiledPass.MemoryDstAccess |= access;
+				}
+
+				state.VisibleStages |= stage;
+			}
+
+			state.ReadStages |= stage;
+		};
+
+		auto slotOccupants = std::vector<uint32_t>(slots.size(), UINT32_MAX);
+		for (uint32_t i = 0; i < graph.Passes.size(); i++)
+		{
+			auto& compiledPass = graph.Passes[i];
+			for (auto& access : liveAccesses[i])
+			{
+				// Memory taken over from an aliased image has to wait until its last user is done
+				const auto slot = imageSlot[access.Resource];
+				if (slot != UINT32_MAX && firstUse[access.Resource] == i)
+				{
+					const auto occupant = slotOccupants[slot];
+					if (occupant != UINT32_MAX)
+					{
+						states[access.Resource].WriteStages = states[occupant].WriteStages | states[occupant].ReadStages;
+						states[access.Resource].WriteAccess = states[occupant].WriteAccess;
+					}
+
+					slotOccupants[slot] = access.Resource;
+				}
+
+				access.PreviousLayout = states[access.Resource].Layout;
+				applyAccess(compiledPass, access.Resource, access.Stage, access.Access, access.Layout, access.Write);
+			}
+
+			CreateRenderPass(compiledPass, liveAccesses[i], lastUse, i);
+
+			if (compiledPass.SrcStages != 0)
+				statistics.BarrierCount++;
+		}
+
+		// Imported images are handed back in the layout their owner expects
+		for (uint32_t i = 0; i < resourceCount; i++)
+		{
+			const auto& node = m_resources[i];
+			if (node.Imported == false || node.IsImage == false || node.Import.FinalState.Layout == VK_IMAGE_LAYOUT_UNDEFINED)
+				continue;
+
+			const auto& finalState = node.Import.FinalState;
+			applyAccess(graph.FinalBarriers, i, finalState.Stage, finalState.Access, finalState.Layout, false);
+		}
+
+		if (graph.FinalBarriers.SrcStages != 0)
+			statistics.BarrierCount++;
+	}
+
+	void VulkanRenderGraph::CreateRenderPass(CompiledPass& compiledPass, const std::vector<PassAccess>& accesses, const std::vector<uint32_t>& lastUse, uint32_t compiledIndex) const
+	{
+		// Color attachments keep their declaration order, the depth attachment goes last
+		auto attachments = std::vector<const PassAccess*>();
+		for (const auto& access : accesses)
+		{
+			if (access.ColorAttachment)
+				attachments.push_back(&access);
+		}
+
+		const auto colorCount = (uint32_t)attachments.size();
+		for (const auto& access : accesses)
+		{
+			if (access.DepthAttachment)
+				attachments.push_back(&access);
+		}
+
+		if (attachments.empty())
+			return;
+
+		if (attachments.size() - colorCount > 1)
+			throw std::runtime_error(std::format("Render graph pass {} has more than one depth attachment!", m_passes[compiledPass.Pass]->m_name));
+
+		auto descriptions = std::vector<VkAttachmentDescription>();
+		auto references = std::vector<VkAttachmentReference>();
+		compiledPass.Extent = m_resources[attachments.front()->Resource].ImageDesc.Extent;
+
+		for (const auto* access : attachments)
+		{
+			const auto& node = m_resources[access->Resource];
+			if (node.ImageDesc.Extent.width != compiledPass.Extent.width || node.ImageDesc.Extent.height != compiledPass.Extent.height)
+				throw std::runtime_error(std::format("Render graph pass {} has attachments of different sizes!", m_passes[compiledPass.Pass]->m_name));
+
+			// Contents that nobody reads afterwards are never stored, undefined contents are never loaded
+			auto loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			if (access->Clear)
+				loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			else if (access->PreviousLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+				loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+
+			const auto storeOp = node.Imported || lastUse[access->Resource] > compiledIndex ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+			// Barriers do the transitions, the render pass itself keeps every layout
+			auto description = VkAttachmentDescription();
+			description.format = node.ImageDesc.Format;
+			description.samples = VK_SAMPLE_COUNT_1_BIT;
+			description.loadOp = loadOp;
+			description.storeOp = storeOp;
+			description.stencilLoadOp = loadOp;
+			description.stencilStoreOp = storeOp;
+			description.initialLayout = access->Layout;
+			description.finalLayout = access->Layout;
+			descriptions.push_back(description);
+
+			references.push_back({ (uint32_t)references.size(), access->Layout });
+
+			// Same operations for dynamic rendering, the view and clear value are filled in when the pass is recorded
+			auto renderingAttachment = VkRenderingAttachmentInfoKHR();
+			renderingAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+			renderingAttachment.imageLayout = access->Layout;
+			renderingAttachment.loadOp = loadOp;
+			renderingAttachment.storeOp = storeOp;
+			compiledPass.RenderingAttachments.push_back(renderingAttachment);
+
+			compiledPass.Attachments.push_back(access->Resource);
+			compiledPass.AttachmentAccesses.push_back(access->AccessIndex);
+		}
+
+		compiledPass.ColorAttachmentCount = colorCount;
+		if (m_dynamicRendering)
+			return;
+
+		auto subPass = VkSubpassDescription();
+		subPass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subPass.colorAttachmentCount = colorCount;
+		subPass.pColorAttachments = colorCount > 0 ? references.data() : nullptr;
+		subPass.pDepthStencilAttachment = references.size() > colorCount ? &references.back() : nullptr;
+
+		auto renderPassInfo = VkRenderPassCreateInfo();
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = (uint32_t)descriptions.size();
+		renderPassInfo.pAttachments = descriptions.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subPass;
+
+		VULKAN_CHECK(vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &compiledPass.RenderPass));
+	}
+
+	void VulkanRenderGraph::Execute(VkCommandBuffer commandBuffer)
+	{
+		m_frameNumber++;
+
+		auto signature = BuildSignature();
+		uint64_t hash = 14695981039346656037ull;
+		for (const auto value : signature)
+		{
+			hash ^= value;
+			hash *= 1099511628211ull;
+		}
+
+		auto& cached = m_compiledGraphs[hash];
+		if (cached != nullptr && cached->Signature != signature)
+		{
+			Destroy(*cached);
+			cached = nullptr;
+		}
+
+		if (cached == nullptr)
+		{
+			cached = std::make_unique<CompiledGraph>();
+			cached->Signature = std::move(signature);
+			Compile(*cached);
+
+			const auto& statistics = cached->Statistics;
+			std::println("Render graph compiled: {} passes ({} culled), {} barriers, {} transient images in {:.2f} MiB ({:.2f} MiB without aliasing)",
+				statistics.PassCount, statistics.CulledPassCount, statistics.BarrierCount, statistics.TransientImageCount,
+				(double)statistics.TransientBytes / (1024.0 * 1024.0), (double)statistics.UnaliasedBytes / (1024.0 * 1024.0));
+		}
+
+		// The command buffer goes out with the next graphics submission
+		auto& graph = *cached;
+		graph.LastUsedValue = m_timeline->GetPendingValue();
+		m_statistics = graph.Statistics;
+		m_executing = &graph;
+
+		auto clearValues = std::vector<VkClearValue>();
+		for (const auto& compiledPass : graph.Passes)
+		{
+			RecordBarriers(commandBuffer, compiledPass);
+
+			const auto& pass = *m_passes[compiledPass.Pass];
+			const bool secondaryContents = pass.m_secondaryContents && compiledPass.Attachments.empty() == false;
+			if (secondaryContents)
+			{
+				// Secondaries have to name the exact render pass and framebuffer, or the formats of the dynamic rendering
+				m_inheritance.RenderPass = compiledPass.RenderPass;
+				m_inheritance.Framebuffer = compiledPass.RenderPass != nullptr ? GetFramebuffer(compiledPass) : nullptr;
+				m_inheritance.Extent = compiledPass.Extent;
+				m_inheritance.ColorFormats.clear();
+				m_inheritance.DepthFormat = VK_FORMAT_UNDEFINED;
+				m_inheritance.StencilFormat = VK_FORMAT_UNDEFINED;
+
+				for (size_t i = 0; i < compiledPass.Attachments.size(); i++)
+				{
+					const auto format = m_resources[compiledPass.Attachments[i]].ImageDesc.Format;
+					if (i < compiledPass.ColorAttachmentCount)
+						m_inheritance.ColorFormats.push_back(format);
+					else
+					{
+						m_inheritance.DepthFormat = format;
+						m_inheritance.StencilFormat = (GetAspectMask(format) & VK_IMAGE_ASPECT_STENCIL_BIT) != 0 ? format : VK_FORMAT_UNDEFINED;
+					}
+				}
+			}
+
+			if (m_dynamicRendering && compiledPass.Attachments.empty() == false)
+				BeginRendering(commandBuffer, compiledPass, secondaryContents);
+
+			if (compiledPass.RenderPass != nullptr)
+			{
+				clearValues.clear();
+				for (const auto accessIndex : compiledPass.AttachmentAccesses)
+					clearValues.push_back(pass.m_accesses[accessIndex].ClearValue);
+
+				auto renderPassInfo = VkRenderPassBeginInfo();
+				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				renderPassInfo.renderPass = compiledPass.RenderPass;
+				renderPassInfo.framebuffer = secondaryContents ? m_inheritance.Framebuffer : GetFramebuffer(compiledPass);
+				renderPassInfo.renderArea.offset = { 0, 0 };
+				renderPassInfo.renderArea.extent = compiledPass.Extent;
+				renderPassInfo.clearValueCount = (uint32_t)clearValues.size();
+				renderPassInfo.pClearValues = clearValues.data();
+
+				vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+			}
+
+			if (pass.m_execute)
+				pass.m_execute(commandBuffer);
+
+			if (compiledPass.RenderPass != nullptr)
+				vkCmdEndRenderPass(commandBuffer);
+			else if (m_dynamicRendering && compiledPass.Attachments.empty() == false)
+				m_logicalDevice->EndRendering(commandBuffer);
+		}
+
+		RecordBarriers(commandBuffer, graph.FinalBarriers);
+		m_executing = nullptr;
+
+		CollectGarbage();
+	}
+
+	void VulkanRenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const CompiledPass& compiledPass)
+	{
+		if (compiledPass.SrcStages == 0)
+			return;
+
+		m_imageBarriers.clear();
+		for (const auto& imageBarrier : compiledPass.ImageBarriers)
+		{
+			auto barrier = VkImageMemoryBarrier();
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = imageBarrier.SrcAccess;
+			barrier.dstAccessMask = imageBarrier.DstAccess;
+			barrier.oldLayout = imageBarrier.OldLayout;
+			barrier.newLayout = imageBarrier.NewLayout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = GetImage({ imageBarrier.Resource });
+			barrier.subresourceRange.aspectMask = GetAspectMask(m_resources[imageBarrier.Resource].ImageDesc.Format);
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+			m_imageBarriers.push_back(barrier);
+		}
+
+		// Buffers share one global memory barrier, drivers don't track buffer ranges anyway
+		auto memoryBarrier = VkMemoryBarrier();
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = compiledPass.MemorySrcAccess;
+		memoryBarrier.dstAccessMask = compiledPass.MemoryDstAccess;
+		const uint32_t memoryBarrierCount = compiledPass.MemorySrcAccess != 0 ? 1 : 0;
+
+		vkCmdPipelineBarrier(commandBuffer, compiledPass.SrcStages, compiledPass.DstStages, 0, memoryBarrierCount, &memoryBarrier,
+			0, nullptr, (uint32_t)m_imageBarriers.size(), m_imageBarriers.data());
+	}
+
+	void VulkanRenderGraph::BeginRendering(VkCommandBuffer commandBuffer, const CompiledPass& compiledPass, bool secondaryContents)
+	{
+		// Views of imported images change every frame, there is nothing to cache like with framebuffers
+		const auto& pass = *m_passes[compiledPass.Pass];
+		m_renderingAttachments.assign(compiledPass.RenderingAttachments.begin(), compiledPass.RenderingAttachments.end());
+		for (size_t i = 0; i < m_renderingAttachments.size(); i++)
+		{
+			m_renderingAttachments[i].imageView = GetImageView({ compiledPass.Attachments[i] });
+			m_renderingAttachments[i].clearValue = pass.m_accesses[compiledPass.AttachmentAccesses[i]].ClearValue;
+		}
+
+		const auto colorCount = compiledPass.ColorAttachmentCount;
+		const auto* depthAttachment = m_renderingAttachments.size() > colorCount ? &m_renderingAttachments.back() : nullptr;
+		const auto depthFormat = depthAttachment != nullptr ? m_resources[compiledPass.Attachments.back()].ImageDesc.Format : VK_FORMAT_UNDEFINED;
+
+		auto renderingInfo = VkRenderingInfoKHR();
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderingInfo.flags = secondaryContents ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+		renderingInfo.renderArea.offset = { 0, 0 };
+		renderingInfo.renderArea.extent = compiledPass.Extent;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = colorCount;
+		renderingInfo.pColorAttachments = colorCount > 0 ? m_renderingAttachments.data() : nullptr;
+		renderingInfo.pDepthAttachment = depthAttachment;
+		renderingInfo.pStencilAttachment = (GetAspectMask(depthFormat) & VK_IMAGE_ASPECT_STENCIL_BIT) != 0 ? depthAttachment : nullptr;
+
+		m_logicalDevice->BeginRendering(commandBuffer, renderingInfo);
+	}
+
+	VkFramebuffer VulkanRenderGraph::GetFramebuffer(const CompiledPass& compiledPass)
+	{
+		// Imported views change every frame, so framebuffers are cached by the views they were built from
+		auto key = std::vector<uint64_t>();
+		key.push_back((uint64_t)compiledPass.RenderPass);
+		key.push_back((uint64_t)compiledPass.Extent.width << 32 | compiledPass.Extent.height);
+
+		auto views = std::vector<VkImageView>();
+		for (const auto attachment : compiledPass.Attachments)
+		{
+			views.push_back(GetImageView({ attachment }));
+			key.push_back((uint64_t)views.back());
+		}
+
+		auto& entry = m_framebuffers[key];
+		entry.LastUsedFrame = m_frameNumber;
+		entry.LastUsedValue = m_timeline->GetPendingValue();
+
+		if (entry.Framebuffer != nullptr)
+			return entry.Framebuffer;
+
+		auto framebufferInfo = VkFramebufferCreateInfo();
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = compiledPass.RenderPass;
+		framebufferInfo.attachmentCount = (uint32_t)views.size();
+		framebufferInfo.pAttachments = views.data();
+		framebufferInfo.width = compiledPass.Extent.width;
+		framebufferInfo.height = compiledPass.Extent.height;
+		framebufferInfo.layers = 1;
+
+		VULKAN_CHECK(vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &entry.Framebuffer));
+		return entry.Framebuffer;
+	}
+
+	void VulkanRenderGraph::CollectGarbage()
+	{
+		// Evicted resources wait in the deletion queue for the last submission that used them
+		while (m_compiledGraphs.size() > MaxCachedGraphs)
+		{
+			const auto oldest = std::ranges::min_element(m_compiledGraphs, {}, [](const auto& graph) { return graph.second->LastUsedValue; });
+			Destroy(*oldest->second);
+			m_compiledGraphs.erase(oldest);
+		}
+
+		// Kept for a few frames so views that alternate don't rebuild them every frame
+		std::erase_if(m_framebuffers, [&](const auto& framebuffer)
+		{
+			if (framebuffer.second.LastUsedFrame + FramebufferRetention > m_frameNumber)
+				return false;
+
+			m_deletionQueue->Destroy(framebuffer.second.Framebuffer, framebuffer.second.LastUsedValue);
+			return true;
+		});
+	}
+
+	void VulkanRenderGraph::Destroy(CompiledGraph& graph)
+	{
+		for (const auto& compiledPass : graph.Passes)
+		{
+			if (compiledPass.RenderPass == nullptr)
+				continue;
+
+			std::erase_if(m_framebuffers, [&](const auto& framebuffer)
+			{
+				if (framebuffer.first.front() != (uint64_t)compiledPass.RenderPass)
+					return false;
+
+				m_deletionQueue->Destroy(framebuffer.second.Framebuffer, framebuffer.second.LastUsedValue);
+				return true;
+			});
+
+			m_deletionQueue->Destroy(compiledPass.RenderPass, graph.LastUsedValue);
+		}
+
+		// Images before the memory they alias, the queue keeps the order for equal values
+		for (const auto& image : graph.Images)
+		{
+			m_deletionQueue->Destroy(image.View, graph.LastUsedValue);
+			m_deletionQueue->Destroy(image.Image, graph.LastUsedValue);
+		}
+
+		for (const auto buffer : graph.Buffers)
+			m_deletionQueue->DestroyBuffer(buffer, graph.LastUsedValue);
+
+		for (const auto slot : graph.MemorySlots)
+			m_deletionQueue->Free(slot, graph.LastUsedValue);
+
+		graph = CompiledGraph();
+	}
+
+	VkImage VulkanRenderGraph::GetImage(VulkanRenderGraphResource resource) const
+	{
+		const auto& node = m_resources[resource.Index];
+		return node.Imported ? node.Import.Image : m_executing->Images[resource.Index].Image;
+	}
+
+	VkImageView VulkanRenderGraph::GetImageView(VulkanRenderGraphResource resource) const
+	{
+		const auto& node = m_resources[resource.Index];
+		return node.Imported ? node.Import.View : m_executing->Images[resource.Index].View;
+	}
+
+	VkBuffer VulkanRenderGraph::GetBuffer(VulkanRenderGraphResource resource) const
+	{
+		const auto& node = m_resources[resource.Index];
+		return node.Imported ? node.ImportedBuffer : m_executing->Buffers[resource.Index]->Buffer;
+	}
+
+	VulkanRenderGraph::~VulkanRenderGraph()
+	{
+		for (auto& [_, graph] : m_compiledGraphs)
+			Destroy(*graph);
+
+		for (const auto& [_, framebuffer] : m_framebuffers)
+			m_deletionQueue->Destroy(framebuffer.Framebuffer, framebuffer.LastUsedValue);
+	}
+}
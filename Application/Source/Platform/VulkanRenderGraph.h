@@ -0,0 +1,277 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "VulkanAllocator.h"
+#include "VulkanDevice.h"
+#include "VulkanRenderTarget.h"
+#include "VulkanTimeline.h"
+
+namespace VEngine
+{
+	enum class VulkanRenderGraphAccess
+	{
+		ColorAttachment,
+		DepthAttachment,
+		DepthAttachmentRead,
+		SampledFragment,
+		SampledCompute,
+		StorageRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst,
+		VertexBuffer,
+		IndexBuffer,
+		IndirectBuffer,
+		UniformBuffer
+	};
+
+	struct VulkanRenderGraphResource
+	{
+		uint32_t Index = UINT32_MAX;
+
+		bool IsValid() const { return Index != UINT32_MAX; }
+	};
+
+	struct VulkanRenderGraphImageDesc
+	{
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		VkExtent2D Extent = {};
+
+		// Added to the usage derived from the declared accesses
+		VkImageUsageFlags Usage = 0;
+	};
+
+	struct VulkanRenderGraphImport
+	{
+		VkImage Image = nullptr;
+		VkImageView View = nullptr;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		VkExtent2D Extent = {};
+
+		VulkanRenderTargetImageState InitialState;
+		VulkanRenderTargetImageState FinalState;
+	};
+
+	struct VulkanRenderGraphStatistics
+	{
+		uint32_t PassCount = 0;
+		uint32_t CulledPassCount = 0;
+		uint32_t BarrierCount = 0;
+		uint32_t TransientImageCount = 0;
+
+		VkDeviceSize TransientBytes = 0;
+		VkDeviceSize UnaliasedBytes = 0;
+	};
+
+	// What secondary command buffers recorded for a pass have to inherit
+	struct VulkanRenderGraphInheritance
+	{
+		// Null with dynamic rendering, the formats describe the attachments instead
+		VkRenderPass RenderPass = nullptr;
+		VkFramebuffer Framebuffer = nullptr;
+
+		std::vector<VkFormat> ColorFormats;
+		VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+		VkFormat StencilFormat = VK_FORMAT_UNDEFINED;
+		VkExtent2D Extent = {};
+	};
+
+	using VulkanRenderGraphExecute = std::function<void(VkCommandBuffer commandBuffer)>;
+
+	class VulkanRenderGraphPass
+	{
+	public:
+		VulkanRenderGraphPass& Read(VulkanRenderGraphResource resource, VulkanRenderGraphAccess access);
+		VulkanRenderGraphPass& Write(VulkanRenderGraphResource resource, VulkanRenderGraphAccess access);
+
+		// Attachment write whose previous contents are discarded, passes that only produced them get culled
+		VulkanRenderGraphPass& Clear(VulkanRenderGraphResource resource, VulkanRenderGraphAccess access, VkClearValue clearValue);
+
+		// Passes with side effects are never culled, even if nothing reads their outputs
+		VulkanRenderGraphPass& SetSideEffects() { m_sideEffects = true; return *this; }
+
+		// Its render pass is begun for secondary command buffers, the callback may only execute them into the primary
+		VulkanRenderGraphPass& SetSecondaryContents() { m_secondaryContents = true; return *this; }
+
+	private:
+		friend class VulkanRenderGraph;
+
+		struct Access
+		{
+			uint32_t Resource = 0;
+			VulkanRenderGraphAccess Type = VulkanRenderGraphAccess::ColorAttachment;
+			bool Write = false;
+			bool Clear = false;
+			VkClearValue ClearValue = {};
+		};
+
+		std::string m_name;
+		VulkanRenderGraphExecute m_execute;
+		std::vector<Access> m_accesses;
+		bool m_sideEffects = false;
+		bool m_secondaryContents = false;
+	};
+
+	class VulkanRenderGraph
+	{
+	public:
+		// Compiled graphs are cached by shape, the last few shapes are kept so toggling a pass doesn't rebuild resources
+		static constexpr size_t MaxCachedGraphs = 4;
+		static constexpr uint64_t FramebufferRetention = 16;
+
+		explicit VulkanRenderGraph(const std::shared_ptr<VulkanLogicalDevice>& device);
+		VulkanRenderGraph(const VulkanRenderGraph&) = delete;
+		VulkanRenderGraph(VulkanRenderGraph&&) = delete;
+		~VulkanRenderGraph();
+
+		// Declarations only live for one frame, the graph is declared again every frame
+		void Reset();
+
+		VulkanRenderGraphResource CreateImage(const std::string& name, const VulkanRenderGraphImageDesc& desc);
+		VulkanRenderGraphResource CreateBuffer(const std::string& name, VkDeviceSize size, VkBufferUsageFlags usage = 0);
+		VulkanRenderGraphResource ImportImage(const std::string& name, const VulkanRenderGraphImport& import);
+		VulkanRenderGraphResource ImportBuffer(const std::string& name, VkBuffer buffer, VkDeviceSize size);
+		VulkanRenderGraphResource ImportTarget(const VulkanRenderTarget& target);
+
+		// Passes run in declaration order, the reference stays valid until Reset
+		VulkanRenderGraphPass& AddPass(const std::string& name, VulkanRenderGraphExecute execute);
+
+		// Culls, inserts barriers and records every live pass, the command buffer must be outside a render pass
+		void Execute(VkCommandBuffer commandBuffer);
+
+		// Only valid while Execute runs the pass callbacks
+		VkImage GetImage(VulkanRenderGraphResource resource) const;
+		VkImageView GetImageView(VulkanRenderGraphResource resource) const;
+		VkBuffer GetBuffer(VulkanRenderGraphResource resource) const;
+
+		// Only valid while Execute runs the callback of a pass with secondary contents
+		const VulkanRenderGraphInheritance& GetInheritance() const { return m_inheritance; }
+
+		const VulkanRenderGraphStatistics& GetStatistics() const { return m_statistics; }
+
+	private:
+		struct ResourceNode
+		{
+			std::string Name;
+			bool IsImage = true;
+			bool Imported = false;
+
+			VulkanRenderGraphImageDesc ImageDesc;
+			VulkanRenderGraphImport Import;
+
+			VkBuffer ImportedBuffer = nullptr;
+			VkDeviceSize BufferSize = 0;
+			VkBufferUsageFlags BufferUsage = 0;
+		};
+
+		struct PassAccess
+		{
+			uint32_t Resource = 0;
+			uint32_t AccessIndex = 0;
+
+			VkPipelineStageFlags Stage = 0;
+			VkAccessFlags Access = 0;
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImageLayout PreviousLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			bool Write = false;
+			bool Clear = false;
+			bool ColorAttachment = false;
+			bool DepthAttachment = false;
+		};
+
+		struct ImageBarrier
+		{
+			uint32_t Resource = 0;
+			VkImageLayout OldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImageLayout NewLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkAccessFlags SrcAccess = 0;
+			VkAccessFlags DstAccess = 0;
+		};
+
+		struct CompiledPass
+		{
+			uint32_t Pass = UINT32_MAX;
+
+			// All hazards of a pass are resolved by a single vkCmdPipelineBarrier
+			VkPipelineStageFlags SrcStages = 0;
+			VkPipelineStageFlags DstStages = 0;
+			std::vector<ImageBarrier> ImageBarriers;
+			VkAccessFlags MemorySrcAccess = 0;
+			VkAccessFlags MemoryDstAccess = 0;
+
+			// RenderPass stays null with dynamic rendering, the attachments are begun directly from RenderingAttachments
+			VkRenderPass RenderPass = nullptr;
+			VkExtent2D Extent = {};
+			std::vector<uint32_t> Attachments;
+			std::vector<uint32_t> AttachmentAccesses;
+			std::vector<VkRenderingAttachmentInfoKHR> RenderingAttachments;
+			uint32_t ColorAttachmentCount = 0;
+		};
+
+		struct TransientImage
+		{
+			VkImage Image = nullptr;
+			VkImageView View = nullptr;
+		};
+
+		struct CompiledGraph
+		{
+			std::vector<uint64_t> Signature;
+
+			std::vector<CompiledPass> Passes;
+			CompiledPass FinalBarriers;
+
+			std::vector<TransientImage> Images;
+			std::vector<VulkanAllocation*> Buffers;
+			std::vector<VulkanAllocation*> MemorySlots;
+
+			VulkanRenderGraphStatistics Statistics;
+			uint64_t LastUsedValue = 0;
+		};
+
+		struct FramebufferEntry
+		{
+			VkFramebuffer Framebuffer = nullptr;
+			uint64_t LastUsedFrame = 0;
+			uint64_t LastUsedValue = 0;
+		};
+
+		std::vector<uint64_t> BuildSignature() const;
+		void Compile(CompiledGraph& graph);
+		std::vector<PassAccess> MergeAccesses(const VulkanRenderGraphPass& pass) const;
+		void CreateRenderPass(CompiledPass& compiledPass, const std::vector<PassAccess>& accesses, const std::vector<uint32_t>& lastUse, uint32_t compiledIndex) const;
+		void Destroy(CompiledGraph& graph);
+
+		void RecordBarriers(VkCommandBuffer commandBuffer, const CompiledPass& compiledPass);
+		void BeginRendering(VkCommandBuffer commandBuffer, const CompiledPass& compiledPass, bool secondaryContents);
+		VkFramebuffer GetFramebuffer(const CompiledPass& compiledPass);
+		void CollectGarbage();
+
+		std::shared_ptr<VulkanLogicalDevice> m_logicalDevice;
+		VkDevice m_device;
+		VulkanAllocator* m_allocator;
+		VulkanTimeline* m_timeline;
+		VulkanDeletionQueue* m_deletionQueue;
+		bool m_dynamicRendering = false;
+		uint64_t m_frameNumber = 0;
+
+		std::vector<ResourceNode> m_resources;
+		std::vector<std::unique_ptr<VulkanRenderGraphPass>> m_passes;
+
+		std::unordered_map<uint64_t, std::unique_ptr<CompiledGraph>> m_compiledGraphs;
+		std::map<std::vector<uint64_t>, FramebufferEntry> m_framebuffers;
+
+		CompiledGraph* m_executing = nullptr;
+		std::vector<VkImageMemoryBarrier> m_imageBarriers;
+		std::vector<VkRenderingAttachmentInfoKHR> m_renderingAttachments;
+		VulkanRenderGraphInheritance m_inheritance;
+		VulkanRenderGraphStatistics m_statistics;
+	};
+}
@@ -0,0 +1,141 @@
+#include "VulkanRenderTarget.h"
+
+#include "Renderer.h"
+#include "VulkanScope.h"
+
+namespace VEngine
+{
+	bool VulkanRenderTarget::Begin(VkSubpassContents contents)
+	{
+		if (BeginFrame() == false)
+			return false;
+
+		BeginRenderPass(contents);
+		return true;
+	}
+
+	void VulkanRenderTarget::BeginRenderPass(VkSubpassContents contents)
+	{
+		constexpr VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
+		if (GetRenderPass() == nullptr)
+		{
+			// No render pass to do the layout transitions, the barriers around the rendering take over
+			const auto initialState = GetInitialState();
+			TransitionImage(initialState, { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT });
+
+			auto colorAttachment = VkRenderingAttachmentInfoKHR();
+			colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+			colorAttachment.imageView = GetImageView();
+			colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			colorAttachment.clearValue = clearColor;
+
+			auto renderingInfo = VkRenderingInfoKHR();
+			renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+			renderingInfo.flags = contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+			renderingInfo.renderArea.offset = { 0, 0 };
+			renderingInfo.renderArea.extent = GetExtent();
+			renderingInfo.layerCount = 1;
+			renderingInfo.colorAttachmentCount = 1;
+			renderingInfo.pColorAttachments = &colorAttachment;
+
+			Renderer::GetScope().GetVulkanDevice()->BeginRendering(GetCommandBuffer(), renderingInfo);
+			m_renderPassActive = true;
+			return;
+		}
+
+		auto renderPassInfo = VkRenderPassBeginInfo();
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = GetRenderPass();
+		renderPassInfo.framebuffer = GetFramebuffer();
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = GetExtent();
+		renderPassInfo.clearValueCount = 1;
+		renderPassInfo.pClearValues = &clearColor;
+
+		vkCmdBeginRenderPass(GetCommandBuffer(), &renderPassInfo, contents);
+		m_renderPassActive = true;
+	}
+
+	void VulkanRenderTarget::EndRenderPass()
+	{
+		if (m_renderPassActive == false)
+			return;
+
+		m_renderPassActive = false;
+		if (GetRenderPass() == nullptr)
+		{
+			Renderer::GetScope().GetVulkanDevice()->EndRendering(GetCommandBuffer());
+			TransitionImage({ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT }, GetFinalState());
+			return;
+		}
+
+		vkCmdEndRenderPass(GetCommandBuffer());
+	}
+
+	void VulkanRenderTarget::TransitionImage(const VulkanRenderTargetImageState& from, const VulkanRenderTargetImageState& to)
+	{
+		auto barrier = VkImageMemoryBarrier();
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = from.Access;
+		barrier.dstAccessMask = to.Access;
+		barrier.oldLayout = from.Layout;
+		barrier.newLayout = to.Layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = GetImage();
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+
+		vkCmdPipelineBarrier(GetCommandBuffer(), from.Stage, to.Stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	void VulkanRenderTarget::Apply(const VulkanPipeline& pipeline)
+	{
+		Apply(GetCommandBuffer(), pipeline);
+	}
+
+	void VulkanRenderTarget::Bind(VkCommandBuffer commandBuffer, const VulkanPipeline& pipeline) const
+	{
+		const auto extent = GetExtent();
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetPipeline());
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = extent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	void VulkanRenderTarget::Apply(VkCommandBuffer commandBuffer, const VulkanPipeline& pipeline) const
+	{
+		Bind(commandBuffer, pipeline);
+		vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+	}
+
+	bool VulkanRenderTarget::Apply(const VulkanPipelineHandle& handle, const std::shared_ptr<VulkanPipeline>& fallback)
+	{
+		if (handle.IsReady())
+		{
+			Apply(*handle.GetPipeline());
+			return true;
+		}
+
+		if (fallback == nullptr)
+			return false;
+
+		Apply(*fallback);
+		return true;
+	}
+}
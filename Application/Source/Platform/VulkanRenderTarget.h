@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+
+#include "VulkanPipeline.h"
+#include "VulkanPipelineCompiler.h"
+
+namespace VEngine 
+{
+	// State of the frame's image when recording starts and the state it has to be left in before submission
+	struct VulkanRenderTargetImageState
+	{
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags Stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		VkAccessFlags Access = 0;
+	};
+
+	class VulkanRenderTarget
+	{
+	public:
+		// Targets clamp the frames in flight they are asked for to this
+		static constexpr uint32_t MaxFramesInFlight = 3;
+
+		virtual ~VulkanRenderTarget() = default;
+
+		// Both are null when the device renders dynamically, pipelines are then built against GetFormat instead
+		virtual VkRenderPass GetRenderPass() const = 0;
+		virtual VkExtent2D GetExtent() const = 0;
+		virtual VkFormat GetFormat() const = 0;
+
+		virtual uint32_t GetFramesInFlight() const = 0;
+		virtual uint32_t GetFrameIndex() const = 0;
+		virtual VkCommandBuffer GetCommandBuffer() const = 0;
+		virtual VkFramebuffer GetFramebuffer() const = 0;
+
+		virtual VkImage GetImage() const = 0;
+		virtual VkImageView GetImageView() const = 0;
+		virtual VulkanRenderTargetImageState GetInitialState() const = 0;
+		virtual VulkanRenderTargetImageState GetFinalState() const = 0;
+
+		// Returns false when the frame has to be skipped, nothing may be recorded and End must not be called then.
+		// Only begins the command buffer, render passes are left to the caller or a VulkanRenderGraph.
+		virtual bool BeginFrame() = 0;
+		virtual void End() = 0;
+
+		// Frame with the target's own render pass already begun.
+		// Secondary command buffers are recorded inside render graph passes instead, see SetSecondaryContents.
+		bool Begin(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+		void BeginRenderPass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+		// Binds the pipeline and sets viewport and scissor to the target, draws are left to the caller
+		void Bind(VkCommandBuffer commandBuffer, const VulkanPipeline& pipeline) const;
+
+		// Binds and draws a fullscreen triangle, passes with many draws go through a VulkanDrawList instead
+		void Apply(const VulkanPipeline& pipeline);
+		void Apply(VkCommandBuffer commandBuffer, const VulkanPipeline& pipeline) const;
+
+		// Never blocks on compilation, draws with the fallback or skips the draw while the pipeline is pending
+		bool Apply(const VulkanPipelineHandle& handle, const std::shared_ptr<VulkanPipeline>& fallback = nullptr);
+
+	protected:
+		void EndRenderPass();
+
+	private:
+		void TransitionImage(const VulkanRenderTargetImageState& from, const VulkanRenderTargetImageState& to);
+
+		bool m_renderPassActive = false;
+	};
+}
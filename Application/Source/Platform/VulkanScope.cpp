@@ -7,7 +7,7 @@
 
 namespace VEngine
 {
-	void VulkanScope::Initialize()
+	void VulkanScope::Initialize(bool headless)
 	{
 		if (s_instance != nullptr)
 			return;
@@ -20,13 +20,38 @@ namespace VEngine
 		appInfo.apiVersion = VK_API_VERSION_1_2;
 
 		// Setup Vulkan Instance
-		uint32_t extCount = 0;
-		const char** exts = glfwGetRequiredInstanceExtensions(&extCount);
+		auto extensions = std::vector<const char*>();
+		if (headless == false)
+		{
+			uint32_t extCount = 0;
+			const char** exts = glfwGetRequiredInstanceExtensions(&extCount);
+			extensions.assign(exts, exts + extCount);
+		}
+
+		uint32_t vulkanExtensionCount = 0;
+		vkEnumerateInstanceExtensionProperties(nullptr, &vulkanExtensionCount, nullptr);
+
+		auto instanceExtensionProperties = std::vector<VkExtensionProperties>(vulkanExtensionCount);
+		vkEnumerateInstanceExtensionProperties(nullptr, &vulkanExtensionCount, instanceExtensionProperties.data());
+
+		// Software ICDs on CI hosts don't always expose the debug extensions
+		const auto addIfSupported = [&](const char* extensionName)
+		{
+			for (const VkExtensionProperties& extension : instanceExtensionProperties)
+			{
+				if (strcmp(extension.extensionName, extensionName) != 0)
+					continue;
+
+				extensions.push_back(extensionName);
+				return true;
+			}
+
+			return false;
+		};
 
-		auto extensions = std::vector(exts, exts + extCount);
-		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-		extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
-		extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+		const bool debugUtils = addIfSupported(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		addIfSupported(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+		addIfSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 
 		constexpr VkValidationFeatureEnableEXT validationFeatures[] = { VK_VALIDATION_FEATURE_ENABLE_BEST_PRACTICES_EXT };
 		auto features = VkValidationFeaturesEXT();
@@ -42,8 +67,6 @@ namespace VEngine
 		createInfo.ppEnabledExtensionNames = extensions.data();
 		createInfo.enabledLayerCount = 0;
 
-		uint32_t vulkanExtensionCount = 0;
-		vkEnumerateInstanceExtensionProperties(nullptr, &vulkanExtensionCount, nullptr);
 		std::println("Enabled extensions: {}, supported extensions: {}\n", extensions.size(), vulkanExtensionCount);
 
 		// Find Validation Layer
@@ -57,7 +80,7 @@ namespace VEngine
 		bool validationLayer = false;
 		for (const VkLayerProperties& layer : instanceLayerProperties)
 		{
-			if (strcmp(layer.layerName, validationLayerName) != 0)
+			if (debugUtils == false || strcmp(layer.layerName, validationLayerName) != 0)
 				continue;
 
 			validationLayer = true;
@@ -67,19 +90,23 @@ namespace VEngine
 			break;
 		}
 
+		if (validationLayer == false)
+			createInfo.pNext = nullptr;
+
 		// Create Instance & Debugger if possible
 		VULKAN_CHECK(vkCreateInstance(&createInfo, nullptr, &s_instance));
 
-		if (validationLayer == false)
+		if (validationLayer)
+		{
+			m_debugger = std::make_unique<VulkanDebugger>();
+			m_debugger->SetupDebugMessenger();
+		}
+		else
 		{
 			std::println("Validation is disabled");
-			return;
 		}
 
-		m_debugger = std::make_unique<VulkanDebugger>();
-		m_debugger->SetupDebugMessenger();
-
-        m_physicalDevice = std::make_shared<VulkanPhysicalDevice>();
+		m_physicalDevice = std::make_shared<VulkanPhysicalDevice>();
 		m_logicalDevice = std::make_shared<VulkanLogicalDevice>(m_physicalDevice);
 	}
 
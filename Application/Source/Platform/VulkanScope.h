@@ -13,7 +13,7 @@ namespace VEngine
 		VulkanScope(VulkanScope&&) = delete;
 		~VulkanScope();
 
-		void Initialize();
+		void Initialize(bool headless = false);
 
 		const std::shared_ptr<VulkanLogicalDevice>& GetVulkanDevice() { return m_logicalDevice; }
 
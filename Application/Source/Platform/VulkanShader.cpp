@@ -1,6 +1,7 @@
 #include "VulkanShader.h"
 
 #include <fstream>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
@@ -27,14 +28,25 @@ namespace VEngine
     }
 
 	VulkanShader::VulkanShader(const std::string& filename, VkShaderStageFlagBits type)
+		: m_filename(filename), m_stage(type)
 	{
 		const auto device = Renderer::GetScope().GetVulkanDevice()->GetDevice();
 
-		const auto code = ReadFile(filename);
+		// Archive entries are aligned, so the mapped SPIR-V goes to the driver without a copy
+		auto code = Renderer::GetAssets().Find(filename);
+		auto looseCode = std::vector<uint32_t>();
+		if (code.empty())
+		{
+			looseCode = ReadFile(filename);
+			code = std::as_bytes(std::span(looseCode));
+		}
+
+		const auto words = std::span(reinterpret_cast<const uint32_t*>(code.data()), code.size() / sizeof(uint32_t));
+		m_reflection = VulkanShaderReflection::Reflect(words, type);
 
 		auto createInfo = VkShaderModuleCreateInfo();
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = 4 * code.size();
+		createInfo.codeSize = code.size();
 		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
 		VULKAN_CHECK(vkCreateShaderModule(device, &createInfo, nullptr, &m_module));
@@ -53,6 +65,7 @@ namespace VEngine
 		if (m_module == nullptr)
 			return;
 
+		// Pipelines keep no reference to their modules and the GPU never reads one, so nothing has to be deferred
 		const auto device = Renderer::GetScope().GetVulkanDevice()->GetDevice();
 
 		vkDestroyShaderModule(device, m_module, nullptr);
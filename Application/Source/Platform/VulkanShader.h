@@ -3,6 +3,8 @@
 #include <string>
 #include <vulkan/vulkan_core.h>
 
+#include "VulkanShaderReflection.h"
+
 namespace VEngine 
 {
 	class VulkanShader
@@ -14,8 +16,14 @@ namespace VEngine
 		~VulkanShader();
 
 		const VkPipelineShaderStageCreateInfo& GetCreateInfo() const { return m_createInfo; }
+		const VulkanShaderReflection& GetReflection() const { return m_reflection; }
+		const std::string& GetFilename() const { return m_filename; }
+		VkShaderStageFlagBits GetStage() const { return m_stage; }
 
 	private:
+		std::string m_filename;
+		VkShaderStageFlagBits m_stage;
+		VulkanShaderReflection m_reflection;
 		VkShaderModule m_module;
 		VkPipelineShaderStageCreateInfo m_createInfo;
 	};
@@ -0,0 +1,409 @@
+#include "VulkanShaderReflection.h"
+#include "VulkanScope.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace VEngine
+{
+	// The subset of the SPIR-V instruction set that describes resource interfaces
+	enum SpirvOp : uint32_t
+	{
+		SpirvOpTypeBool = 20,
+		SpirvOpTypeInt = 21,
+		SpirvOpTypeFloat = 22,
+		SpirvOpTypeVector = 23,
+		SpirvOpTypeMatrix = 24,
+		SpirvOpTypeImage = 25,
+		SpirvOpTypeSampler = 26,
+		SpirvOpTypeSampledImage = 27,
+		SpirvOpTypeArray = 28,
+		SpirvOpTypeRuntimeArray = 29,
+		SpirvOpTypeStruct = 30,
+		SpirvOpTypePointer = 32,
+		SpirvOpConstant = 43,
+		SpirvOpSpecConstant = 50,
+		SpirvOpVariable = 59,
+		SpirvOpDecorate = 71,
+		SpirvOpMemberDecorate = 72,
+		SpirvOpTypeAccelerationStructure = 5341
+	};
+
+	enum SpirvDecoration : uint32_t
+	{
+		SpirvDecorationBufferBlock = 3,
+		SpirvDecorationArrayStride = 6,
+		SpirvDecorationMatrixStride = 7,
+		SpirvDecorationBinding = 33,
+		SpirvDecorationDescriptorSet = 34,
+		SpirvDecorationOffset = 35
+	};
+
+	enum SpirvStorageClass : uint32_t
+	{
+		SpirvStorageClassUniformConstant = 0,
+		SpirvStorageClassUniform = 2,
+		SpirvStorageClassPushConstant = 9,
+		SpirvStorageClassStorageBuffer = 12
+	};
+
+	static constexpr uint32_t SpirvMagic = 0x07230203;
+	static constexpr uint32_t SpirvDimBuffer = 5;
+	static constexpr uint32_t SpirvDimSubpassData = 6;
+	static constexpr uint32_t SpirvUnset = UINT32_MAX;
+
+	// Everything the reflection needs to know about one result id
+	struct SpirvId
+	{
+		uint32_t Opcode = 0;
+
+		// Pointee, element, component or column type, depending on the opcode
+		uint32_t Type = SpirvUnset;
+
+		// Bit width of scalars, component count of vectors and matrices, length id of arrays, value of constants
+		uint32_t Value = 0;
+
+		uint32_t StorageClass = SpirvUnset;
+		uint32_t Set = SpirvUnset;
+		uint32_t Binding = SpirvUnset;
+		uint32_t ArrayStride = 0;
+		uint32_t ImageDim = 0;
+		uint32_t ImageSampled = 0;
+		bool BufferBlock = false;
+
+		std::vector<uint32_t> Members;
+		std::vector<uint32_t> MemberOffsets;
+		std::vector<uint32_t> MemberMatrixStrides;
+	};
+
+	static uint32_t GetTypeSize(const std::vector<SpirvId>& ids, uint32_t type, uint32_t matrixStride = 0)
+	{
+		if (type >= ids.size())
+			return 0;
+
+		const auto& id = ids[type];
+		switch (id.Opcode)
+		{
+		case SpirvOpTypeBool:
+			return 4;
+		case SpirvOpTypeInt:
+		case SpirvOpTypeFloat:
+			return id.Value / 8;
+		case SpirvOpTypeVector:
+			return id.Value * GetTypeSize(ids, id.Type);
+		case SpirvOpTypeMatrix:
+			return id.Value * (matrixStride != 0 ? matrixStride : GetTypeSize(ids, id.Type));
+		case SpirvOpTypeArray:
+			return (id.Value < ids.size() ? ids[id.Value].Value : 0) * (id.ArrayStride != 0 ? id.ArrayStride : GetTypeSize(ids, id.Type));
+		case SpirvOpTypeStruct:
+		{
+			uint32_t size = 0;
+			for (size_t member = 0; member < id.Members.size(); member++)
+			{
+				const auto offset = member < id.MemberOffsets.size() ? id.MemberOffsets[member] : 0;
+				const auto stride = member < id.MemberMatrixStrides.size() ? id.MemberMatrixStrides[member] : 0;
+				size = std::max(size, offset + GetTypeSize(ids, id.Members[member], stride));
+			}
+
+			return size;
+		}
+		default:
+			// Runtime arrays have no static size
+			return 0;
+		}
+	}
+
+	static VkDescriptorType GetDescriptorType(const SpirvId& type, uint32_t storageClass)
+	{
+		if (storageClass == SpirvStorageClassStorageBuffer || (storageClass == SpirvStorageClassUniform && type.BufferBlock))
+			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		if (storageClass == SpirvStorageClassUniform)
+			return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+		switch (type.Opcode)
+		{
+		case SpirvOpTypeSampler:
+			return VK_DESCRIPTOR_TYPE_SAMPLER;
+		case SpirvOpTypeSampledImage:
+			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case SpirvOpTypeAccelerationStructure:
+			return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+		case SpirvOpTypeImage:
+			// Sampled is 1 for images used with a sampler and 2 for storage images
+			if (type.ImageDim == SpirvDimBuffer)
+				return type.ImageSampled == 1 ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+			if (type.ImageDim == SpirvDimSubpassData)
+				return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			return type.ImageSampled == 1 ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		default:
+			throw std::runtime_error(std::format("Unsupported SPIR-V resource type (opcode {})", type.Opcode));
+		}
+	}
+
+	VulkanShaderReflection VulkanShaderReflection::Reflect(std::span<const uint32_t> code, VkShaderStageFlagBits stage)
+	{
+		// Header: magic, version, generator, id bound, schema
+		if (code.size() < 5 || code[0] != SpirvMagic)
+			throw std::runtime_error("Shader code is not SPIR-V");
+
+		auto ids = std::vector<SpirvId>(code[3]);
+		const auto getId = [&](uint32_t id) -> SpirvId&
+		{
+			if (id >= ids.size())
+				throw std::runtime_error("SPIR-V id is out of bounds");
+
+			return ids[id];
+		};
+
+		auto variables = std::vector<uint32_t>();
+		for (size_t offset = 5; offset < code.size();)
+		{
+			const auto wordCount = code[offset] >> 16;
+			const auto opcode = code[offset] & 0xffff;
+			if (wordCount == 0 || offset + wordCount > code.size())
+				throw std::runtime_error("SPIR-V instruction is truncated");
+
+			const auto operands = code.subspan(offset + 1, wordCount - 1);
+			const auto operand = [&](size_t index)
+			{
+				if (index >= operands.size())
+					throw std::runtime_error("SPIR-V instruction is missing operands");
+
+				return operands[index];
+			};
+
+			offset += wordCount;
+
+			switch (opcode)
+			{
+			case SpirvOpDecorate:
+			{
+				auto& target = getId(operand(0));
+				const auto literal = operands.size() > 2 ? operands[2] : 0;
+				switch (operand(1))
+				{
+				case SpirvDecorationDescriptorSet: target.Set = literal; break;
+				case SpirvDecorationBinding: target.Binding = literal; break;
+				case SpirvDecorationArrayStride: target.ArrayStride = literal; break;
+				case SpirvDecorationBufferBlock: target.BufferBlock = true; break;
+				default: break;
+				}
+				break;
+			}
+			case SpirvOpMemberDecorate:
+			{
+				// Decorations come before the struct is declared, so the member arrays grow on demand
+				auto& target = getId(operand(0));
+				const auto member = operand(1);
+				auto* values = operand(2) == SpirvDecorationOffset ? &target.MemberOffsets :
+					operand(2) == SpirvDecorationMatrixStride ? &target.MemberMatrixStrides : nullptr;
+
+				if (values != nullptr)
+				{
+					values->resize(std::max<size_t>(values->size(), member + 1), 0);
+					(*values)[member] = operand(3);
+				}
+				break;
+			}
+			case SpirvOpTypeBool:
+			case SpirvOpTypeSampler:
+			case SpirvOpTypeSampledImage:
+			case SpirvOpTypeAccelerationStructure:
+				getId(operand(0)).Opcode = opcode;
+				break;
+			case SpirvOpTypeInt:
+			case SpirvOpTypeFloat:
+			{
+				auto& type = getId(operand(0));
+				type.Opcode = opcode;
+				type.Value = operand(1);
+				break;
+			}
+			case SpirvOpTypeVector:
+			case SpirvOpTypeMatrix:
+			case SpirvOpTypeArray:
+			{
+				auto& type = getId(operand(0));
+				type.Opcode = opcode;
+				type.Type = operand(1);
+				type.Value = operand(2);
+				break;
+			}
+			case SpirvOpTypeRuntimeArray:
+			{
+				auto& type = getId(operand(0));
+				type.Opcode = opcode;
+				type.Type = operand(1);
+				break;
+			}
+			case SpirvOpTypeImage:
+			{
+				auto& type = getId(operand(0));
+				type.Opcode = opcode;
+				type.ImageDim = operand(2);
+				type.ImageSampled = operand(6);
+				break;
+			}
+			case SpirvOpTypeStruct:
+			{
+				auto& type = getId(operand(0));
+				type.Opcode = opcode;
+				type.Members.assign(operands.begin() + 1, operands.end());
+				break;
+			}
+			case SpirvOpTypePointer:
+			{
+				auto& type = getId(operand(0));
+				type.Opcode = opcode;
+				type.StorageClass = operand(1);
+				type.Type = operand(2);
+				break;
+			}
+			case SpirvOpConstant:
+			case SpirvOpSpecConstant:
+			{
+				// Only 32-bit values matter, they size arrays
+				auto& constant = getId(operand(1));
+				constant.Opcode = opcode;
+				constant.Value = operand(2);
+				break;
+			}
+			case SpirvOpVariable:
+			{
+				auto& variable = getId(operand(1));
+				variable.Opcode = opcode;
+				variable.Type = operand(0);
+				variable.StorageClass = operand(2);
+				variables.push_back(operand(1));
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		auto reflection = VulkanShaderReflection();
+		reflection.Stage = stage;
+
+		for (const auto variableId : variables)
+		{
+			const auto& variable = ids[variableId];
+			auto type = getId(variable.Type).Type;
+
+			if (variable.StorageClass == SpirvStorageClassPushConstant)
+			{
+				reflection.PushConstantSize = std::max(reflection.PushConstantSize, GetTypeSize(ids, type));
+				continue;
+			}
+
+			const auto isResource = variable.StorageClass == SpirvStorageClassUniformConstant || variable.StorageClass == SpirvStorageClassUniform ||
+				variable.StorageClass == SpirvStorageClassStorageBuffer;
+			if (isResource == false || variable.Set == SpirvUnset || variable.Binding == SpirvUnset)
+				continue;
+
+			// Arrays of resources become the descriptor count
+			uint32_t count = 1;
+			while (getId(type).Opcode == SpirvOpTypeArray || getId(type).Opcode == SpirvOpTypeRuntimeArray)
+			{
+				const auto& array = ids[type];
+				count = array.Opcode == SpirvOpTypeRuntimeArray ? 0 : count * getId(array.Value).Value;
+				type = array.Type;
+			}
+
+			auto binding = VulkanReflectedBinding();
+			binding.Set = variable.Set;
+			binding.Binding = variable.Binding;
+			binding.Type = GetDescriptorType(getId(type), variable.StorageClass);
+			binding.Count = count;
+			binding.Stages = stage;
+			reflection.Bindings.push_back(binding);
+		}
+
+		return reflection;
+	}
+
+	VulkanReflectedLayout::VulkanReflectedLayout(std::span<const VulkanShaderReflection* const> shaders)
+	{
+		const auto device = Renderer::GetScope().GetVulkanDevice()->GetDevice();
+
+		auto bindings = std::vector<VulkanReflectedBinding>();
+		auto pushConstantRange = VkPushConstantRange();
+		uint32_t setCount = 0;
+
+		for (const auto* shader : shaders)
+		{
+			for (const auto& binding : shader->Bindings)
+			{
+				// Unbounded arrays need descriptor indexing flags, those sets come from shared layouts such as the bindless table's
+				if (binding.Count == 0)
+					throw std::runtime_error(std::format("Set {} binding {} is a runtime array, use a shared layout", binding.Set, binding.Binding));
+
+				auto it = std::ranges::find_if(bindings, [&](const VulkanReflectedBinding& other) { return other.Set == binding.Set && other.Binding == binding.Binding; });
+				if (it == bindings.end())
+				{
+					bindings.push_back(binding);
+					setCount = std::max(setCount, binding.Set + 1);
+					continue;
+				}
+
+				if (it->Type != binding.Type || it->Count != binding.Count)
+					throw std::runtime_error(std::format("Stages disagree on the resource at set {} binding {}", binding.Set, binding.Binding));
+
+				it->Stages |= binding.Stages;
+			}
+
+			// One range for every stage, blocks that differ per stage share the same offsets in GLSL anyway
+			if (shader->PushConstantSize != 0)
+			{
+				pushConstantRange.stageFlags |= shader->Stage;
+				pushConstantRange.size = std::max(pushConstantRange.size, shader->PushConstantSize);
+			}
+		}
+
+		// Sets without bindings in between still need a layout
+		m_setLayouts.resize(setCount, nullptr);
+		for (uint32_t set = 0; set < setCount; set++)
+		{
+			auto setBindings = std::vector<VkDescriptorSetLayoutBinding>();
+			for (const auto& binding : bindings)
+			{
+				if (binding.Set != set)
+					continue;
+
+				auto setBinding = VkDescriptorSetLayoutBinding();
+				setBinding.binding = binding.Binding;
+				setBinding.descriptorType = binding.Type;
+				setBinding.descriptorCount = binding.Count;
+				setBinding.stageFlags = binding.Stages;
+				setBindings.push_back(setBinding);
+			}
+
+			auto setLayoutInfo = VkDescriptorSetLayoutCreateInfo();
+			setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			setLayoutInfo.bindingCount = (uint32_t)setBindings.size();
+			setLayoutInfo.pBindings = setBindings.data();
+
+			VULKAN_CHECK(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &m_setLayouts[set]));
+		}
+
+		auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo();
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = (uint32_t)m_setLayouts.size();
+		pipelineLayoutInfo.pSetLayouts = m_setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = pushConstantRange.size != 0 ? 1 : 0;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		VULKAN_CHECK(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_layout));
+	}
+
+	VulkanReflectedLayout::~VulkanReflectedLayout()
+	{
+		// Goes with its pipelines, which frames in flight may still use
+		auto& deletionQueue = Renderer::GetScope().GetVulkanDevice()->GetDeletionQueue();
+		deletionQueue.Destroy(m_layout);
+		for (const auto setLayout : m_setLayouts)
+			deletionQueue.Destroy(setLayout);
+	}
+}
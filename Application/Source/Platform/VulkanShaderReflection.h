@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace VEngine
+{
+	struct VulkanReflectedBinding
+	{
+		uint32_t Set = 0;
+		uint32_t Binding = 0;
+		VkDescriptorType Type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+
+		// Zero for runtime sized arrays
+		uint32_t Count = 1;
+		VkShaderStageFlags Stages = 0;
+	};
+
+	// Resource interface of one SPIR-V module, read straight from the instruction stream
+	struct VulkanShaderReflection
+	{
+		VkShaderStageFlags Stage = 0;
+		std::vector<VulkanReflectedBinding> Bindings;
+
+		// Size of the push constant block, zero without one
+		uint32_t PushConstantSize = 0;
+
+		// Throws when the code is not valid SPIR-V
+		static VulkanShaderReflection Reflect(std::span<const uint32_t> code, VkShaderStageFlagBits stage);
+	};
+
+	// Descriptor set layouts and a pipeline layout merged from the reflection of every stage of a pipeline
+	class VulkanReflectedLayout
+	{
+	public:
+		explicit VulkanReflectedLayout(std::span<const VulkanShaderReflection* const> shaders);
+		VulkanReflectedLayout(const VulkanReflectedLayout&) = delete;
+		VulkanReflectedLayout(VulkanReflectedLayout&&) = delete;
+		~VulkanReflectedLayout();
+
+		VkPipelineLayout GetLayout() const { return m_layout; }
+		const std::vector<VkDescriptorSetLayout>& GetSetLayouts() const { return m_setLayouts; }
+
+	private:
+		std::vector<VkDescriptorSetLayout> m_setLayouts;
+		VkPipelineLayout m_layout = nullptr;
+	};
+}
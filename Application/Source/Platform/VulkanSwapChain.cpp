@@ -2,34 +2,36 @@
 
 #include <algorithm>
 
-#include "Renderer.h"
 #include "VulkanScope.h"
 
 namespace VEngine
 {
-	VulkanSwapChain::VulkanSwapChain(const std::shared_ptr<VulkanLogicalDevice>& device, GLFWwindow* window)
+	VulkanSwapChain::VulkanSwapChain(const std::shared_ptr<VulkanLogicalDevice>& device, GLFWwindow* window, uint32_t framesInFlight)
 	{
 		const auto instance = VulkanScope::GetVulkanInstance();
-		const auto physicalDevice = device->GetPhysicalDevice()->GetDevice();
+		m_physicalDevice = device->GetPhysicalDevice()->GetDevice();
 		m_device = device->GetDevice();
+		m_queue = &device->GetQueue(VulkanQueueType::Graphics);
+		m_timeline = &m_queue->GetTimeline();
+		m_deletionQueue = &device->GetDeletionQueue();
+		m_window = window;
+		m_dynamicRendering = device->HasDynamicRendering();
 
 		// Setup surface
 		VULKAN_CHECK(glfwCreateWindowSurface(instance, window, nullptr, &m_surface));
 
 		// Setup details
-		VULKAN_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, m_surface, &m_capabilities));
-
 		uint32_t formatCount;
-		VULKAN_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, m_surface, &formatCount, nullptr));
+		VULKAN_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(m_physicalDevice, m_surface, &formatCount, nullptr));
 
 		auto formats = std::vector<VkSurfaceFormatKHR>(formatCount);
-		vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, m_surface, &formatCount, formats.data());
+		vkGetPhysicalDeviceSurfaceFormatsKHR(m_physicalDevice, m_surface, &formatCount, formats.data());
 
 		uint32_t presentModeCount;
-		VULKAN_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, m_surface, &presentModeCount, nullptr));
+		VULKAN_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(m_physicalDevice, m_surface, &presentModeCount, nullptr));
 
 		auto presentModes = std::vector<VkPresentModeKHR>(presentModeCount);
-		vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, m_surface, &presentModeCount, presentModes.data());
+		vkGetPhysicalDeviceSurfacePresentModesKHR(m_physicalDevice, m_surface, &presentModeCount, presentModes.data());
 
 		VkSurfaceFormatKHR selectedFormat = formats[0];
 		for (const auto& availableFormat : formats)
@@ -41,22 +43,83 @@ namespace VEngine
 			}
 		}
 		m_format = selectedFormat.format;
+		m_colorSpace = selectedFormat.colorSpace;
 
-		VkPresentModeKHR selectedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+		m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
 		for (const auto& availablePresentMode : presentModes)
 		{
 			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) 
 			{
-				selectedPresentMode = availablePresentMode;
+				m_presentMode = availablePresentMode;
 				break;
 			}
 		}
 
+		CreateSwapChain();
+		if (m_dynamicRendering == false)
+		{
+			CreateRenderPass();
+			CreateFramebuffers();
+		}
+
+		// Create Command Buffer
+		const auto graphicsQueueIndex = device->GetPhysicalDevice()->GetQueueFamilyIndices().GraphicsFamily;
+		uint32_t presentQueueIndex = graphicsQueueIndex.value();
+
+		uint32_t queueCount;
+		vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueCount, nullptr);
+		for (uint32_t i = 0; i < queueCount; i++)
+		{
+			VkBool32 presentIndex;
+			vkGetPhysicalDeviceSurfaceSupportKHR(m_physicalDevice, i, m_surface, &presentIndex);
+
+			presentQueueIndex = presentIndex == VK_TRUE ? i : presentQueueIndex;
+
+			if (graphicsQueueIndex == presentQueueIndex)
+				break;
+		}
+
+		auto poolInfo = VkCommandPoolCreateInfo();
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = presentQueueIndex;
+
+		VULKAN_CHECK(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool));
+
+		m_frames.resize(std::clamp(framesInFlight, 1u, MaxFramesInFlight));
+
+		auto commandBuffers = std::vector<VkCommandBuffer>(m_frames.size());
+		auto allocInfo = VkCommandBufferAllocateInfo();
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+
+		VULKAN_CHECK(vkAllocateCommandBuffers(m_device, &allocInfo, commandBuffers.data()));
+
+		// Synchronization objects
+		auto semaphoreInfo = VkSemaphoreCreateInfo();
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		// Acquire and present only work with binary semaphores, CPU waits go through the graphics timeline
+		for (size_t i = 0; i < m_frames.size(); i++)
+		{
+			auto& frame = m_frames[i];
+			frame.CommandBuffer = commandBuffers[i];
+
+			VULKAN_CHECK(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &frame.ImageAvailableSemaphore));
+		}
+	}
+
+	void VulkanSwapChain::CreateSwapChain()
+	{
+		VULKAN_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_physicalDevice, m_surface, &m_capabilities));
+
 		m_extent = m_capabilities.currentExtent;
 		if (m_capabilities.currentExtent.width == std::numeric_limits<uint32_t>::max()) 
 		{
 			int width, height;
-			glfwGetFramebufferSize(window, &width, &height);
+			glfwGetFramebufferSize(m_window, &width, &height);
 
 			VkExtent2D actualExtent = 
 			{
@@ -70,26 +133,37 @@ namespace VEngine
 			m_extent = actualExtent;
 		}
 
+		// Minimized window, keep the current swapchain until it has an area again
+		if (m_extent.width == 0 || m_extent.height == 0)
+			return;
+
 		// Create Images
-		uint32_t imageCount = std::min(m_capabilities.minImageCount + 1, m_capabilities.maxImageCount);
+		uint32_t imageCount = m_capabilities.minImageCount + 1;
+		if (m_capabilities.maxImageCount > 0)
+			imageCount = std::min(imageCount, m_capabilities.maxImageCount);
 
 		auto createInfo = VkSwapchainCreateInfoKHR();
 		createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
 		createInfo.surface = m_surface;
 		createInfo.minImageCount = imageCount;
-		createInfo.imageFormat = selectedFormat.format;
-		createInfo.imageColorSpace = selectedFormat.colorSpace;
+		createInfo.imageFormat = m_format;
+		createInfo.imageColorSpace = m_colorSpace;
 		createInfo.imageExtent = m_extent;
 		createInfo.imageArrayLayers = 1;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 		createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		createInfo.preTransform = m_capabilities.currentTransform;
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-		createInfo.presentMode = selectedPresentMode;
+		createInfo.presentMode = m_presentMode;
 		createInfo.clipped = VK_TRUE;
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		createInfo.oldSwapchain = m_swapChain;
+
+		VkSwapchainKHR swapChain;
+		VULKAN_CHECK(vkCreateSwapchainKHR(m_device, &createInfo, nullptr, &swapChain))
 
-		VULKAN_CHECK(vkCreateSwapchainKHR(m_device, &createInfo, nullptr, &m_swapChain))
+		// Old images may still be in flight, they are destroyed once those frames complete
+		RetireSwapChain();
+		m_swapChain = swapChain;
 
 		vkGetSwapchainImagesKHR(m_device, m_swapChain, &imageCount, nullptr);
 		m_swapChainImages.resize(imageCount);
@@ -116,7 +190,19 @@ namespace VEngine
 			VULKAN_CHECK(vkCreateImageView(m_device, &viewCreateInfo, nullptr, &m_swapChainImageViews[i]));
 		}
 
-		// Create Render Pass
+		auto semaphoreInfo = VkSemaphoreCreateInfo();
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		m_presentSemaphores.resize(imageCount);
+		for (auto& semaphore : m_presentSemaphores)
+			VULKAN_CHECK(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &semaphore));
+
+		// New images were never rendered into
+		m_imagesInFlight.assign(imageCount, 0);
+	}
+
+	void VulkanSwapChain::CreateRenderPass()
+	{
 		auto colorAttachmentRef = VkAttachmentReference();
 		colorAttachmentRef.attachment = 0;
 		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -154,9 +240,11 @@ namespace VEngine
 		renderPassInfo.pDependencies = &dependency;
 
 		VULKAN_CHECK(vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass));
+	}
 
-		// Create Framebuffers
-		m_swapChainFramebuffers.resize(imageCount);
+	void VulkanSwapChain::CreateFramebuffers()
+	{
+		m_swapChainFramebuffers.resize(m_swapChainImageViews.size());
 		for (size_t i = 0; i < m_swapChainImageViews.size(); i++)
 		{
 			VkImageView attachments[] = 
@@ -175,157 +263,175 @@ namespace VEngine
 
 			VULKAN_CHECK(vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &m_swapChainFramebuffers[i]));
 		}
+	}
 
-		// Create Command Buffer
-		const auto graphicsQueueIndex = device->GetPhysicalDevice()->GetQueueFamilyIndices().GraphicsFamily;
-		uint32_t presentQueueIndex;
+	void VulkanSwapChain::Recreate()
+	{
+		const auto previousFormat = m_format;
+		const auto previousSwapChain = m_swapChain;
 
-		uint32_t queueCount;
-		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, nullptr);
-		for (uint32_t i = 0; i < queueCount; i++)
-		{
-			VkBool32 presentIndex;
-			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, m_surface, &presentIndex);
+		CreateSwapChain();
+		if (m_swapChain == previousSwapChain)
+			return;
 
-			presentQueueIndex = presentIndex == VK_TRUE ? i : presentQueueIndex;
+		m_outOfDate = false;
 
-			if (graphicsQueueIndex == presentQueueIndex)
-				break;
+		// Dynamic rendering only needs the new image views
+		if (m_dynamicRendering)
+			return;
+
+		// Same format keeps the render pass, so pipelines built against it stay valid
+		if (m_format != previousFormat)
+		{
+			m_deletionQueue->Destroy(m_renderPass);
+			CreateRenderPass();
 		}
 
-		auto poolInfo = VkCommandPoolCreateInfo();
-		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-		poolInfo.queueFamilyIndex = presentQueueIndex;
+		CreateFramebuffers();
+	}
 
-		VULKAN_CHECK(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool));
+	void VulkanSwapChain::RetireSwapChain()
+	{
+		if (m_swapChain == nullptr)
+			return;
+
+		auto retired = VulkanRetiredSwapChain();
+		retired.SwapChain = m_swapChain;
+		retired.ImageViews = std::move(m_swapChainImageViews);
+		retired.Framebuffers = std::move(m_swapChainFramebuffers);
+		retired.PresentSemaphores = std::move(m_presentSemaphores);
+		retired.LastValue = m_timeline->GetSubmittedValue();
+
+		m_retiredSwapChains.push_back(std::move(retired));
+
+		m_swapChainImageViews.clear();
+		m_swapChainFramebuffers.clear();
+		m_presentSemaphores.clear();
+		m_swapChain = nullptr;
+	}
 
-		auto allocInfo = VkCommandBufferAllocateInfo();
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandPool = m_commandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = 1;
+	void VulkanSwapChain::DestroyRetiredSwapChains(bool force)
+	{
+		if (m_retiredSwapChains.empty())
+			return;
 
-		VULKAN_CHECK(vkAllocateCommandBuffers(m_device, &allocInfo, &m_commandBuffer));
+		std::erase_if(m_retiredSwapChains, [&](const VulkanRetiredSwapChain& retired)
+		{
+			if (force == false && m_timeline->IsComplete(retired.LastValue) == false)
+				return false;
 
-		// Synchronization objects
-		auto semaphoreInfo = VkSemaphoreCreateInfo();
-		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			for (const auto framebuffer : retired.Framebuffers)
+				vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+
+			for (const auto imageView : retired.ImageViews)
+				vkDestroyImageView(m_device, imageView, nullptr);
 
-		auto fenceInfo = VkFenceCreateInfo();
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+			vkDestroySwapchainKHR(m_device, retired.SwapChain, nullptr);
 
-		VULKAN_CHECK(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_imageAvailableSemaphore));
-		VULKAN_CHECK(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_renderFinishedSemaphore));
-		VULKAN_CHECK(vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFence));
+			for (const auto semaphore : retired.PresentSemaphores)
+				vkDestroySemaphore(m_device, semaphore, nullptr);
+
+			return true;
+		});
 	}
 
-	void VulkanSwapChain::Begin()
+	bool VulkanSwapChain::BeginFrame()
 	{
-		vkWaitForFences(m_device, 1, &m_inFlightFence, VK_TRUE, UINT64_MAX);
-		vkResetFences(m_device, 1, &m_inFlightFence);
+		auto& frame = m_frames[m_currentFrame];
 
-		vkAcquireNextImageKHR(m_device, m_swapChain, UINT64_MAX, m_imageAvailableSemaphore, VK_NULL_HANDLE, &m_ImageIndex);
-		vkResetCommandBuffer(m_commandBuffer, 0);
+		// Only the slot being reused has to be finished, other frames keep running
+		m_timeline->Wait(frame.SubmittedValue);
 
-		auto beginInfo = VkCommandBufferBeginInfo();
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		DestroyRetiredSwapChains();
 
-		VULKAN_CHECK(vkBeginCommandBuffer(m_commandBuffer, &beginInfo))
+		if (m_outOfDate || m_swapChain == nullptr)
+		{
+			Recreate();
 
-		constexpr VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
-		auto renderPassInfo = VkRenderPassBeginInfo();
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = m_renderPass;
-		renderPassInfo.framebuffer = m_swapChainFramebuffers[m_ImageIndex];
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = m_extent;
-		renderPassInfo.clearValueCount = 1;
-		renderPassInfo.pClearValues = &clearColor;
+			if (m_outOfDate || m_swapChain == nullptr)
+				return false;
+		}
 
-		vkCmdBeginRenderPass(m_commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	}
+		auto result = vkAcquireNextImageKHR(m_device, m_swapChain, UINT64_MAX, frame.ImageAvailableSemaphore, VK_NULL_HANDLE, &m_ImageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// Semaphore stays unsignaled, so the slot can be reused right away on the next attempt
+			m_outOfDate = true;
+			return false;
+		}
 
-	void VulkanSwapChain::Apply(std::shared_ptr<VulkanPipeline> pipeline)
-	{
-		vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->GetPipeline());
-
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(m_extent.width);
-		viewport.height = static_cast<float>(m_extent.height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport(m_commandBuffer, 0, 1, &viewport);
-
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = m_extent;
-		vkCmdSetScissor(m_commandBuffer, 0, 1, &scissor);
-
-		vkCmdDraw(m_commandBuffer, 3, 1, 0, 0);
-	}
+		// Suboptimal images are still presentable, the swapchain is rebuilt after this frame
+		if (result == VK_SUBOPTIMAL_KHR)
+			m_outOfDate = true;
+		else
+			VULKAN_CHECK(result);
+
+		// Image may be acquired out of order and still be used by another slot
+		m_timeline->Wait(m_imagesInFlight[m_ImageIndex]);
 
+		vkResetCommandBuffer(frame.CommandBuffer, 0);
 
-	void VulkanSwapChain::End() const
+		auto beginInfo = VkCommandBufferBeginInfo();
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VULKAN_CHECK(vkBeginCommandBuffer(frame.CommandBuffer, &beginInfo))
+
+		return true;
+	}
+
+	void VulkanSwapChain::End()
 	{
-		vkCmdEndRenderPass(m_commandBuffer);
+		auto& frame = m_frames[m_currentFrame];
 
-		VULKAN_CHECK(vkEndCommandBuffer(m_commandBuffer))
+		EndRenderPass();
 
-		const VkSemaphore waitSemaphores[] = { m_imageAvailableSemaphore };
-		const VkSemaphore signalSemaphores[] = { m_renderFinishedSemaphore };
-		constexpr VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		VULKAN_CHECK(vkEndCommandBuffer(frame.CommandBuffer))
 
-		auto submitInfo = VkSubmitInfo();
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_commandBuffer;
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = signalSemaphores;
+		auto submit = VulkanQueueSubmit();
+		submit.CommandBuffers = { &frame.CommandBuffer, 1 };
+		submit.WaitSemaphore = frame.ImageAvailableSemaphore;
+		submit.WaitStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		submit.SignalSemaphore = m_presentSemaphores[m_ImageIndex];
 
-		const auto queue = Renderer::GetScope().GetVulkanDevice()->GetGraphicsQueue();
-		VULKAN_CHECK(vkQueueSubmit(queue, 1, &submitInfo, m_inFlightFence))
+		frame.SubmittedValue = m_queue->Submit(submit);
+		m_imagesInFlight[m_ImageIndex] = frame.SubmittedValue;
 
 		VkPresentInfoKHR presentInfo{};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
 		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = signalSemaphores;
+		presentInfo.pWaitSemaphores = &m_presentSemaphores[m_ImageIndex];
 
 		VkSwapchainKHR swapChains[] = { m_swapChain };
 		presentInfo.swapchainCount = 1;
 		presentInfo.pSwapchains = swapChains;
 		presentInfo.pImageIndices = &m_ImageIndex;
 
-		vkQueuePresentKHR(queue, &presentInfo);
+		const auto result = m_queue->Present(presentInfo);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+			m_outOfDate = true;
+		else
+			VULKAN_CHECK(result);
 
-		vkDeviceWaitIdle(m_device);
+		m_currentFrame = (m_currentFrame + 1) % (uint32_t)m_frames.size();
 	}
 
 	VulkanSwapChain::~VulkanSwapChain()
 	{
 		const auto instance = VulkanScope::GetVulkanInstance();
 
-		vkDeviceWaitIdle(m_device);
-		vkDestroySemaphore(m_device, m_imageAvailableSemaphore, nullptr);
-		vkDestroySemaphore(m_device, m_renderFinishedSemaphore, nullptr);
-		vkDestroyFence(m_device, m_inFlightFence, nullptr);
+		// Presentation still holds images and semaphores after the timeline passed, only the queue presenting them has to finish
+		m_queue->WaitIdle();
+		for (const auto& frame : m_frames)
+			vkDestroySemaphore(m_device, frame.ImageAvailableSemaphore, nullptr);
 
-		vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+		vkDestroyCommandPool(m_device, m_commandPool, nullptr);
 
-		for (size_t i = 0; i < m_swapChainImages.size(); i++)
-		{
-			vkDestroyImageView(m_device, m_swapChainImageViews[i], nullptr);
-			vkDestroyFramebuffer(m_device, m_swapChainFramebuffers[i], nullptr);
-		}
+		RetireSwapChain();
+		DestroyRetiredSwapChains(true);
 
-		vkDestroySwapchainKHR(m_device, m_swapChain, nullptr);
+		vkDestroyRenderPass(m_device, m_renderPass, nullptr);
 		vkDestroySurfaceKHR(instance, m_surface, nullptr);
 	}
 
@@ -4,43 +4,103 @@
 #include <GLFW/glfw3.h>
 
 #include "VulkanDevice.h"
-#include "VulkanPipeline.h"
+#include "VulkanRenderTarget.h"
+#include "VulkanQueue.h"
+#include "VulkanTimeline.h"
 
 namespace VEngine 
 {
-	class VulkanSwapChain
+	struct VulkanFrameData
+	{
+		VkCommandBuffer CommandBuffer = nullptr;
+		VkSemaphore ImageAvailableSemaphore = nullptr;
+
+		// Graphics timeline value of the slot's last submission
+		uint64_t SubmittedValue = 0;
+	};
+
+	struct VulkanRetiredSwapChain
+	{
+		VkSwapchainKHR SwapChain = nullptr;
+		std::vector<VkImageView> ImageViews;
+		std::vector<VkFramebuffer> Framebuffers;
+		std::vector<VkSemaphore> PresentSemaphores;
+
+		// Last timeline value that may still reference the retired images
+		uint64_t LastValue = 0;
+	};
+
+	class VulkanSwapChain : public VulkanRenderTarget
 	{
 	public:
-		VulkanSwapChain(const std::shared_ptr<VulkanLogicalDevice>& device, GLFWwindow* window);
-		~VulkanSwapChain();
+		VulkanSwapChain(const std::shared_ptr<VulkanLogicalDevice>& device, GLFWwindow* window, uint32_t framesInFlight = 2);
+		~VulkanSwapChain() override;
 
-		VkRenderPass GetRenderPass() { return m_renderPass; }
-		VkExtent2D GetExtent() const { return m_extent; }
+		VkRenderPass GetRenderPass() const override { return m_renderPass; }
+		VkExtent2D GetExtent() const override { return m_extent; }
+		VkFormat GetFormat() const override { return m_format; }
 
-		void Begin();
-		void Apply(std::shared_ptr<VulkanPipeline> pipeline);
-		void End() const;
+		uint32_t GetFramesInFlight() const override { return (uint32_t)m_frames.size(); }
+		uint32_t GetFrameIndex() const override { return m_currentFrame; }
+		VkCommandBuffer GetCommandBuffer() const override { return m_frames[m_currentFrame].CommandBuffer; }
+		VkFramebuffer GetFramebuffer() const override { return m_dynamicRendering ? nullptr : m_swapChainFramebuffers[m_ImageIndex]; }
+
+		VkImage GetImage() const override { return m_swapChainImages[m_ImageIndex]; }
+		VkImageView GetImageView() const override { return m_swapChainImageViews[m_ImageIndex]; }
+
+		// Acquire semaphore is waited on at the color output stage, so the first transition has to wait there too
+		VulkanRenderTargetImageState GetInitialState() const override { return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0 }; }
+		VulkanRenderTargetImageState GetFinalState() const override { return { VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 }; }
+
+		// Marks the swapchain out of date, it is rebuilt at the start of the next frame
+		void Invalidate() { m_outOfDate = true; }
+
+		bool BeginFrame() override;
+		void End() override;
 
 	private:
+		void CreateSwapChain();
+		void CreateRenderPass();
+		void CreateFramebuffers();
+		void Recreate();
+		void RetireSwapChain();
+		void DestroyRetiredSwapChains(bool force = false);
+
 		uint32_t m_ImageIndex;
-		VkFormat m_format;
+		VkFormat m_format = VK_FORMAT_UNDEFINED;
+		VkColorSpaceKHR m_colorSpace;
+		VkPresentModeKHR m_presentMode;
 		VkExtent2D m_extent;
 		std::vector<VkImage> m_swapChainImages;
 		std::vector<VkImageView> m_swapChainImageViews;
 		std::vector<VkFramebuffer> m_swapChainFramebuffers;
 
+		// Signalled by the submission rendering into an image and waited on by its present. Only reacquiring the
+		// image guarantees the presentation engine consumed the wait, so there is one per image, not per frame slot.
+		std::vector<VkSemaphore> m_presentSemaphores;
+
 		VkDevice m_device;
+		VkPhysicalDevice m_physicalDevice;
+		VulkanQueue* m_queue;
+		VulkanTimeline* m_timeline;
+		VulkanDeletionQueue* m_deletionQueue;
+		GLFWwindow* m_window;
+		bool m_dynamicRendering = false;
 
-		VkCommandBuffer m_commandBuffer;
 		VkCommandPool m_commandPool;
-		VkRenderPass m_renderPass;
+		VkRenderPass m_renderPass = nullptr;
 
 		VkSurfaceCapabilitiesKHR m_capabilities;
-		VkSwapchainKHR m_swapChain;
+		VkSwapchainKHR m_swapChain = nullptr;
 		VkSurfaceKHR m_surface;
 
-		VkSemaphore m_imageAvailableSemaphore;
-		VkSemaphore m_renderFinishedSemaphore;
-		VkFence m_inFlightFence;
+		bool m_outOfDate = false;
+		std::vector<VulkanRetiredSwapChain> m_retiredSwapChains;
+
+		uint32_t m_currentFrame = 0;
+		std::vector<VulkanFrameData> m_frames;
+
+		// Timeline value of the last submission that rendered into each image
+		std::vector<uint64_t> m_imagesInFlight;
 	};
 }
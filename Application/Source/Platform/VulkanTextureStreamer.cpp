@@ -0,0 +1,441 @@
+#include "VulkanTextureStreamer.h"
+#include "VulkanDebugger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <print>
+
+namespace VEngine
+{
+	static VkFormat GetVulkanFormat(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::Rgba8Unorm:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+		case TextureFormat::Rgba8Srgb:
+			return VK_FORMAT_R8G8B8A8_SRGB;
+		}
+
+		return VK_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	VulkanTextureStreamer::VulkanTextureStreamer(const std::shared_ptr<VulkanLogicalDevice>& device, VulkanBindlessTable& bindlessTable, VulkanUploader& uploader,
+		uint32_t framesInFlight, const VulkanTextureStreamerSettings& settings)
+		: m_device(device->GetDevice()), m_allocator(&device->GetAllocator()), m_deletionQueue(&device->GetDeletionQueue()),
+		m_physicalDevice(device->GetPhysicalDevice().get()), m_bindlessTable(bindlessTable), m_uploader(uploader), m_settings(settings)
+	{
+		m_supported = bindlessTable.IsSupported();
+		if (m_supported == false)
+		{
+			std::println("Texture streaming needs the bindless table");
+			return;
+		}
+
+		// Optimal images end up in device local memory, its heap is the one the budget applies to
+		const auto& memoryProperties = m_physicalDevice->GetMemoryProperties();
+		m_heapIndex = memoryProperties.memoryTypes[m_physicalDevice->FindMemoryType(UINT32_MAX, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)].heapIndex;
+
+		// Trilinear over whatever mips are resident, the view's first level is the texture's finest resident mip
+		auto samplerInfo = VkSamplerCreateInfo();
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		if (m_physicalDevice->GetFeatures().samplerAnisotropy)
+		{
+			samplerInfo.anisotropyEnable = VK_TRUE;
+			samplerInfo.maxAnisotropy = std::min(8.0f, m_physicalDevice->GetProperties().limits.maxSamplerAnisotropy);
+		}
+
+		VULKAN_CHECK(vkCreateSampler(m_device, &samplerInfo, nullptr, &m_sampler));
+		m_samplerIndex = bindlessTable.RegisterSampler(m_sampler);
+
+		m_textures = std::vector<Texture>(std::max(m_settings.MaxTextures, 1u));
+
+		// Rewritten every frame, one table per slot so frames in flight keep the images they were recorded with
+		m_tables = std::vector<TableSlot>(std::max(framesInFlight, 1u));
+		for (auto& table : m_tables)
+		{
+			table.Buffer = std::make_unique<VulkanBuffer>(m_textures.size() * 2 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VulkanMemoryUsage::CpuToGpu);
+			table.Index = bindlessTable.RegisterStorageBuffer(table.Buffer->GetBuffer());
+		}
+
+		std::println("Texture streaming: {:.1f} MiB budget, {}", (double)ComputeBudget() / (1024.0 * 1024.0),
+			m_physicalDevice->SupportsMemoryBudget() ? "tracking VK_EXT_memory_budget" : "estimated from the heap size");
+	}
+
+	VulkanTextureStreamer::~VulkanTextureStreamer()
+	{
+		if (m_supported == false)
+			return;
+
+		for (uint32_t i = 0; i < m_textureCount; i++)
+		{
+			if (m_textures[i].Source == nullptr)
+				continue;
+
+			m_bindlessTable.Release(VulkanBindlessType::SampledImage, m_textures[i].Current.BindlessIndex);
+			DestroyResidency(m_textures[i].Current);
+		}
+
+		for (auto& table : m_tables)
+			m_bindlessTable.Release(VulkanBindlessType::StorageBuffer, table.Index);
+
+		m_tables.clear();
+		m_bindlessTable.Release(VulkanBindlessType::Sampler, m_samplerIndex);
+		vkDestroySampler(m_device, m_sampler, nullptr);
+	}
+
+	uint32_t VulkanTextureStreamer::Register(std::shared_ptr<const TextureData> source)
+	{
+		if (m_supported == false || source == nullptr || source->GetMipCount() == 0)
+			return InvalidTexture;
+
+		if (m_freeTextures.empty() && m_textureCount == m_textures.size())
+			return InvalidTexture;
+
+		const auto handle = m_freeTextures.empty() ? m_textureCount : m_freeTextures.back();
+		auto& texture = m_textures[handle];
+		texture.Source = std::move(source);
+		texture.TailMip = texture.Source->FindMip(m_settings.TailSize);
+
+		// A chain taking more than a quarter of the staging ring would starve every other upload
+		texture.MinMip = 0;
+		while (texture.MinMip < texture.TailMip && texture.Source->GetChainData(texture.MinMip).size() > m_uploader.GetStagingSize() / 4)
+			texture.MinMip++;
+
+		texture.RequestedMip.store(NoRequest, std::memory_order_relaxed);
+		texture.WantedMip = texture.TailMip;
+		texture.LastRequestFrame = m_frame;
+
+		if (ChangeResidency(texture, texture.TailMip) == false)
+		{
+			texture.Source = nullptr;
+			return InvalidTexture;
+		}
+
+		texture.RequestSource.store(texture.Source, std::memory_order_release);
+		if (m_freeTextures.empty())
+			m_textureCount++;
+		else
+			m_freeTextures.pop_back();
+
+		return handle;
+	}
+
+	void VulkanTextureStreamer::Unregister(uint32_t texture)
+	{
+		if (texture >= m_textureCount || m_textures[texture].Source == nullptr)
+			return;
+
+		Retire(m_textures[texture].Current);
+		m_textures[texture].Source = nullptr;
+		m_textures[texture].RequestSource.store(nullptr, std::memory_order_release);
+		m_freeTextures.push_back(texture);
+	}
+
+	void VulkanTextureStreamer::RequestSize(uint32_t texture, float screenPixels)
+	{
+		if (texture >= m_textures.size())
+			return;
+
+		// Holds the source alive even if the render thread unregisters the texture meanwhile
+		auto& entry = m_textures[texture];
+		const auto source = entry.RequestSource.load(std::memory_order_acquire);
+		if (source == nullptr)
+			return;
+
+		const auto mip = ComputeMip(*source, screenPixels);
+
+		auto requested = entry.RequestedMip.load(std::memory_order_relaxed);
+		while (mip < requested && entry.RequestedMip.compare_exchange_weak(requested, mip, std::memory_order_relaxed) == false)
+		{
+		}
+	}
+
+	uint32_t VulkanTextureStreamer::ComputeMip(const TextureData& source, float screenPixels)
+	{
+		const auto size = (float)std::max(source.GetWidth(), source.GetHeight());
+		const auto lastMip = (float)source.GetMipCount() - 1.0f;
+		if (screenPixels <= 0.0f || size <= 0.0f)
+			return (uint32_t)std::max(lastMip, 0.0f);
+
+		// About one texel per pixel, anything finer is filtered away
+		return (uint32_t)std::clamp(std::floor(std::log2(size / screenPixels)), 0.0f, std::max(lastMip, 0.0f));
+	}
+
+	void VulkanTextureStreamer::Update(uint32_t frameIndex)
+	{
+		if (m_supported == false)
+			return;
+
+		m_frame++;
+		m_uploadedThisFrame = 0;
+
+		// Requests since the last update set the wanted mip, textures nobody asked for in a while fall back to their tail
+		auto upgrades = std::vector<uint32_t>();
+		auto candidates = std::vector<uint32_t>();
+		for (uint32_t i = 0; i < m_textureCount; i++)
+		{
+			auto& texture = m_textures[i];
+			if (texture.Source == nullptr)
+				continue;
+
+			const auto requested = texture.RequestedMip.exchange(NoRequest, std::memory_order_relaxed);
+			if (requested != NoRequest)
+			{
+				texture.WantedMip = std::clamp(requested, texture.MinMip, texture.TailMip);
+				texture.LastRequestFrame = m_frame;
+			}
+			else if (m_frame - texture.LastRequestFrame > m_settings.EvictionDelay)
+			{
+				texture.WantedMip = texture.TailMip;
+			}
+
+			if (texture.WantedMip < texture.Current.FirstMip)
+				upgrades.push_back(i);
+
+			// The frame about to be recorded requested what it draws, only the rest can be evicted
+			if (texture.Current.FirstMip < texture.TailMip && texture.LastRequestFrame < m_frame)
+				candidates.push_back(i);
+		}
+
+		const auto budget = ComputeBudget();
+		m_statistics.Budget = budget;
+
+		// Least recently requested first
+		std::ranges::stable_sort(candidates, {}, [&](uint32_t index) { return m_textures[index].LastRequestFrame; });
+		size_t nextCandidate = 0;
+
+		const auto evictOne = [&](uint32_t keep)
+		{
+			while (nextCandidate < candidates.size())
+			{
+				const auto index = candidates[nextCandidate++];
+				auto& victim = m_textures[index];
+				if (index == keep || victim.Current.FirstMip >= victim.TailMip)
+					continue;
+
+				if (ChangeResidency(victim, victim.TailMip) == false)
+					return false;
+
+				victim.WantedMip = victim.TailMip;
+				m_statistics.Evictions++;
+				return true;
+			}
+
+			return false;
+		};
+
+		// The budget shrinks when other processes allocate. Unused textures go first, then the largest visible ones lose their finest mip.
+		if (m_residentBytes > budget)
+			m_statistics.OverBudgetFrames++;
+
+		while (m_residentBytes > budget)
+		{
+			if (evictOne(InvalidTexture))
+				continue;
+
+			Texture* largest = nullptr;
+			for (uint32_t i = 0; i < m_textureCount; i++)
+			{
+				auto& texture = m_textures[i];
+				if (texture.Source != nullptr && texture.Current.FirstMip < texture.TailMip && (largest == nullptr || texture.Current.Bytes > largest->Current.Bytes))
+					largest = &texture;
+			}
+
+			if (largest == nullptr || ChangeResidency(*largest, largest->Current.FirstMip + 1) == false)
+				break;
+
+			m_statistics.Downgrades++;
+		}
+
+		// Most missing mips first, the frame's upload allowance and the budget cut the list off
+		std::ranges::stable_sort(upgrades, std::ranges::greater(), [&](uint32_t index) { return m_textures[index].Current.FirstMip - m_textures[index].WantedMip; });
+		for (size_t i = 0; i < upgrades.size(); i++)
+		{
+			auto& texture = m_textures[upgrades[i]];
+			if (texture.WantedMip >= texture.Current.FirstMip)
+				continue;
+
+			const auto fits = [&](uint32_t mip) { return m_residentBytes - texture.Current.Bytes + texture.Source->GetChainData(mip).size() <= budget; };
+
+			while (fits(texture.WantedMip) == false && evictOne(upgrades[i]))
+			{
+			}
+
+			// Without room for all of it the texture still gets the finest mips that fit
+			auto mip = texture.WantedMip;
+			while (mip < texture.Current.FirstMip && fits(mip) == false)
+				mip++;
+
+			const auto chainBytes = texture.Source->GetChainData(mip).size();
+			if (mip == texture.Current.FirstMip || (m_uploadedThisFrame > 0 && m_uploadedThisFrame + chainBytes > m_settings.MaxUploadBytesPerFrame))
+			{
+				m_statistics.DeferredUpgrades++;
+				continue;
+			}
+
+			// A full staging ring stops the frame's streaming, everything left is retried next frame
+			if (ChangeResidency(texture, mip) == false)
+			{
+				m_statistics.DeferredUpgrades += upgrades.size() - i;
+				break;
+			}
+
+			m_statistics.Upgrades++;
+		}
+
+		m_statistics.PeakResidentBytes = std::max(m_statistics.PeakResidentBytes, m_residentBytes);
+
+		auto* entries = static_cast<uint32_t*>(m_tables[frameIndex].Buffer->GetMappedData());
+		for (uint32_t i = 0; i < m_textureCount; i++)
+		{
+			const auto& texture = m_textures[i];
+			entries[i * 2] = texture.Source != nullptr ? texture.Current.BindlessIndex : VulkanBindlessTable::InvalidIndex;
+			entries[i * 2 + 1] = texture.Current.FirstMip;
+		}
+	}
+
+	bool VulkanTextureStreamer::CreateResidency(const TextureData& source, uint32_t firstMip, Residency& residency)
+	{
+		const auto& mip = source.GetMip(firstMip);
+		const auto mipCount = source.GetMipCount() - firstMip;
+		const auto format = GetVulkanFormat(source.GetFormat());
+
+		auto imageInfo = VkImageCreateInfo();
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = format;
+		imageInfo.extent = { mip.Width, mip.Height, 1 };
+		imageInfo.mipLevels = mipCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		residency.Image = m_allocator->CreateImage(imageInfo, VulkanMemoryUsage::GpuOnly);
+		residency.FirstMip = firstMip;
+		residency.Bytes = residency.Image->Size;
+
+		auto viewInfo = VkImageViewCreateInfo();
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = residency.Image->Image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, 0, 1 };
+
+		VULKAN_CHECK(vkCreateImageView(m_device, &viewInfo, nullptr, &residency.View));
+
+		residency.BindlessIndex = m_bindlessTable.RegisterSampledImage(residency.View);
+		if (residency.BindlessIndex == VulkanBindlessTable::InvalidIndex)
+		{
+			DestroyResidency(residency);
+			residency = Residency();
+			return false;
+		}
+
+		// One region per mip, the chain is a single range of the source
+		const auto chain = source.GetChainData(firstMip);
+		auto regions = std::vector<VkBufferImageCopy>(mipCount);
+		for (uint32_t level = 0; level < mipCount; level++)
+		{
+			const auto& levelMip = source.GetMip(firstMip + level);
+			regions[level].bufferOffset = levelMip.Offset - mip.Offset;
+			regions[level].imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+			regions[level].imageExtent = { levelMip.Width, levelMip.Height, 1 };
+		}
+
+		auto upload = VulkanImageUpload();
+		upload.Image = residency.Image->Image;
+		upload.Range = viewInfo.subresourceRange;
+		upload.Regions = regions;
+
+		// Never seen by the GPU, so it can go right away
+		if (m_uploader.UploadImage(upload, chain).IsValid() == false)
+		{
+			m_bindlessTable.Release(VulkanBindlessType::SampledImage, residency.BindlessIndex);
+			DestroyResidency(residency);
+			residency = Residency();
+			return false;
+		}
+
+		m_uploadedThisFrame += chain.size();
+		m_statistics.UploadedBytes += chain.size();
+		return true;
+	}
+
+	void VulkanTextureStreamer::DestroyResidency(const Residency& residency)
+	{
+		vkDestroyImageView(m_device, residency.View, nullptr);
+		m_allocator->DestroyImage(residency.Image);
+	}
+
+	bool VulkanTextureStreamer::ChangeResidency(Texture& texture, uint32_t firstMip)
+	{
+		auto residency = Residency();
+		if (CreateResidency(*texture.Source, firstMip, residency) == false)
+			return false;
+
+		if (texture.Current.Image != nullptr)
+			Retire(texture.Current);
+
+		texture.Current = residency;
+		m_residentBytes += residency.Bytes;
+		return true;
+	}
+
+	void VulkanTextureStreamer::Retire(Residency& residency)
+	{
+		// Frames recorded so far may still sample it, the next graphics submission is the first one that can't
+		m_bindlessTable.Release(VulkanBindlessType::SampledImage, residency.BindlessIndex);
+		m_deletionQueue->Destroy(residency.View);
+		m_deletionQueue->DestroyImage(residency.Image);
+
+		m_residentBytes -= residency.Bytes;
+		residency = Residency();
+	}
+
+	VkDeviceSize VulkanTextureStreamer::ComputeBudget() const
+	{
+		// Usage covers the whole process, what isn't resident textures belongs to everything else, including images still being deleted
+		const auto heapBudget = m_physicalDevice->GetHeapBudget(m_heapIndex);
+		const auto otherUsage = heapBudget.Usage > m_residentBytes ? heapBudget.Usage - m_residentBytes : 0;
+
+		auto budget = heapBudget.Budget > otherUsage + m_settings.Headroom ? heapBudget.Budget - otherUsage - m_settings.Headroom : 0;
+		if (m_settings.MaxResidentBytes > 0)
+			budget = std::min(budget, m_settings.MaxResidentBytes);
+
+		return budget;
+	}
+
+	VulkanTextureStreamerStatistics VulkanTextureStreamer::GetStatistics() const
+	{
+		auto statistics = m_statistics;
+		statistics.ResidentBytes = m_residentBytes;
+		return statistics;
+	}
+
+	void VulkanTextureStreamer::PrintStatistics() const
+	{
+		if (m_supported == false)
+			return;
+
+		constexpr double mebibyte = 1024.0 * 1024.0;
+		const auto textureCount = m_textureCount - (uint32_t)m_freeTextures.size();
+		std::println("Texture streaming: {} textures, {:.1f} MiB resident (peak {:.1f} MiB) of {:.1f} MiB budget", textureCount,
+			(double)m_residentBytes / mebibyte, (double)m_statistics.PeakResidentBytes / mebibyte, (double)m_statistics.Budget / mebibyte);
+		std::println("Texture streaming: {} upgrades, {} evictions, {} downgrades, {} deferred, {:.1f} MiB uploaded, {} frames over budget",
+			m_statistics.Upgrades, m_statistics.Evictions, m_statistics.Downgrades, m_statistics.DeferredUpgrades,
+			(double)m_statistics.UploadedBytes / mebibyte, m_statistics.OverBudgetFrames);
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Texture.h"
+#include "VulkanBindlessTable.h"
+#include "VulkanBuffer.h"
+#include "VulkanUploader.h"
+
+namespace VEngine
+{
+	struct VulkanTextureStreamerSettings
+	{
+		uint32_t MaxTextures = 1024;
+
+		// Zero leaves the limit to the device local heap budget alone
+		VkDeviceSize MaxResidentBytes = 0;
+
+		// Kept free of textures for everything else that still has to fit into the heap budget
+		VkDeviceSize Headroom = 256 * 1024 * 1024;
+
+		// Upgrades beyond this wait for the next frame, the frame's graphics submission waits for the copies
+		VkDeviceSize MaxUploadBytesPerFrame = 8 * 1024 * 1024;
+
+		// Mips up to this size are loaded on registration and never evicted
+		uint32_t TailSize = 64;
+
+		// Frames without a request before a texture counts as unused and may drop back to its tail
+		uint32_t EvictionDelay = 60;
+	};
+
+	struct VulkanTextureStreamerStatistics
+	{
+		uint64_t Upgrades = 0;
+		uint64_t Evictions = 0;
+		uint64_t Downgrades = 0;
+		uint64_t UploadedBytes = 0;
+		uint64_t DeferredUpgrades = 0;
+		uint64_t OverBudgetFrames = 0;
+		VkDeviceSize ResidentBytes = 0;
+		VkDeviceSize PeakResidentBytes = 0;
+		VkDeviceSize Budget = 0;
+	};
+
+	// Keeps a mip range of every registered texture resident under a device local memory budget.
+	// Registration uploads the coarse tail, so a texture can be sampled right away. Any thread requests detail
+	// by the screen size a texture covers, and once per frame the most starved textures are upgraded while the
+	// least recently requested ones drop back to their tail when the budget runs out.
+	//
+	// A residency change builds a new image with the new mip range and swaps it in through the texture table,
+	// a per frame buffer of (bindless image index, finest resident mip) that shaders index by texture handle.
+	// Frames in flight keep sampling the old image, it is destroyed once the graphics timeline passed them.
+	class VulkanTextureStreamer
+	{
+	public:
+		static constexpr uint32_t InvalidTexture = UINT32_MAX;
+
+		VulkanTextureStreamer(const std::shared_ptr<VulkanLogicalDevice>& device, VulkanBindlessTable& bindlessTable, VulkanUploader& uploader,
+			uint32_t framesInFlight, const VulkanTextureStreamerSettings& settings = {});
+		VulkanTextureStreamer(const VulkanTextureStreamer&) = delete;
+		VulkanTextureStreamer(VulkanTextureStreamer&&) = delete;
+
+		// The device must be idle
+		~VulkanTextureStreamer();
+
+		// Sampled images through the bindless table
+		bool IsSupported() const { return m_supported; }
+
+		// Render thread. InvalidTexture when unsupported, full or the tail doesn't fit the staging ring right now.
+		uint32_t Register(std::shared_ptr<const TextureData> source);
+		void Unregister(uint32_t texture);
+
+		// Any thread. The largest request of a frame wins.
+		void RequestSize(uint32_t texture, float screenPixels);
+
+		// Finest mip worth sampling when the texture covers screenPixels along its larger side
+		static uint32_t ComputeMip(const TextureData& source, float screenPixels);
+
+		// Render thread, after the target began the frame and before the uploader flushes
+		void Update(uint32_t frameIndex);
+
+		// Storage buffer of uvec2 entries for the frame slot, see Textures.glsl
+		uint32_t GetTableIndex(uint32_t frameIndex) const { return m_tables[frameIndex].Index; }
+		uint32_t GetSamplerIndex() const { return m_samplerIndex; }
+
+		uint32_t GetResidentMip(uint32_t texture) const { return m_textures[texture].Current.FirstMip; }
+		VulkanTextureStreamerStatistics GetStatistics() const;
+		void PrintStatistics() const;
+
+	private:
+		static constexpr uint32_t NoRequest = UINT32_MAX;
+
+		struct Residency
+		{
+			VulkanAllocation* Image = nullptr;
+			VkImageView View = nullptr;
+			uint32_t BindlessIndex = VulkanBindlessTable::InvalidIndex;
+			uint32_t FirstMip = 0;
+			VkDeviceSize Bytes = 0;
+		};
+
+		struct Texture
+		{
+			// Render thread only, RequestSize reads the copy published below so Unregister never frees it mid request
+			std::shared_ptr<const TextureData> Source = nullptr;
+			std::atomic<std::shared_ptr<const TextureData>> RequestSource;
+			Residency Current;
+
+			// Coarsest first mip, always resident, and the finest one whose chain still fits the staging ring
+			uint32_t TailMip = 0;
+			uint32_t MinMip = 0;
+
+			// Finest mip requested since the last update
+			std::atomic<uint32_t> RequestedMip = NoRequest;
+			uint32_t WantedMip = 0;
+			uint64_t LastRequestFrame = 0;
+		};
+
+		struct TableSlot
+		{
+			std::unique_ptr<VulkanBuffer> Buffer;
+			uint32_t Index = VulkanBindlessTable::InvalidIndex;
+		};
+
+		// Creates the image for firstMip onwards and queues its upload, false when the staging ring is full
+		bool CreateResidency(const TextureData& source, uint32_t firstMip, Residency& residency);
+		void DestroyResidency(const Residency& residency);
+
+		// Swaps in a new mip range, the old image goes through the deletion queue
+		bool ChangeResidency(Texture& texture, uint32_t firstMip);
+		void Retire(Residency& residency);
+
+		VkDeviceSize ComputeBudget() const;
+
+		VkDevice m_device;
+		VulkanAllocator* m_allocator;
+		VulkanDeletionQueue* m_deletionQueue;
+		const VulkanPhysicalDevice* m_physicalDevice;
+		VulkanBindlessTable& m_bindlessTable;
+		VulkanUploader& m_uploader;
+		VulkanTextureStreamerSettings m_settings;
+		bool m_supported = false;
+
+		uint32_t m_heapIndex = 0;
+		VkSampler m_sampler = nullptr;
+		uint32_t m_samplerIndex = VulkanBindlessTable::InvalidIndex;
+
+		// Fixed capacity, requests from other threads never see the array move
+		std::vector<Texture> m_textures;
+		std::vector<uint32_t> m_freeTextures;
+		uint32_t m_textureCount = 0;
+
+		std::vector<TableSlot> m_tables;
+
+		uint64_t m_frame = 0;
+		VkDeviceSize m_residentBytes = 0;
+		VkDeviceSize m_uploadedThisFrame = 0;
+		VulkanTextureStreamerStatistics m_statistics;
+	};
+}
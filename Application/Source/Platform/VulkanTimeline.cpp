@@ -0,0 +1,70 @@
+#include "VulkanTimeline.h"
+
+#include <cstdint>
+
+#include "VulkanDebugger.h"
+
+namespace VEngine
+{
+	VulkanTimeline::VulkanTimeline(VkDevice device)
+	{
+		m_device = device;
+
+		auto typeInfo = VkSemaphoreTypeCreateInfo();
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		auto semaphoreInfo = VkSemaphoreCreateInfo();
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		VULKAN_CHECK(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_semaphore));
+	}
+
+	VulkanTimeline::~VulkanTimeline()
+	{
+		vkDestroySemaphore(m_device, m_semaphore, nullptr);
+	}
+
+	bool VulkanTimeline::IsComplete(uint64_t value)
+	{
+		if (value <= m_completed.load(std::memory_order_acquire))
+			return true;
+
+		return value <= GetCompletedValue();
+	}
+
+	uint64_t VulkanTimeline::GetCompletedValue()
+	{
+		uint64_t value = 0;
+		VULKAN_CHECK(vkGetSemaphoreCounterValue(m_device, m_semaphore, &value));
+
+		UpdateCompleted(value);
+		return m_completed.load(std::memory_order_acquire);
+	}
+
+	void VulkanTimeline::Wait(uint64_t value)
+	{
+		if (IsComplete(value))
+			return;
+
+		auto waitInfo = VkSemaphoreWaitInfo();
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_semaphore;
+		waitInfo.pValues = &value;
+
+		VULKAN_CHECK(vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX));
+		UpdateCompleted(value);
+	}
+
+	void VulkanTimeline::UpdateCompleted(uint64_t value)
+	{
+		// Threads may race on the update, the known value must never move backwards
+		auto completed = m_completed.load(std::memory_order_relaxed);
+		while (completed < value && m_completed.compare_exchange_weak(completed, value, std::memory_order_acq_rel) == false)
+		{
+		}
+	}
+}
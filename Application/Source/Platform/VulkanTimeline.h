@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+namespace VEngine
+{
+	// Timeline semaphore of one queue, every submission signals the next value. Whether submission N finished is a
+	// counter comparison, so any subsystem can track GPU progress without fences of its own.
+	class VulkanTimeline
+	{
+	public:
+		explicit VulkanTimeline(VkDevice device);
+		VulkanTimeline(const VulkanTimeline&) = delete;
+		VulkanTimeline(VulkanTimeline&&) = delete;
+		~VulkanTimeline();
+
+		VkSemaphore GetSemaphore() const { return m_semaphore; }
+
+		// Value the next submission signals, work being recorded now is done once it completes
+		uint64_t GetPendingValue() const { return m_submitted.load(std::memory_order_acquire) + 1; }
+		uint64_t GetSubmittedValue() const { return m_submitted.load(std::memory_order_acquire); }
+
+		// Claims the pending value for a submission that signals it, submissions to the queue are externally synchronized anyway
+		uint64_t Submit() { return m_submitted.fetch_add(1, std::memory_order_acq_rel) + 1; }
+
+		// Only asks the driver when the last known value is older than the one in question
+		bool IsComplete(uint64_t value);
+		uint64_t GetCompletedValue();
+
+		// Blocks until the submission that signals value finished
+		void Wait(uint64_t value);
+
+	private:
+		void UpdateCompleted(uint64_t value);
+
+		VkDevice m_device;
+		VkSemaphore m_semaphore = nullptr;
+
+		std::atomic<uint64_t> m_submitted = 0;
+		std::atomic<uint64_t> m_completed = 0;
+	};
+}
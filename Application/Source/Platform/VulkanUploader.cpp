@@ -0,0 +1,376 @@
+#include "VulkanUploader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <print>
+#include <stdexcept>
+#include <utility>
+
+#include "StagingRing.h"
+#include "VulkanDebugger.h"
+
+namespace VEngine
+{
+	// Covers every texel block size and the 4 byte copy alignment of transfer queues
+	static constexpr VkDeviceSize StagingAlignment = 16;
+
+	bool VulkanUploadTicket::IsComplete() const
+	{
+		if (m_value == nullptr)
+			return false;
+
+		const auto value = m_value->load(std::memory_order_acquire);
+		return value != 0 && m_timeline->IsComplete(value);
+	}
+
+	void VulkanUploadTicket::Wait() const
+	{
+		if (m_value == nullptr)
+			return;
+
+		m_value->wait(0, std::memory_order_acquire);
+		m_timeline->Wait(m_value->load(std::memory_order_acquire));
+	}
+
+	VulkanUploader::VulkanUploader(const std::shared_ptr<VulkanLogicalDevice>& device, VkDeviceSize stagingSize)
+	{
+		m_device = device->GetDevice();
+		m_allocator = &device->GetAllocator();
+		m_transferQueue = &device->GetQueue(VulkanQueueType::Transfer);
+		m_graphicsQueue = &device->GetQueue(VulkanQueueType::Graphics);
+		m_stagingSize = (stagingSize + StagingAlignment - 1) & ~(StagingAlignment - 1);
+
+		// Persistently mapped by the allocator, producers write straight into it
+		auto bufferInfo = VkBufferCreateInfo();
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = m_stagingSize;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		m_staging = m_allocator->CreateBuffer(bufferInfo, VulkanMemoryUsage::CpuToGpu);
+		if (m_staging == nullptr || m_staging->MappedData == nullptr)
+			throw std::runtime_error("Failed to create the upload staging ring!");
+	}
+
+	VulkanUploader::~VulkanUploader()
+	{
+		auto* request = m_pending.exchange(nullptr, std::memory_order_acquire);
+		while (request != nullptr)
+			delete std::exchange(request, request->Next);
+
+		for (const auto& batch : m_batches)
+			vkDestroyCommandPool(m_device, batch.CommandPool, nullptr);
+
+		m_allocator->DestroyBuffer(m_staging);
+	}
+
+	VulkanUploadTicket VulkanUploader::UploadBuffer(VkBuffer buffer, VkDeviceSize offset, std::span<const std::byte> data)
+	{
+		auto* request = Stage(data);
+		if (request == nullptr)
+			return {};
+
+		request->Buffer = buffer;
+		request->Offset = offset;
+
+		auto ticket = VulkanUploadTicket();
+		ticket.m_value = request->Value;
+		ticket.m_timeline = &m_transferQueue->GetTimeline();
+
+		Push(request);
+		return ticket;
+	}
+
+	VulkanUploadTicket VulkanUploader::UploadImage(const VulkanImageUpload& upload, std::span<const std::byte> data)
+	{
+		auto* request = Stage(data);
+		if (request == nullptr)
+			return {};
+
+		// Regions are rebased onto the ring when the batch is recorded
+		request->Image = upload;
+		request->Regions.assign(upload.Regions.begin(), upload.Regions.end());
+		request->Image.Regions = {};
+
+		auto ticket = VulkanUploadTicket();
+		ticket.m_value = request->Value;
+		ticket.m_timeline = &m_transferQueue->GetTimeline();
+
+		Push(request);
+		return ticket;
+	}
+
+	VulkanUploader::Request* VulkanUploader::Stage(std::span<const std::byte> data)
+	{
+		const auto size = (VkDeviceSize)data.size();
+		if (size == 0)
+			return nullptr;
+
+		if (size > m_stagingSize)
+			throw std::runtime_error(std::format("Upload of {} bytes is larger than the {} byte staging ring", size, m_stagingSize));
+
+		auto head = m_head.load(std::memory_order_relaxed);
+		auto reservation = StagingRingReservation();
+		do
+		{
+			reservation = ReserveStagingRange(head, m_tail.load(std::memory_order_acquire), m_stagingSize, size, StagingAlignment);
+			if (reservation.Head == head)
+			{
+				m_ringFull.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+		}
+		while (m_head.compare_exchange_weak(head, reservation.Head, std::memory_order_relaxed) == false);
+
+		auto* request = new Request();
+		request->RingBegin = head;
+		request->RingEnd = reservation.Head;
+
+		// Only the skipped bytes were taken, they hold no data and retire along with the ranges before them
+		if (reservation.Reserved == false)
+		{
+			m_ringFull.fetch_add(1, std::memory_order_relaxed);
+			Push(request);
+			return nullptr;
+		}
+
+		request->Size = size;
+		request->Value = std::make_shared<std::atomic<uint64_t>>(0);
+
+		std::memcpy(static_cast<std::byte*>(m_staging->MappedData) + (request->RingEnd - size) % m_stagingSize, data.data(), data.size());
+		return request;
+	}
+
+	void VulkanUploader::Push(Request* request)
+	{
+		request->Next = m_pending.load(std::memory_order_relaxed);
+		while (m_pending.compare_exchange_weak(request->Next, request, std::memory_order_release, std::memory_order_relaxed) == false)
+		{
+		}
+	}
+
+	VulkanUploader::Batch& VulkanUploader::AcquireBatch()
+	{
+		for (auto& batch : m_batches)
+		{
+			if (batch.Value == 0)
+				return batch;
+		}
+
+		auto& batch = m_batches.emplace_back();
+
+		auto poolInfo = VkCommandPoolCreateInfo();
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = m_transferQueue->GetFamilyIndex();
+		VULKAN_CHECK(vkCreateCommandPool(m_device, &poolInfo, nullptr, &batch.CommandPool));
+
+		auto allocInfo = VkCommandBufferAllocateInfo();
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = batch.CommandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		VULKAN_CHECK(vkAllocateCommandBuffers(m_device, &allocInfo, &batch.CommandBuffer));
+
+		return batch;
+	}
+
+	void VulkanUploader::RetireBatches()
+	{
+		auto& timeline = m_transferQueue->GetTimeline();
+		for (auto& batch : m_batches)
+		{
+			if (batch.Value == 0 || timeline.IsComplete(batch.Value) == false)
+				continue;
+
+			for (const auto& [begin, end] : batch.RingRanges)
+				m_retiredRanges.emplace(begin, end);
+
+			batch.RingRanges.clear();
+			batch.Value = 0;
+			VULKAN_CHECK(vkResetCommandPool(m_device, batch.CommandPool, 0));
+		}
+
+		// Ranges were reserved in ring order but may finish out of it, the tail only moves over contiguous ones
+		auto tail = m_tail.load(std::memory_order_relaxed);
+		for (auto it = m_retiredRanges.begin(); it != m_retiredRanges.end() && it->first == tail; it = m_retiredRanges.erase(it))
+			tail = it->second;
+
+		m_tail.store(tail, std::memory_order_release);
+	}
+
+	void VulkanUploader::Flush(VkCommandBuffer commandBuffer)
+	{
+		auto requests = std::vector<Request*>();
+		for (auto* request = m_pending.exchange(nullptr, std::memory_order_acquire); request != nullptr; request = request->Next)
+		{
+			// Skipped ends of the ring copy nothing, the tail moves over them with the ranges before them
+			if (request->Size == 0)
+			{
+				m_retiredRanges.emplace(request->RingBegin, request->RingEnd);
+				delete request;
+				continue;
+			}
+
+			requests.push_back(request);
+		}
+
+		RetireBatches();
+		if (requests.empty())
+			return;
+
+		// Oldest first, then grouped by destination so every buffer and image gets one copy command, unless buffer uploads overlap
+		std::ranges::reverse(requests);
+		std::ranges::stable_sort(requests, [](const Request* a, const Request* b)
+		{
+			return a->Buffer != b->Buffer ? a->Buffer < b->Buffer : a->Image.Image < b->Image.Image;
+		});
+
+		auto& batch = AcquireBatch();
+
+		auto beginInfo = VkCommandBufferBeginInfo();
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VULKAN_CHECK(vkBeginCommandBuffer(batch.CommandBuffer, &beginInfo))
+
+		auto bufferRegions = std::vector<VkBufferCopy>();
+		auto imageRegions = std::vector<VkBufferImageCopy>();
+		auto imageBarriers = std::vector<VkImageMemoryBarrier>();
+		bool buffersWritten = false;
+
+		for (size_t first = 0; first < requests.size();)
+		{
+			const auto& head = *requests[first];
+			auto last = first;
+
+			if (head.Buffer != nullptr)
+			{
+				// Regions of one copy must not overlap, a request writing over an earlier one starts a new copy after a barrier
+				bufferRegions.clear();
+				for (; last < requests.size() && requests[last]->Buffer == head.Buffer; last++)
+				{
+					const auto& request = *requests[last];
+					const bool overlaps = std::ranges::any_of(bufferRegions, [&](const VkBufferCopy& region)
+					{
+						return request.Offset < region.dstOffset + region.size && region.dstOffset < request.Offset + request.Size;
+					});
+
+					if (overlaps)
+					{
+						vkCmdCopyBuffer(batch.CommandBuffer, m_staging->Buffer, head.Buffer, (uint32_t)bufferRegions.size(), bufferRegions.data());
+						m_statistics.CopyCommands++;
+						bufferRegions.clear();
+
+						auto barrier = VkMemoryBarrier();
+						barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+						barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+						barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+						vkCmdPipelineBarrier(batch.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+					}
+
+					bufferRegions.push_back({ (request.RingEnd - request.Size) % m_stagingSize, request.Offset, request.Size });
+				}
+
+				vkCmdCopyBuffer(batch.CommandBuffer, m_staging->Buffer, head.Buffer, (uint32_t)bufferRegions.size(), bufferRegions.data());
+				buffersWritten = true;
+			}
+			else
+			{
+				imageRegions.clear();
+				imageBarriers.clear();
+				for (; last < requests.size() && requests[last]->Buffer == nullptr && requests[last]->Image.Image == head.Image.Image; last++)
+				{
+					const auto& request = *requests[last];
+					for (auto region : request.Regions)
+					{
+						region.bufferOffset += (request.RingEnd - request.Size) % m_stagingSize;
+						imageRegions.push_back(region);
+					}
+
+					auto barrier = VkImageMemoryBarrier();
+					barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.image = request.Image.Image;
+					barrier.subresourceRange = request.Image.Range;
+					imageBarriers.push_back(barrier);
+				}
+
+				vkCmdPipelineBarrier(batch.CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)imageBarriers.size(), imageBarriers.data());
+				vkCmdCopyBufferToImage(batch.CommandBuffer, m_staging->Buffer, head.Image.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)imageRegions.size(), imageRegions.data());
+
+				for (size_t i = first; i < last; i++)
+				{
+					const auto& image = requests[i]->Image;
+					m_transferQueue->ReleaseImage(batch.CommandBuffer, *m_graphicsQueue, image.Image, image.Range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						image.FinalLayout, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+				}
+			}
+
+			m_statistics.CopyCommands++;
+			first = last;
+		}
+
+		VULKAN_CHECK(vkEndCommandBuffer(batch.CommandBuffer))
+
+		auto submit = VulkanQueueSubmit();
+		submit.CommandBuffers = { &batch.CommandBuffer, 1 };
+		batch.Value = m_transferQueue->Submit(submit);
+
+		// Nothing the frame records can start before the copies landed
+		m_graphicsQueue->AddWait({ m_transferQueue, batch.Value, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT });
+
+		// Buffers are concurrent and covered by the semaphore wait, on a shared queue a barrier orders them instead
+		if (buffersWritten && m_transferQueue == m_graphicsQueue)
+		{
+			auto barrier = VkMemoryBarrier();
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+
+		for (auto* request : requests)
+		{
+			if (request->Image.Image != nullptr)
+			{
+				m_graphicsQueue->AcquireImage(commandBuffer, *m_transferQueue, request->Image.Image, request->Image.Range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					request->Image.FinalLayout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_SHADER_READ_BIT);
+			}
+
+			batch.RingRanges.emplace_back(request->RingBegin, request->RingEnd);
+			m_statistics.Bytes += request->Size;
+
+			request->Value->store(batch.Value, std::memory_order_release);
+			request->Value->notify_all();
+			delete request;
+		}
+
+		const auto used = m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_relaxed);
+		m_statistics.PeakStagingBytes = std::max(m_statistics.PeakStagingBytes, used);
+		m_statistics.Uploads += requests.size();
+		m_statistics.Batches++;
+	}
+
+	VulkanUploaderStatistics VulkanUploader::GetStatistics() const
+	{
+		auto statistics = m_statistics;
+		statistics.RingFull = m_ringFull.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	void VulkanUploader::PrintStatistics() const
+	{
+		constexpr double MiB = 1024.0 * 1024.0;
+		const auto statistics = GetStatistics();
+
+		std::println("Uploader ({} queue): {} uploads in {} batches and {} copy commands, {:.2f} MiB, staging peak {:.2f} of {:.2f} MiB, ring full {} times",
+			m_transferQueue == m_graphicsQueue ? "graphics" : "transfer", statistics.Uploads, statistics.Batches, statistics.CopyCommands,
+			(double)statistics.Bytes / MiB, (double)statistics.PeakStagingBytes / MiB, (double)m_stagingSize / MiB, statistics.RingFull);
+	}
+}
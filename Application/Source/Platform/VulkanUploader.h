@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "VulkanAllocator.h"
+#include "VulkanDevice.h"
+#include "VulkanQueue.h"
+
+namespace VEngine
+{
+	// Future-like handle of one upload. The value is zero until the batch holding the upload was submitted.
+	class VulkanUploadTicket
+	{
+	public:
+		VulkanUploadTicket() = default;
+
+		// False when the staging ring was full, the upload has to be retried later
+		bool IsValid() const { return m_value != nullptr; }
+
+		// Finished on the transfer queue. Frames recorded after the flush that submitted it can use the data.
+		bool IsComplete() const;
+
+		// Blocks until complete. The thread calling Flush must not wait on uploads it hasn't flushed yet.
+		void Wait() const;
+
+	private:
+		friend class VulkanUploader;
+
+		std::shared_ptr<std::atomic<uint64_t>> m_value = nullptr;
+		VulkanTimeline* m_timeline = nullptr;
+	};
+
+	// Whole subresources of a new image, whatever Range held before is discarded
+	struct VulkanImageUpload
+	{
+		VkImage Image = nullptr;
+		VkImageSubresourceRange Range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		// Buffer offsets are relative to the uploaded data
+		std::span<const VkBufferImageCopy> Regions;
+	};
+
+	struct VulkanUploaderStatistics
+	{
+		uint64_t Uploads = 0;
+		uint64_t Batches = 0;
+		uint64_t CopyCommands = 0;
+		uint64_t Bytes = 0;
+		uint64_t RingFull = 0;
+		VkDeviceSize PeakStagingBytes = 0;
+	};
+
+	// Streams data to device local memory through a persistently mapped staging ring on the transfer queue.
+	// Any thread copies its data into the ring and queues the upload without taking a lock. The render thread
+	// flushes once per frame: everything queued goes out as one transfer submission with one copy command per
+	// destination, and the frame's graphics submission waits for it on the transfer timeline.
+	class VulkanUploader
+	{
+	public:
+		VulkanUploader(const std::shared_ptr<VulkanLogicalDevice>& device, VkDeviceSize stagingSize);
+		VulkanUploader(const VulkanUploader&) = delete;
+		VulkanUploader(VulkanUploader&&) = delete;
+
+		// Uploads still queued are dropped, the device must be idle
+		~VulkanUploader();
+
+		// Buffers from the allocator are shared with the transfer queue, so no ownership transfer is needed.
+		// Uploads overlapping within one flush land in the order they were made. Throws when the data can never fit the ring.
+		VulkanUploadTicket UploadBuffer(VkBuffer buffer, VkDeviceSize offset, std::span<const std::byte> data);
+
+		// Images change ownership to the graphics queue and end up in FinalLayout, readable from any shader stage
+		VulkanUploadTicket UploadImage(const VulkanImageUpload& upload, std::span<const std::byte> data);
+
+		// Render thread, after the target began the frame and before anything reads the uploads
+		void Flush(VkCommandBuffer commandBuffer);
+
+		VkDeviceSize GetStagingSize() const { return m_stagingSize; }
+		VulkanUploaderStatistics GetStatistics() const;
+		void PrintStatistics() const;
+
+	private:
+		struct Request
+		{
+			Request* Next = nullptr;
+
+			VkBuffer Buffer = nullptr;
+			VkDeviceSize Offset = 0;
+
+			VulkanImageUpload Image;
+			std::vector<VkBufferImageCopy> Regions;
+
+			// Ring space in the monotonic offsets of the ring, the staging offset is End - Size modulo the ring size
+			uint64_t RingBegin = 0;
+			uint64_t RingEnd = 0;
+			VkDeviceSize Size = 0;
+
+			std::shared_ptr<std::atomic<uint64_t>> Value;
+		};
+
+		struct Batch
+		{
+			VkCommandPool CommandPool = nullptr;
+			VkCommandBuffer CommandBuffer = nullptr;
+
+			// Zero while the batch is free
+			uint64_t Value = 0;
+			std::vector<std::pair<uint64_t, uint64_t>> RingRanges;
+		};
+
+		Request* Stage(std::span<const std::byte> data);
+		void Push(Request* request);
+		Batch& AcquireBatch();
+		void RetireBatches();
+
+		VkDevice m_device;
+		VulkanAllocator* m_allocator;
+		VulkanQueue* m_transferQueue;
+		VulkanQueue* m_graphicsQueue;
+
+		VulkanAllocation* m_staging = nullptr;
+		VkDeviceSize m_stagingSize = 0;
+
+		// Producers bump the head, the flushing thread moves the tail once the copies out of a range completed
+		std::atomic<uint64_t> m_head = 0;
+		std::atomic<uint64_t> m_tail = 0;
+		std::map<uint64_t, uint64_t> m_retiredRanges;
+
+		// Intrusive stack of queued uploads, reversed into submission order on flush
+		std::atomic<Request*> m_pending = nullptr;
+
+		std::vector<Batch> m_batches;
+
+		std::atomic<uint64_t> m_ringFull = 0;
+		VulkanUploaderStatistics m_statistics;
+	};
+}
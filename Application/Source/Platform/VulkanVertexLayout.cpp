@@ -0,0 +1,87 @@
+#include "VulkanVertexLayout.h"
+#include "VertexQuantization.h"
+
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+
+namespace VEngine
+{
+	VulkanVertexLayout& VulkanVertexLayout::Add(uint32_t location, VkFormat format)
+	{
+		auto attribute = VulkanVertexAttribute();
+		attribute.Location = location;
+		attribute.Format = format;
+		attribute.Offset = m_stride;
+
+		m_attributes.push_back(attribute);
+		m_stride += GetFormatSize(format);
+
+		return *this;
+	}
+
+	VkVertexInputBindingDescription VulkanVertexLayout::GetBindingDescription(uint32_t binding) const
+	{
+		auto description = VkVertexInputBindingDescription();
+		description.binding = binding;
+		description.stride = m_stride;
+		description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return description;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> VulkanVertexLayout::GetAttributeDescriptions(uint32_t binding) const
+	{
+		auto descriptions = std::vector<VkVertexInputAttributeDescription>();
+		for (const auto& attribute : m_attributes)
+		{
+			auto description = VkVertexInputAttributeDescription();
+			description.location = attribute.Location;
+			description.binding = binding;
+			description.format = attribute.Format;
+			description.offset = attribute.Offset;
+			descriptions.push_back(description);
+		}
+
+		return descriptions;
+	}
+
+	uint32_t VulkanVertexLayout::GetFormatSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SNORM:
+		case VK_FORMAT_R16G16_SNORM:
+		case VK_FORMAT_R16G16_UNORM:
+		case VK_FORMAT_R16G16_SFLOAT:
+		case VK_FORMAT_R32_SFLOAT:
+		case VK_FORMAT_R32_UINT:
+			return 4;
+		case VK_FORMAT_R16G16B16A16_SNORM:
+		case VK_FORMAT_R16G16B16A16_UNORM:
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+		case VK_FORMAT_R32G32_SFLOAT:
+			return 8;
+		case VK_FORMAT_R32G32B32_SFLOAT:
+			return 12;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+		default:
+			throw std::runtime_error(std::format("Vertex format {} is not supported", (int)format));
+		}
+	}
+
+	VulkanVertexLayout VulkanVertexLayout::Quantized()
+	{
+		// All three formats have mandatory vertex buffer support
+		auto layout = VulkanVertexLayout();
+		layout.Add(0, VK_FORMAT_R16G16B16A16_SNORM)
+			.Add(1, VK_FORMAT_R16G16_SNORM)
+			.Add(2, VK_FORMAT_R16G16_SFLOAT);
+
+		return layout;
+	}
+
+	static_assert(offsetof(QuantizedVertex, Normal) == 8 && offsetof(QuantizedVertex, Uv) == 12, "QuantizedVertex has to match VulkanVertexLayout::Quantized");
+}
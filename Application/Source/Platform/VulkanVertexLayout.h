@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace VEngine
+{
+	struct VulkanVertexAttribute
+	{
+		uint32_t Location = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Offset = 0;
+	};
+
+	// Interleaved attributes of one vertex binding, pipelines derive their vertex input state from it
+	class VulkanVertexLayout
+	{
+	public:
+		// Packs the attribute right after the previous one
+		VulkanVertexLayout& Add(uint32_t location, VkFormat format);
+
+		uint32_t GetStride() const { return m_stride; }
+		const std::vector<VulkanVertexAttribute>& GetAttributes() const { return m_attributes; }
+
+		VkVertexInputBindingDescription GetBindingDescription(uint32_t binding = 0) const;
+		std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(uint32_t binding = 0) const;
+
+		// Byte size of the formats vertex layouts use, throws for anything else
+		static uint32_t GetFormatSize(VkFormat format);
+
+		// QuantizedVertex: 16-bit snorm position, snorm octahedral normal, half float uv
+		static VulkanVertexLayout Quantized();
+
+	private:
+		std::vector<VulkanVertexAttribute> m_attributes;
+		uint32_t m_stride = 0;
+	};
+}
@@ -0,0 +1,178 @@
+#include <cstring>
+#include <exception>
+#include <print>
+#include <unordered_set>
+#include <vector>
+
+#include "VulkanAllocator.h"
+#include "VulkanDebugger.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanScope.h"
+
+// Needs a Vulkan device, a software ICD is enough. Without one the test reports itself as skipped.
+namespace
+{
+	constexpr int SkipReturnCode = 77;
+	constexpr VkDeviceSize BufferSize = 1024 * 1024;
+
+	uint32_t s_failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (condition)
+			return;
+
+		std::println("FAILED: {}", message);
+		s_failures++;
+	}
+
+	VEngine::VulkanHeapStatistics GetHeap(const VEngine::VulkanAllocator& allocator, uint32_t heapIndex)
+	{
+		return allocator.GetStatistics()[heapIndex];
+	}
+
+	// Records into a one off command buffer on the graphics queue and waits for it
+	template <typename Record>
+	void Submit(const VEngine::VulkanLogicalDevice& device, Record&& record)
+	{
+		auto& queue = device.GetQueue(VEngine::VulkanQueueType::Graphics);
+
+		auto poolInfo = VkCommandPoolCreateInfo();
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = queue.GetFamilyIndex();
+
+		VkCommandPool commandPool;
+		VULKAN_CHECK(vkCreateCommandPool(device.GetDevice(), &poolInfo, nullptr, &commandPool));
+
+		auto allocInfo = VkCommandBufferAllocateInfo();
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		VULKAN_CHECK(vkAllocateCommandBuffers(device.GetDevice(), &allocInfo, &commandBuffer));
+
+		auto beginInfo = VkCommandBufferBeginInfo();
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VULKAN_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+		record(commandBuffer);
+
+		VULKAN_CHECK(vkEndCommandBuffer(commandBuffer));
+
+		auto submit = VEngine::VulkanQueueSubmit();
+		submit.CommandBuffers = { &commandBuffer, 1 };
+		queue.GetTimeline().Wait(queue.Submit(submit));
+
+		vkDestroyCommandPool(device.GetDevice(), commandPool, nullptr);
+	}
+
+	// Fills a few blocks with buffers, frees three of every four and lets one pass pack the survivors
+	void TestDefragmentation(const VEngine::VulkanLogicalDevice& device)
+	{
+		auto& allocator = device.GetAllocator();
+		auto& deletionQueue = device.GetDeletionQueue();
+
+		auto bufferInfo = VkBufferCreateInfo();
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = BufferSize;
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		auto buffers = std::vector<VEngine::VulkanAllocation*>();
+		auto blocks = std::unordered_set<VEngine::VulkanMemoryBlock*>();
+		while (blocks.size() < 4)
+		{
+			auto* allocation = allocator.CreateBuffer(bufferInfo, VEngine::VulkanMemoryUsage::GpuOnly);
+			allocation->Movable = true;
+			blocks.insert(allocation->Block);
+			buffers.push_back(allocation);
+		}
+
+		const auto heapIndex = device.GetPhysicalDevice()->GetMemoryProperties().memoryTypes[buffers[0]->MemoryTypeIndex].heapIndex;
+
+		auto kept = std::vector<VEngine::VulkanAllocation*>();
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			if (i % 4 == 0)
+				kept.push_back(buffers[i]);
+			else
+				allocator.DestroyBuffer(buffers[i]);
+		}
+
+		const auto before = GetHeap(allocator, heapIndex);
+		Check(before.Fragmentation > 0.0f, "freeing most buffers fragments the heap");
+
+		VkDeviceSize bytesMoved = 0;
+		Submit(device, [&](VkCommandBuffer commandBuffer)
+		{
+			// Every buffer gets its own pattern, it has to survive the move
+			for (uint32_t i = 0; i < (uint32_t)kept.size(); i++)
+				vkCmdFillBuffer(commandBuffer, kept[i]->Buffer, 0, VK_WHOLE_SIZE, i + 1);
+
+			bytesMoved = allocator.Defragment(commandBuffer, deletionQueue);
+		});
+
+		Check(bytesMoved > 0, "the pass moved buffers");
+		Check(GetHeap(allocator, heapIndex).MovingBytes == bytesMoved, "old ranges count as moving until the copies completed");
+
+		deletionQueue.Collect();
+		const auto after = GetHeap(allocator, heapIndex);
+		Check(after.MovingBytes == 0, "old ranges were freed once the copies completed");
+		Check(after.BlockCount < before.BlockCount, "emptied blocks were released");
+		Check(after.Fragmentation < before.Fragmentation, "the pass reduced fragmentation");
+		Check(after.AllocationCount == before.AllocationCount, "moving keeps the allocation count");
+
+		// Read every buffer's first word back through host visible memory
+		auto readbackInfo = bufferInfo;
+		readbackInfo.size = kept.size() * sizeof(uint32_t);
+		readbackInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		auto* readback = allocator.CreateBuffer(readbackInfo, VEngine::VulkanMemoryUsage::GpuToCpu);
+
+		Submit(device, [&](VkCommandBuffer commandBuffer)
+		{
+			for (uint32_t i = 0; i < (uint32_t)kept.size(); i++)
+			{
+				const auto region = VkBufferCopy{ 0, i * sizeof(uint32_t), sizeof(uint32_t) };
+				vkCmdCopyBuffer(commandBuffer, kept[i]->Buffer, readback->Buffer, 1, &region);
+			}
+		});
+
+		auto values = std::vector<uint32_t>(kept.size());
+		std::memcpy(values.data(), readback->MappedData, values.size() * sizeof(uint32_t));
+
+		bool intact = true;
+		for (uint32_t i = 0; i < (uint32_t)values.size(); i++)
+			intact = intact && values[i] == i + 1;
+
+		Check(intact, "moved buffers kept their contents");
+
+		allocator.DestroyBuffer(readback);
+		for (auto* allocation : kept)
+			allocator.DestroyBuffer(allocation);
+	}
+}
+
+int main()
+{
+	auto scope = VEngine::VulkanScope();
+	try
+	{
+		scope.Initialize(true);
+	}
+	catch (const std::exception& exception)
+	{
+		std::println("Skipped, no Vulkan device: {}", exception.what());
+		return SkipReturnCode;
+	}
+
+	TestDefragmentation(*scope.GetVulkanDevice());
+
+	if (s_failures == 0)
+		std::println("All allocator tests passed");
+
+	return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+#include <atomic>
+#include <chrono>
+#include <print>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Returns the number of failed checks, every test runs on its own job system so a hang points at one test
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	uint32_t s_failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (condition)
+			return;
+
+		std::println("FAILED: {}", message);
+		s_failures++;
+	}
+
+	// A job blocks its worker and pushes children to that worker's own deque, only a thief can run them
+	void TestStealing()
+	{
+		auto jobSystem = VEngine::JobSystem(2);
+		auto counter = VEngine::JobCounter();
+		std::atomic<bool> stolen = false;
+
+		jobSystem.Schedule([&]
+		{
+			const auto owner = std::this_thread::get_id();
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				jobSystem.Schedule([&, owner]
+				{
+					if (std::this_thread::get_id() != owner)
+						stolen = true;
+				}, &counter);
+			}
+
+			const auto deadline = Clock::now() + std::chrono::seconds(5);
+			while (stolen == false && Clock::now() < deadline)
+				std::this_thread::yield();
+		}, &counter);
+
+		jobSystem.Wait(counter);
+		Check(stolen, "children pushed by a busy worker were stolen");
+	}
+
+	// A job waiting on a dependency starts only after every job of that counter finished
+	void TestDependencies()
+	{
+		auto jobSystem = VEngine::JobSystem(3);
+		auto first = VEngine::JobCounter();
+		auto second = VEngine::JobCounter();
+		std::atomic<uint32_t> finished = 0;
+		std::atomic<uint32_t> seen = 0;
+
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			jobSystem.Schedule([&]
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				finished++;
+			}, &first);
+		}
+
+		jobSystem.Schedule([&] { seen = finished.load(); }, &second, &first);
+		jobSystem.Wait(second);
+
+		Check(first.IsDone(), "dependency done before its dependent finished");
+		Check(seen == 8, "dependent job saw every dependency job finished");
+
+		// A finished dependency queues the job right away
+		auto third = VEngine::JobCounter();
+		std::atomic<bool> ran = false;
+		jobSystem.Schedule([&] { ran = true; }, &third, &first);
+		jobSystem.Wait(third);
+		Check(ran, "job depending on a finished counter ran");
+	}
+
+	// Jobs for the main thread run inside the main thread's Wait, even when a worker schedules them
+	void TestMainThreadJobs()
+	{
+		auto jobSystem = VEngine::JobSystem(2);
+		auto counter = VEngine::JobCounter();
+		const auto mainThread = std::this_thread::get_id();
+		std::atomic<bool> onMainThread = false;
+
+		jobSystem.Schedule([&]
+		{
+			jobSystem.ScheduleOnMainThread([&] { onMainThread = std::this_thread::get_id() == mainThread; }, &counter);
+		}, &counter);
+
+		// Gives a worker the time to take the job before the main thread helps out
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		jobSystem.Wait(counter);
+		Check(onMainThread, "main thread job ran on the main thread");
+
+		// Workers never run them, only the pump does
+		auto pumped = VEngine::JobCounter();
+		jobSystem.ScheduleOnMainThread([] {}, &pumped);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		Check(pumped.IsDone() == false, "main thread job waited for the pump");
+
+		jobSystem.PumpMainThread();
+		Check(pumped.IsDone(), "pump ran the main thread job");
+	}
+
+	// Every index is covered by exactly one chunk
+	void TestParallelFor()
+	{
+		auto jobSystem = VEngine::JobSystem(3);
+		auto counter = VEngine::JobCounter();
+		auto hits = std::vector<std::atomic<uint32_t>>(1000);
+
+		jobSystem.ParallelFor((uint32_t)hits.size(), 64, [&](uint32_t first, uint32_t count)
+		{
+			for (uint32_t i = first; i < first + count; i++)
+				hits[i]++;
+		}, &counter);
+		jobSystem.Wait(counter);
+
+		bool once = true;
+		for (const auto& hit : hits)
+			once = once && hit == 1;
+
+		Check(once, "parallel for ran every index once");
+	}
+}
+
+int main()
+{
+	TestStealing();
+	TestDependencies();
+	TestMainThreadJobs();
+	TestParallelFor();
+
+	if (s_failures == 0)
+		std::println("All job system tests passed");
+
+	return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#include <cstdint>
+#include <map>
+#include <print>
+
+#include "StagingRing.h"
+
+// Drives the uploader's ring math the way VulkanUploader does, without a device
+namespace
+{
+	constexpr uint64_t MiB = 1024 * 1024;
+	constexpr uint64_t RingSize = 32 * MiB;
+	constexpr uint64_t Alignment = 16;
+
+	uint32_t s_failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (condition)
+			return;
+
+		std::println("FAILED: {}", message);
+		s_failures++;
+	}
+
+	struct Ring
+	{
+		uint64_t Head = 0;
+		uint64_t Tail = 0;
+		std::map<uint64_t, uint64_t> Retired;
+
+		// Returns the range's end, zero when nothing was reserved. Skipped bytes retire right away like on a flush.
+		uint64_t Upload(uint64_t size)
+		{
+			const auto reservation = VEngine::ReserveStagingRange(Head, Tail, RingSize, size, Alignment);
+			if (reservation.Head == Head)
+				return 0;
+
+			if (reservation.Reserved == false)
+				Retired.emplace(Head, reservation.Head);
+
+			Head = reservation.Head;
+			Retire();
+			return reservation.Reserved ? Head : 0;
+		}
+
+		void Retire()
+		{
+			for (auto it = Retired.begin(); it != Retired.end() && it->first == Tail; it = Retired.erase(it))
+				Tail = it->second;
+		}
+
+		void Complete(uint64_t begin, uint64_t end)
+		{
+			Retired.emplace(begin, end);
+			Retire();
+		}
+	};
+
+	// An upload larger than half the ring after the ring drained to an unaligned head, the skip alone never fits
+	void TestLargeUploadAfterUnalignedHead()
+	{
+		auto ring = Ring();
+		const auto first = ring.Upload(20 * MiB + 5);
+		Check(first == 20 * MiB + 5, "first upload starts at the beginning of the ring");
+		ring.Complete(0, first);
+		Check(ring.Tail == ring.Head, "ring drained");
+
+		uint64_t end = 0;
+		for (uint32_t attempt = 0; attempt < 2 && end == 0; attempt++)
+			end = ring.Upload(24 * MiB);
+
+		Check(end != 0, "large upload fits once the skipped end of the ring retired");
+		Check(end == RingSize + 24 * MiB, "large upload starts at the next lap");
+		Check((end - 24 * MiB) % RingSize + 24 * MiB <= RingSize, "large upload does not wrap");
+		Check(end - ring.Tail <= RingSize, "large upload stays within the ring");
+	}
+
+	// A whole ring sized upload behind a head just short of a lap, only the alignment skips to the boundary
+	void TestFullRingUploadBeforeBoundary()
+	{
+		auto ring = Ring();
+		const auto first = ring.Upload(RingSize - 5);
+		ring.Complete(0, first);
+
+		uint64_t end = 0;
+		for (uint32_t attempt = 0; attempt < 2 && end == 0; attempt++)
+			end = ring.Upload(RingSize);
+
+		Check(end == 2 * RingSize, "ring sized upload fills the next lap");
+	}
+
+	// Skipped bytes are never taken over data still in flight from the previous lap
+	void TestSkipRespectsLiveRanges()
+	{
+		auto ring = Ring();
+		const auto first = ring.Upload(20 * MiB);
+		const auto second = ring.Upload(10 * MiB);
+		ring.Complete(0, first);
+		const auto third = ring.Upload(20 * MiB);
+		Check(third == RingSize + 20 * MiB, "third upload skipped to the next lap");
+
+		const auto head = ring.Head;
+		Check(ring.Upload(16 * MiB) == 0, "upload waits while the ring is busy");
+		Check(ring.Head == head, "skip waits while it would overwrite live data");
+
+		ring.Complete(first, second);
+		ring.Complete(second, third);
+		uint64_t end = 0;
+		for (uint32_t attempt = 0; attempt < 2 && end == 0; attempt++)
+			end = ring.Upload(16 * MiB);
+
+		Check(end == 2 * RingSize + 16 * MiB, "upload fits once the ring drained");
+	}
+
+	// Small uploads keep their alignment and pack back to back
+	void TestAlignment()
+	{
+		auto ring = Ring();
+		const auto first = ring.Upload(5);
+		const auto second = ring.Upload(7);
+		Check(first == 5, "first upload at the start");
+		Check(second == Alignment + 7, "second upload starts aligned");
+	}
+}
+
+int main()
+{
+	TestLargeUploadAfterUnalignedHead();
+	TestFullRingUploadBeforeBoundary();
+	TestSkipRespectsLiveRanges();
+	TestAlignment();
+
+	if (s_failures == 0)
+		std::println("All staging ring tests passed");
+
+	return s_failures == 0 ? 0 : 1;
+}
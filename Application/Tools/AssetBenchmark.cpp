@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AssetArchive.h"
+
+// Usage: VEngineAssetBench <archive.vpak> [iterations]
+// Run from the directory the archive was packed in, so the loose files resolve under their entry names.
+// Both paths run with a warm page cache after the first iteration, cold numbers need the cache dropped between runs.
+
+// VulkanShader's loose file path: open, seek, copy into a vector. Rounded up since not every asset is SPIR-V.
+static std::vector<uint32_t> ReadFile(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+		return {};
+
+	const uint32_t fileSize = file.tellg();
+	auto buffer = std::vector<uint32_t>((fileSize + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
+
+	return buffer;
+}
+
+// Reads every byte, so both paths pay for faulting in or copying all the data. Zero padding doesn't change the sum.
+static uint64_t Checksum(const void* data, size_t size)
+{
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	uint64_t checksum = 0;
+	for (size_t i = 0; i < size; i++)
+		checksum += bytes[i];
+
+	return checksum;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::println("Usage: VEngineAssetBench <archive.vpak> [iterations]");
+		return 1;
+	}
+
+	uint32_t iterations = 20;
+	if (argc > 2)
+		std::from_chars(argv[2], argv[2] + std::string_view(argv[2]).size(), iterations);
+
+	auto archive = VEngine::AssetArchive();
+	if (archive.Open(argv[1]) == false)
+	{
+		std::println("Failed to open {}", argv[1]);
+		return 1;
+	}
+
+	auto names = std::vector<std::string>();
+	uint64_t totalBytes = 0;
+	for (uint32_t i = 0; i < archive.GetEntryCount(); i++)
+	{
+		names.emplace_back(archive.GetName(i));
+		totalBytes += archive.GetData(i).size();
+	}
+
+	archive.Close();
+
+	using Clock = std::chrono::steady_clock;
+	auto streamTimes = std::vector<double>();
+	auto mappedTimes = std::vector<double>();
+	uint64_t streamChecksum = 0;
+	uint64_t mappedChecksum = 0;
+
+	for (uint32_t iteration = 0; iteration < std::max(iterations, 1u); iteration++)
+	{
+		streamChecksum = 0;
+		auto start = Clock::now();
+		for (const auto& name : names)
+		{
+			const auto code = ReadFile(name);
+			streamChecksum += Checksum(code.data(), code.size() * sizeof(uint32_t));
+		}
+
+		streamTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+		// Opening is part of the cost, an engine start maps the archive once
+		mappedChecksum = 0;
+		start = Clock::now();
+		auto mapped = VEngine::AssetArchive();
+		mapped.Open(argv[1]);
+		for (const auto& name : names)
+		{
+			const auto data = mapped.Find(name);
+			mappedChecksum += Checksum(data.data(), data.size());
+		}
+
+		mapped.Close();
+		mappedTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+
+	if (streamChecksum != mappedChecksum)
+		std::println("Warning: loose files differ from the archive, repack before comparing");
+
+	const auto report = [&](std::string_view label, std::vector<double>& times)
+	{
+		std::ranges::sort(times);
+		std::println("{:<10} min {:8.3f} ms, median {:8.3f} ms, {:8.1f} MiB/s", label, times.front(), times[times.size() / 2],
+			(double)totalBytes / (1024.0 * 1024.0) / (times[times.size() / 2] / 1000.0));
+	};
+
+	std::println("{} assets, {} bytes, {} iterations", names.size(), totalBytes, streamTimes.size());
+	report("ifstream", streamTimes);
+	report("mmap", mappedTimes);
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <vector>
+
+#include "AssetArchive.h"
+
+// Usage: VEnginePack <output.vpak> <file or directory>...
+// Entries are named by their path as given, relative to the working directory, with '/' separators.
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::println("Usage: VEnginePack <output.vpak> <file or directory>...");
+		return 1;
+	}
+
+	auto files = std::vector<std::filesystem::path>();
+	for (int i = 2; i < argc; i++)
+	{
+		const auto input = std::filesystem::path(argv[i]);
+		if (std::filesystem::is_directory(input))
+		{
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(input))
+			{
+				if (entry.is_regular_file())
+					files.push_back(entry.path());
+			}
+		}
+		else if (std::filesystem::is_regular_file(input))
+		{
+			files.push_back(input);
+		}
+		else
+		{
+			std::println("{} does not exist", input.string());
+			return 1;
+		}
+	}
+
+	// Directory iteration order is unspecified, sorting keeps archives reproducible
+	std::ranges::sort(files);
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+
+	auto writer = VEngine::AssetArchiveWriter();
+	uint64_t totalBytes = 0;
+	for (const auto& path : files)
+	{
+		auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+		if (file.is_open() == false)
+		{
+			std::println("Failed to read {}", path.string());
+			return 1;
+		}
+
+		auto data = std::vector<std::byte>((size_t)file.tellg());
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), (std::streamsize)data.size());
+
+		totalBytes += data.size();
+		writer.Add(path.lexically_normal().generic_string(), std::move(data));
+	}
+
+	const auto output = std::filesystem::path(argv[1]);
+	if (output.has_parent_path())
+		std::filesystem::create_directories(output.parent_path());
+
+	if (writer.Write(output) == false)
+	{
+		std::println("Failed to write {}", output.string());
+		return 1;
+	}
+
+	std::println("Packed {} files ({} bytes) into {}", writer.GetEntryCount(), totalBytes, output.string());
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <print>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "FrustumCuller.h"
+
+// Usage: VEngineCullBench [instances] [iterations]
+// Boxes are scattered through a cube around a camera looking down -z, roughly a quarter of them end up visible.
+int main(int argc, char** argv)
+{
+	uint32_t instanceCount = 1000000;
+	uint32_t iterations = 50;
+	if (argc > 1)
+		std::from_chars(argv[1], argv[1] + std::string_view(argv[1]).size(), instanceCount);
+	if (argc > 2)
+		std::from_chars(argv[2], argv[2] + std::string_view(argv[2]).size(), iterations);
+
+	iterations = std::max(iterations, 1u);
+
+	// Fixed seed, every run culls the same scene
+	auto random = std::mt19937(1234);
+	auto position = std::uniform_real_distribution<float>(-500.0f, 500.0f);
+	auto size = std::uniform_real_distribution<float>(0.1f, 2.0f);
+
+	auto bounds = VEngine::CullingBounds();
+	bounds.Reserve(instanceCount);
+	for (uint32_t i = 0; i < instanceCount; i++)
+		bounds.Add(glm::vec3(position(random), position(random), position(random)), glm::vec3(size(random), size(random), size(random)));
+
+	const auto projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	const auto view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const auto frustum = VEngine::Frustum::FromMatrix(projection * view);
+
+	using Clock = std::chrono::steady_clock;
+	auto reference = std::vector<uint32_t>();
+
+	const auto measure = [&](std::string_view label, auto&& cull)
+	{
+		auto visible = std::vector<uint32_t>();
+		auto times = std::vector<double>();
+		for (uint32_t iteration = 0; iteration < iterations; iteration++)
+		{
+			const auto start = Clock::now();
+			cull(visible);
+			times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+
+		if (reference.empty())
+			reference = visible;
+		else if (visible != reference)
+			std::println("Warning: {} disagrees with the scalar kernel", label);
+
+		std::ranges::sort(times);
+		std::println("{:<16} min {:8.3f} ms, median {:8.3f} ms, {:7.1f} M boxes/s, {} visible", label, times.front(), times[times.size() / 2],
+			(double)instanceCount / (times[times.size() / 2] * 1000.0), visible.size());
+	};
+
+	std::println("{} boxes, {} iterations, best kernel {}", instanceCount, iterations, VEngine::FrustumCuller::GetKernelName(VEngine::FrustumCuller::GetBestKernel()));
+
+	for (const auto kernel : { VEngine::CullingKernel::Scalar, VEngine::CullingKernel::Sse, VEngine::CullingKernel::Avx2 })
+	{
+		if (VEngine::FrustumCuller::IsSupported(kernel) == false)
+			continue;
+
+		measure(VEngine::FrustumCuller::GetKernelName(kernel), [&](std::vector<uint32_t>& visible)
+		{
+			visible.resize(instanceCount);
+			visible.resize(VEngine::FrustumCuller::CullRange(kernel, bounds, frustum, 0, instanceCount, visible.data()));
+		});
+	}
+
+	auto jobSystem = VEngine::JobSystem();
+	auto culler = VEngine::FrustumCuller(jobSystem);
+	for (const auto kernel : { VEngine::CullingKernel::Scalar, culler.GetBestKernel() })
+	{
+		culler.SetKernel(kernel);
+		measure(std::format("{} x{}", VEngine::FrustumCuller::GetKernelName(kernel), culler.GetThreadCount()), [&](std::vector<uint32_t>& visible)
+		{
+			culler.Cull(bounds, frustum, visible);
+		});
+	}
+
+	return 0;
+}
@@ -0,0 +1,592 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Renderer.h"
+#include "VulkanBuffer.h"
+#include "VulkanDrawList.h"
+#include "VulkanOffscreenTarget.h"
+#include "VulkanParallelRecorder.h"
+#include "VulkanPipeline.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanRenderGraph.h"
+#include "VulkanShader.h"
+#include "VulkanUploader.h"
+
+// Usage: VEngineBench [--scenario name]... [--iterations n] [--warmup n] [--draws n] [--switches n] [--pipelines n]
+//                     [--upload-mib n] [--width n] [--height n] [--frames-in-flight n] [--report path]
+// Scenarios: draws, switches, pipelines, shaders, upload, submit, recording. Without --scenario all of them run.
+// Recording draws the same sorted draw list through a render graph pass, inline and split over the job system.
+// Always headless, so it runs on any ICD including software ones like lavapipe. Run from the build directory,
+// shaders are loaded as loose files from Resources/Shaders. Cold pipeline numbers only clear the engine's cache,
+// driver side caches have to be disabled separately, e.g. MESA_SHADER_CACHE_DISABLE=true.
+// The report is JSON with one entry per scenario and metric, times in milliseconds.
+
+struct BenchmarkSettings
+{
+	std::vector<std::string> Scenarios;
+	uint32_t Iterations = 200;
+	uint32_t Warmup = 10;
+	uint32_t Draws = 10000;
+	uint32_t Switches = 1000;
+	uint32_t Pipelines = 16;
+	uint32_t UploadMiB = 8;
+	uint32_t Width = 64;
+	uint32_t Height = 64;
+	uint32_t FramesInFlight = 2;
+	std::string ReportPath = "BenchmarkReport.json";
+};
+
+struct BenchmarkResult
+{
+	std::string Scenario;
+	std::string Metric;
+
+	// Draw count, switch count and so on, zero where the scenario has none
+	uint64_t Parameter = 0;
+
+	// Bytes moved per sample for bandwidth metrics
+	uint64_t Bytes = 0;
+	std::vector<double> Samples;
+};
+
+struct BenchmarkSummary
+{
+	double Mean = 0.0;
+	double Min = 0.0;
+	double P50 = 0.0;
+	double P90 = 0.0;
+	double P99 = 0.0;
+	double Max = 0.0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedMs(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static uint32_t ParseNumber(std::string_view value)
+{
+	uint32_t result = 0;
+	std::from_chars(value.data(), value.data() + value.size(), result);
+	return result;
+}
+
+// Nearest rank, so every reported percentile is a time that was actually measured
+static BenchmarkSummary Summarize(std::vector<double> samples)
+{
+	auto summary = BenchmarkSummary();
+	if (samples.empty())
+		return summary;
+
+	std::ranges::sort(samples);
+	const auto percentile = [&](double p)
+	{
+		const auto rank = (size_t)std::ceil(p / 100.0 * (double)samples.size());
+		return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+	};
+
+	double sum = 0.0;
+	for (const auto sample : samples)
+		sum += sample;
+
+	summary.Mean = sum / (double)samples.size();
+	summary.Min = samples.front();
+	summary.P50 = percentile(50.0);
+	summary.P90 = percentile(90.0);
+	summary.P99 = percentile(99.0);
+	summary.Max = samples.back();
+	return summary;
+}
+
+static std::string EscapeJson(std::string_view text)
+{
+	auto escaped = std::string();
+	for (const auto c : text)
+	{
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+
+		if ((unsigned char)c >= 0x20)
+			escaped += c;
+	}
+
+	return escaped;
+}
+
+static bool WriteReport(const std::string& path, const BenchmarkSettings& settings, const std::vector<BenchmarkResult>& results)
+{
+	const auto& properties = VEngine::Renderer::GetScope().GetVulkanDevice()->GetPhysicalDevice()->GetProperties();
+
+	auto json = std::string();
+	json += "{\n";
+	json += std::format("\t\"version\": 1,\n");
+	json += std::format("\t\"device\": \"{}\",\n", EscapeJson(properties.deviceName));
+	json += std::format("\t\"vendorId\": {},\n\t\"deviceId\": {},\n\t\"driverVersion\": {},\n", properties.vendorID, properties.deviceID, properties.driverVersion);
+	json += std::format("\t\"apiVersion\": \"{}.{}.{}\",\n", VK_API_VERSION_MAJOR(properties.apiVersion), VK_API_VERSION_MINOR(properties.apiVersion), VK_API_VERSION_PATCH(properties.apiVersion));
+	json += std::format("\t\"extent\": [{}, {}],\n\t\"framesInFlight\": {},\n\t\"warmup\": {},\n", settings.Width, settings.Height, settings.FramesInFlight, settings.Warmup);
+	json += "\t\"results\": [";
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const auto& result = results[i];
+		const auto summary = Summarize(result.Samples);
+
+		json += i == 0 ? "\n" : ",\n";
+		json += std::format("\t\t{{ \"scenario\": \"{}\", \"metric\": \"{}\", \"unit\": \"ms\", \"parameter\": {}, \"bytes\": {}, \"count\": {}, ",
+			result.Scenario, result.Metric, result.Parameter, result.Bytes, result.Samples.size());
+		json += std::format("\"mean\": {:.6f}, \"min\": {:.6f}, \"p50\": {:.6f}, \"p90\": {:.6f}, \"p99\": {:.6f}, \"max\": {:.6f} }}",
+			summary.Mean, summary.Min, summary.P50, summary.P90, summary.P99, summary.Max);
+	}
+
+	json += "\n\t]\n}\n";
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (file.is_open() == false)
+		return false;
+
+	file.write(json.data(), (std::streamsize)json.size());
+	return file.good();
+}
+
+static void PrintResult(const BenchmarkResult& result)
+{
+	const auto summary = Summarize(result.Samples);
+	std::print("{:<10} {:<16} p50 {:9.3f} ms, p90 {:9.3f} ms, p99 {:9.3f} ms, max {:9.3f} ms", result.Scenario, result.Metric,
+		summary.P50, summary.P90, summary.P99, summary.Max);
+
+	if (result.Bytes > 0 && summary.P50 > 0.0)
+		std::print(", {:8.1f} MiB/s", (double)result.Bytes / (1024.0 * 1024.0) / (summary.P50 / 1000.0));
+
+	std::println("");
+}
+
+class EngineBenchmark
+{
+public:
+	explicit EngineBenchmark(const BenchmarkSettings& settings)
+		: m_settings(settings)
+	{
+		const auto& device = VEngine::Renderer::GetScope().GetVulkanDevice();
+		m_target = std::make_unique<VEngine::VulkanOffscreenTarget>(device, VkExtent2D{ m_settings.Width, m_settings.Height }, m_settings.FramesInFlight);
+
+		m_vertex = std::make_shared<VEngine::VulkanShader>("Resources/Shaders/triangle.vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
+		m_fragment = std::make_shared<VEngine::VulkanShader>("Resources/Shaders/triangle.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+
+		m_layout.Vertex = m_vertex;
+		m_layout.Fragment = m_fragment;
+		m_layout.RenderPass = m_target->GetRenderPass();
+		m_layout.Extent = m_target->GetExtent();
+		m_layout.ColorFormat = m_target->GetFormat();
+
+		// Identical state, switching still makes the driver bind a different object every time
+		for (uint32_t i = 0; i < std::max(m_settings.Pipelines, 2u); i++)
+			m_pipelines.push_back(std::make_unique<VEngine::VulkanPipeline>(m_layout));
+	}
+
+	EngineBenchmark(const EngineBenchmark&) = delete;
+	EngineBenchmark(EngineBenchmark&&) = delete;
+
+	~EngineBenchmark()
+	{
+		Drain();
+	}
+
+	void Run(std::string_view scenario)
+	{
+		if (scenario == "draws")
+			RunDraws();
+		else if (scenario == "switches")
+			RunSwitches();
+		else if (scenario == "pipelines")
+			RunPipelines();
+		else if (scenario == "shaders")
+			RunShaders();
+		else if (scenario == "upload")
+			RunUpload();
+		else if (scenario == "submit")
+			RunSubmit();
+		else if (scenario == "recording")
+			RunRecording();
+		else
+			std::println("Unknown scenario {}", scenario);
+
+		Drain();
+	}
+
+	const std::vector<BenchmarkResult>& GetResults() const { return m_results; }
+
+private:
+	// Every scenario starts without GPU work or released objects of the previous one
+	void Drain()
+	{
+		const auto& device = VEngine::Renderer::GetScope().GetVulkanDevice();
+		VULKAN_CHECK(vkDeviceWaitIdle(device->GetDevice()));
+		m_target->FlushReadbacks();
+		device->GetDeletionQueue().Collect();
+	}
+
+	void AddResult(std::string_view scenario, std::string_view metric, std::vector<double> samples, uint64_t parameter = 0, uint64_t bytes = 0)
+	{
+		auto& result = m_results.emplace_back();
+		result.Scenario = scenario;
+		result.Metric = metric;
+		result.Parameter = parameter;
+		result.Bytes = bytes;
+		result.Samples = std::move(samples);
+	}
+
+	// Frames go back to back with the target's frames in flight, so frame times include waiting for the GPU.
+	// Without the target's render pass the recording begins its own, e.g. through a render graph.
+	void MeasureFrames(std::string_view scenario, uint64_t parameter, const std::function<void(VkCommandBuffer)>& record,
+		std::string_view metricPrefix = {}, bool targetRenderPass = true)
+	{
+		auto recordTimes = std::vector<double>();
+		auto frameTimes = std::vector<double>();
+		auto& deletionQueue = VEngine::Renderer::GetScope().GetVulkanDevice()->GetDeletionQueue();
+
+		for (uint32_t iteration = 0; iteration < m_settings.Warmup + m_settings.Iterations; iteration++)
+		{
+			const auto frameStart = Clock::now();
+			if ((targetRenderPass ? m_target->Begin() : m_target->BeginFrame()) == false)
+				continue;
+
+			deletionQueue.Collect();
+
+			const auto recordStart = Clock::now();
+			record(m_target->GetCommandBuffer());
+			const auto recordEnd = Clock::now();
+
+			m_target->End();
+			const auto frameEnd = Clock::now();
+
+			if (iteration < m_settings.Warmup)
+				continue;
+
+			recordTimes.push_back(ElapsedMs(recordStart, recordEnd));
+			frameTimes.push_back(ElapsedMs(frameStart, frameEnd));
+		}
+
+		AddResult(scenario, std::format("{}record", metricPrefix), std::move(recordTimes), parameter);
+		AddResult(scenario, std::format("{}frame", metricPrefix), std::move(frameTimes), parameter);
+	}
+
+	void RunDraws()
+	{
+		MeasureFrames("draws", m_settings.Draws, [&](VkCommandBuffer commandBuffer)
+		{
+			m_target->Bind(commandBuffer, *m_pipelines.front());
+			for (uint32_t i = 0; i < m_settings.Draws; i++)
+				vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+		});
+	}
+
+	void RunSwitches()
+	{
+		MeasureFrames("switches", m_settings.Switches, [&](VkCommandBuffer commandBuffer)
+		{
+			for (uint32_t i = 0; i < m_settings.Switches; i++)
+			{
+				m_target->Bind(commandBuffer, *m_pipelines[i % m_pipelines.size()]);
+				vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+			}
+		});
+	}
+
+	// Cold clears the pipeline cache before every creation, cached creates the same pipeline into a warm one
+	void RunPipelines()
+	{
+		auto& pipelineCache = VEngine::Renderer::GetScope().GetVulkanDevice()->GetPipelineCache();
+		auto coldTimes = std::vector<double>();
+		auto cachedTimes = std::vector<double>();
+
+		const auto create = [&]()
+		{
+			const auto start = Clock::now();
+			auto pipeline = VEngine::VulkanPipeline(m_layout);
+			return ElapsedMs(start, Clock::now());
+		};
+
+		for (uint32_t iteration = 0; iteration < m_settings.Warmup + m_settings.Iterations; iteration++)
+		{
+			pipelineCache.Clear();
+			const auto time = create();
+			if (iteration >= m_settings.Warmup)
+				coldTimes.push_back(time);
+		}
+
+		for (uint32_t iteration = 0; iteration < m_settings.Warmup + m_settings.Iterations; iteration++)
+		{
+			const auto time = create();
+			if (iteration >= m_settings.Warmup)
+				cachedTimes.push_back(time);
+		}
+
+		AddResult("pipelines", "cold", std::move(coldTimes));
+		AddResult("pipelines", "cached", std::move(cachedTimes));
+	}
+
+	// File read, reflection and vkCreateShaderModule for every shader the engine ships, one sample per module
+	void RunShaders()
+	{
+		struct ShaderFile
+		{
+			const char* Filename;
+			VkShaderStageFlagBits Stage;
+		};
+
+		constexpr ShaderFile shaders[] =
+		{
+			{ "Resources/Shaders/triangle.vert.spv", VK_SHADER_STAGE_VERTEX_BIT },
+			{ "Resources/Shaders/triangle.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT },
+			{ "Resources/Shaders/scene.vert.spv", VK_SHADER_STAGE_VERTEX_BIT },
+			{ "Resources/Shaders/cull.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT }
+		};
+
+		auto times = std::vector<double>();
+		for (uint32_t iteration = 0; iteration < m_settings.Warmup + m_settings.Iterations; iteration++)
+		{
+			for (const auto& shader : shaders)
+			{
+				const auto start = Clock::now();
+				auto shaderModule = VEngine::VulkanShader(shader.Filename, shader.Stage);
+				const auto time = ElapsedMs(start, Clock::now());
+
+				if (iteration >= m_settings.Warmup)
+					times.push_back(time);
+			}
+		}
+
+		AddResult("shaders", "module", std::move(times));
+	}
+
+	// From queueing the data until the transfer timeline says it landed, including the frame that flushes it
+	void RunUpload()
+	{
+		const auto& device = VEngine::Renderer::GetScope().GetVulkanDevice();
+		const auto uploadSize = (VkDeviceSize)std::max(m_settings.UploadMiB, 1u) * 1024 * 1024;
+
+		auto uploader = VEngine::VulkanUploader(device, uploadSize * 2);
+		auto buffer = VEngine::VulkanBuffer(uploadSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+		auto data = std::vector<std::byte>(uploadSize);
+		for (size_t i = 0; i < data.size(); i++)
+			data[i] = (std::byte)(i * 31);
+
+		auto times = std::vector<double>();
+		for (uint32_t iteration = 0; iteration < m_settings.Warmup + m_settings.Iterations; iteration++)
+		{
+			const auto start = Clock::now();
+			if (m_target->BeginFrame() == false)
+				continue;
+
+			const auto ticket = uploader.UploadBuffer(buffer.GetBuffer(), 0, data);
+			uploader.Flush(m_target->GetCommandBuffer());
+			m_target->End();
+
+			if (ticket.IsValid() == false)
+			{
+				std::println("Upload didn't fit the staging ring");
+				continue;
+			}
+
+			ticket.Wait();
+			if (iteration >= m_settings.Warmup)
+				times.push_back(ElapsedMs(start, Clock::now()));
+		}
+
+		AddResult("upload", "upload", std::move(times), m_settings.UploadMiB, uploadSize);
+
+		// The uploader and the buffer need an idle device
+		Drain();
+	}
+
+	// Empty frames, each one waited on before the next, so nothing else is queued ahead of it
+	void RunSubmit()
+	{
+		auto& timeline = VEngine::Renderer::GetScope().GetVulkanDevice()->GetGraphicsTimeline();
+		auto submitTimes = std::vector<double>();
+		auto latencyTimes = std::vector<double>();
+
+		for (uint32_t iteration = 0; iteration < m_settings.Warmup + m_settings.Iterations; iteration++)
+		{
+			if (m_target->Begin() == false)
+				continue;
+
+			const auto submitStart = Clock::now();
+			m_target->End();
+			const auto submitEnd = Clock::now();
+
+			timeline.Wait(timeline.GetSubmittedValue());
+			const auto completed = Clock::now();
+
+			if (iteration < m_settings.Warmup)
+				continue;
+
+			submitTimes.push_back(ElapsedMs(submitStart, submitEnd));
+			latencyTimes.push_back(ElapsedMs(submitStart, completed));
+		}
+
+		AddResult("submit", "submit", std::move(submitTimes));
+		AddResult("submit", "latency", std::move(latencyTimes));
+	}
+
+	// Same draws both ways, one batch each with the pipelines switching, so only the recording differs
+	void RunRecording()
+	{
+		const auto& device = VEngine::Renderer::GetScope().GetVulkanDevice();
+		const auto drawCount = std::min(m_settings.Draws, VEngine::VulkanDrawList::MaxMeshes);
+
+		// Triangle shaders take their vertices from gl_VertexIndex, the index buffer only feeds the indexed draws
+		auto indexBuffer = VEngine::VulkanBuffer(3 * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VEngine::VulkanMemoryUsage::CpuToGpu);
+		constexpr uint32_t indices[] = { 0, 1, 2 };
+		std::memcpy(indexBuffer.GetMappedData(), indices, sizeof(indices));
+
+		auto drawList = VEngine::VulkanDrawList();
+		for (uint32_t i = 0; i < drawCount; i++)
+		{
+			auto item = VEngine::VulkanDrawItem();
+			item.Pipeline = m_pipelines[i % m_pipelines.size()].get();
+			item.Mesh = i;
+			item.IndexCount = 3;
+			item.Instance = i;
+			drawList.Add(item);
+		}
+
+		drawList.Sort();
+
+		auto jobSystem = VEngine::JobSystem();
+		auto recorder = VEngine::VulkanParallelRecorder(device, jobSystem.GetWorkerCount() + 1, m_target->GetFramesInFlight());
+		auto renderGraph = VEngine::VulkanRenderGraph(device);
+
+		const auto bindBuffers = [&](VkCommandBuffer commandBuffer) { vkCmdBindIndexBuffer(commandBuffer, indexBuffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32); };
+		const auto record = [&](VkCommandBuffer commandBuffer, bool parallel)
+		{
+			constexpr VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
+			renderGraph.Reset();
+			const auto backBuffer = renderGraph.ImportTarget(*m_target);
+
+			auto& pass = renderGraph.AddPass("Recording", [&](VkCommandBuffer commandBuffer)
+			{
+				if (parallel == false)
+				{
+					bindBuffers(commandBuffer);
+					drawList.Record(commandBuffer, m_target->GetExtent(), nullptr);
+					return;
+				}
+
+				recorder.BeginPass(renderGraph.GetInheritance());
+				recorder.RecordDrawList(jobSystem, drawList, m_target->GetExtent(), 0, bindBuffers, nullptr);
+				recorder.Execute(commandBuffer);
+			}).Clear(backBuffer, VEngine::VulkanRenderGraphAccess::ColorAttachment, clearColor);
+
+			if (parallel)
+			{
+				pass.SetSecondaryContents();
+				recorder.BeginFrame(m_target->GetFrameIndex());
+			}
+
+			renderGraph.Execute(commandBuffer);
+		};
+
+		MeasureFrames("recording", drawCount, [&](VkCommandBuffer commandBuffer) { record(commandBuffer, false); }, "inline-", false);
+		MeasureFrames("recording", drawCount, [&](VkCommandBuffer commandBuffer) { record(commandBuffer, true); }, "parallel-", false);
+
+		// The graph, the recorder's pools and the index buffer need an idle device
+		Drain();
+	}
+
+	BenchmarkSettings m_settings;
+	std::unique_ptr<VEngine::VulkanOffscreenTarget> m_target = nullptr;
+	std::shared_ptr<VEngine::VulkanShader> m_vertex = nullptr;
+	std::shared_ptr<VEngine::VulkanShader> m_fragment = nullptr;
+	VEngine::VulkanPipelineLayout m_layout;
+	std::vector<std::unique_ptr<VEngine::VulkanPipeline>> m_pipelines;
+	std::vector<BenchmarkResult> m_results;
+};
+
+int main(int argc, char** argv)
+{
+	auto settings = BenchmarkSettings();
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (arg == "--scenario" && hasValue)
+			settings.Scenarios.emplace_back(argv[++i]);
+		else if (arg == "--iterations" && hasValue)
+			settings.Iterations = std::max(ParseNumber(argv[++i]), 1u);
+		else if (arg == "--warmup" && hasValue)
+			settings.Warmup = ParseNumber(argv[++i]);
+		else if (arg == "--draws" && hasValue)
+			settings.Draws = ParseNumber(argv[++i]);
+		else if (arg == "--switches" && hasValue)
+			settings.Switches = ParseNumber(argv[++i]);
+		else if (arg == "--pipelines" && hasValue)
+			settings.Pipelines = ParseNumber(argv[++i]);
+		else if (arg == "--upload-mib" && hasValue)
+			settings.UploadMiB = ParseNumber(argv[++i]);
+		else if (arg == "--width" && hasValue)
+			settings.Width = std::max(ParseNumber(argv[++i]), 1u);
+		else if (arg == "--height" && hasValue)
+			settings.Height = std::max(ParseNumber(argv[++i]), 1u);
+		else if (arg == "--frames-in-flight" && hasValue)
+			settings.FramesInFlight = std::max(ParseNumber(argv[++i]), 1u);
+		else if (arg == "--report" && hasValue)
+			settings.ReportPath = argv[++i];
+		else
+		{
+			std::println("Unknown argument {}", arg);
+			return 1;
+		}
+	}
+
+	if (settings.Scenarios.empty())
+		settings.Scenarios = { "draws", "switches", "pipelines", "shaders", "upload", "submit", "recording" };
+
+	if (std::filesystem::exists("Resources/Shaders/triangle.vert.spv") == false)
+	{
+		std::println("Resources/Shaders not found, run from the build directory");
+		return 1;
+	}
+
+	VEngine::Renderer::GetScope().Initialize(true);
+	std::println("{} iterations after {} warmup, {}x{} target, {} frames in flight", settings.Iterations, settings.Warmup,
+		settings.Width, settings.Height, settings.FramesInFlight);
+
+	auto results = std::vector<BenchmarkResult>();
+	{
+		auto benchmark = EngineBenchmark(settings);
+		for (const auto& scenario : settings.Scenarios)
+			benchmark.Run(scenario);
+
+		results = benchmark.GetResults();
+	}
+
+	for (const auto& result : results)
+		PrintResult(result);
+
+	if (WriteReport(settings.ReportPath, settings, results) == false)
+	{
+		std::println("Failed to write report to {}", settings.ReportPath);
+		return 1;
+	}
+
+	std::println("Report written to {}", settings.ReportPath);
+	return 0;
+}